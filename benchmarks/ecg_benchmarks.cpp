@@ -0,0 +1,1153 @@
+#include <QtTest>
+#include <QApplication>
+#include <QImage>
+#include <QJsonDocument>
+#include <QPainter>
+#include <QLoggingCategory>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+#include <QtMath>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+
+#include "VitalSignData.h"
+#include "MqttClientManager.h"
+#include "DatabaseManager.h"
+#include "ChartWidget.h"
+#include "SessionCapture.h"
+#include "WaveformStore.h"
+#include "QrsDetector.h"
+#include "MorphologyAnalyzer.h"
+#include "RhythmClassifier.h"
+#include "HrvAnalyzer.h"
+#include "SignalQuality.h"
+#include "PolyphaseResampler.h"
+#include "StftAnalyzer.h"
+#include "CentralStationRenderer.h"
+#include "RasterThreadPool.h"
+#include "PowerPolicy.h"
+
+// ==================== 堆分配计数 ====================
+// glibc下替换malloc系列以统计热点路径的堆分配次数（Qt容器与operator new最终都走malloc）
+// 其他平台不计数，相关用例会被跳过
+
+namespace {
+std::atomic<qint64> g_allocationCount{0};
+}
+
+#if defined(__GLIBC__)
+#define ECG_COUNT_ALLOCATIONS 1
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+}
+#endif
+
+namespace {
+
+// 统计函数调用期间的平均每次分配数
+template <typename Func>
+double allocationsPerCall(int iterations, Func func) {
+    func(); // 预热：设备池首次分配slab
+    const qint64 before = g_allocationCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < iterations; ++i) {
+        func();
+    }
+    return double(g_allocationCount.load(std::memory_order_relaxed) - before) / iterations;
+}
+
+// 生成一帧(1秒)模拟数据，波形与 scripts/mqtt_simulator.py 一致
+VitalSignData makeFrame(int sampleRate, int index = 0) {
+    VitalSignData data;
+    data.deviceId = "bench";
+    data.timestampUs = (QDateTime::currentMSecsSinceEpoch() - qint64(index) * 1000) * 1000;
+    data.temperature = 36.5 + (index % 10) * 0.05;
+    data.oxygenSaturation = 97;
+    data.heartRate = 72;
+
+    data.ecgSignal = EcgFrame::allocate(data.deviceId, sampleRate, data.timestampUs, sampleRate);
+    float* samples = data.ecgSignal.mutableData();
+    for (int i = 0; i < sampleRate; ++i) {
+        double t = static_cast<double>(i) / sampleRate;
+        double value = 0.5 * qSin(2 * M_PI * 1.2 * t);
+        double phase = std::fmod(t * 1.2, 1.0);
+        if (phase > 0.1 && phase < 0.15) {
+            value += 1.5; // R波
+        }
+        value += 0.05 * qSin(2 * M_PI * 50 * t); // 工频干扰
+        samples[i] = static_cast<float>(value);
+    }
+    return data;
+}
+
+// 标准12导联的一帧：各导联为同一波形按不同幅度缩放
+VitalSignData makeTwelveLeadFrame(int sampleRate, int index = 0) {
+    const VitalSignData single = makeFrame(sampleRate, index);
+    VitalSignData data = single;
+    data.ecgSignal = EcgFrame::allocate(data.deviceId, sampleRate, data.timestampUs, sampleRate,
+                                        EcgLead::firstLeads(EcgLead::Count));
+    for (int lead = 0; lead < EcgLead::Count; ++lead) {
+        const float scale = 0.4f + 0.1f * lead;
+        float* samples = data.ecgSignal.mutableLead(lead);
+        for (int i = 0; i < sampleRate; ++i) {
+            samples[i] = single.ecgSignal[i] * scale;
+        }
+    }
+    return data;
+}
+
+// 100/250/500 Hz 三种常见设备采样率
+void addSampleRateRows() {
+    QTest::addColumn<int>("sampleRate");
+    QTest::newRow("100Hz") << 100;
+    QTest::newRow("250Hz") << 250;
+    QTest::newRow("500Hz") << 500;
+}
+
+} // namespace
+
+class EcgBenchmarks : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // 数据模型
+    void vitalSignToJson_data() { addSampleRateRows(); }
+    void vitalSignToJson();
+    void vitalSignFromJson_data() { addSampleRateRows(); }
+    void vitalSignFromJson();
+    void vitalSignParse_data() { addSampleRateRows(); }
+    void vitalSignParse();
+    void vitalSignParse12Lead_data() { addSampleRateRows(); }
+    void vitalSignParse12Lead();
+    void vitalSignParseWithoutTimestamp();
+
+    // 每帧堆分配次数（DOM解析 / 直接解析 / 解析后分发到多个消费者）
+    void allocationsParseDom_data() { addSampleRateRows(); }
+    void allocationsParseDom();
+    void allocationsParseFast_data() { addSampleRateRows(); }
+    void allocationsParseFast();
+    void allocationsFanOut_data() { addSampleRateRows(); }
+    void allocationsFanOut();
+
+    // MQTT解析
+    void mqttParseVitalSign_data() { addSampleRateRows(); }
+    void mqttParseVitalSign();
+
+    // 数据库
+    void dbSaveVitalSign_data() { addSampleRateRows(); }
+    void dbSaveVitalSign();
+    void dbSaveVitalSignBatch_data() { addSampleRateRows(); }
+    void dbSaveVitalSignBatch();
+    void dbQueryVitalSigns_data() { addSampleRateRows(); }
+    void dbQueryVitalSigns();
+    void dbQueryVitalSignsAsync_data() { addSampleRateRows(); }
+    void dbQueryVitalSignsAsync();
+    void dbQueryVitalSignsCachedTail_data() { addSampleRateRows(); }
+    void dbQueryVitalSignsCachedTail();
+    void dbQueryVitalSignsCachedTailLimited_data() { addSampleRateRows(); }
+    void dbQueryVitalSignsCachedTailLimited();
+    void hotWindowQueryRecent_data() { addSampleRateRows(); }
+    void hotWindowQueryRecent();
+    void hotWindowLatest();
+    void waveformStoreReadRange_data() { addSampleRateRows(); }
+    void waveformStoreReadRange();
+    void eventFindNextSevere();
+    void eventDensity90Days();
+
+    // 心率变异性
+    void qrsDetect_data() { addSampleRateRows(); }
+    void qrsDetect();
+    void hrvComputeMetrics24h();
+
+    // 心搏模板与ST/QT测量
+    void morphologyProcess_data() { addSampleRateRows(); }
+    void morphologyProcess();
+    void rhythmClassify200Streams();
+
+    // 信号质量
+    void signalQualityAssess_data() { addSampleRateRows(); }
+    void signalQualityAssess();
+
+    // 流式STFT（频谱图）
+    void stftProcess_data() { addSampleRateRows(); }
+    void stftProcess();
+
+    // 重采样到显示采样率（每路设备一个流）
+    void resampleToDisplay_data();
+    void resampleToDisplay();
+
+    // 图表与波形
+    void chartConstruct();
+    void chartAddECGPoint_data() { addSampleRateRows(); }
+    void chartAddECGPoint();
+    void chartAddTrendPoint();
+    void chartFollowLiveAppend();
+    void waveformAddECGData_data() { addSampleRateRows(); }
+    void waveformAddECGData();
+    void waveformPaintEvent_data() { addSampleRateRows(); }
+    void waveformPaintEvent();
+    void waveformPaint12Lead_data() { addSampleRateRows(); }
+    void waveformPaint12Lead();
+    void waveformRasterPool_data();
+    void waveformRasterPool();
+    void centralStationTick_data();
+    void centralStationTick();
+
+    // 会话回放（最快速度，走完整解析路径）
+    void replayMaxSpeed_data() { addSampleRateRows(); }
+    void replayMaxSpeed();
+    // 追加到末尾有半条记录的录制文件后，追加的记录仍可读出（正确性检查）
+    void captureAppendAfterTornTail();
+
+    // 功耗档位：固定的实时回放负载下的进程CPU时间与唤醒次数（Linux）
+    void powerReplayCpuTime_data() { addPowerModeRows(); }
+    void powerReplayCpuTime();
+    void powerReplayWakeups_data() { addPowerModeRows(); }
+    void powerReplayWakeups();
+
+private:
+    QTemporaryDir m_tempDir;
+    DatabaseManager* m_database = nullptr;
+    MqttClientManager* m_mqttClient = nullptr;
+
+    void clearVitalSigns();
+    void populateEvents();
+    void addPowerModeRows();
+    void replayUnderPowerMode(PowerPolicy::Mode mode, ProcessActivity& used);
+};
+
+void EcgBenchmarks::initTestCase() {
+    QVERIFY(m_tempDir.isValid());
+
+    m_database = new DatabaseManager(this);
+    QVERIFY(m_database->initialize(m_tempDir.filePath("bench.db")));
+
+    m_mqttClient = new MqttClientManager(this);
+}
+
+void EcgBenchmarks::cleanupTestCase() {
+    delete m_mqttClient;
+    m_mqttClient = nullptr;
+    delete m_database;
+    m_database = nullptr;
+}
+
+void EcgBenchmarks::clearVitalSigns() {
+    QSqlQuery query(QSqlDatabase::database());
+    QVERIFY(query.exec("DELETE FROM vital_signs"));
+    // 绕过DatabaseManager删除，热窗口一并清空；此后写入的过去时间数据只走数据库
+    m_database->hotWindowCache()->reset(QDateTime::currentMSecsSinceEpoch() * 1000);
+    m_database->historyQueryCache()->invalidate();
+}
+
+void EcgBenchmarks::vitalSignToJson() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+
+    QBENCHMARK {
+        QJsonObject json = data.toJson();
+        Q_UNUSED(json);
+    }
+}
+
+void EcgBenchmarks::vitalSignFromJson() {
+    QFETCH(int, sampleRate);
+    const QJsonObject json = makeFrame(sampleRate).toJson();
+
+    VitalSignData data;
+    QBENCHMARK {
+        data = VitalSignData::fromJson(json);
+    }
+    QCOMPARE(data.ecgSignal.size(), sampleRate);
+}
+
+void EcgBenchmarks::vitalSignParse() {
+    QFETCH(int, sampleRate);
+    const QByteArray payload = QJsonDocument(makeFrame(sampleRate).toJson()).toJson(QJsonDocument::Compact);
+
+    VitalSignData data;
+    QBENCHMARK {
+        QVERIFY(VitalSignData::parse(payload, data));
+    }
+    QCOMPARE(data.ecgSignal.size(), sampleRate);
+}
+
+void EcgBenchmarks::vitalSignParse12Lead() {
+    QFETCH(int, sampleRate);
+    const QByteArray payload = QJsonDocument(makeTwelveLeadFrame(sampleRate).toJson()).toJson(QJsonDocument::Compact);
+
+    VitalSignData data;
+    QBENCHMARK {
+        QVERIFY(VitalSignData::parse(payload, data));
+    }
+    QCOMPARE(data.ecgSignal.leadCount(), int(EcgLead::Count));
+    QCOMPARE(data.ecgSignal.size(), sampleRate);
+}
+
+void EcgBenchmarks::vitalSignParseWithoutTimestamp() {
+    // 没有时间戳的负载两条路径都取接收时刻
+    const QByteArray payload = R"({"deviceId":"dev1","heartRate":72,"ecgSignal":[0.1,0.2,0.3]})";
+    const qint64 beforeUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+
+    VitalSignData fast;
+    QVERIFY(VitalSignData::parse(payload, fast));
+    const VitalSignData slow = VitalSignData::fromJson(QJsonDocument::fromJson(payload).object());
+    const qint64 afterUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+
+    for (const VitalSignData& data : {fast, slow}) {
+        QVERIFY(data.timestampUs >= beforeUs && data.timestampUs <= afterUs);
+        QCOMPARE(data.ecgSignal.timestampUs(), data.timestampUs);
+    }
+}
+
+void EcgBenchmarks::allocationsParseDom() {
+#ifndef ECG_COUNT_ALLOCATIONS
+    QSKIP("Allocation counting requires glibc");
+#else
+    QFETCH(int, sampleRate);
+    const QByteArray payload = QJsonDocument(makeFrame(sampleRate).toJson()).toJson(QJsonDocument::Compact);
+
+    VitalSignData data;
+    const double allocations = allocationsPerCall(1000, [&]() {
+        data = VitalSignData::fromJson(QJsonDocument::fromJson(payload).object());
+    });
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+#endif
+}
+
+void EcgBenchmarks::allocationsParseFast() {
+#ifndef ECG_COUNT_ALLOCATIONS
+    QSKIP("Allocation counting requires glibc");
+#else
+    QFETCH(int, sampleRate);
+    const QByteArray payload = QJsonDocument(makeFrame(sampleRate).toJson()).toJson(QJsonDocument::Compact);
+
+    VitalSignData data;
+    const double allocations = allocationsPerCall(1000, [&]() {
+        VitalSignData::parse(payload, data);
+    });
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+#endif
+}
+
+void EcgBenchmarks::allocationsFanOut() {
+#ifndef ECG_COUNT_ALLOCATIONS
+    QSKIP("Allocation counting requires glibc");
+#else
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+
+    // 模拟解析后的三跳：界面、数据库、云端队列各持有一份
+    VitalSignData display;
+    VitalSignData storage;
+    VitalSignData upload;
+    const double allocations = allocationsPerCall(1000, [&]() {
+        display = data;
+        storage = display;
+        upload = storage;
+    });
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+#endif
+}
+
+void EcgBenchmarks::mqttParseVitalSign() {
+    QFETCH(int, sampleRate);
+    const QByteArray payload = QJsonDocument(makeFrame(sampleRate).toJson()).toJson(QJsonDocument::Compact);
+
+    int received = 0;
+    auto connection = connect(m_mqttClient, &MqttClientManager::vitalSignReceived,
+                              this, [&received](const VitalSignData&) { ++received; });
+
+    QBENCHMARK {
+        m_mqttClient->injectMessage(payload, "ecg/vitalsign");
+    }
+
+    disconnect(connection);
+    QVERIFY(received > 0);
+}
+
+void EcgBenchmarks::dbSaveVitalSign() {
+    QFETCH(int, sampleRate);
+    clearVitalSigns();
+    const VitalSignData data = makeFrame(sampleRate);
+
+    QBENCHMARK {
+        m_database->saveVitalSign(data);
+    }
+}
+
+void EcgBenchmarks::dbSaveVitalSignBatch() {
+    QFETCH(int, sampleRate);
+    clearVitalSigns();
+
+    // 一分钟的数据作为一批
+    QVector<VitalSignData> batch;
+    for (int i = 0; i < 60; ++i) {
+        batch.append(makeFrame(sampleRate, i));
+    }
+
+    QBENCHMARK {
+        QVERIFY(m_database->saveVitalSignBatch(batch));
+    }
+}
+
+void EcgBenchmarks::dbQueryVitalSigns() {
+    QFETCH(int, sampleRate);
+    clearVitalSigns();
+
+    QVector<VitalSignData> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.append(makeFrame(sampleRate, i));
+    }
+    QVERIFY(m_database->saveVitalSignBatch(batch));
+
+    const QDateTime endTime = QDateTime::currentDateTime().addSecs(1);
+    const QDateTime startTime = endTime.addDays(-1);
+
+    QVector<VitalSignData> result;
+    QBENCHMARK {
+        result = m_database->queryVitalSigns(startTime, endTime, 1000);
+    }
+    QCOMPARE(result.size(), 1000);
+}
+
+void EcgBenchmarks::dbQueryVitalSignsAsync() {
+    QFETCH(int, sampleRate);
+    clearVitalSigns();
+
+    QVector<VitalSignData> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.append(makeFrame(sampleRate, i));
+    }
+    QVERIFY(m_database->saveVitalSignBatch(batch));
+
+    const QDateTime endTime = QDateTime::currentDateTime().addSecs(1);
+    const QDateTime startTime = endTime.addDays(-1);
+
+    // 含线程池调度与只读连接的往返开销（每次清空历史查询缓存，测量完整查询）
+    QVector<VitalSignData> result;
+    QBENCHMARK {
+        m_database->historyQueryCache()->invalidate();
+        result = m_database->queryVitalSignsAsync(startTime, endTime, 1000).result();
+    }
+    QCOMPARE(result.size(), 1000);
+}
+
+void EcgBenchmarks::dbQueryVitalSignsCachedTail() {
+    QFETCH(int, sampleRate);
+    clearVitalSigns();
+
+    QVector<VitalSignData> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.append(makeFrame(sampleRate, i + 10));
+    }
+    QVERIFY(m_database->saveVitalSignBatch(batch));
+
+    // 重复查看"最近24小时"：每次新到一帧，缓存只查询新增的尾部
+    QVector<VitalSignData> result = m_database->queryVitalSignsAsync(
+        QDateTime::currentDateTime().addDays(-1), QDateTime::currentDateTime(), 2000).result();
+    const HistoryQueryCache::Stats before = m_database->historyQueryCache()->stats();
+    QBENCHMARK {
+        QVERIFY(m_database->saveVitalSign(makeFrame(sampleRate)));
+        const QDateTime endTime = QDateTime::currentDateTime().addMSecs(1);
+        result = m_database->queryVitalSignsAsync(endTime.addDays(-1), endTime, 2000).result();
+    }
+    QVERIFY(result.size() > 1000);
+    QVERIFY(m_database->historyQueryCache()->stats().hits > before.hits);
+}
+
+void EcgBenchmarks::dbQueryVitalSignsCachedTailLimited() {
+    QFETCH(int, sampleRate);
+    clearVitalSigns();
+
+    // 时间段内的数据多于条数上限（历史查询默认1000条），缓存的结果只完整覆盖最新的1000条
+    QVector<VitalSignData> batch;
+    for (int i = 0; i < 3000; ++i) {
+        batch.append(makeFrame(sampleRate, i + 10));
+    }
+    QVERIFY(m_database->saveVitalSignBatch(batch));
+
+    QVector<VitalSignData> result = m_database->queryVitalSignsAsync(
+        QDateTime::currentDateTime().addDays(-1), QDateTime::currentDateTime()).result();
+    const HistoryQueryCache::Stats before = m_database->historyQueryCache()->stats();
+    QBENCHMARK {
+        QVERIFY(m_database->saveVitalSign(makeFrame(sampleRate)));
+        const QDateTime endTime = QDateTime::currentDateTime().addMSecs(1);
+        result = m_database->queryVitalSignsAsync(endTime.addDays(-1), endTime).result();
+    }
+    QCOMPARE(result.size(), 1000);
+    const HistoryQueryCache::Stats after = m_database->historyQueryCache()->stats();
+    QVERIFY(after.hits > before.hits);
+    QCOMPARE(after.misses, before.misses);
+}
+
+void EcgBenchmarks::hotWindowQueryRecent() {
+    QFETCH(int, sampleRate);
+    clearVitalSigns();
+    m_database->hotWindowCache()->reset(QDateTime::currentMSecsSinceEpoch() * 1000 - 3600LL * 1000000);
+
+    // 最近10分钟，全部在热窗口内
+    QVector<VitalSignData> batch;
+    for (int i = 0; i < 600; ++i) {
+        batch.append(makeFrame(sampleRate, i));
+    }
+    QVERIFY(m_database->saveVitalSignBatch(batch));
+
+    const QDateTime endTime = QDateTime::currentDateTime().addSecs(1);
+    const QDateTime startTime = endTime.addSecs(-11 * 60);
+
+    QVector<VitalSignData> result;
+    QBENCHMARK {
+        result = m_database->queryVitalSigns(startTime, endTime, 1000);
+    }
+    QCOMPARE(result.size(), 600);
+}
+
+void EcgBenchmarks::hotWindowLatest() {
+    clearVitalSigns();
+    QVERIFY(m_database->saveVitalSign(makeFrame(250)));
+
+    VitalSignData latest;
+    QBENCHMARK {
+        latest = m_database->getLatestVitalSign();
+    }
+    QCOMPARE(latest.deviceId, QString("bench"));
+}
+
+void EcgBenchmarks::populateEvents() {
+    QSqlDatabase db = QSqlDatabase::database();
+    QSqlQuery query(db);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM event_index") && query.next());
+    if (query.value(0).toInt() > 0) return;
+
+    // 90天、约10万个事件，绝大多数为低级别，严重事件约每两天一个
+    const int eventCount = 100000;
+    const QDateTime startTime = QDateTime::currentDateTime().addDays(-90);
+    const qint64 stepMs = 90LL * 86400 * 1000 / eventCount;
+    db.transaction();
+    query.prepare(R"(
+        INSERT INTO event_index (timestamp, end_time, device_id, category, type, severity, message)
+        VALUES (:timestamp, :timestamp, :device_id, 0, :type, :severity, '')
+    )");
+    for (int i = 0; i < eventCount; ++i) {
+        const QDateTime time = startTime.addMSecs(i * stepMs);
+        query.bindValue(":timestamp", time);
+        query.bindValue(":device_id", QString("bed%1").arg(i % 32, 2, 10, QChar('0')));
+        query.bindValue(":type", i % 5);
+        query.bindValue(":severity", i % 2000 == 1999 ? 4 : 1 + i % 3);
+        QVERIFY(query.exec());
+    }
+    QVERIFY(query.exec(R"(
+        INSERT INTO event_hourly (timestamp, device_id, category, type, severity, count)
+        SELECT substr(timestamp, 1, 13) || ':00:00.000', device_id, category, type, severity, COUNT(*)
+        FROM event_index
+        GROUP BY 1, 2, 3, 4, 5
+    )"));
+    QVERIFY(db.commit());
+}
+
+void EcgBenchmarks::eventFindNextSevere() {
+    populateEvents();
+    QSqlDatabase db = QSqlDatabase::database();
+
+    // 从90天前开始逐个跳到下一个严重事件（每个严重度一次索引定位）
+    EventFilter filter;
+    filter.minSeverity = 4;
+    QDateTime from = QDateTime::currentDateTime().addDays(-90);
+    qint64 fromId = -1;
+    QString error;
+    EventRecord event;
+    QBENCHMARK {
+        event = DatabaseManager::selectAdjacentEvent(db, from, fromId, true, filter, error);
+        if (event.isValid()) {
+            from = QDateTime::fromMSecsSinceEpoch(event.timestampUs / 1000);
+            fromId = event.id;
+        } else {
+            from = QDateTime::currentDateTime().addDays(-90);
+            fromId = -1;
+        }
+    }
+    QVERIFY(error.isEmpty());
+}
+
+void EcgBenchmarks::eventDensity90Days() {
+    populateEvents();
+    QSqlDatabase db = QSqlDatabase::database();
+
+    // 密度条：90天逐小时计数，只读小时计数表
+    const QDateTime endTime = QDateTime::currentDateTime();
+    const QDateTime startTime = endTime.addDays(-90);
+    EventFilter filter;
+    QString error;
+    QVector<EventHourCount> hours;
+    QBENCHMARK {
+        hours = DatabaseManager::selectEventDensity(db, startTime, endTime, filter, error);
+    }
+    QVERIFY(error.isEmpty());
+    QVERIFY(hours.size() > 2000);
+}
+
+void EcgBenchmarks::qrsDetect() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+    QrsDetector detector(sampleRate);
+    detector.reset(data.timestampUs);
+
+    // 每次迭代输入一分钟连续信号
+    QVector<qint64> beats;
+    QBENCHMARK {
+        beats.resize(0);
+        for (int i = 0; i < 60; ++i) {
+            detector.process(data.ecgSignal.constData(), data.ecgSignal.size(), beats);
+        }
+    }
+    QVERIFY(!beats.isEmpty());
+}
+
+void EcgBenchmarks::hrvComputeMetrics24h() {
+    // 24小时约10万个RR区间（约72bpm，带呼吸性窦性心律不齐）
+    QVector<RrInterval> intervals;
+    qint64 t = 0;
+    while (t < HrvAnalyzer::HourUs * 24) {
+        const double ms = 833.0 + 40.0 * qSin(2 * M_PI * 0.25 * t / 1e6) + 20.0 * qSin(2 * M_PI * 0.1 * t / 1e6);
+        const qint64 next = t + qint64(ms * 1000);
+        intervals.append({t, next});
+        t = next;
+    }
+
+    HrvMetrics metrics;
+    QBENCHMARK {
+        metrics = HrvAnalyzer::computeMetrics(intervals, 0, t);
+    }
+    QVERIFY(metrics.hasSpectrum);
+    QVERIFY(metrics.hfPower > 0.0);
+}
+
+void EcgBenchmarks::morphologyProcess() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+
+    // 预先检出一分钟信号中的R波，按帧分组
+    QrsDetector detector(sampleRate);
+    detector.reset(data.timestampUs);
+    QVector<qint64> beats;
+    QVector<int> frameBeats;
+    for (int i = 0; i < 60; ++i) {
+        frameBeats.append(beats.size());
+        detector.process(data.ecgSignal.constData(), data.ecgSignal.size(), beats);
+    }
+    frameBeats.append(beats.size());
+    QVERIFY(!beats.isEmpty());
+
+    // 每次迭代输入一分钟连续信号与对应的R波
+    MorphologyAnalyzer analyzer;
+    QBENCHMARK {
+        analyzer.restart(sampleRate, data.timestampUs);
+        for (int i = 0; i < 60; ++i) {
+            analyzer.process(data.ecgSignal.constData(), data.ecgSignal.size(),
+                             beats.constData() + frameBeats[i], frameBeats[i + 1] - frameBeats[i]);
+        }
+    }
+    QVERIFY(analyzer.stats().matched > 0);
+}
+
+void EcgBenchmarks::stftProcess() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+    StftAnalyzer analyzer(sampleRate);
+
+    // 每次迭代输入一分钟连续信号；每采样的开销应与已处理的长度无关
+    QVector<float> columns;
+    int count = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 60; ++i) {
+            columns.resize(0);
+            count += analyzer.process(data.ecgSignal.constData(), data.ecgSignal.size(), columns);
+        }
+    }
+    QVERIFY(count > 0);
+}
+
+void EcgBenchmarks::rhythmClassify200Streams() {
+    // 200路设备各一分钟心搏（约75bpm）：前半为窦性，后半为RR绝对不齐，每20个心搏一个宽QRS早搏
+    const int streams = 200;
+    QVector<AnalyzedBeat> beats;
+    qint64 t = 0;
+    for (int i = 0; i < 75; ++i) {
+        const bool premature = i % 20 == 19;
+        const int rrMs = premature ? 500 : (i < 38 ? 800 : 450 + (i * 7919) % 650);
+        t += rrMs * 1000;
+        beats.append({t, premature ? 140.0f : 90.0f, !premature});
+    }
+
+    std::vector<RhythmClassifier> classifiers(streams);
+    const RhythmLimits limits;
+    QVector<RhythmEpisode> finished;
+    QBENCHMARK {
+        for (RhythmClassifier& classifier : classifiers) {
+            for (const AnalyzedBeat& beat : std::as_const(beats)) {
+                classifier.addBeat(beat, limits, finished);
+            }
+            classifier.flush(finished);
+        }
+    }
+    QVERIFY(!finished.isEmpty());
+}
+
+void EcgBenchmarks::signalQualityAssess() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+    SignalQualityAnalyzer analyzer(sampleRate);
+
+    SignalQuality quality;
+    QBENCHMARK {
+        quality = analyzer.assess(data.ecgSignal.constData(), data.ecgSignal.size());
+    }
+    QVERIFY(quality.isAssessed());
+}
+
+void EcgBenchmarks::resampleToDisplay_data() {
+    QTest::addColumn<int>("sampleRate");
+    QTest::newRow("125Hz") << 125;
+    QTest::newRow("250Hz") << 250;
+    QTest::newRow("360Hz") << 360;
+    QTest::newRow("500Hz") << 500;
+}
+
+void EcgBenchmarks::resampleToDisplay() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+    PolyphaseResampler resampler(sampleRate, ECGWaveformWidget::DisplayRate);
+    QVERIFY(resampler.hasBuiltinKernel());
+
+    // 每次迭代一路设备一分钟的连续信号
+    QVector<float> out;
+    QBENCHMARK {
+        out.resize(0);
+        for (int i = 0; i < 60; ++i) {
+            resampler.process(data.ecgSignal.constData(), data.ecgSignal.size(), out);
+        }
+    }
+    QVERIFY(qAbs(out.size() - 60 * ECGWaveformWidget::DisplayRate) <= 1);
+}
+
+void EcgBenchmarks::waveformStoreReadRange() {
+    QFETCH(int, sampleRate);
+    WaveformStore store(m_tempDir.filePath(QString("waveforms_%1").arg(sampleRate)));
+    QVERIFY(store.open());
+
+    // 一小时的波形，按时间段顺序读取（回看/导出路径）
+    const int frameCount = 3600;
+    const qint64 startUs = 1767225600LL * 1000000; // 2026-01-01T00:00:00Z，落在同一分段内
+    const VitalSignData data = makeFrame(sampleRate);
+    for (int i = 0; i < frameCount; ++i) {
+        QVERIFY(store.append("bench", startUs + qint64(i) * 1000000, data.ecgSignal).isValid());
+    }
+    store.close();
+
+    int frames = 0;
+    QBENCHMARK {
+        double sum = 0.0;
+        frames = store.readRange("bench", startUs, startUs + WaveformStore::SegmentDurationUs - 1,
+                                 [&sum](const WaveformFrameView& view) {
+            for (int i = 0; i < view.sampleCount; ++i) {
+                sum += view.samples[i];
+            }
+            return true;
+        });
+        QVERIFY(!qIsNaN(sum));
+    }
+    QCOMPARE(frames, frameCount);
+}
+
+void EcgBenchmarks::chartAddECGPoint() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+
+    ChartWidget chart;
+    QBENCHMARK {
+        for (float value : data.ecgSignal) {
+            chart.addECGPoint(value, sampleRate);
+        }
+    }
+}
+
+void EcgBenchmarks::chartConstruct() {
+    // 历史页图表的创建代价（启动时不再创建，首次打开历史页时才付出）
+    QBENCHMARK {
+        ChartWidget chart;
+        chart.setDisplayMode(ChartWidget::HeartRateTrend);
+    }
+}
+
+void EcgBenchmarks::chartAddTrendPoint() {
+    const VitalSignData data = makeFrame(100);
+
+    ChartWidget chart;
+    chart.setDisplayMode(ChartWidget::HeartRateTrend);
+    QBENCHMARK {
+        chart.addTrendPoint(data);
+    }
+}
+
+void EcgBenchmarks::chartFollowLiveAppend() {
+    // 一小时窗口先载入3600帧，之后每次迭代追加一帧（窗口持续滑动）
+    ChartWidget chart;
+    chart.setDisplayMode(ChartWidget::HeartRateTrend);
+    chart.setFollowLive(true, 3600LL * 1000);
+    QVector<VitalSignData> history;
+    for (int i = 0; i < 3600; ++i) {
+        VitalSignData data = makeFrame(100, i);
+        data.ecgSignal = EcgFrame();
+        history.append(data);
+    }
+    chart.loadHistoryData(history);
+
+    VitalSignData live = history.first();
+    QBENCHMARK {
+        live.timestampUs += 1000000;
+        live.heartRate = 60 + int(live.timestampUs / 1000000 % 40);
+        chart.appendCommitted(live);
+    }
+}
+
+void EcgBenchmarks::waveformAddECGData() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+
+    ECGWaveformWidget waveform;
+    waveform.resize(800, 300);
+    waveform.start();
+    QBENCHMARK {
+        waveform.addECGData(data.ecgSignal);
+    }
+}
+
+void EcgBenchmarks::waveformPaintEvent() {
+    QFETCH(int, sampleRate);
+    const VitalSignData data = makeFrame(sampleRate);
+
+    EcgGridRenderer renderer;
+    for (int i = 0; i < 10; ++i) {
+        renderer.append(data.ecgSignal);
+    }
+
+    // 栅格化任务的工作量（paintEvent只复制结果图像）：截取可见数据 + 整幅绘制
+    QImage image(800, 300, QImage::Format_ARGB32_Premultiplied);
+    EcgGridRaster raster;
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        raster.paint(painter, image.rect(), renderer.snapshot(image.rect()));
+    }
+}
+
+void EcgBenchmarks::waveformPaint12Lead() {
+    QFETCH(int, sampleRate);
+
+    EcgGridRenderer renderer;
+    for (int i = 9; i >= 0; --i) {
+        renderer.append(makeTwelveLeadFrame(sampleRate, i).ecgSignal);
+    }
+
+    // 一次完整栅格化（12导联网格），应远低于40ms的帧预算
+    QImage image(1280, 720, QImage::Format_ARGB32_Premultiplied);
+    EcgGridRaster raster;
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        raster.paint(painter, image.rect(), renderer.snapshot(image.rect()));
+    }
+}
+
+void EcgBenchmarks::waveformRasterPool_data() {
+    QTest::addColumn<int>("views");
+    QTest::newRow("1view") << 1;
+    QTest::newRow("4views") << 4;
+    QTest::newRow("16views") << 16;
+}
+
+void EcgBenchmarks::waveformRasterPool() {
+    QFETCH(int, views);
+
+    // 每个视图一路500Hz的12导联，各自持有背景缓存与结果图像
+    struct View {
+        EcgGridRenderer renderer;
+        EcgGridRaster raster;
+        QImage image{960, 540, QImage::Format_ARGB32_Premultiplied};
+    };
+    std::vector<View> all(views);
+    for (View& view : all) {
+        for (int i = 9; i >= 0; --i) {
+            view.renderer.append(makeTwelveLeadFrame(500, i).ecgSignal);
+        }
+    }
+
+    // 全部视图在栅格化线程池中并行绘制一次，随核数扩展
+    QBENCHMARK {
+        QtConcurrent::blockingMap(RasterThreadPool::instance(), all, [](View& view) {
+            view.image.fill(Qt::transparent);
+            QPainter painter(&view.image);
+            painter.setRenderHint(QPainter::Antialiasing);
+            view.raster.paint(painter, view.image.rect(), view.renderer.snapshot(view.image.rect()));
+        });
+    }
+}
+
+void EcgBenchmarks::centralStationTick_data() {
+    QTest::addColumn<int>("beds");
+    QTest::newRow("16beds") << 16;
+    QTest::newRow("32beds") << 32;
+    QTest::newRow("64beds") << 64;
+}
+
+void EcgBenchmarks::centralStationTick() {
+    QFETCH(int, beds);
+
+    // 每床250Hz、每秒一帧
+    QVector<VitalSignData> frames;
+    for (int bed = 0; bed < beds; ++bed) {
+        VitalSignData data = makeFrame(250);
+        data.deviceId = QString("bed%1").arg(bed, 2, 10, QChar('0'));
+        frames.append(data);
+    }
+
+    CentralStationRenderer renderer;
+    renderer.resize(QSize(1920, 1080));
+    qint64 nowMs = 0;
+    const auto receive = [&]() {
+        for (const VitalSignData& data : std::as_const(frames)) {
+            renderer.updateVitals(data, nowMs);
+        }
+    };
+    receive();
+    receive();
+    renderer.advance(nowMs);    // 布局与首次整幅绘制不计入
+
+    // 一个刷新周期的增量绘制（含平摊的1/25秒数据接收），全部床位应远低于40ms的帧预算
+    int tick = 0;
+    QBENCHMARK {
+        nowMs += CentralStationWidget::RefreshIntervalMs;
+        if (++tick % 25 == 0) {
+            receive();
+        }
+        renderer.advance(nowMs);
+    }
+    QCOMPARE(renderer.bedCount(), beds);
+}
+
+void EcgBenchmarks::replayMaxSpeed() {
+    QFETCH(int, sampleRate);
+    const QString capturePath = m_tempDir.filePath(QString("replay_%1.ecgcap").arg(sampleRate));
+    const int frameCount = 600;
+
+    // 十分钟的录制数据
+    {
+        QFile::remove(capturePath);
+        SessionRecorder recorder;
+        QVERIFY(recorder.open(capturePath));
+        const qint64 startUs = SessionRecorder::currentEpochUs();
+        for (int i = 0; i < frameCount; ++i) {
+            const QByteArray payload = QJsonDocument(makeFrame(sampleRate, i).toJson())
+                                           .toJson(QJsonDocument::Compact);
+            recorder.append("ecg/vitalsign", payload, startUs + qint64(i) * 1000000);
+        }
+        recorder.close();
+    }
+
+    SessionReplayer replayer;
+    QVERIFY(replayer.open(capturePath));
+    replayer.setSpeed(0);
+    connect(&replayer, &SessionReplayer::messageReplayed, m_mqttClient,
+            [this](const QByteArray& payload, const QString& topic) {
+        m_mqttClient->injectMessage(payload, topic);
+    });
+
+    QSignalSpy finishedSpy(&replayer, &SessionReplayer::finished);
+    QBENCHMARK_ONCE {
+        replayer.start();
+        QVERIFY(finishedSpy.wait(60000));
+    }
+    QCOMPARE(replayer.replayedCount(), qint64(frameCount));
+}
+
+void EcgBenchmarks::captureAppendAfterTornTail() {
+    const QString capturePath = m_tempDir.filePath("torn_tail.ecgcap");
+    QFile::remove(capturePath);
+    {
+        SessionRecorder recorder;
+        QVERIFY(recorder.open(capturePath));
+        recorder.append("ecg/vitalsign", "first", 1000);
+        recorder.append("ecg/vitalsign", "second", 2000);
+        recorder.close();
+    }
+
+    // 模拟崩溃：最后一条记录只写了一半
+    {
+        QFile file(capturePath);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() - 3));
+    }
+
+    {
+        SessionRecorder recorder;
+        QVERIFY(recorder.open(capturePath));
+        recorder.append("ecg/vitalsign", "third", 3000);
+        recorder.append("ecg/vitalsign", "fourth", 4000);
+        recorder.close();
+    }
+
+    SessionCaptureReader reader;
+    QVERIFY(reader.open(capturePath));
+    QStringList payloads;
+    CaptureRecord record;
+    while (reader.next(record)) {
+        payloads << QString::fromUtf8(record.payload);
+    }
+    QVERIFY(reader.errorString().isEmpty());
+    QCOMPARE(payloads, QStringList() << "first" << "third" << "fourth");
+    QVERIFY(reader.atEnd());
+}
+
+void EcgBenchmarks::addPowerModeRows() {
+    QTest::addColumn<int>("mode");
+    QTest::newRow("interactive") << int(PowerPolicy::Interactive);
+    QTest::newRow("battery") << int(PowerPolicy::Battery);
+    QTest::newRow("background") << int(PowerPolicy::Background);
+}
+
+void EcgBenchmarks::replayUnderPowerMode(PowerPolicy::Mode mode, ProcessActivity& used) {
+    // 固定负载：20台设备、250Hz、每台每秒一帧，交错到达（每50ms一帧），实时速度回放3秒
+    const QString capturePath = m_tempDir.filePath("power_replay.ecgcap");
+    const int devices = 20;
+    const int frameCount = 60;
+    if (!QFile::exists(capturePath)) {
+        SessionRecorder recorder;
+        QVERIFY(recorder.open(capturePath));
+        const qint64 startUs = SessionRecorder::currentEpochUs();
+        for (int i = 0; i < frameCount; ++i) {
+            VitalSignData data = makeFrame(250, frameCount - i);
+            data.deviceId = QString("bed%1").arg(i % devices, 2, 10, QChar('0'));
+            const QByteArray payload = QJsonDocument(data.toJson()).toJson(QJsonDocument::Compact);
+            recorder.append("ecg/vitalsign", payload, startUs + qint64(i) * 50000);
+        }
+        recorder.close();
+    }
+
+    // 与主窗口相同的实时视图与写入路径，按档位配置
+    ECGWaveformWidget waveform;
+    SpectrogramWidget spectrogram;
+    CentralStationWidget station;
+    waveform.resize(960, 300);
+    station.resize(1280, 720);
+    waveform.show();
+    spectrogram.show();
+    station.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&station));
+
+    const PowerProfile profile = PowerPolicy::profile(mode);
+    waveform.setMinRasterInterval(profile.waveformIntervalMs);
+    if (profile.renderingPaused) {
+        waveform.stop();
+    } else {
+        waveform.start();
+    }
+    spectrogram.setRepaintInterval(profile.refreshIntervalMs);
+    station.setRefreshInterval(profile.renderingPaused ? 0 : profile.refreshIntervalMs);
+    m_database->setWriteCoalescing(profile.dbBatchFrames, profile.dbBatchDelayMs);
+
+    SessionReplayer replayer;
+    QVERIFY(replayer.open(capturePath));
+    replayer.setSpeed(1.0);
+    connect(&replayer, &SessionReplayer::messageReplayed, m_mqttClient,
+            [this](const QByteArray& payload, const QString& topic) {
+        m_mqttClient->injectMessage(payload, topic);
+    });
+    connect(m_mqttClient, &MqttClientManager::vitalSignReceived, &station, [&](const VitalSignData& data) {
+        waveform.addECGData(data.ecgSignal, data.receivedAtNs, data.signalQuality);
+        spectrogram.addECGData(data.deviceId, data.ecgSignal);
+        station.updateVitals(data);
+        m_database->enqueueVitalSign(data);
+    });
+
+    QSignalSpy finishedSpy(&replayer, &SessionReplayer::finished);
+    ProcessActivity before;
+    QVERIFY(ProcessActivity::sample(before));
+    replayer.start();
+    QVERIFY(finishedSpy.wait(30000));
+    QVERIFY(m_database->flushPendingWrites());     // 合并写入的尾部计入
+    ProcessActivity after;
+    QVERIFY(ProcessActivity::sample(after));
+    m_database->setWriteCoalescing(1, 0);
+    QCOMPARE(replayer.replayedCount(), qint64(frameCount));
+
+    used.cpuUs = after.cpuUs - before.cpuUs;
+    used.wakeups = after.wakeups - before.wakeups;
+}
+
+void EcgBenchmarks::powerReplayCpuTime() {
+    QFETCH(int, mode);
+    ProcessActivity used;
+    if (!ProcessActivity::sample(used)) {
+        QSKIP("当前平台不支持读取进程CPU时间与唤醒次数");
+    }
+    replayUnderPowerMode(PowerPolicy::Mode(mode), used);
+    if (QTest::currentTestFailed()) return;
+    // Qt Test没有CPU时间单位，按毫秒记录整个回放期间的进程CPU时间（墙钟时间固定为3秒）
+    QTest::setBenchmarkResult(used.cpuUs / 1000.0, QTest::WalltimeMilliseconds);
+}
+
+void EcgBenchmarks::powerReplayWakeups() {
+    QFETCH(int, mode);
+    ProcessActivity used;
+    if (!ProcessActivity::sample(used)) {
+        QSKIP("当前平台不支持读取进程CPU时间与唤醒次数");
+    }
+    replayUnderPowerMode(PowerPolicy::Mode(mode), used);
+    if (QTest::currentTestFailed()) return;
+    QTest::setBenchmarkResult(used.wakeups, QTest::ContextSwitches);
+}
+
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    // 屏蔽热点路径中的调试日志，避免干扰计时
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    EcgBenchmarks benchmarks;
+    return QTest::qExec(&benchmarks, argc, argv);
+}
+
+#include "ecg_benchmarks.moc"
@@ -1,6 +1,6 @@
 # QtMqtt需要单独安装，暂时禁用
-# QT += core gui widgets mqtt sql charts network
-QT += core gui widgets sql charts network
+# QT += core gui widgets mqtt sql charts network concurrent
+QT += core gui widgets sql charts network concurrent
 
 # 定义宏禁用MQTT功能
 DEFINES += NO_MQTT_SUPPORT
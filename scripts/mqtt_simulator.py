@@ -18,8 +18,9 @@ MQTT_BROKER = "47.115.148.200"
 MQTT_PORT = 1883
 MQTT_TOPIC_VITAL = "ecg/vitalsign"
 MQTT_TOPIC_ALARM = "ecg/alarm"
+ECG_SAMPLE_RATE = 100  # Hz，可改为125/250/360/500模拟不同设备
 
-def generate_ecg_signal(duration=1.0, sample_rate=100):
+def generate_ecg_signal(duration=1.0, sample_rate=ECG_SAMPLE_RATE):
     """生成模拟ECG信号（简化的正弦波 + 噪声）"""
     samples = int(duration * sample_rate)
     signal = []
@@ -30,7 +31,7 @@ def generate_ecg_signal(duration=1.0, sample_rate=100):
         value = 0.5 * math.sin(2 * math.pi * 1.2 * t)  # 1.2Hz ≈ 72 bpm
         
         # 添加R波（QRS复合波）
-        if i % 80 < 5:  # 每80个样本点添加一个R波
+        if i % int(0.8 * sample_rate) < max(1, sample_rate // 20):  # 每0.8秒添加一个R波
             value += 1.5
         
         # 添加随机噪声
@@ -47,7 +48,8 @@ def generate_vital_sign_data():
         "temperature": round(random.uniform(36.0, 37.5), 1),
         "oxygenSaturation": random.randint(95, 100),
         "heartRate": random.randint(60, 90),
-        "ecgSignal": generate_ecg_signal()
+        "ecgSignal": generate_ecg_signal(),
+        "sampleRate": ECG_SAMPLE_RATE
     }
     return data
 
@@ -0,0 +1,390 @@
+#include "CentralStationRenderer.h"
+#include <QFontMetrics>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int PrebufferSamples = CentralStationRenderer::SweepRate;      // 开始扫描前缓冲1秒，吸收帧到达抖动
+const int MaxLagSamples = 3 * CentralStationRenderer::SweepRate;     // 排队超过3秒时丢弃最旧的部分
+const int EraseGap = 8;             // 扫描位置前方擦除的宽度（像素）
+const qint64 MaxTickMs = 1000;      // 视图长时间隐藏后恢复时，一次最多补扫1秒
+const qint64 OfflineMs = 5000;      // 超过5秒无数据视为离线
+const qint64 AlarmHoldMs = 10000;   // 报警在标题栏保持10秒
+const qint64 FlashPeriodMs = 250;   // 高级别报警以2Hz闪烁
+const double TileAspect = 2.0;      // 格子宽高比约2:1时波形最易看清
+const char* const DefaultBedLabel = "未标识设备";     // 没有设备ID的数据（单机直连、旧格式）共用的床位
+
+const QColor TileBackground(40, 40, 40);
+
+// 质量可用为绿色，质量差为黄色，导联脱落为灰色（与实时波形一致）
+const QPen& levelPen(quint8 level) {
+    static const QPen pens[] = {
+        QPen(Qt::green, 1),
+        QPen(QColor(230, 180, 0), 1),
+        QPen(Qt::gray, 1)
+    };
+    return pens[level];
+}
+
+quint8 qualityLevel(const SignalQuality& quality) {
+    if (quality.has(SignalQuality::LeadOff)) return 2;
+    return quality.isUsable() ? 0 : 1;
+}
+
+// 报警颜色与VitalSignPanel一致
+QColor alarmColor(int severity) {
+    switch (severity) {
+        case 1:
+        case 2:
+            return QColor(255, 165, 0);
+        case 3:
+        case 4:
+            return Qt::red;
+        case 5:
+            return Qt::darkRed;
+        default:
+            return Qt::yellow;
+    }
+}
+
+// 数值区分三行：心率占上半，血氧、体温各占四分之一
+void numericRows(const QRect& numerics, QRect rows[3]) {
+    const int half = numerics.height() / 2;
+    const int quarter = (numerics.height() - half) / 2;
+    rows[0] = QRect(numerics.left(), numerics.top(), numerics.width(), half);
+    rows[1] = QRect(numerics.left(), rows[0].bottom() + 1, numerics.width(), quarter);
+    rows[2] = QRect(numerics.left(), rows[1].bottom() + 1, numerics.width(), numerics.bottom() - rows[1].bottom());
+}
+
+} // namespace
+
+CentralStationRenderer::CentralStationRenderer()
+    : m_layoutDirty(true)
+    , m_lastTickMs(-1)
+{
+}
+
+CentralStationRenderer::Bed* CentralStationRenderer::bedFor(const QString& deviceId) {
+    const auto it = m_index.constFind(deviceId);
+    if (it != m_index.constEnd()) return &m_beds[it.value()];
+    if (bedCount() >= MaxBeds) return nullptr;
+
+    m_index.insert(deviceId, bedCount());
+    m_beds.emplace_back();
+    m_beds.back().deviceId = deviceId;
+    m_layoutDirty = true;
+    return &m_beds.back();
+}
+
+void CentralStationRenderer::updateVitals(const VitalSignData& data, qint64 nowMs) {
+    Bed* bed = bedFor(data.deviceId);
+    if (!bed) return;
+
+    bed->hasVitals = true;
+    bed->heartRate = data.heartRate;
+    bed->oxygenSaturation = data.oxygenSaturation;
+    bed->temperature = data.temperature;
+    bed->lastDataMs = nowMs;
+    bed->numericsDirty = true;
+
+    const EcgFrame& frame = data.ecgSignal;
+    if (frame.isEmpty()) return;
+
+    if (frame.sampleRate() != bed->resampler.inputRate()) {
+        bed->resampler = PolyphaseResampler(frame.sampleRate(), SweepRate);
+    } else if (bed->nextInputUs >= 0 &&
+               qAbs(frame.timestampUs() - bed->nextInputUs) > 500000 / qMax(1, frame.sampleRate())) {
+        bed->resampler.reset();
+    }
+    bed->nextInputUs = frame.timestampUs() + qint64(frame.durationSeconds() * 1e6);
+
+    // 去掉已扫描的部分，再追加新采样（第一导联）
+    if (bed->pendingHead > 0) {
+        bed->pending.remove(0, bed->pendingHead);
+        bed->pendingLevel.remove(0, bed->pendingHead);
+        bed->pendingHead = 0;
+    }
+    const int before = bed->pending.size();
+    bed->resampler.process(frame.constData(), frame.size(), bed->pending);
+    bed->pendingLevel.resize(bed->pending.size());
+    std::fill(bed->pendingLevel.begin() + before, bed->pendingLevel.end(), qualityLevel(data.signalQuality));
+
+    // 视图隐藏时不扫描，只保留最近的部分
+    bed->pendingHead = qMax(0, int(bed->pending.size()) - MaxLagSamples);
+}
+
+void CentralStationRenderer::showAlarm(const AlarmInfo& alarm, qint64 nowMs) {
+    Bed* bed = bedFor(alarm.deviceId);
+    if (!bed) return;
+
+    // 保持期内只被同级或更高级别的报警覆盖
+    if (nowMs < bed->alarmUntilMs && alarm.severity < bed->alarmSeverity) return;
+    bed->alarmMessage = alarm.message;
+    bed->alarmSeverity = alarm.severity;
+    bed->alarmUntilMs = nowMs + AlarmHoldMs;
+    bed->headerDirty = true;
+}
+
+void CentralStationRenderer::clear() {
+    m_beds.clear();
+    m_index.clear();
+    m_layoutDirty = true;
+}
+
+QString CentralStationRenderer::deviceAt(const QPoint& position) const {
+    for (const Bed& bed : m_beds) {
+        if (bed.tile.contains(position)) return bed.deviceId;
+    }
+    return QString();
+}
+
+void CentralStationRenderer::resize(const QSize& size) {
+    if (size == m_size) return;
+    m_size = size;
+    m_layoutDirty = true;
+}
+
+void CentralStationRenderer::layout() {
+    m_layoutDirty = false;
+    m_background = QImage(m_size, QImage::Format_RGB32);
+    m_background.fill(Qt::black);
+
+    // 在候选列数中选格子宽高比最接近TileAspect的
+    const int count = qMax(1, bedCount());
+    int columns = 1;
+    double best = std::numeric_limits<double>::max();
+    for (int candidate = 1; candidate <= count; ++candidate) {
+        const int rows = (count + candidate - 1) / candidate;
+        const double aspect = (double(m_size.width()) / candidate) / (double(m_size.height()) / rows);
+        const double score = std::abs(std::log(aspect / TileAspect));
+        if (score < best) {
+            best = score;
+            columns = candidate;
+        }
+    }
+    const int rows = (count + columns - 1) / columns;
+    const int tileWidth = m_size.width() / columns;
+    const int tileHeight = m_size.height() / rows;
+    const int headerHeight = qBound(12, tileHeight / 6, 22);
+
+    m_headerFont = QFont("Arial");
+    m_headerFont.setPixelSize(headerHeight - 4);
+    m_headerFont.setBold(true);
+    m_smallFont = QFont("Arial");
+    m_smallFont.setPixelSize(qBound(8, tileHeight / 12, 12));
+    m_valueFont = QFont("Arial");
+    m_valueFont.setPixelSize(qMax(10, (tileHeight - headerHeight) / 3));
+    m_valueFont.setBold(true);
+
+    QPainter painter(&m_background);
+    for (int i = 0; i < bedCount(); ++i) {
+        Bed& bed = m_beds[i];
+        bed.tile = QRect((i % columns) * tileWidth, (i / columns) * tileHeight, tileWidth, tileHeight)
+                       .adjusted(1, 1, -1, -1);
+        bed.header = QRect(bed.tile.left(), bed.tile.top(), bed.tile.width(), headerHeight);
+        const int numericsWidth = qMin(bed.tile.width(), qMax(48, bed.tile.width() * 3 / 10));
+        bed.numerics = QRect(bed.tile.right() - numericsWidth + 1, bed.header.bottom() + 1,
+                             numericsWidth, bed.tile.bottom() - bed.header.bottom());
+        bed.wave = QRect(bed.tile.left() + 2, bed.header.bottom() + 3,
+                         bed.numerics.left() - bed.tile.left() - 4, bed.numerics.height() - 4);
+        paintBackground(painter, bed);
+
+        bed.sweepX = 0;
+        bed.hasLast = false;
+        bed.headerState = -1;
+        bed.headerDirty = true;
+        bed.numericsDirty = true;
+    }
+    painter.end();
+
+    m_image = m_background.copy();
+    m_dirty = QRegion(m_image.rect());
+}
+
+void CentralStationRenderer::paintBackground(QPainter& painter, const Bed& bed) {
+    painter.setPen(QColor(70, 70, 70));
+    painter.drawRect(bed.tile.adjusted(0, 0, -1, -1));
+    painter.drawLine(bed.numerics.left(), bed.numerics.top(), bed.numerics.left(), bed.numerics.bottom());
+
+    QRect rows[3];
+    numericRows(bed.numerics, rows);
+    static const char* const labels[] = {"HR", "SpO2", "T"};
+    painter.setPen(Qt::darkGray);
+    painter.setFont(m_smallFont);
+    for (int i = 0; i < 3; ++i) {
+        painter.drawText(rows[i].adjusted(4, 1, -2, 0), Qt::AlignTop | Qt::AlignLeft, labels[i]);
+    }
+}
+
+void CentralStationRenderer::paintHeader(QPainter& painter, Bed& bed, qint64 nowMs) {
+    const bool alarmActive = bed.alarmSeverity > 0 && nowMs < bed.alarmUntilMs;
+    const bool flashOn = alarmActive && bed.alarmSeverity >= 3 && (nowMs / FlashPeriodMs) % 2 == 0;
+    const bool offline = bed.lastDataMs < 0 || nowMs - bed.lastDataMs > OfflineMs;
+    if (offline != bed.offline) {
+        bed.offline = offline;
+        bed.numericsDirty = true;
+    }
+
+    const int state = (alarmActive ? 1 : 0) | (flashOn ? 2 : 0) | (offline ? 4 : 0);
+    if (state == bed.headerState && !bed.headerDirty) return;
+    bed.headerState = state;
+    bed.headerDirty = false;
+
+    QColor background = TileBackground;
+    QColor text = offline ? Qt::gray : Qt::white;
+    QString label = bed.deviceId.isEmpty() ? QString(DefaultBedLabel) : bed.deviceId;
+    if (alarmActive) {
+        // 低级别报警常亮，高级别报警背景闪烁
+        if (bed.alarmSeverity < 3 || flashOn) {
+            background = alarmColor(bed.alarmSeverity);
+            text = Qt::black;
+        } else {
+            text = alarmColor(bed.alarmSeverity);
+        }
+        label += "  " + bed.alarmMessage;
+    } else if (offline) {
+        label += "  离线";
+    }
+
+    painter.fillRect(bed.header, background);
+    painter.setPen(text);
+    painter.setFont(m_headerFont);
+    const QRect textRect = bed.header.adjusted(4, 0, -4, 0);
+    painter.drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft,
+                     QFontMetrics(m_headerFont).elidedText(label, Qt::ElideRight, textRect.width()));
+    m_dirty += bed.header;
+}
+
+void CentralStationRenderer::paintNumerics(QPainter& painter, Bed& bed) {
+    if (!bed.numericsDirty) return;
+    bed.numericsDirty = false;
+
+    restore(painter, bed.numerics.adjusted(1, 0, 0, 0));
+    if (!bed.hasVitals) return;
+
+    // 超限着色阈值与VitalSignPanel一致，离线时灰显
+    const auto color = [&bed](bool abnormal, const QColor& normal) -> QColor {
+        if (bed.offline) return Qt::darkGray;
+        return abnormal ? QColor(Qt::red) : normal;
+    };
+
+    QRect rows[3];
+    numericRows(bed.numerics, rows);
+    painter.setFont(m_valueFont);
+    painter.setPen(color(bed.heartRate < 60 || bed.heartRate > 100, Qt::green));
+    painter.drawText(rows[0].adjusted(2, 0, -4, 0), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(bed.heartRate));
+
+    painter.setFont(m_headerFont);
+    painter.setPen(color(bed.oxygenSaturation < 95, Qt::cyan));
+    painter.drawText(rows[1].adjusted(2, 0, -4, 0), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(bed.oxygenSaturation));
+    painter.setPen(color(bed.temperature < 36.0 || bed.temperature > 38.0, Qt::white));
+    painter.drawText(rows[2].adjusted(2, 0, -4, 0), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(bed.temperature, 'f', 1));
+}
+
+void CentralStationRenderer::sweep(QPainter& painter, Bed& bed, qint64 elapsedMs) {
+    const int available = bed.pending.size() - bed.pendingHead;
+    if (!bed.sweeping) {
+        if (available < PrebufferSamples) return;
+        bed.sweeping = true;
+        bed.sweepCredit = 0.0;
+    }
+
+    bed.sweepCredit += elapsedMs * (SweepRate / 1000.0);
+    const int due = int(bed.sweepCredit);
+    const int count = qMin(available, due);
+    bed.sweepCredit -= count;
+    if (count < due) {
+        // 数据耗尽（设备停发或严重延迟），重新预缓冲
+        bed.sweeping = false;
+    }
+    if (count == 0) return;
+
+    const float* samples = bed.pending.constData() + bed.pendingHead;
+    const quint8* levels = bed.pendingLevel.constData() + bed.pendingHead;
+    bed.pendingHead += count;
+
+    const QRect& wave = bed.wave;
+    const int width = wave.width();
+    if (width < 2 || wave.height() < 2) return;
+
+    // 擦除扫描位置起的一段（新波形加扫描间隙），超出右端时从左端接续
+    const int erase = qMin(width, count + EraseGap);
+    const int first = qMin(erase, width - bed.sweepX);
+    restore(painter, QRect(wave.left() + bed.sweepX, wave.top(), first, wave.height()));
+    if (erase > first) {
+        restore(painter, QRect(wave.left(), wave.top(), erase - first, wave.height()));
+    }
+
+    // ±2mV占满波形区
+    const double centerY = wave.top() + wave.height() / 2.0;
+    const double scale = wave.height() / 4.0;
+    const double top = wave.top();
+    const double bottom = wave.bottom();
+
+    m_polyline.resize(0);
+    if (bed.hasLast) {
+        m_polyline.append(QPointF(wave.left() + bed.sweepX - 1, bed.lastY));
+    }
+    quint8 level = levels[0];
+    for (int i = 0; i < count; ++i) {
+        if (levels[i] != level) {
+            flushPolyline(painter, level);
+            level = levels[i];
+        }
+        const double y = qBound(top, centerY - samples[i] * scale, bottom);
+        m_polyline.append(QPointF(wave.left() + bed.sweepX, y));
+        bed.lastY = float(y);
+        bed.hasLast = true;
+        if (++bed.sweepX == width) {
+            flushPolyline(painter, level);
+            m_polyline.resize(0);
+            bed.sweepX = 0;
+            bed.hasLast = false;
+        }
+    }
+    flushPolyline(painter, level);
+}
+
+void CentralStationRenderer::restore(QPainter& painter, const QRect& rect) {
+    painter.drawImage(rect.topLeft(), m_background, rect);
+    m_dirty += rect;
+}
+
+void CentralStationRenderer::flushPolyline(QPainter& painter, quint8 level) {
+    if (m_polyline.size() >= 2) {
+        painter.setPen(levelPen(level));
+        painter.drawPolyline(m_polyline.constData(), m_polyline.size());
+    }
+    // 下一段从最后一点接续
+    if (!m_polyline.isEmpty()) {
+        const QPointF last = m_polyline.last();
+        m_polyline.resize(0);
+        m_polyline.append(last);
+    }
+}
+
+QRegion CentralStationRenderer::advance(qint64 nowMs) {
+    const qint64 elapsedMs = m_lastTickMs < 0 ? 0 : qBound<qint64>(0, nowMs - m_lastTickMs, MaxTickMs);
+    m_lastTickMs = nowMs;
+    m_dirty = QRegion();
+    if (m_size.isEmpty()) return m_dirty;
+
+    if (m_layoutDirty) {
+        layout();
+    }
+
+    QPainter painter(&m_image);
+    for (Bed& bed : m_beds) {
+        // 标题栏先画：离线状态变化会使数值需要重画
+        paintHeader(painter, bed, nowMs);
+        paintNumerics(painter, bed);
+        sweep(painter, bed, elapsedMs);
+    }
+    return m_dirty;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QPolygonF>
+#include <QRegion>
+#include <QVector>
+#include <vector>
+#include "VitalSignData.h"
+#include "PolyphaseResampler.h"
+
+class QPainter;
+
+// 中央站多床位总览绘制
+// 所有床位格子画在同一张后备图像上，每个刷新周期只做增量更新：扫描波形只擦除并补画上次位置之后的一小段，
+// 标题栏（报警、离线）与数值在状态变化时重画；静态背景（边框、标签）缓存在单独的图像中，擦除即从背景复制。
+// 波形取第一导联，重采样到SweepRate后排队，按实际经过的时间匀速扫描，帧到达的抖动不影响扫描速度
+class CentralStationRenderer {
+public:
+    static constexpr int SweepRate = 100;   // 扫描采样率：每个采样一个像素
+    static constexpr int MaxBeds = 64;
+
+    CentralStationRenderer();
+
+    // 更新床位数据（nowMs为单调时钟毫秒）；新设备自动分配床位，超过MaxBeds时忽略。
+    // 没有设备ID的数据共用一个默认床位
+    void updateVitals(const VitalSignData& data, qint64 nowMs);
+    void showAlarm(const AlarmInfo& alarm, qint64 nowMs);
+    void clear();
+
+    int bedCount() const { return int(m_beds.size()); }
+    // 位置所在床位的设备ID，不在任何床位上时为空
+    QString deviceAt(const QPoint& position) const;
+
+    void resize(const QSize& size);
+    const QImage& image() const { return m_image; }
+
+    // 推进到nowMs并更新后备图像，返回本次改变的区域
+    QRegion advance(qint64 nowMs);
+
+private:
+    struct Bed {
+        QString deviceId;
+        PolyphaseResampler resampler{EcgFrame::DefaultSampleRate, SweepRate};
+        qint64 nextInputUs = -1;
+        QVector<float> pending;         // 已重采样、尚未扫描的采样
+        QVector<quint8> pendingLevel;   // 逐采样的质量等级
+        int pendingHead = 0;
+        bool sweeping = false;          // 预缓冲完成后才开始扫描
+        double sweepCredit = 0.0;       // 按经过时间累计、尚未扫描的采样数
+        int sweepX = 0;                 // 下一个采样在波形区内的横坐标
+        float lastY = 0.0f;
+        bool hasLast = false;
+        quint8 level = 0;
+
+        bool hasVitals = false;
+        int heartRate = 0;
+        int oxygenSaturation = 0;
+        double temperature = 0.0;
+        qint64 lastDataMs = -1;
+
+        QString alarmMessage;
+        int alarmSeverity = 0;
+        qint64 alarmUntilMs = 0;
+
+        int headerState = -1;           // 上次绘制的标题栏状态
+        bool headerDirty = true;
+        bool numericsDirty = true;
+        bool offline = false;
+
+        QRect tile;
+        QRect header;
+        QRect wave;
+        QRect numerics;
+    };
+
+    Bed* bedFor(const QString& deviceId);
+    void layout();
+    void paintBackground(QPainter& painter, const Bed& bed);
+    void paintHeader(QPainter& painter, Bed& bed, qint64 nowMs);
+    void paintNumerics(QPainter& painter, Bed& bed);
+    void sweep(QPainter& painter, Bed& bed, qint64 elapsedMs);
+    void restore(QPainter& painter, const QRect& rect);
+    void flushPolyline(QPainter& painter, quint8 level);
+
+    std::vector<Bed> m_beds;
+    QHash<QString, int> m_index;        // 设备ID -> 床位
+    QSize m_size;
+    QImage m_background;
+    QImage m_image;
+    bool m_layoutDirty;
+    qint64 m_lastTickMs;
+    QRegion m_dirty;
+    QFont m_headerFont;
+    QFont m_valueFont;
+    QFont m_smallFont;
+    QPolygonF m_polyline;
+};
@@ -1,8 +1,14 @@
 #include "ChartWidget.h"
+#include "PipelineMetrics.h"
+#include "RasterThreadPool.h"
 #include <QVBoxLayout>
 #include <QPainter>
+#include <QPaintEvent>
 #include <QLabel>
 #include <QDebug>
+#include <QtConcurrent>
+#include <algorithm>
+#include <utility>
 
 // ==================== ChartWidget ====================
 
@@ -12,7 +18,12 @@ ChartWidget::ChartWidget(QWidget* parent)
     , m_chartView(nullptr)
     , m_currentMode(RealTimeECG)
     , m_maxDataPoints(1000)
-    , m_currentDataCount(0)
+    , m_ecgTime(0.0)
+    , m_bucketMs(1)
+    , m_followWindowMs(0)
+    , m_followLoaded(false)
+    , m_livePaused(false)
+    , m_latestTrendUs(-1)
 {
     qDebug() << "ChartWidget: Constructor - Start";
     
@@ -145,10 +156,10 @@ void ChartWidget::setupTrendChart() {
     m_chart->setTitle(title);
 }
 
-void ChartWidget::addECGPoint(double value) {
+void ChartWidget::addECGPoint(double value, int sampleRate) {
     if (m_currentMode != RealTimeECG) return;
     
-    double timePoint = m_currentDataCount * 0.01; // 假设100Hz采样率
+    double timePoint = m_ecgTime;
     m_ecgSeries->append(timePoint, value);
     
     // 限制数据点数量
@@ -161,11 +172,11 @@ void ChartWidget::addECGPoint(double value) {
         m_ecgAxisX->setRange(minX, maxX);
     }
     
-    m_currentDataCount++;
+    m_ecgTime += 1.0 / qMax(1, sampleRate);
 }
 
 void ChartWidget::addTrendPoint(const VitalSignData& data) {
-    qint64 timestamp = data.timestamp.toMSecsSinceEpoch();
+    qint64 timestamp = data.timestampUs / 1000;
     
     m_temperatureSeries->append(timestamp, data.temperature);
     m_heartRateSeries->append(timestamp, data.heartRate);
@@ -190,17 +201,212 @@ void ChartWidget::addTrendPoint(const VitalSignData& data) {
 void ChartWidget::loadHistoryData(const QVector<VitalSignData>& historyData) {
     clearData();
     
-    for (const auto& data : historyData) {
-        addTrendPoint(data);
+    // 查询结果按时间降序
+    QVector<VitalSignData> rows = historyData;
+    std::stable_sort(rows.begin(), rows.end(), [](const VitalSignData& a, const VitalSignData& b) {
+        return a.timestampUs < b.timestampUs;
+    });
+    
+    // 跟随实时时桶长由窗口决定，实时并入的点与历史点落在同一组桶上
+    qint64 startMs = 0;
+    if (m_followWindowMs > 0) {
+        qint64 endMs = QDateTime::currentMSecsSinceEpoch();
+        if (!rows.isEmpty()) {
+            endMs = qMax(endMs, rows.last().timestampUs / 1000);
+        }
+        startMs = endMs - m_followWindowMs;
+        m_bucketMs = qMax<qint64>(1, m_followWindowMs / m_maxDataPoints);
+    } else if (!rows.isEmpty()) {
+        startMs = rows.first().timestampUs / 1000;
+        const qint64 spanMs = rows.last().timestampUs / 1000 - startMs;
+        m_bucketMs = spanMs / m_maxDataPoints + 1;
+    }
+    
+    // 整批替换序列，避免逐点触发重绘
+    QList<QPointF> temperature, heartRate, oxygen;
+    const auto flush = [&]() {
+        if (m_lastBucket.count == 0) return;
+        const double n = m_lastBucket.count;
+        temperature.append(QPointF(m_lastBucket.startMs, m_lastBucket.temperature / n));
+        heartRate.append(QPointF(m_lastBucket.startMs, m_lastBucket.heartRate / n));
+        oxygen.append(QPointF(m_lastBucket.startMs, m_lastBucket.oxygen / n));
+    };
+    for (const VitalSignData& data : std::as_const(rows)) {
+        const qint64 ms = data.timestampUs / 1000;
+        if (ms < startMs) continue;
+        const qint64 bucketStart = ms - ms % m_bucketMs;
+        if (bucketStart != m_lastBucket.startMs) {
+            flush();
+            m_lastBucket = TrendBucket();
+            m_lastBucket.startMs = bucketStart;
+        }
+        ++m_lastBucket.count;
+        m_lastBucket.temperature += data.temperature;
+        m_lastBucket.heartRate += data.heartRate;
+        m_lastBucket.oxygen += data.oxygenSaturation;
+        m_latestTrendUs = data.timestampUs;
+    }
+    flush();
+    m_temperatureSeries->replace(temperature);
+    m_heartRateSeries->replace(heartRate);
+    m_oxygenSeries->replace(oxygen);
+    
+    // 补上载入期间提交的帧（已包含在查询结果中的跳过）
+    if (m_followWindowMs > 0) {
+        m_followLoaded = true;
+        replayPendingLive(m_latestTrendUs);
+    }
+    updateTrendAxis();
+}
+
+void ChartWidget::loadTrendBuckets(const QVector<VitalTrendBucket>& buckets) {
+    clearData();
+    if (m_followWindowMs <= 0) return;
+    m_bucketMs = followBucketMs();
+    
+    qint64 endMs = QDateTime::currentMSecsSinceEpoch();
+    if (!buckets.isEmpty()) {
+        endMs = qMax(endMs, buckets.last().lastUs / 1000);
+    }
+    const qint64 startMs = endMs - m_followWindowMs;
+    
+    QList<QPointF> temperature, heartRate, oxygen;
+    for (const VitalTrendBucket& bucket : buckets) {
+        if (bucket.count <= 0 || bucket.startMs + m_bucketMs <= startMs) continue;
+        temperature.append(QPointF(bucket.startMs, bucket.temperature));
+        heartRate.append(QPointF(bucket.startMs, bucket.heartRate));
+        oxygen.append(QPointF(bucket.startMs, bucket.oxygen));
+        
+        // 最后一个桶恢复为累计值，实时帧继续并入
+        m_lastBucket.startMs = bucket.startMs;
+        m_lastBucket.count = bucket.count;
+        m_lastBucket.temperature = bucket.temperature * bucket.count;
+        m_lastBucket.heartRate = bucket.heartRate * bucket.count;
+        m_lastBucket.oxygen = bucket.oxygen * bucket.count;
+        m_latestTrendUs = qMax(m_latestTrendUs, bucket.lastUs);
+    }
+    m_temperatureSeries->replace(temperature);
+    m_heartRateSeries->replace(heartRate);
+    m_oxygenSeries->replace(oxygen);
+    
+    m_followLoaded = true;
+    replayPendingLive(m_latestTrendUs);
+    updateTrendAxis();
+}
+
+void ChartWidget::setFollowLive(bool enabled, qint64 windowMs) {
+    m_followWindowMs = enabled ? qMax<qint64>(1, windowMs) : 0;
+    m_followLoaded = false;
+    m_pendingLive.clear();
+}
+
+void ChartWidget::setLivePaused(bool paused) {
+    m_livePaused = paused;
+    if (!paused && m_followLoaded && isVisible() && !m_pendingLive.isEmpty()) {
+        replayPendingLive(-1);
+        updateTrendAxis();
+    }
+}
+
+void ChartWidget::appendCommitted(const VitalSignData& data) {
+    if (m_followWindowMs <= 0) return;
+    if (!m_followLoaded || m_livePaused || !isVisible()) {
+        if (m_pendingLive.size() >= MaxPendingLive) {
+            if (m_followLoaded) {
+                replayPendingLive(-1);
+            } else {
+                // 查询迟迟未返回时只保留最近的一部分
+                m_pendingLive.removeFirst();
+            }
+        }
+        m_pendingLive.append(data);
+        return;
+    }
+    appendTrendSample(data);
+    updateTrendAxis();
+}
+
+void ChartWidget::replayPendingLive(qint64 afterUs) {
+    const QVector<VitalSignData> pending = std::exchange(m_pendingLive, {});
+    for (const VitalSignData& data : pending) {
+        if (data.timestampUs > afterUs) {
+            appendTrendSample(data);
+        }
+    }
+}
+
+void ChartWidget::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    // 隐藏期间暂存的帧一次并入
+    if (m_followLoaded && !m_livePaused && !m_pendingLive.isEmpty()) {
+        replayPendingLive(-1);
+        updateTrendAxis();
+    }
+}
+
+void ChartWidget::appendTrendSample(const VitalSignData& data) {
+    const qint64 ms = data.timestampUs / 1000;
+    const qint64 bucketStart = ms - ms % m_bucketMs;
+    // 早于最后一个桶的帧（补传）不再并入，下次载入时计入
+    if (bucketStart < m_lastBucket.startMs) return;
+    
+    if (bucketStart == m_lastBucket.startMs) {
+        // 更新最后一个点
+        ++m_lastBucket.count;
+        m_lastBucket.temperature += data.temperature;
+        m_lastBucket.heartRate += data.heartRate;
+        m_lastBucket.oxygen += data.oxygenSaturation;
+        const double n = m_lastBucket.count;
+        const int last = m_temperatureSeries->count() - 1;
+        m_temperatureSeries->replace(last, bucketStart, m_lastBucket.temperature / n);
+        m_heartRateSeries->replace(last, bucketStart, m_lastBucket.heartRate / n);
+        m_oxygenSeries->replace(last, bucketStart, m_lastBucket.oxygen / n);
+    } else {
+        m_lastBucket = TrendBucket();
+        m_lastBucket.startMs = bucketStart;
+        m_lastBucket.count = 1;
+        m_lastBucket.temperature = data.temperature;
+        m_lastBucket.heartRate = data.heartRate;
+        m_lastBucket.oxygen = data.oxygenSaturation;
+        m_temperatureSeries->append(bucketStart, data.temperature);
+        m_heartRateSeries->append(bucketStart, data.heartRate);
+        m_oxygenSeries->append(bucketStart, data.oxygenSaturation);
+    }
+    m_latestTrendUs = qMax(m_latestTrendUs, data.timestampUs);
+    
+    // 滑出窗口的桶从头部移除，点数保持在上限附近
+    const qint64 cutoffMs = m_latestTrendUs / 1000 - m_followWindowMs;
+    int expired = 0;
+    while (expired < m_temperatureSeries->count() - 1 && m_temperatureSeries->at(expired).x() < cutoffMs) {
+        ++expired;
+    }
+    if (expired > 0) {
+        m_temperatureSeries->removePoints(0, expired);
+        m_heartRateSeries->removePoints(0, expired);
+        m_oxygenSeries->removePoints(0, expired);
     }
 }
 
+void ChartWidget::updateTrendAxis() {
+    if (m_temperatureSeries->count() == 0) return;
+    
+    qint64 maxTime = qint64(m_temperatureSeries->at(m_temperatureSeries->count() - 1).x()) + m_bucketMs;
+    qint64 minTime = qint64(m_temperatureSeries->at(0).x());
+    if (m_followWindowMs > 0) {
+        maxTime = qMax(maxTime, m_latestTrendUs / 1000);
+        minTime = maxTime - m_followWindowMs;
+    }
+    m_trendAxisX->setRange(QDateTime::fromMSecsSinceEpoch(minTime), QDateTime::fromMSecsSinceEpoch(maxTime));
+}
+
 void ChartWidget::clearData() {
     m_ecgSeries->clear();
     m_temperatureSeries->clear();
     m_heartRateSeries->clear();
     m_oxygenSeries->clear();
-    m_currentDataCount = 0;
+    m_ecgTime = 0.0;
+    m_lastBucket = TrendBucket();
+    m_latestTrendUs = -1;
 }
 
 void ChartWidget::setDisplayMode(DisplayMode mode) {
@@ -236,26 +442,80 @@ void ChartWidget::updateChart() {
 
 ECGWaveformWidget::ECGWaveformWidget(QWidget* parent)
     : QWidget(parent)
+    , m_renderer(BUFFER_SIZE)
+    , m_raster(std::make_shared<EcgGridRaster>())
+    , m_rasterBusy(false)
+    , m_rasterPending(false)
     , m_sweepSpeed(25.0)
     , m_gain(10.0)
     , m_isRunning(false)
     , m_currentPosition(0)
+    , m_minRasterIntervalMs(0)
+    , m_rasterTimer(new QTimer(this))
 {
     setMinimumSize(800, 300);
-    m_ecgBuffer.reserve(BUFFER_SIZE);
+    m_renderer.setGain(m_gain);
+    
+    m_rasterTimer->setSingleShot(true);
+    connect(m_rasterTimer, &QTimer::timeout, this, &ECGWaveformWidget::scheduleRaster);
 }
 
-void ECGWaveformWidget::addECGData(const QVector<double>& ecgSignal) {
-    for (double value : ecgSignal) {
-        m_ecgBuffer.append(value);
-        if (m_ecgBuffer.size() > BUFFER_SIZE) {
-            m_ecgBuffer.removeFirst();
+void ECGWaveformWidget::addECGData(const EcgFrame& ecgSignal, qint64 receivedAtNs,
+                                   const SignalQuality& quality) {
+    m_renderer.append(ecgSignal, quality);
+    
+    if (m_isRunning && isVisible()) {
+        if (receivedAtNs > 0) {
+            m_queuedTraces.append(receivedAtNs);
         }
+        scheduleRaster();
     }
-    
-    if (m_isRunning) {
-        update();
+}
+
+void ECGWaveformWidget::scheduleRaster() {
+    // 不可见（其他标签页）时不栅格化，重新显示时按缓冲中的最新数据补画
+    if (!m_isRunning || !isVisible() || size().isEmpty()) return;
+    if (m_rasterBusy) {
+        m_rasterPending = true;
+        return;
+    }
+    if (m_minRasterIntervalMs > 0 && m_rasterClock.isValid()) {
+        const qint64 remainingMs = m_minRasterIntervalMs - m_rasterClock.elapsed();
+        if (remainingMs > 0) {
+            if (!m_rasterTimer->isActive()) {
+                m_rasterTimer->start(int(remainingMs));
+            }
+            return;
+        }
     }
+    m_rasterClock.start();
+    m_rasterBusy = true;
+    m_rasterPending = false;
+    
+    // 截取可见数据后交给工作线程，接收可以继续写入环形缓冲
+    const QRect area = rect();
+    const qreal ratio = devicePixelRatioF();
+    const EcgGridSnapshot snapshot = m_renderer.snapshot(area);
+    const std::shared_ptr<EcgGridRaster> raster = m_raster;
+    const QVector<qint64> traces = std::exchange(m_queuedTraces, QVector<qint64>());
+    
+    QtConcurrent::run(RasterThreadPool::instance(), [raster, snapshot, area, ratio]() {
+        QImage image(area.size() * ratio, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(ratio);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        raster->paint(painter, area, snapshot);
+        return image;
+    }).then(this, [this, traces](const QImage& image) {
+        m_frame = image;
+        m_pendingPaintTraces += traces;
+        m_rasterBusy = false;
+        update();
+        if (m_rasterPending) {
+            scheduleRaster();
+        }
+    });
 }
 
 void ECGWaveformWidget::setSweepSpeed(double speed) {
@@ -264,46 +524,343 @@ void ECGWaveformWidget::setSweepSpeed(double speed) {
 
 void ECGWaveformWidget::setGain(double gain) {
     m_gain = gain;
+    m_renderer.setGain(gain);
+    scheduleRaster();
 }
 
 void ECGWaveformWidget::start() {
     m_isRunning = true;
-    update();
+    scheduleRaster();
 }
 
 void ECGWaveformWidget::stop() {
     m_isRunning = false;
+    m_rasterTimer->stop();
+    m_queuedTraces.clear();
+}
+
+void ECGWaveformWidget::setMinRasterInterval(int intervalMs) {
+    m_minRasterIntervalMs = qMax(0, intervalMs);
+    if (m_rasterTimer->isActive()) {
+        // 按新间隔重新计算
+        m_rasterTimer->stop();
+        scheduleRaster();
+    }
 }
 
 void ECGWaveformWidget::paintEvent(QPaintEvent* event) {
     Q_UNUSED(event);
     
+    // 网格背景与各导联波形已在工作线程中栅格化；尺寸变化后新图像就绪前沿用旧图像
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+    if (!m_frame.isNull()) {
+        painter.drawImage(0, 0, m_frame);
+    }
     
-    // 绘制背景网格
-    painter.setPen(QPen(Qt::lightGray, 0.5));
-    int gridSize = 20;
-    for (int x = 0; x < width(); x += gridSize) {
-        painter.drawLine(x, 0, x, height());
+    // 多帧可能合并到同一次绘制，逐帧记录
+    for (qint64 receivedAtNs : std::as_const(m_pendingPaintTraces)) {
+        PipelineMetrics::instance()->recordStage(PipelineMetrics::FirstPaint, receivedAtNs);
+    }
+    m_pendingPaintTraces.clear();
+}
+
+void ECGWaveformWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    scheduleRaster();
+}
+
+void ECGWaveformWidget::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    scheduleRaster();
+}
+
+// ==================== SpectrogramWidget ====================
+
+namespace {
+
+// 峰值参考每列下降的量（约0.5dB/秒），噪声消失后颜色逐渐恢复
+const float PeakDecayDb = 0.125f;
+const int AxisWidth = 44;
+
+} // namespace
+
+SpectrogramWidget::SpectrogramWidget(QWidget* parent)
+    : QWidget(parent)
+    , m_stft(EcgFrame::DefaultSampleRate)
+    , m_nextInputUs(-1)
+    , m_writeColumn(0)
+    , m_filledColumns(0)
+    , m_peakDb(0.0f)
+    , m_repaintIntervalMs(0)
+    , m_repaintTimer(new QTimer(this))
+{
+    setMinimumSize(400, 160);
+    m_repaintTimer->setSingleShot(true);
+    connect(m_repaintTimer, &QTimer::timeout, this, [this]() {
+        update(plotRect());
+    });
+    
+    // 黑-蓝-青-黄-红
+    const QColor stops[] = {Qt::black, QColor(0, 0, 160), QColor(0, 200, 220), QColor(255, 230, 0), QColor(230, 0, 0)};
+    const int segments = int(sizeof(stops) / sizeof(stops[0])) - 1;
+    m_palette.resize(256);
+    for (int i = 0; i < 256; ++i) {
+        const double position = i / 255.0 * segments;
+        const int segment = qMin(int(position), segments - 1);
+        const double t = position - segment;
+        const QColor& a = stops[segment];
+        const QColor& b = stops[segment + 1];
+        m_palette[i] = qRgb(int(a.red() + (b.red() - a.red()) * t),
+                            int(a.green() + (b.green() - a.green()) * t),
+                            int(a.blue() + (b.blue() - a.blue()) * t));
     }
-    for (int y = 0; y < height(); y += gridSize) {
-        painter.drawLine(0, y, width(), y);
+    resetStream(EcgFrame::DefaultSampleRate);
+}
+
+void SpectrogramWidget::setDeviceId(const QString& deviceId) {
+    if (deviceId == m_deviceId) return;
+    m_deviceId = deviceId;
+    m_followedDevice.clear();
+    resetStream(m_stft.sampleRate());
+    update();
+}
+
+void SpectrogramWidget::resetStream(int sampleRate) {
+    if (sampleRate != m_stft.sampleRate()) {
+        m_stft = StftAnalyzer(sampleRate);
+    } else {
+        m_stft.reset();
+    }
+    m_nextInputUs = -1;
+    m_image = QImage(ColumnCount, m_stft.binCount(), QImage::Format_RGB32);
+    m_image.fill(m_palette.first());
+    m_writeColumn = 0;
+    m_filledColumns = 0;
+}
+
+void SpectrogramWidget::addECGData(const QString& deviceId, const EcgFrame& ecgSignal) {
+    if (ecgSignal.isEmpty()) return;
+    if (m_followedDevice.isEmpty()) {
+        if (!m_deviceId.isEmpty() && deviceId != m_deviceId) return;
+        m_followedDevice = deviceId;
+    } else if (deviceId != m_followedDevice) {
+        return;
     }
     
-    // 绘制ECG波形
-    if (m_ecgBuffer.isEmpty()) return;
+    // 采样率变化时重新开始；缺口只清空窗内历史，已有的列保留
+    if (ecgSignal.sampleRate() != m_stft.sampleRate()) {
+        resetStream(ecgSignal.sampleRate());
+    } else if (m_nextInputUs >= 0 && ecgSignal.timestampUs() != 0 &&
+               qAbs(ecgSignal.timestampUs() - m_nextInputUs) > 500000 / qMax(1, ecgSignal.sampleRate())) {
+        m_stft.reset();
+    }
+    if (ecgSignal.timestampUs() != 0) {
+        m_nextInputUs = ecgSignal.timestampUs() + qint64(ecgSignal.durationSeconds() * 1e6);
+    }
     
-    painter.setPen(QPen(Qt::green, 2));
+    m_columns.resize(0);
+    const int count = m_stft.process(ecgSignal.constData(), ecgSignal.size(), m_columns);
+    for (int i = 0; i < count; ++i) {
+        appendColumn(m_columns.constData() + i * m_stft.binCount());
+    }
+    // 不可见时不安排重绘，重新显示时整体重绘
+    if (count > 0 && isVisible() && !m_repaintTimer->isActive()) {
+        if (m_repaintIntervalMs > 0) {
+            m_repaintTimer->start(m_repaintIntervalMs);
+        } else {
+            update(plotRect());
+        }
+    }
+}
+
+void SpectrogramWidget::setRepaintInterval(int intervalMs) {
+    m_repaintIntervalMs = qMax(0, intervalMs);
+}
+
+void SpectrogramWidget::appendColumn(const float* column) {
+    const int bins = m_stft.binCount();
+    float columnPeak = column[0];
+    for (int k = 1; k < bins; ++k) {
+        columnPeak = qMax(columnPeak, column[k]);
+    }
+    m_peakDb = m_filledColumns == 0 ? columnPeak : qMax(columnPeak, m_peakDb - PeakDecayDb);
+    
+    // 只着色新的一列，第0行为最高频率
+    const float floorDb = m_peakDb - DynamicRangeDb;
+    const float scale = 255.0f / DynamicRangeDb;
+    for (int k = 0; k < bins; ++k) {
+        const int level = qBound(0, int((column[k] - floorDb) * scale), 255);
+        reinterpret_cast<QRgb*>(m_image.scanLine(bins - 1 - k))[m_writeColumn] = m_palette[level];
+    }
+    m_writeColumn = (m_writeColumn + 1) % ColumnCount;
+    m_filledColumns = qMin(m_filledColumns + 1, ColumnCount);
+}
+
+QRect SpectrogramWidget::plotRect() const {
+    return rect().adjusted(AxisWidth, 4, -4, -4);
+}
+
+void SpectrogramWidget::paintEvent(QPaintEvent* event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    
+    // 环形图像：m_writeColumn起为较旧的一段，之前为较新的一段
+    const QRect plot = plotRect();
+    const double columnWidth = double(plot.width()) / ColumnCount;
+    const int older = ColumnCount - m_writeColumn;
+    const QRectF olderTarget(plot.left(), plot.top(), older * columnWidth, plot.height());
+    const QRectF newerTarget(olderTarget.right(), plot.top(), m_writeColumn * columnWidth, plot.height());
+    painter.drawImage(olderTarget, m_image, QRectF(m_writeColumn, 0, older, m_image.height()));
+    if (m_writeColumn > 0) {
+        painter.drawImage(newerTarget, m_image, QRectF(0, 0, m_writeColumn, m_image.height()));
+    }
     
-    int centerY = height() / 2;
-    double scaleX = width() / static_cast<double>(qMin(m_ecgBuffer.size(), width()));
+    // 频率轴
+    const double nyquist = m_stft.sampleRate() / 2.0;
+    const int step = nyquist > 100.0 ? 25 : 10;
+    painter.setPen(Qt::lightGray);
+    QFont font = painter.font();
+    font.setPointSize(8);
+    painter.setFont(font);
+    for (int hz = 0; hz <= nyquist; hz += step) {
+        const int y = plot.bottom() - int(hz / nyquist * plot.height());
+        painter.drawLine(plot.left() - 4, y, plot.left(), y);
+        painter.drawText(QRect(0, y - 8, AxisWidth - 6, 16), Qt::AlignRight | Qt::AlignVCenter,
+                         QString("%1Hz").arg(hz));
+    }
+    if (!m_followedDevice.isEmpty()) {
+        painter.drawText(plot.adjusted(6, 2, -6, -2), Qt::AlignTop | Qt::AlignLeft, m_followedDevice);
+    }
+}
+
+// ==================== CentralStationWidget ====================
+
+CentralStationWidget::CentralStationWidget(QWidget* parent)
+    : QWidget(parent)
+    , m_renderer(std::make_shared<CentralStationRenderer>())
+    , m_rasterBusy(false)
+    , m_resizePending(false)
+    , m_refreshTimer(new QTimer(this))
+    , m_refreshIntervalMs(RefreshIntervalMs)
+{
+    // 每次绘制都从不透明的后备图像复制，不需要先擦除背景
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(640, 360);
+    m_clock.start();
     
-    for (int i = 1; i < m_ecgBuffer.size() && i < width(); ++i) {
-        double y1 = centerY - m_ecgBuffer[i - 1] * m_gain;
-        double y2 = centerY - m_ecgBuffer[i] * m_gain;
-        painter.drawLine(QPointF((i - 1) * scaleX, y1), QPointF(i * scaleX, y2));
+    m_refreshTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_refreshTimer, &QTimer::timeout, this, &CentralStationWidget::refresh);
+}
+
+void CentralStationWidget::updateVitals(const VitalSignData& data) {
+    const qint64 nowMs = m_clock.elapsed();
+    // 隐藏或暂停刷新时不栅格化，每床只保留最新一帧，等显示或恢复刷新时一并交给渲染器
+    if (!m_refreshTimer->isActive()) {
+        for (auto& queued : m_queuedVitals) {
+            if (queued.second.deviceId == data.deviceId) {
+                queued = qMakePair(nowMs, data);
+                return;
+            }
+        }
     }
+    m_queuedVitals.append(qMakePair(nowMs, data));
+}
+
+void CentralStationWidget::showAlarm(const AlarmInfo& alarm) {
+    m_queuedAlarms.append(qMakePair(m_clock.elapsed(), alarm));
+}
+
+void CentralStationWidget::setRefreshInterval(int intervalMs) {
+    m_refreshIntervalMs = qMax(0, intervalMs);
+    if (m_refreshIntervalMs == 0) {
+        m_refreshTimer->stop();
+    } else if (isVisible()) {
+        m_refreshTimer->start(m_refreshIntervalMs);
+    }
+}
+
+void CentralStationWidget::refresh() {
+    // 上一周期的任务未完成时跳过，下一周期按实际经过时间补扫
+    if (m_rasterBusy) return;
+    m_rasterBusy = true;
+    
+    const std::shared_ptr<CentralStationRenderer> renderer = m_renderer;
+    const auto vitals = std::exchange(m_queuedVitals, {});
+    const auto alarms = std::exchange(m_queuedAlarms, {});
+    const QSize area = size();
+    const qint64 nowMs = m_clock.elapsed();
+    
+    QtConcurrent::run(RasterThreadPool::instance(), [renderer, vitals, alarms, area, nowMs]() {
+        for (const auto& vital : vitals) {
+            renderer->updateVitals(vital.second, vital.first);
+        }
+        for (const auto& alarm : alarms) {
+            renderer->showAlarm(alarm.second, alarm.first);
+        }
+        renderer->resize(area);
+        return renderer->advance(nowMs);
+    }).then(this, [this](const QRegion& dirty) {
+        // 任务已结束，此时可以在GUI线程读取渲染器的图像
+        m_rasterBusy = false;
+        if (m_resizePending) {
+            // 任务进行中改变了尺寸；定时刷新停止时没有下一周期，在这里补一次
+            m_resizePending = false;
+            if (!m_refreshTimer->isActive()) {
+                QTimer::singleShot(0, this, &CentralStationWidget::refresh);
+            }
+        }
+        const QImage& image = m_renderer->image();
+        if (m_frame.size() != image.size()) {
+            m_frame = image.copy();
+            update();
+            return;
+        }
+        if (dirty.isEmpty()) return;
+        
+        QPainter painter(&m_frame);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const QRect& rect : dirty) {
+            painter.drawImage(rect.topLeft(), image, rect);
+        }
+        painter.end();
+        update(dirty);
+    });
+}
+
+void CentralStationWidget::paintEvent(QPaintEvent* event) {
+    QPainter painter(this);
+    if (m_frame.size() != size()) {
+        painter.fillRect(event->rect(), Qt::black);
+    }
+    if (m_frame.isNull()) return;
+    for (const QRect& rect : event->region()) {
+        painter.drawImage(rect.topLeft(), m_frame, rect);
+    }
+}
+
+void CentralStationWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    // 渲染器只在栅格化任务中访问，新尺寸随下一次任务传入；隐藏时等showEvent再栅格化
+    if (!isVisible()) return;
+    if (m_rasterBusy) {
+        m_resizePending = true;
+        return;
+    }
+    refresh();
+}
+
+void CentralStationWidget::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    refresh();
+    if (m_refreshIntervalMs > 0) {
+        m_refreshTimer->start(m_refreshIntervalMs);
+    }
+}
+
+void CentralStationWidget::hideEvent(QHideEvent* event) {
+    QWidget::hideEvent(event);
+    m_refreshTimer->stop();
 }
 
 // ==================== VitalSignPanel ====================
@@ -7,7 +7,13 @@
 #include <QtCharts/QValueAxis>
 #include <QtCharts/QDateTimeAxis>
 #include <QLabel>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <memory>
 #include "VitalSignData.h"
+#include "EcgGridRenderer.h"
+#include "CentralStationRenderer.h"
+#include "StftAnalyzer.h"
 
 class ChartWidget : public QWidget {
     Q_OBJECT
@@ -16,15 +22,31 @@ public:
     explicit ChartWidget(QWidget* parent = nullptr);
     ~ChartWidget();
 
-    // 添加实时ECG波形数据点
-    void addECGPoint(double value);
+    // 添加实时ECG波形数据点（sampleRate为该点所属信号的采样率）
+    void addECGPoint(double value, int sampleRate = EcgFrame::DefaultSampleRate);
     
     // 添加实时趋势数据
     void addTrendPoint(const VitalSignData& data);
     
     // 加载历史数据显示趋势图
+    // 按固定时长的时间桶取平均（桶边界按绝对时间对齐），点数不超过上限
     void loadHistoryData(const QVector<VitalSignData>& historyData);
     
+    // 跟随实时：趋势窗口（windowMs）随最新数据滑动，新提交的帧并入最后一个时间桶或开启新桶，
+    // 滑出窗口的点从头部移除，每帧的代价与新增点数成正比。
+    // 开启后到下一次loadHistoryData之前提交的帧先暂存，载入后补上，查询与载入之间的数据不丢失
+    void setFollowLive(bool enabled, qint64 windowMs = 0);
+    bool isFollowingLive() const { return m_followWindowMs > 0; }
+    qint64 followBucketMs() const { return qMax<qint64>(1, m_followWindowMs / m_maxDataPoints); }
+    
+    // 载入跟随窗口的历史趋势：数据库按followBucketMs()聚合好的时间桶（按时间升序），
+    // 长窗口不受查询条数上限影响；暂存的帧与loadHistoryData一样在载入后补上
+    void loadTrendBuckets(const QVector<VitalTrendBucket>& buckets);
+    
+    // 暂停跟随实时的绘制（应用在后台）。暂停或不可见（其他标签页）时提交的帧先暂存，
+    // 恢复或重新显示时一次并入；暂存达到上限时提前并入，内存有界
+    void setLivePaused(bool paused);
+    
     // 清除所有数据
     void clearData();
     
@@ -43,10 +65,26 @@ public:
     // 设置X轴时间范围（秒）
     void setTimeRange(int seconds);
 
+public slots:
+    // 数据库提交的一帧（跟随实时时并入趋势）
+    void appendCommitted(const VitalSignData& data);
+
 signals:
     void chartClicked(const QPointF& point);
 
+protected:
+    void showEvent(QShowEvent* event) override;
+
 private:
+    // 一个时间桶内各参数的累计
+    struct TrendBucket {
+        qint64 startMs = -1;
+        int count = 0;
+        double temperature = 0.0;
+        double heartRate = 0.0;
+        double oxygen = 0.0;
+    };
+
     QChartView* m_chartView;
     QChart* m_chart;
     
@@ -64,7 +102,22 @@ private:
     
     DisplayMode m_currentMode;
     int m_maxDataPoints;
-    int m_currentDataCount;
+    double m_ecgTime;           // 下一个ECG点的横坐标 (秒)
+    
+    // 历史趋势的时间桶
+    qint64 m_bucketMs;
+    TrendBucket m_lastBucket;           // 最后一个点所在的桶（跟随实时时继续累计）
+    qint64 m_followWindowMs;            // 0表示不跟随
+    bool m_followLoaded;                // 已载入跟随窗口的历史数据
+    bool m_livePaused;
+    qint64 m_latestTrendUs;             // 已并入的最新一帧
+    QVector<VitalSignData> m_pendingLive;
+    static constexpr int MaxPendingLive = 10000;
+    
+    void appendTrendSample(const VitalSignData& data);
+    // 并入暂存的帧（afterUs及更早的跳过）
+    void replayPendingLive(qint64 afterUs);
+    void updateTrendAxis();
     
     // 初始化图表
     void initializeChart();
@@ -75,15 +128,19 @@ private:
     void updateChart();
 };
 
-// ECG波形显示组件
+// ECG波形显示组件（多导联帧按网格显示全部导联）
+// 接收在GUI线程，栅格化在RasterThreadPool中进行，paintEvent只复制最近一次的结果图像；
+// 同一时刻最多一个栅格化任务，期间到达的数据合并到下一次
 class ECGWaveformWidget : public QWidget {
     Q_OBJECT
 
 public:
     explicit ECGWaveformWidget(QWidget* parent = nullptr);
     
-    // 添加ECG数据
-    void addECGData(const QVector<double>& ecgSignal);
+    // 添加ECG数据（receivedAtNs用于统计接收到首次绘制的延迟）
+    // quality为该帧的信号质量，质量差的波形段以不同颜色显示
+    void addECGData(const EcgFrame& ecgSignal, qint64 receivedAtNs = 0,
+                    const SignalQuality& quality = SignalQuality());
     
     // 设置显示速度 (mm/s)
     void setSweepSpeed(double speed);
@@ -91,23 +148,123 @@ public:
     // 设置增益
     void setGain(double gain);
     
-    // 启动/停止显示
+    // 启动/停止显示（停止期间数据照常进入缓冲，不栅格化）
     void start();
     void stop();
+    
+    // 两次栅格化的最小间隔（低刷新率），期间到达的数据合并到下一次；0表示每帧
+    void setMinRasterInterval(int intervalMs);
+    
+    // 显示采样率：每个采样占一个像素，各种设备采样率都先重采样到此
+    static constexpr int DisplayRate = EcgGridRenderer::DisplayRate;
 
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void showEvent(QShowEvent* event) override;
 
 private:
-    QVector<double> m_ecgBuffer;
+    void scheduleRaster();
+    
+    EcgGridRenderer m_renderer;
+    std::shared_ptr<EcgGridRaster> m_raster;   // 背景缓存，只在栅格化任务中使用
+    QImage m_frame;                 // 最近一次栅格化的结果
+    bool m_rasterBusy;
+    bool m_rasterPending;           // 任务进行中又有新数据
     double m_sweepSpeed;
     double m_gain;
     bool m_isRunning;
     int m_currentPosition;
+    int m_minRasterIntervalMs;
+    QElapsedTimer m_rasterClock;    // 上一次栅格化开始
+    QTimer* m_rasterTimer;          // 间隔未到时推迟的栅格化
+    QVector<qint64> m_queuedTraces;       // 尚未栅格化的帧接收时刻
+    QVector<qint64> m_pendingPaintTraces; // 已栅格化、等待首次绘制的帧接收时刻
     
     static constexpr int BUFFER_SIZE = 5000;
 };
 
+// 滚动频谱图：用于判断工频干扰、肌电等噪声来源
+// 一台设备第一导联的StftAnalyzer输出逐列写入环形图像（横轴时间，纵轴0~采样率/2），每列只在产生时着色一次，
+// 绘制时把环形图像按新旧两段拼接，最新一列在右端。颜色按最近的峰值向下DynamicRangeDb映射
+class SpectrogramWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit SpectrogramWidget(QWidget* parent = nullptr);
+    
+    // 只显示指定设备的频谱；为空时跟随第一台发来数据的设备
+    void setDeviceId(const QString& deviceId);
+    
+    void addECGData(const QString& deviceId, const EcgFrame& ecgSignal);
+    
+    // 两次重绘的最小间隔，0表示每帧；频谱照常计算，只合并重绘
+    void setRepaintInterval(int intervalMs);
+    
+    static constexpr int ColumnCount = 480;             // 跳步为1/4窗长时约2分钟
+    static constexpr float DynamicRangeDb = 50.0f;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    void resetStream(int sampleRate);
+    void appendColumn(const float* column);
+    QRect plotRect() const;
+    
+    QString m_deviceId;
+    QString m_followedDevice;       // 实际显示的设备
+    StftAnalyzer m_stft;
+    qint64 m_nextInputUs;           // 下一帧预期的起始时间，用于发现缺口
+    QVector<float> m_columns;
+    QImage m_image;                 // 环形：每列一个STFT输出，第0行为最高频率
+    int m_writeColumn;
+    int m_filledColumns;
+    float m_peakDb;
+    QVector<QRgb> m_palette;
+    int m_repaintIntervalMs;
+    QTimer* m_repaintTimer;
+};
+
+// 中央站多床位总览
+// 全部床位由一个共享的CentralStationRenderer画到同一张后备图像上。每个刷新周期（25帧/秒）把期间收到的数据
+// 交给RasterThreadPool中的任务处理（重采样与增量绘制），完成后GUI线程只把变化的区域复制到前台图像和屏幕；
+// 上一周期的任务未完成时跳过本周期。不可见或刷新周期为0（后台）时停止定时刷新，期间每床只保留最新一帧
+class CentralStationWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit CentralStationWidget(QWidget* parent = nullptr);
+    
+    void updateVitals(const VitalSignData& data);
+    void showAlarm(const AlarmInfo& alarm);
+    
+    // 刷新周期（低功耗时降低帧率），0表示暂停定时刷新
+    void setRefreshInterval(int intervalMs);
+    
+    static constexpr int RefreshIntervalMs = 40;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private slots:
+    void refresh();
+
+private:
+    std::shared_ptr<CentralStationRenderer> m_renderer;    // 只在栅格化任务中访问
+    QVector<QPair<qint64, VitalSignData>> m_queuedVitals;   // (接收时刻ms, 数据)
+    QVector<QPair<qint64, AlarmInfo>> m_queuedAlarms;
+    QImage m_frame;                 // 前台图像，只在GUI线程访问
+    bool m_rasterBusy;
+    bool m_resizePending;           // 栅格化任务进行中改变了尺寸，任务结束后补一次刷新
+    QTimer* m_refreshTimer;
+    int m_refreshIntervalMs;
+    QElapsedTimer m_clock;
+};
+
 // 多参数显示面板
 class VitalSignPanel : public QWidget {
     Q_OBJECT
@@ -1,4 +1,5 @@
 #include "CloudSyncManager.h"
+#include "PipelineMetrics.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -12,6 +13,9 @@ CloudSyncManager::CloudSyncManager(QObject* parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
     , m_autoSyncTimer(new QTimer(this))
+    , m_batchTimer(new QTimer(this))
+    , m_batchFrames(1)
+    , m_batchDelayMs(0)
     , m_isLoggedIn(false)
 {
     connect(m_networkManager, &QNetworkAccessManager::finished,
@@ -19,6 +23,13 @@ CloudSyncManager::CloudSyncManager(QObject* parent)
     
     connect(m_autoSyncTimer, &QTimer::timeout,
             this, &CloudSyncManager::onAutoSyncTriggered);
+    
+    m_batchTimer->setSingleShot(true);
+    connect(m_batchTimer, &QTimer::timeout, this, [this]() {
+        if (m_isLoggedIn) {
+            processUploadQueue();
+        }
+    });
 }
 
 CloudSyncManager::~CloudSyncManager() {
@@ -79,11 +90,23 @@ void CloudSyncManager::uploadVitalSign(const VitalSignData& data) {
         return;
     }
     
+    if (m_batchFrames > 1) {
+        addToUploadQueue(data);
+        if (m_uploadQueue.size() >= m_batchFrames) {
+            processUploadQueue();
+        } else if (!m_batchTimer->isActive()) {
+            // 从最早一帧起计时，期间到达的帧不推迟上传
+            m_batchTimer->start(m_batchDelayMs);
+        }
+        return;
+    }
+    
     QJsonObject jsonData = data.toJson();
     jsonData["deviceId"] = m_deviceId;
     
     QNetworkRequest request = buildRequest("/api/vitalsign/upload");
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setAttribute(QNetworkRequest::User, data.receivedAtNs);
     
     QJsonDocument doc(jsonData);
     m_networkManager->post(request, doc.toJson());
@@ -100,8 +123,13 @@ void CloudSyncManager::uploadVitalSignBatch(const QVector<VitalSignData>& dataLi
     }
     
     QJsonArray dataArray;
+    qint64 oldestReceivedAtNs = 0;
     for (const auto& data : dataList) {
         dataArray.append(data.toJson());
+        if (data.receivedAtNs > 0 &&
+            (oldestReceivedAtNs == 0 || data.receivedAtNs < oldestReceivedAtNs)) {
+            oldestReceivedAtNs = data.receivedAtNs;
+        }
     }
     
     QJsonObject batchData;
@@ -110,6 +138,8 @@ void CloudSyncManager::uploadVitalSignBatch(const QVector<VitalSignData>& dataLi
     
     QNetworkRequest request = buildRequest("/api/vitalsign/batch");
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    // 批量上传以最早一帧计延迟
+    request.setAttribute(QNetworkRequest::User, oldestReceivedAtNs);
     
     QJsonDocument doc(batchData);
     m_networkManager->post(request, doc.toJson());
@@ -140,6 +170,14 @@ void CloudSyncManager::enableAutoSync(bool enable, int intervalMinutes) {
     }
 }
 
+void CloudSyncManager::setUploadBatching(int maxFrames, int maxDelayMs) {
+    m_batchFrames = qMax(1, maxFrames);
+    m_batchDelayMs = qMax(0, maxDelayMs);
+    if (m_batchFrames <= 1 && m_isLoggedIn && !m_uploadQueue.isEmpty()) {
+        processUploadQueue();
+    }
+}
+
 void CloudSyncManager::syncNow() {
     if (!m_isLoggedIn) {
         emit errorOccurred("请先登录");
@@ -246,6 +284,8 @@ void CloudSyncManager::onDownloadFinished(QNetworkReply* reply) {
 
 void CloudSyncManager::handleUploadResponse(QNetworkReply* reply) {
     if (reply->error() == QNetworkReply::NoError) {
+        qint64 receivedAtNs = reply->request().attribute(QNetworkRequest::User).toLongLong();
+        PipelineMetrics::instance()->recordStage(PipelineMetrics::CloudAck, receivedAtNs);
         emit uploadCompleted(true);
         emit syncStatusChanged("上传成功");
         qDebug() << "Data uploaded successfully";
@@ -275,9 +315,11 @@ void CloudSyncManager::handleDownloadResponse(QNetworkReply* reply) {
 
 void CloudSyncManager::addToUploadQueue(const VitalSignData& data) {
     m_uploadQueue.append(data);
+    PipelineMetrics::instance()->setQueueDepth("cloud_upload", m_uploadQueue.size());
 }
 
 void CloudSyncManager::processUploadQueue() {
+    m_batchTimer->stop();
     if (m_uploadQueue.isEmpty()) {
         emit syncStatusChanged("无待上传数据");
         return;
@@ -285,6 +327,7 @@ void CloudSyncManager::processUploadQueue() {
     
     uploadVitalSignBatch(m_uploadQueue);
     m_uploadQueue.clear();
+    PipelineMetrics::instance()->setQueueDepth("cloud_upload", 0);
 }
 
 void CloudSyncManager::onAutoSyncTriggered() {
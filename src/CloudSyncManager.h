@@ -30,6 +30,10 @@ public:
     // 自动同步设置
     void enableAutoSync(bool enable, int intervalMinutes = 5);
     
+    // 上传合并（电池/后台时减少网络唤醒）：maxFrames > 1时uploadVitalSign先进入队列，
+    // 攒满maxFrames帧或最早一帧等待maxDelayMs后批量上传；maxFrames <= 1时立即上传队列中的数据
+    void setUploadBatching(int maxFrames, int maxDelayMs);
+    
     // 手动触发同步
     void syncNow();
     
@@ -68,6 +72,9 @@ private slots:
 private:
     QNetworkAccessManager* m_networkManager;
     QTimer* m_autoSyncTimer;
+    QTimer* m_batchTimer;
+    int m_batchFrames;
+    int m_batchDelayMs;
     
     QString m_serverUrl;
     QString m_apiKey;
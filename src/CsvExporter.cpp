@@ -0,0 +1,219 @@
+#include "CsvExporter.h"
+#include "DatabaseManager.h"
+#include "WaveformStore.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <cmath>
+
+namespace {
+
+const int WriteBufferBytes = 1 << 20;
+
+void appendInteger(QByteArray& out, qint64 value) {
+    char digits[24];
+    int count = 0;
+    quint64 magnitude = value < 0 ? quint64(-(value + 1)) + 1 : quint64(value);
+    do {
+        digits[count++] = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) out.append('-');
+    while (count > 0) out.append(digits[--count]);
+}
+
+// 定点格式化（去掉末尾的0），不受系统区域设置影响且不分配内存。
+// NaN、无穷大或超出qint64范围的值写为空字段
+void appendFixed(QByteArray& out, double value, int decimals) {
+    static const qint64 scales[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    const qint64 scale = scales[decimals];
+    if (!std::isfinite(value) || std::fabs(value * scale) >= 9.2e18) return;
+    qint64 scaled = qRound64(value * scale);
+    if (scaled < 0) {
+        out.append('-');
+        scaled = -scaled;
+    }
+    appendInteger(out, scaled / scale);
+
+    qint64 fraction = scaled % scale;
+    if (fraction == 0) return;
+    char digits[8];
+    for (int i = decimals - 1; i >= 0; --i) {
+        digits[i] = char('0' + fraction % 10);
+        fraction /= 10;
+    }
+    int length = decimals;
+    while (length > 0 && digits[length - 1] == '0') --length;
+    out.append('.');
+    out.append(digits, length);
+}
+
+void appendField(QByteArray& out, const QString& text) {
+    const QByteArray utf8 = text.toUtf8();
+    if (!utf8.contains(',') && !utf8.contains('"') && !utf8.contains('\n')) {
+        out.append(utf8);
+        return;
+    }
+    out.append('"');
+    for (char c : utf8) {
+        if (c == '"') out.append('"');
+        out.append(c);
+    }
+    out.append('"');
+}
+
+} // namespace
+
+CsvExporter::CsvExporter(const QString& dbPath, WaveformStore* waveformStore, QObject* parent)
+    : FileExporter(dbPath, waveformStore, parent)
+{
+}
+
+CsvExporter::~CsvExporter() {
+    stopThread();
+}
+
+bool CsvExporter::start(const Options& options) {
+    return startThread([this, options]() { exportRows(options); });
+}
+
+bool CsvExporter::exportNow(const Options& options) {
+    m_cancelled = false;
+    return exportRows(options);
+}
+
+bool CsvExporter::exportRows(const Options& options) {
+    return exportFile(options.filePath, "CSV", [this, &options](QSqlDatabase& db, QFile& file, qint64& rows) {
+        return writeRows(db, file, options, rows);
+    });
+}
+
+QString CsvExporter::writeRows(QSqlDatabase& db, QFile& file, const Options& options, qint64& rows) {
+    const bool withWaveform = options.waveform != NoWaveform;
+
+    QSqlQuery query(db);
+    // 只进游标逐行取数，不缓存整个结果集
+    query.setForwardOnly(true);
+    QString sql = QString(R"(
+        SELECT timestamp, temperature, oxygen_saturation, heart_rate, device_id,
+               wave_segment, wave_offset%1
+        FROM vital_signs
+        WHERE timestamp BETWEEN :start AND :end%2
+        ORDER BY timestamp ASC
+    )").arg(withWaveform ? ", ecg_signal" : "",
+            options.deviceId.isEmpty() ? "" : " AND device_id = :device_id");
+    query.prepare(sql);
+    query.bindValue(":start", options.startTime);
+    query.bindValue(":end", options.endTime);
+    if (!options.deviceId.isEmpty()) {
+        query.bindValue(":device_id", options.deviceId);
+    }
+    if (!query.exec()) {
+        return "查询数据失败: " + query.lastError().text();
+    }
+
+    QByteArray out;
+    out.reserve(WriteBufferBytes + 64 * 1024);
+    out.append("时间戳,体温(°C),血氧(%),心率(bpm),设备ID");
+    switch (options.waveform) {
+        case LongLayout: out.append(",采样偏移(s),ECG(mV)"); break;
+        case WideLayout: out.append(",采样率(Hz),ECG采样(mV)..."); break;
+        case NoWaveform: break;
+    }
+    out.append('\n');
+
+    const qint64 startMs = options.startTime.toMSecsSinceEpoch();
+    const qint64 spanMs = qMax<qint64>(1, options.endTime.toMSecsSinceEpoch() - startMs);
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+
+    QByteArray prefix;
+    while (query.next()) {
+        if (m_cancelled) {
+            return "导出已取消";
+        }
+
+        const QDateTime timestamp = query.value(0).toDateTime();
+        const QString deviceId = query.value(4).toString();
+
+        prefix.resize(0);
+        prefix.append(timestamp.toString("yyyy-MM-dd hh:mm:ss").toLatin1());
+        prefix.append(',');
+        appendFixed(prefix, query.value(1).toDouble(), 2);
+        prefix.append(',');
+        appendInteger(prefix, query.value(2).toInt());
+        prefix.append(',');
+        appendInteger(prefix, query.value(3).toInt());
+        prefix.append(',');
+        appendField(prefix, deviceId);
+
+        EcgFrame frame;
+        if (withWaveform) {
+            WaveformLocation location;
+            location.segment = query.value(5).toString();
+            location.offset = query.value(6).isNull() ? -1 : query.value(6).toLongLong();
+            if (location.isValid() && m_waveformStore) {
+                frame = m_waveformStore->read(location, deviceId);
+            } else {
+                // 旧数据：波形以JSON保存在ecg_signal列
+                const QByteArray legacy = query.value(7).toByteArray();
+                VitalSignData data;
+                if (!legacy.isEmpty() && VitalSignData::parse(legacy, data, deviceId)) {
+                    frame = data.ecgSignal;
+                } else if (!legacy.isEmpty()) {
+                    frame = VitalSignData::fromJson(QJsonDocument::fromJson(legacy).object()).ecgSignal;
+                }
+            }
+        }
+
+        if (options.waveform == LongLayout && !frame.isEmpty()) {
+            const double interval = 1.0 / qMax(1, frame.sampleRate());
+            for (int i = 0; i < frame.size(); ++i) {
+                out.append(prefix);
+                out.append(',');
+                appendFixed(out, i * interval, 4);
+                out.append(',');
+                appendFixed(out, frame[i], 6);
+                out.append('\n');
+            }
+        } else {
+            out.append(prefix);
+            if (options.waveform == LongLayout) {
+                out.append(",,");
+            } else if (options.waveform == WideLayout) {
+                out.append(',');
+                appendInteger(out, frame.sampleRate());
+                for (float value : frame) {
+                    out.append(',');
+                    appendFixed(out, value, 6);
+                }
+            }
+            out.append('\n');
+        }
+        rows++;
+
+        if (out.size() >= WriteBufferBytes) {
+            if (file.write(out) != out.size()) {
+                return "写入CSV文件失败: " + file.errorString();
+            }
+            out.resize(0);   // 保留容量
+        }
+
+        if (progressTimer.elapsed() >= 100) {
+            progressTimer.restart();
+            const int percent = int(qBound<qint64>(0, (timestamp.toMSecsSinceEpoch() - startMs) * 100 / spanMs, 100));
+            emit progress(rows, percent);
+        }
+    }
+
+    if (!out.isEmpty() && file.write(out) != out.size()) {
+        return "写入CSV文件失败: " + file.errorString();
+    }
+    if (!file.flush()) {
+        return "写入CSV文件失败: " + file.errorString();
+    }
+    emit progress(rows, 100);
+    return QString();
+}
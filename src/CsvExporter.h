@@ -0,0 +1,38 @@
+#pragma once
+#include <QDateTime>
+#include "FileExporter.h"
+
+// 流式CSV导出
+// 使用独立的数据库连接按时间升序逐行读取（只进游标），经缓冲写入文件，内存占用与时间范围无关；
+// start()在工作线程中运行，exportNow()在调用线程中同步运行；progress/finished的count为已导出行数
+class CsvExporter : public FileExporter {
+    Q_OBJECT
+
+public:
+    enum WaveformLayout {
+        NoWaveform,     // 仅生理参数，每帧一行
+        LongLayout,     // 每个采样一行（参数随采样重复），便于分析工具直接读取
+        WideLayout      // 每帧一行，采样依次排在参数之后
+    };
+
+    struct Options {
+        QString filePath;
+        QDateTime startTime;
+        QDateTime endTime;
+        QString deviceId;                       // 为空则导出全部设备
+        WaveformLayout waveform = NoWaveform;
+    };
+
+    CsvExporter(const QString& dbPath, WaveformStore* waveformStore, QObject* parent = nullptr);
+    ~CsvExporter();
+
+    // 在工作线程中导出，已有导出在运行时返回false
+    bool start(const Options& options);
+    // 在当前线程同步导出
+    bool exportNow(const Options& options);
+
+private:
+    bool exportRows(const Options& options);
+    // 返回错误信息，成功时为空
+    QString writeRows(QSqlDatabase& db, QFile& file, const Options& options, qint64& rows);
+};
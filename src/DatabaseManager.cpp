@@ -1,23 +1,121 @@
 #include "DatabaseManager.h"
+#include "CsvExporter.h"
+#include "PipelineMetrics.h"
+#include "StartupTrace.h"
 #include <QStandardPaths>
 #include <QDir>
 #include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
 #include <QJsonDocument>
+#include <QThread>
+#include <QtConcurrent>
+#include <QTimer>
 #include <QDebug>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace {
+
+// 事件筛选条件（事件索引与小时计数表的列名相同）；exactSeverity时只匹配minSeverity这一级
+QString eventConditions(const EventFilter& filter, bool exactSeverity = false) {
+    QString conditions = exactSeverity ? " AND severity = :min_severity" : " AND severity >= :min_severity";
+    if (!filter.deviceId.isEmpty()) conditions += " AND device_id = :device_id";
+    if (filter.category >= 0) conditions += " AND category = :category";
+    if (filter.type >= 0) conditions += " AND type = :type";
+    return conditions;
+}
+
+void bindEventFilter(QSqlQuery& query, const EventFilter& filter) {
+    query.bindValue(":min_severity", filter.minSeverity);
+    if (!filter.deviceId.isEmpty()) query.bindValue(":device_id", filter.deviceId);
+    if (filter.category >= 0) query.bindValue(":category", filter.category);
+    if (filter.type >= 0) query.bindValue(":type", filter.type);
+}
+
+EventRecord readEventRow(const QSqlQuery& query) {
+    // 列顺序: timestamp, end_time, device_id, category, type, severity, message, wave_segment, wave_offset, rowid
+    EventRecord event;
+    event.timestampUs = query.value(0).toDateTime().toMSecsSinceEpoch() * 1000;
+    event.endUs = query.value(1).toDateTime().toMSecsSinceEpoch() * 1000;
+    event.deviceId = query.value(2).toString();
+    event.category = static_cast<EventRecord::Category>(query.value(3).toInt());
+    event.type = query.value(4).toInt();
+    event.severity = query.value(5).toInt();
+    event.message = query.value(6).toString();
+    event.waveform.segment = query.value(7).toString();
+    event.waveform.offset = query.value(8).isNull() ? -1 : query.value(8).toLongLong();
+    event.id = query.value(9).toLongLong();
+    return event;
+}
+
+// 小时计数表的键：本地时间的整点（与Qt绑定QDateTime时的ISO格式一致）
+QDateTime hourStart(qint64 timestampUs) {
+    QDateTime hour = QDateTime::fromMSecsSinceEpoch(timestampUs / 1000);
+    hour.setTime(QTime(hour.time().hour(), 0));
+    return hour;
+}
+
+} // namespace
 
 DatabaseManager::DatabaseManager(QObject* parent)
     : QObject(parent)
+    , m_waveformStore(nullptr)
+    , m_retentionThread(nullptr)
+    , m_retentionJob(nullptr)
+    , m_retentionTimer(new QTimer(this))
+    , m_readPool(nullptr)
+    , m_reportPool(nullptr)
+    , m_hrvAnalyzer(nullptr)
+    , m_initializing(false)
+    , m_retentionIntervalMs(0)
+    , m_coalesceFrames(1)
+    , m_coalesceDelayMs(0)
+    , m_flushTimer(new QTimer(this))
 {
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &DatabaseManager::flushPendingWrites);
+    connect(m_retentionTimer, &QTimer::timeout, this, [this]() {
+        if (m_retentionJob) {
+            QMetaObject::invokeMethod(m_retentionJob, &RetentionJob::run, Qt::QueuedConnection);
+        }
+    });
 }
 
 DatabaseManager::~DatabaseManager() {
+    // 准备任务引用波形存储
+    m_prepareFuture.waitForFinished();
+    flushPendingWrites();
+    stopRetentionWorker();
+    delete m_readPool;
+    delete m_reportPool;
+    delete m_hrvAnalyzer;
+    delete m_waveformStore;
     if (m_db.isOpen()) {
         m_db.close();
     }
 }
 
 bool DatabaseManager::initialize(const QString& dbPath) {
+    if (!beginInitialize(dbPath)) {
+        return false;
+    }
+    const qint64 sinceUs = QDateTime::currentMSecsSinceEpoch() * 1000 - m_hotWindow.windowUs();
+    return finishInitialize(prepareDatabase(m_dbPath, m_waveformStore, sinceUs), sinceUs);
+}
+
+QFuture<bool> DatabaseManager::initializeAsync(const QString& dbPath) {
+    if (!beginInitialize(dbPath)) {
+        return QtFuture::makeReadyValueFuture(false);
+    }
+    const qint64 sinceUs = QDateTime::currentMSecsSinceEpoch() * 1000 - m_hotWindow.windowUs();
+    m_prepareFuture = QtConcurrent::run(&DatabaseManager::prepareDatabase, m_dbPath, m_waveformStore, sinceUs);
+    return m_prepareFuture.then(this, [this, sinceUs](const PreparedDatabase& prepared) {
+        return finishInitialize(prepared, sinceUs);
+    });
+}
+
+bool DatabaseManager::beginInitialize(const QString& dbPath) {
     QString path = dbPath;
     if (path.isEmpty()) {
         // 使用应用数据目录
@@ -29,20 +127,219 @@ bool DatabaseManager::initialize(const QString& dbPath) {
         path = appDataPath + "/ecg_data.db";
     }
     
-    m_db = QSqlDatabase::addDatabase("QSQLITE");
-    m_db.setDatabaseName(path);
+    // 暂存的帧属于原来的数据库
+    flushPendingWrites();
+    stopRetentionWorker();
+    delete m_readPool;
+    m_readPool = nullptr;
+    delete m_reportPool;
+    m_reportPool = nullptr;
+    delete m_hrvAnalyzer;
+    m_hrvAnalyzer = nullptr;
+    m_historyCache.invalidate();
+    m_dbPath = path;
+    if (m_db.isOpen()) {
+        m_db.close();
+    }
     
-    if (!m_db.open()) {
-        emit databaseError("无法打开数据库: " + m_db.lastError().text());
+    // 波形与数据库放在同一目录下
+    delete m_waveformStore;
+    m_waveformStore = new WaveformStore(QFileInfo(path).absolutePath() + "/waveforms");
+    if (!m_waveformStore->open()) {
+        emit databaseError(m_waveformStore->errorString());
+        emit initialized(false);
+        return false;
+    }
+    m_hrvAnalyzer = new HrvAnalyzer(m_waveformStore);
+    m_initializing = true;
+    return true;
+}
+
+DatabaseManager::PreparedDatabase DatabaseManager::prepareDatabase(const QString& dbPath,
+                                                                   WaveformStore* waveformStore,
+                                                                   qint64 sinceUs) {
+    StartupTrace::Scope trace("db_prepare");
+    PreparedDatabase prepared;
+    const QString connectionName = QString("prepare_%1").arg(quintptr(QThread::currentThreadId()));
+    {
+        QSqlDatabase db = openConnection(connectionName, dbPath);
+        if (!db.isOpen()) {
+            prepared.error = "无法打开数据库: " + db.lastError().text();
+        } else if (createTables(db, prepared.error)) {
+            readRecent(db, waveformStore, sinceUs, prepared);
+            prepared.ok = true;
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return prepared;
+}
+
+bool DatabaseManager::finishInitialize(const PreparedDatabase& prepared, qint64 hotWindowSinceUs) {
+    StartupTrace::Scope trace("db_open");
+    m_initializing = false;
+    if (prepared.ok) {
+        m_db = openConnection(QLatin1String(QSqlDatabase::defaultConnection), m_dbPath);
+    }
+    if (!prepared.ok || !m_db.isOpen()) {
+        emit databaseError(prepared.ok ? "无法打开数据库: " + m_db.lastError().text() : prepared.error);
+        // 暂存的帧与事件无处提交
+        m_pendingWrites.clear();
+        m_pendingEvents.clear();
+        PipelineMetrics::instance()->setQueueDepth("db_write", 0);
+        for (const std::function<void(bool)>& start : std::exchange(m_pendingQueries, {})) {
+            start(false);
+        }
+        emit initialized(false);
         return false;
     }
     
-    qDebug() << "Database opened at:" << path;
-    return createTables();
+    qDebug() << "Database opened at:" << m_dbPath;
+    
+    m_hotWindow.reset(hotWindowSinceUs);
+    for (const VitalSignData& data : prepared.recentVitals) {
+        m_hotWindow.insert(data);
+    }
+    for (const AlarmInfo& alarm : prepared.recentAlarms) {
+        m_hotWindow.insertAlarm(alarm);
+    }
+    qDebug() << "Hot window loaded" << prepared.recentVitals.size() << "records,"
+             << m_hotWindow.stats().bytes << "bytes";
+    
+    startRetentionWorker();
+    if (m_retentionIntervalMs > 0) {
+        startRetentionSchedule(m_retentionIntervalMs);
+    }
+    
+    // 历史查询、统计在只读连接池中执行，不阻塞界面也不与写入争锁
+    m_readPool = new DbReadPool(m_dbPath);
+    m_readPool->setErrorHandler([this](const QString& error) {
+        QMetaObject::invokeMethod(this, [this, error]() { emit databaseError(error); }, Qt::QueuedConnection);
+    });
+    m_reportPool = new DbReadPool(m_dbPath, 1);
+    m_reportPool->setErrorHandler([this](const QString& error) {
+        QMetaObject::invokeMethod(this, [this, error]() { emit databaseError(error); }, Qt::QueuedConnection);
+    });
+    
+    // 初始化期间到达的帧与事件
+    flushPendingWrites();
+    const QVector<std::function<void()>> pendingEvents = std::exchange(m_pendingEvents, {});
+    for (const std::function<void()>& save : pendingEvents) {
+        save();
+    }
+    for (const std::function<void(bool)>& start : std::exchange(m_pendingQueries, {})) {
+        start(true);
+    }
+    emit initialized(true);
+    return true;
 }
 
-bool DatabaseManager::createTables() {
-    QSqlQuery query(m_db);
+QSqlDatabase DatabaseManager::openConnection(const QString& connectionName, const QString& dbPath) {
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(dbPath);
+    // 写锁被后台清理短暂占用时等待，而不是立即返回SQLITE_BUSY
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!db.open()) {
+        return db;
+    }
+    
+    QSqlQuery query(db);
+    // 仅对尚未建表的新数据库生效，必须先于journal_mode设置
+    query.exec("PRAGMA auto_vacuum = INCREMENTAL");
+    // WAL模式下读取不被写入阻塞
+    query.exec("PRAGMA journal_mode = WAL");
+    
+    return db;
+}
+
+void DatabaseManager::startRetentionWorker() {
+    m_retentionThread = new QThread(this);
+    m_retentionThread->setObjectName("RetentionJob");
+    m_retentionJob = new RetentionJob(m_dbPath, m_waveformStore);
+    m_retentionJob->setPolicy(m_retentionPolicy);
+    m_retentionJob->moveToThread(m_retentionThread);
+    
+    connect(m_retentionJob, &RetentionJob::finished, this, &DatabaseManager::retentionFinished);
+    connect(m_retentionJob, &RetentionJob::finished, this, [this](qint64 vitalRows) {
+        if (vitalRows > 0) {
+            m_historyCache.invalidate();
+        }
+    });
+    connect(m_retentionJob, &RetentionJob::errorOccurred, this, &DatabaseManager::databaseError);
+    
+    m_retentionThread->start(QThread::LowPriority);
+}
+
+void DatabaseManager::stopRetentionWorker() {
+    m_retentionTimer->stop();
+    if (!m_retentionThread) return;
+    
+    m_retentionJob->cancel();
+    m_retentionThread->quit();
+    m_retentionThread->wait();
+    delete m_retentionJob;
+    m_retentionJob = nullptr;
+    delete m_retentionThread;
+    m_retentionThread = nullptr;
+}
+
+void DatabaseManager::setRetentionPolicy(const RetentionPolicy& policy) {
+    m_retentionPolicy = policy;
+    if (m_retentionJob) {
+        m_retentionJob->setPolicy(policy);
+    }
+}
+
+void DatabaseManager::startRetentionSchedule(int intervalMs) {
+    // 初始化完成后按此间隔启动
+    m_retentionIntervalMs = intervalMs;
+    if (!m_retentionJob) return;
+    
+    m_retentionTimer->start(intervalMs);
+    QMetaObject::invokeMethod(m_retentionJob, &RetentionJob::run, Qt::QueuedConnection);
+}
+
+void DatabaseManager::setHotWindow(qint64 windowMs, qint64 budgetBytes) {
+    m_hotWindow.setWindowUs(windowMs * 1000);
+    m_hotWindow.setBudgetBytes(budgetBytes);
+}
+
+void DatabaseManager::readRecent(QSqlDatabase& db, WaveformStore* waveformStore, qint64 sinceUs,
+                                 PreparedDatabase& prepared) {
+    const QDateTime since = QDateTime::fromMSecsSinceEpoch(sinceUs / 1000);
+    
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT timestamp, temperature, oxygen_saturation, heart_rate, device_id,
+               wave_segment, wave_offset, ecg_signal, signal_quality, quality_flags
+        FROM vital_signs
+        WHERE timestamp >= :since
+        ORDER BY timestamp ASC
+    )");
+    query.bindValue(":since", since);
+    if (query.exec()) {
+        while (query.next()) {
+            prepared.recentVitals.append(readVitalSignRow(query, waveformStore));
+        }
+    }
+    
+    query.prepare(R"(
+        SELECT timestamp, type, message, severity, device_id
+        FROM alarms
+        WHERE timestamp >= :since
+        ORDER BY timestamp ASC
+    )");
+    query.bindValue(":since", since);
+    if (query.exec()) {
+        while (query.next()) {
+            prepared.recentAlarms.append(readAlarmRow(query));
+        }
+    }
+}
+
+bool DatabaseManager::createTables(QSqlDatabase& db, QString& error) {
+    QSqlQuery query(db);
     
     // 创建生理数据表
     QString createVitalSignTable = R"(
@@ -53,12 +350,26 @@ bool DatabaseManager::createTables() {
             oxygen_saturation INTEGER,
             heart_rate INTEGER,
             ecg_signal TEXT,
-            INDEX idx_timestamp (timestamp)
+            device_id TEXT,
+            wave_segment TEXT,
+            wave_offset INTEGER,
+            signal_quality REAL,
+            quality_flags INTEGER
         )
     )";
     
     if (!query.exec(createVitalSignTable)) {
-        emit databaseError("创建vital_signs表失败: " + query.lastError().text());
+        error = "创建vital_signs表失败: " + query.lastError().text();
+        return false;
+    }
+    
+    if (!migrateVitalSignsTable(db, error)) {
+        return false;
+    }
+    
+    // SQLite不支持在CREATE TABLE中内联INDEX，需单独建索引
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_timestamp ON vital_signs (timestamp)")) {
+        error = "创建vital_signs索引失败: " + query.lastError().text();
         return false;
     }
     
@@ -70,12 +381,76 @@ bool DatabaseManager::createTables() {
             type INTEGER,
             message TEXT,
             severity INTEGER,
-            INDEX idx_alarm_timestamp (timestamp)
+            device_id TEXT
         )
     )";
     
     if (!query.exec(createAlarmTable)) {
-        emit databaseError("创建alarms表失败: " + query.lastError().text());
+        error = "创建alarms表失败: " + query.lastError().text();
+        return false;
+    }
+    
+    if (!migrateAlarmsTable(db, error)) {
+        return false;
+    }
+    
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_alarm_timestamp ON alarms (timestamp)")) {
+        error = "创建alarms索引失败: " + query.lastError().text();
+        return false;
+    }
+    
+    // 形态趋势表：模板测量结果按分钟采样
+    QString createMorphologyTable = R"(
+        CREATE TABLE IF NOT EXISTS morphology_trends (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            timestamp DATETIME NOT NULL,
+            device_id TEXT,
+            st_mv REAL,
+            qrs_ms REAL,
+            qt_ms REAL,
+            qtc_ms REAL,
+            rr_ms REAL,
+            template_beats INTEGER
+        )
+    )";
+    
+    if (!query.exec(createMorphologyTable)) {
+        error = "创建morphology_trends表失败: " + query.lastError().text();
+        return false;
+    }
+    
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_morphology_timestamp ON morphology_trends (timestamp)") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS idx_morphology_device_timestamp ON morphology_trends (device_id, timestamp)")) {
+        error = "创建morphology_trends索引失败: " + query.lastError().text();
+        return false;
+    }
+    
+    // 心律事件表：timestamp为开始时间（数据清理按此列），end_time为结束时间；
+    // 按时间段查询有交集的事件时先按end_time范围扫描，再过滤开始时间
+    QString createRhythmTable = R"(
+        CREATE TABLE IF NOT EXISTS rhythm_episodes (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            timestamp DATETIME NOT NULL,
+            end_time DATETIME NOT NULL,
+            device_id TEXT,
+            type INTEGER,
+            beats INTEGER
+        )
+    )";
+    
+    if (!query.exec(createRhythmTable)) {
+        error = "创建rhythm_episodes表失败: " + query.lastError().text();
+        return false;
+    }
+    
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_rhythm_timestamp ON rhythm_episodes (timestamp)") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS idx_rhythm_end ON rhythm_episodes (end_time)") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS idx_rhythm_device_end ON rhythm_episodes (device_id, end_time)")) {
+        error = "创建rhythm_episodes索引失败: " + query.lastError().text();
+        return false;
+    }
+    
+    if (!createEventIndex(db, error)) {
         return false;
     }
     
@@ -83,6 +458,288 @@ bool DatabaseManager::createTables() {
     return true;
 }
 
+bool DatabaseManager::migrateVitalSignsTable(QSqlDatabase& db, QString& error) {
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA table_info(vital_signs)")) {
+        error = "读取vital_signs表结构失败: " + query.lastError().text();
+        return false;
+    }
+    
+    QStringList columns;
+    while (query.next()) {
+        columns << query.value(1).toString();
+    }
+    
+    // 旧数据库的波形仍保存在ecg_signal列中，读取时回退
+    const QList<QPair<QString, QString>> added = {
+        {"device_id", "TEXT"},
+        {"wave_segment", "TEXT"},
+        {"wave_offset", "INTEGER"},
+        {"signal_quality", "REAL"},
+        {"quality_flags", "INTEGER"}
+    };
+    for (const auto& column : added) {
+        if (columns.contains(column.first)) continue;
+        if (!query.exec(QString("ALTER TABLE vital_signs ADD COLUMN %1 %2").arg(column.first, column.second))) {
+            error = "升级vital_signs表失败: " + query.lastError().text();
+            return false;
+        }
+        qDebug() << "Added column" << column.first << "to vital_signs";
+    }
+    
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_device_timestamp ON vital_signs (device_id, timestamp)")) {
+        error = "创建vital_signs索引失败: " + query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+bool DatabaseManager::migrateAlarmsTable(QSqlDatabase& db, QString& error) {
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA table_info(alarms)")) {
+        error = "读取alarms表结构失败: " + query.lastError().text();
+        return false;
+    }
+    
+    bool hasDeviceId = false;
+    while (query.next()) {
+        hasDeviceId = hasDeviceId || query.value(1).toString() == "device_id";
+    }
+    
+    // 旧报警的设备ID为空
+    if (!hasDeviceId) {
+        if (!query.exec("ALTER TABLE alarms ADD COLUMN device_id TEXT")) {
+            error = "升级alarms表失败: " + query.lastError().text();
+            return false;
+        }
+        qDebug() << "Added column device_id to alarms";
+    }
+    
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_alarm_device_timestamp ON alarms (device_id, timestamp)")) {
+        error = "创建alarms索引失败: " + query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+bool DatabaseManager::createEventIndex(QSqlDatabase& db, QString& error) {
+    QSqlQuery query(db);
+    
+    // 首次创建时由已有的报警和心律事件补建
+    bool exists = false;
+    if (query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'event_index'")) {
+        exists = query.next();
+    }
+    
+    // 事件索引：报警与心律事件合并，按设备、严重度、类型各建复合索引，
+    // 查找"下一个严重事件"、按条件筛选都是索引定位；波形指针指向事件前的帧
+    QString createEventTable = R"(
+        CREATE TABLE IF NOT EXISTS event_index (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            timestamp DATETIME NOT NULL,
+            end_time DATETIME NOT NULL,
+            device_id TEXT NOT NULL DEFAULT '',
+            category INTEGER NOT NULL,
+            type INTEGER NOT NULL,
+            severity INTEGER NOT NULL,
+            message TEXT,
+            wave_segment TEXT,
+            wave_offset INTEGER
+        )
+    )";
+    
+    if (!query.exec(createEventTable)) {
+        error = "创建event_index表失败: " + query.lastError().text();
+        return false;
+    }
+    
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_event_timestamp ON event_index (timestamp)") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS idx_event_severity ON event_index (severity, timestamp)") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS idx_event_device ON event_index (device_id, severity, timestamp)") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS idx_event_type ON event_index (category, type, timestamp)")) {
+        error = "创建event_index索引失败: " + query.lastError().text();
+        return false;
+    }
+    
+    // 每小时事件数：密度条与按月浏览只读这张表，写入事件时累加
+    QString createHourlyTable = R"(
+        CREATE TABLE IF NOT EXISTS event_hourly (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            timestamp DATETIME NOT NULL,
+            device_id TEXT NOT NULL DEFAULT '',
+            category INTEGER NOT NULL,
+            type INTEGER NOT NULL,
+            severity INTEGER NOT NULL,
+            count INTEGER NOT NULL,
+            UNIQUE (timestamp, device_id, category, type, severity)
+        )
+    )";
+    
+    if (!query.exec(createHourlyTable)) {
+        error = "创建event_hourly表失败: " + query.lastError().text();
+        return false;
+    }
+    
+    if (exists) {
+        return true;
+    }
+    
+    // 旧报警没有设备ID，已有的报警也没有波形指针
+    const QString rhythmSeverity = QString("CASE type WHEN %1 THEN %2 WHEN %3 THEN %4 ELSE %5 END")
+        .arg(int(RhythmEpisode::Pause)).arg(RhythmEpisode::severity(RhythmEpisode::Pause))
+        .arg(int(RhythmEpisode::Ventricular)).arg(RhythmEpisode::severity(RhythmEpisode::Ventricular))
+        .arg(RhythmEpisode::severity(RhythmEpisode::AtrialFibrillation));
+    const QStringList backfill = {
+        QString(R"(
+            INSERT INTO event_index (timestamp, end_time, device_id, category, type, severity, message)
+            SELECT timestamp, timestamp, COALESCE(device_id, ''), %1, type, severity, message FROM alarms
+        )").arg(int(EventRecord::AlarmEvent)),
+        QString(R"(
+            INSERT INTO event_index (timestamp, end_time, device_id, category, type, severity, message)
+            SELECT timestamp, end_time, COALESCE(device_id, ''), %1, type, %2, beats || '个心搏'
+            FROM rhythm_episodes
+        )").arg(int(EventRecord::RhythmEvent)).arg(rhythmSeverity),
+        R"(
+            INSERT INTO event_hourly (timestamp, device_id, category, type, severity, count)
+            SELECT substr(timestamp, 1, 13) || ':00:00.000', device_id, category, type, severity, COUNT(*)
+            FROM event_index
+            GROUP BY 1, 2, 3, 4, 5
+        )"
+    };
+    
+    db.transaction();
+    for (const QString& sql : backfill) {
+        if (!query.exec(sql)) {
+            db.rollback();
+            error = "建立事件索引失败: " + query.lastError().text();
+            return false;
+        }
+    }
+    if (!db.commit()) {
+        error = "建立事件索引失败: " + db.lastError().text();
+        return false;
+    }
+    qDebug() << "Event index built from existing alarms and rhythm episodes";
+    return true;
+}
+
+bool DatabaseManager::indexEvent(const EventRecord& event) {
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        INSERT INTO event_index (timestamp, end_time, device_id, category, type, severity, message,
+                                 wave_segment, wave_offset)
+        VALUES (:timestamp, :end_time, :device_id, :category, :type, :severity, :message,
+                :wave_segment, :wave_offset)
+    )");
+    
+    const bool linked = event.waveform.isValid();
+    query.bindValue(":timestamp", QDateTime::fromMSecsSinceEpoch(event.timestampUs / 1000));
+    query.bindValue(":end_time", QDateTime::fromMSecsSinceEpoch(event.endUs / 1000));
+    query.bindValue(":device_id", event.deviceId.isNull() ? QString("") : event.deviceId);
+    query.bindValue(":category", int(event.category));
+    query.bindValue(":type", event.type);
+    query.bindValue(":severity", event.severity);
+    query.bindValue(":message", event.message);
+    query.bindValue(":wave_segment", linked ? QVariant(event.waveform.segment) : QVariant());
+    query.bindValue(":wave_offset", linked ? QVariant(event.waveform.offset) : QVariant());
+    
+    if (!query.exec()) {
+        emit databaseError("写入事件索引失败: " + query.lastError().text());
+        return false;
+    }
+    
+    query.prepare(R"(
+        INSERT INTO event_hourly (timestamp, device_id, category, type, severity, count)
+        VALUES (:timestamp, :device_id, :category, :type, :severity, 1)
+        ON CONFLICT (timestamp, device_id, category, type, severity) DO UPDATE SET count = count + 1
+    )");
+    
+    query.bindValue(":timestamp", hourStart(event.timestampUs));
+    query.bindValue(":device_id", event.deviceId.isNull() ? QString("") : event.deviceId);
+    query.bindValue(":category", int(event.category));
+    query.bindValue(":type", event.type);
+    query.bindValue(":severity", event.severity);
+    
+    if (!query.exec()) {
+        emit databaseError("更新事件计数失败: " + query.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+WaveformLocation DatabaseManager::preRollLocation(const QString& deviceId, qint64 timestampUs) {
+    WaveformLocation location;
+    if (deviceId.isEmpty()) return location;
+    
+    // 预留时长内该设备最早的一帧；这段时间没有波形（断线）时不关联
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        SELECT wave_segment, wave_offset
+        FROM vital_signs
+        WHERE device_id = :device_id AND timestamp BETWEEN :start AND :end AND wave_segment IS NOT NULL
+        ORDER BY timestamp ASC
+        LIMIT 1
+    )");
+    
+    const qint64 timestampMs = timestampUs / 1000;
+    query.bindValue(":device_id", deviceId);
+    query.bindValue(":start", QDateTime::fromMSecsSinceEpoch(timestampMs - EventRecord::PreRollMs));
+    query.bindValue(":end", QDateTime::fromMSecsSinceEpoch(timestampMs));
+    
+    if (query.exec() && query.next()) {
+        location.segment = query.value(0).toString();
+        location.offset = query.value(1).toLongLong();
+    }
+    return location;
+}
+
+VitalSignData DatabaseManager::readVitalSignRow(const QSqlQuery& query, WaveformStore* waveformStore) {
+    // 列顺序: timestamp, temperature, oxygen_saturation, heart_rate, device_id,
+    //         wave_segment, wave_offset, ecg_signal, signal_quality, quality_flags
+    VitalSignData data;
+    data.setDateTime(query.value(0).toDateTime());
+    data.temperature = query.value(1).toDouble();
+    data.oxygenSaturation = query.value(2).toInt();
+    data.heartRate = query.value(3).toInt();
+    data.deviceId = query.value(4).toString();
+    
+    WaveformLocation location;
+    location.segment = query.value(5).toString();
+    location.offset = query.value(6).isNull() ? -1 : query.value(6).toLongLong();
+    if (location.isValid() && waveformStore) {
+        data.ecgSignal = waveformStore->read(location, data.deviceId);
+    } else {
+        // 旧数据：整帧JSON保存在ecg_signal列
+        const QString ecgJson = query.value(7).toString();
+        if (!ecgJson.isEmpty()) {
+            QJsonDocument doc = QJsonDocument::fromJson(ecgJson.toUtf8());
+            if (doc.isObject()) {
+                data = VitalSignData::fromJson(doc.object());
+            }
+        }
+    }
+    
+    // 升级前写入的行没有质量评估
+    if (!query.value(8).isNull()) {
+        data.signalQuality.score = query.value(8).toFloat();
+        data.signalQuality.flags = quint8(query.value(9).toUInt());
+    }
+    return data;
+}
+
+AlarmInfo DatabaseManager::readAlarmRow(const QSqlQuery& query) {
+    // 列顺序: timestamp, type, message, severity, device_id
+    AlarmInfo alarm;
+    alarm.timestamp = query.value(0).toDateTime();
+    alarm.type = static_cast<AlarmInfo::AlarmType>(query.value(1).toInt());
+    alarm.message = query.value(2).toString();
+    alarm.severity = query.value(3).toInt();
+    alarm.deviceId = query.value(4).toString();
+    return alarm;
+}
+
 bool DatabaseManager::checkConnection() {
     if (!m_db.isOpen()) {
         emit databaseError("数据库未连接");
@@ -94,198 +751,952 @@ bool DatabaseManager::checkConnection() {
 bool DatabaseManager::saveVitalSign(const VitalSignData& data) {
     if (!checkConnection()) return false;
     
+    PendingWrite write{data};
+    if (!writeVitalSign(write)) return false;
+    
+    // 补传到已缓存时间段的数据使对应的查询结果失效；必须在提交之后，
+    // 否则读线程可能在失效之后读到提交前的快照并重新缓存
+    m_historyCache.noteWrite(data.deviceId, data.timestampUs);
+    m_hotWindow.insert(data);
+    emit vitalSignCommitted(data);
+    return true;
+}
+
+bool DatabaseManager::writeVitalSign(PendingWrite& write) {
+    const VitalSignData& data = write.data;
+    
+    // 波形写入分段文件，表中只保存指针；提交失败重试时沿用已写入的位置，不重复追加
+    if (!write.waveformStored) {
+        write.location = m_waveformStore->append(data.deviceId, data.timestampUs, data.ecgSignal);
+        if (!data.ecgSignal.isEmpty() && !write.location.isValid()) {
+            emit databaseError(m_waveformStore->errorString());
+            return false;
+        }
+        write.waveformStored = true;
+    }
+    const WaveformLocation& location = write.location;
+    
     QSqlQuery query(m_db);
     query.prepare(R"(
-        INSERT INTO vital_signs (timestamp, temperature, oxygen_saturation, heart_rate, ecg_signal)
-        VALUES (:timestamp, :temperature, :oxygen_saturation, :heart_rate, :ecg_signal)
+        INSERT INTO vital_signs (timestamp, temperature, oxygen_saturation, heart_rate,
+                                 device_id, wave_segment, wave_offset, signal_quality, quality_flags)
+        VALUES (:timestamp, :temperature, :oxygen_saturation, :heart_rate,
+                :device_id, :wave_segment, :wave_offset, :signal_quality, :quality_flags)
     )");
     
-    query.bindValue(":timestamp", data.timestamp);
+    query.bindValue(":timestamp", data.dateTime());
     query.bindValue(":temperature", data.temperature);
     query.bindValue(":oxygen_saturation", data.oxygenSaturation);
     query.bindValue(":heart_rate", data.heartRate);
-    
-    // 将ECG信号数组转换为JSON字符串存储
-    QJsonDocument doc(data.toJson());
-    query.bindValue(":ecg_signal", QString::fromUtf8(doc.toJson(QJsonDocument::Compact)));
+    query.bindValue(":device_id", data.deviceId);
+    query.bindValue(":wave_segment", location.isValid() ? QVariant(location.segment) : QVariant());
+    query.bindValue(":wave_offset", location.isValid() ? QVariant(location.offset) : QVariant());
+    const bool assessed = data.signalQuality.isAssessed();
+    query.bindValue(":signal_quality", assessed ? QVariant(data.signalQuality.score) : QVariant());
+    query.bindValue(":quality_flags", assessed ? QVariant(int(data.signalQuality.flags)) : QVariant());
     
     if (!query.exec()) {
         emit databaseError("保存数据失败: " + query.lastError().text());
         return false;
     }
-    
     return true;
 }
 
 bool DatabaseManager::saveVitalSignBatch(const QVector<VitalSignData>& dataList) {
+    QVector<PendingWrite> writes;
+    writes.reserve(dataList.size());
+    for (const auto& data : dataList) {
+        writes.append(PendingWrite{data});
+    }
+    return commitBatch(writes);
+}
+
+bool DatabaseManager::commitBatch(QVector<PendingWrite>& writes) {
+    if (writes.isEmpty()) return true;
     if (!checkConnection()) return false;
     
-    m_db.transaction();
+    if (!m_db.transaction()) {
+        emit databaseError("开始事务失败: " + m_db.lastError().text());
+        requeueWrites(writes);
+        return false;
+    }
     
-    for (const auto& data : dataList) {
-        if (!saveVitalSign(data)) {
-            m_db.rollback();
-            return false;
+    // 单帧失败只跳过该帧（错误已由writeVitalSign报告）；回滚整批会使已写入分段文件的波形失去索引
+    QVector<PendingWrite> saved;
+    saved.reserve(writes.size());
+    for (auto& write : writes) {
+        if (writeVitalSign(write)) {
+            saved.append(write);
         }
     }
+    const bool complete = saved.size() == writes.size();
+    
+    if (!m_db.commit()) {
+        emit databaseError("提交事务失败: " + m_db.lastError().text());
+        m_db.rollback();
+        // 放回队列稍后重试，否则这些帧既不进热窗口也不会发出vitalSignCommitted
+        requeueWrites(saved);
+        return false;
+    }
+    for (const auto& write : saved) {
+        m_historyCache.noteWrite(write.data.deviceId, write.data.timestampUs);
+        m_hotWindow.insert(write.data);
+        emit vitalSignCommitted(write.data);
+    }
+    return complete;
+}
+
+void DatabaseManager::requeueWrites(const QVector<PendingWrite>& writes) {
+    // 放在新到达的帧之前，保持到达顺序
+    m_pendingWrites = writes + m_pendingWrites;
+    if (m_pendingWrites.size() > MaxPendingWrites) {
+        const int dropped = m_pendingWrites.size() - MaxPendingWrites;
+        m_pendingWrites.remove(0, dropped);
+        emit databaseError(QString("数据库持续写入失败，丢弃最早的%1帧").arg(dropped));
+    }
+    PipelineMetrics::instance()->setQueueDepth("db_write", m_pendingWrites.size());
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start(qMax(m_coalesceDelayMs, RetryDelayMs));
+    }
+}
+
+void DatabaseManager::setWriteCoalescing(int maxFrames, int maxDelayMs) {
+    m_coalesceFrames = qMax(1, maxFrames);
+    m_coalesceDelayMs = qMax(0, maxDelayMs);
+    // 暂存中的帧要等最长m_coalesceDelayMs才落库，这段时间不能算作查询缓存已覆盖
+    const qint64 pendingMs = m_coalesceFrames > 1 ? m_coalesceDelayMs : 0;
+    m_historyCache.setSettleMs(qMax(HistoryQueryCache::DefaultSettleMs,
+                                    pendingMs + HistoryQueryCache::SettleSlackMs));
+    if (m_coalesceFrames <= 1) {
+        flushPendingWrites();
+    }
+}
+
+void DatabaseManager::enqueueVitalSign(const VitalSignData& data) {
+    if (m_coalesceFrames <= 1 && !m_initializing) {
+        saveVitalSign(data);
+        return;
+    }
+    
+    m_pendingWrites.append(PendingWrite{data});
+    PipelineMetrics::instance()->setQueueDepth("db_write", m_pendingWrites.size());
+    if (m_initializing) {
+        // 初始化完成时提交
+        return;
+    }
+    if (m_pendingWrites.size() >= m_coalesceFrames) {
+        flushPendingWrites();
+    } else if (!m_flushTimer->isActive()) {
+        // 从最早一帧起计时，期间到达的帧不推迟提交
+        m_flushTimer->start(m_coalesceDelayMs);
+    }
+}
+
+bool DatabaseManager::flushPendingWrites() {
+    m_flushTimer->stop();
+    if (m_pendingWrites.isEmpty()) return true;
+    if (m_initializing) return false;
     
-    return m_db.commit();
+    QVector<PendingWrite> pending = std::exchange(m_pendingWrites, {});
+    PipelineMetrics::instance()->setQueueDepth("db_write", 0);
+    return commitBatch(pending);
 }
 
 bool DatabaseManager::saveAlarm(const AlarmInfo& alarm) {
+    if (m_initializing) {
+        m_pendingEvents.append([this, alarm]() { saveAlarm(alarm); });
+        return true;
+    }
     if (!checkConnection()) return false;
     
+    // 报警与其事件索引在同一事务中写入
+    m_db.transaction();
+    
     QSqlQuery query(m_db);
     query.prepare(R"(
-        INSERT INTO alarms (timestamp, type, message, severity)
-        VALUES (:timestamp, :type, :message, :severity)
+        INSERT INTO alarms (timestamp, type, message, severity, device_id)
+        VALUES (:timestamp, :type, :message, :severity, :device_id)
     )");
     
     query.bindValue(":timestamp", alarm.timestamp);
     query.bindValue(":type", static_cast<int>(alarm.type));
     query.bindValue(":message", alarm.message);
     query.bindValue(":severity", alarm.severity);
+    query.bindValue(":device_id", alarm.deviceId);
     
     if (!query.exec()) {
+        m_db.rollback();
         emit databaseError("保存报警信息失败: " + query.lastError().text());
         return false;
     }
     
+    EventRecord event;
+    event.timestampUs = alarm.timestamp.toMSecsSinceEpoch() * 1000;
+    event.endUs = event.timestampUs;
+    event.deviceId = alarm.deviceId;
+    event.category = EventRecord::AlarmEvent;
+    event.type = static_cast<int>(alarm.type);
+    event.severity = alarm.severity;
+    event.message = alarm.message;
+    event.waveform = preRollLocation(alarm.deviceId, event.timestampUs);
+    if (!indexEvent(event)) {
+        m_db.rollback();
+        return false;
+    }
+    
+    if (!m_db.commit()) {
+        emit databaseError("保存报警信息失败: " + m_db.lastError().text());
+        return false;
+    }
+    
+    m_hotWindow.insertAlarm(alarm);
+    return true;
+}
+
+bool DatabaseManager::saveMorphologyTrend(const QString& deviceId, qint64 timestampUs,
+                                          const BeatMorphology& morphology) {
+    if (m_initializing) {
+        m_pendingEvents.append([this, deviceId, timestampUs, morphology]() {
+            saveMorphologyTrend(deviceId, timestampUs, morphology);
+        });
+        return true;
+    }
+    if (!checkConnection()) return false;
+    
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        INSERT INTO morphology_trends (timestamp, device_id, st_mv, qrs_ms, qt_ms, qtc_ms, rr_ms, template_beats)
+        VALUES (:timestamp, :device_id, :st_mv, :qrs_ms, :qt_ms, :qtc_ms, :rr_ms, :template_beats)
+    )");
+    
+    query.bindValue(":timestamp", QDateTime::fromMSecsSinceEpoch(timestampUs / 1000));
+    query.bindValue(":device_id", deviceId);
+    query.bindValue(":st_mv", morphology.stMv);
+    query.bindValue(":qrs_ms", morphology.qrsMs);
+    query.bindValue(":qt_ms", morphology.qtMs);
+    query.bindValue(":qtc_ms", morphology.qtcMs);
+    query.bindValue(":rr_ms", morphology.rrMs);
+    query.bindValue(":template_beats", morphology.templateBeats);
+    
+    if (!query.exec()) {
+        emit databaseError("保存形态趋势失败: " + query.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::saveRhythmEpisode(const QString& deviceId, const RhythmEpisode& episode) {
+    if (m_initializing) {
+        m_pendingEvents.append([this, deviceId, episode]() { saveRhythmEpisode(deviceId, episode); });
+        return true;
+    }
+    if (!checkConnection()) return false;
+    
+    m_db.transaction();
+    
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        INSERT INTO rhythm_episodes (timestamp, end_time, device_id, type, beats)
+        VALUES (:timestamp, :end_time, :device_id, :type, :beats)
+    )");
+    
+    query.bindValue(":timestamp", QDateTime::fromMSecsSinceEpoch(episode.startUs / 1000));
+    query.bindValue(":end_time", QDateTime::fromMSecsSinceEpoch(episode.endUs / 1000));
+    query.bindValue(":device_id", deviceId);
+    query.bindValue(":type", static_cast<int>(episode.type));
+    query.bindValue(":beats", episode.beats);
+    
+    if (!query.exec()) {
+        m_db.rollback();
+        emit databaseError("保存心律事件失败: " + query.lastError().text());
+        return false;
+    }
+    
+    EventRecord event;
+    event.timestampUs = episode.startUs;
+    event.endUs = episode.endUs;
+    event.deviceId = deviceId;
+    event.category = EventRecord::RhythmEvent;
+    event.type = static_cast<int>(episode.type);
+    event.severity = RhythmEpisode::severity(episode.type);
+    event.message = QString("%1个心搏").arg(episode.beats);
+    event.waveform = preRollLocation(deviceId, episode.startUs);
+    if (!indexEvent(event)) {
+        m_db.rollback();
+        return false;
+    }
+    
+    if (!m_db.commit()) {
+        emit databaseError("保存心律事件失败: " + m_db.lastError().text());
+        return false;
+    }
     return true;
 }
 
 QVector<VitalSignData> DatabaseManager::queryVitalSigns(const QDateTime& startTime,
                                                         const QDateTime& endTime,
-                                                        int limit) {
+                                                        int limit,
+                                                        const QString& deviceId) {
+    if (!checkConnection()) return {};
+    
+    QString error;
+    const auto result = selectVitalSigns(m_db, m_waveformStore, &m_hotWindow, startTime, endTime,
+                                         limit, deviceId, error);
+    if (!error.isEmpty()) {
+        emit databaseError(error);
+    }
+    return result;
+}
+
+QVector<AlarmInfo> DatabaseManager::queryAlarms(const QDateTime& startTime,
+                                                const QDateTime& endTime,
+                                                int limit) {
+    if (!checkConnection()) return {};
+    
+    QString error;
+    const auto result = selectAlarms(m_db, &m_hotWindow, startTime, endTime, limit, error);
+    if (!error.isEmpty()) {
+        emit databaseError(error);
+    }
+    return result;
+}
+
+QFuture<QVector<VitalSignData>> DatabaseManager::queryVitalSignsAsync(const QDateTime& startTime,
+                                                                      const QDateTime& endTime,
+                                                                      int limit,
+                                                                      const QString& deviceId,
+                                                                      const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<QVector<VitalSignData>>([=]() {
+            return queryVitalSignsAsync(startTime, endTime, limit, deviceId, tag);
+        });
+    }
+    if (!m_readPool) return {};
+    
+    WaveformStore* waveformStore = m_waveformStore;
+    HotWindowCache* hotWindow = &m_hotWindow;
+    HistoryQueryCache* historyCache = &m_historyCache;
+    const qint64 startMs = startTime.toMSecsSinceEpoch();
+    const qint64 endMs = endTime.toMSecsSinceEpoch();
+    return m_readPool->run<QVector<VitalSignData>>(tag.isEmpty() ? QStringLiteral("vital_signs") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>& isCancelled, QString& error) {
+            QVector<VitalSignData> result;
+            historyCache->query(deviceId, startMs, endMs, limit,
+                [&](qint64 fromMs, qint64 toMs, QVector<VitalSignData>& rows) {
+                    rows = selectVitalSigns(db, waveformStore, hotWindow, QDateTime::fromMSecsSinceEpoch(fromMs),
+                                            QDateTime::fromMSecsSinceEpoch(toMs), limit, deviceId,
+                                            error, isCancelled);
+                    return error.isEmpty() && !(isCancelled && isCancelled());
+                }, result);
+            return result;
+        });
+}
+
+QFuture<QVector<VitalTrendBucket>> DatabaseManager::queryTrendBucketsAsync(const QDateTime& startTime,
+                                                                          const QDateTime& endTime,
+                                                                          qint64 bucketMs,
+                                                                          const QString& deviceId,
+                                                                          const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<QVector<VitalTrendBucket>>([=]() {
+            return queryTrendBucketsAsync(startTime, endTime, bucketMs, deviceId, tag);
+        });
+    }
+    if (!m_readPool) return {};
+    
+    return m_readPool->run<QVector<VitalTrendBucket>>(tag.isEmpty() ? QStringLiteral("vital_trend") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>& isCancelled, QString& error) {
+            return selectTrendBuckets(db, startTime, endTime, bucketMs, deviceId, error, isCancelled);
+        });
+}
+
+QFuture<QVector<AlarmInfo>> DatabaseManager::queryAlarmsAsync(const QDateTime& startTime,
+                                                              const QDateTime& endTime,
+                                                              int limit,
+                                                              const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<QVector<AlarmInfo>>([=]() { return queryAlarmsAsync(startTime, endTime, limit, tag); });
+    }
+    if (!m_readPool) return {};
+    
+    HotWindowCache* hotWindow = &m_hotWindow;
+    return m_readPool->run<QVector<AlarmInfo>>(tag.isEmpty() ? QStringLiteral("alarms") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>& isCancelled, QString& error) {
+            return selectAlarms(db, hotWindow, startTime, endTime, limit, error, isCancelled);
+        });
+}
+
+QFuture<QVector<DatabaseManager::MorphologyTrendPoint>> DatabaseManager::queryMorphologyTrendsAsync(
+        const QDateTime& startTime, const QDateTime& endTime, const QString& deviceId, const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<QVector<MorphologyTrendPoint>>([=]() {
+            return queryMorphologyTrendsAsync(startTime, endTime, deviceId, tag);
+        });
+    }
+    if (!m_readPool) return {};
+    
+    return m_readPool->run<QVector<MorphologyTrendPoint>>(tag.isEmpty() ? QStringLiteral("morphology") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>& isCancelled, QString& error) {
+            return selectMorphologyTrends(db, startTime, endTime, deviceId, error, isCancelled);
+        });
+}
+
+QFuture<QVector<DatabaseManager::RhythmEpisodeRecord>> DatabaseManager::queryRhythmEpisodesAsync(
+        const QDateTime& startTime, const QDateTime& endTime, const QString& deviceId, const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<QVector<RhythmEpisodeRecord>>([=]() {
+            return queryRhythmEpisodesAsync(startTime, endTime, deviceId, tag);
+        });
+    }
+    if (!m_readPool) return {};
+    
+    return m_readPool->run<QVector<RhythmEpisodeRecord>>(tag.isEmpty() ? QStringLiteral("rhythm") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>& isCancelled, QString& error) {
+            return selectRhythmEpisodes(db, startTime, endTime, deviceId, error, isCancelled);
+        });
+}
+
+QFuture<QVector<EventRecord>> DatabaseManager::queryEventsAsync(const QDateTime& startTime,
+                                                                const QDateTime& endTime,
+                                                                const EventFilter& filter,
+                                                                int limit,
+                                                                const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<QVector<EventRecord>>([=]() {
+            return queryEventsAsync(startTime, endTime, filter, limit, tag);
+        });
+    }
+    if (!m_readPool) return {};
+    
+    return m_readPool->run<QVector<EventRecord>>(tag.isEmpty() ? QStringLiteral("events") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>& isCancelled, QString& error) {
+            return selectEvents(db, startTime, endTime, filter, limit, error, isCancelled);
+        });
+}
+
+QFuture<EventRecord> DatabaseManager::findEventAsync(const QDateTime& fromTime, qint64 fromId, bool forward,
+                                                     const EventFilter& filter, const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<EventRecord>([=]() { return findEventAsync(fromTime, fromId, forward, filter, tag); });
+    }
+    if (!m_readPool) return {};
+    
+    return m_readPool->run<EventRecord>(tag.isEmpty() ? QStringLiteral("findEvent") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>&, QString& error) {
+            return selectAdjacentEvent(db, fromTime, fromId, forward, filter, error);
+        });
+}
+
+QFuture<QVector<EcgFrame>> DatabaseManager::readEventWaveformAsync(const EventRecord& event) {
+    if (m_initializing) {
+        return deferQuery<QVector<EcgFrame>>([=]() { return readEventWaveformAsync(event); });
+    }
+    if (!m_readPool || !m_waveformStore) return {};
+    
+    // 有波形指针时一次定位后顺序读取；补建索引的旧事件没有指针，按时间范围查找
+    WaveformStore* waveformStore = m_waveformStore;
+    return m_readPool->run<QVector<EcgFrame>>(QString(),
+        [=](QSqlDatabase&, const std::function<bool()>& isCancelled, QString&) {
+            const qint64 preRollUs = qint64(EventRecord::PreRollMs) * 1000;
+            const qint64 endUs = event.timestampUs + preRollUs;
+            QVector<EcgFrame> frames;
+            const auto copyFrame = [&](const WaveformFrameView& view) {
+                EcgFrame frame = EcgFrame::allocate(event.deviceId, view.sampleCount, view.timestampUs,
+                                                    view.sampleRate, view.leads);
+                if (frame.leadCount() == view.leadCount) {
+                    memcpy(frame.mutableData(), view.samples,
+                           qint64(view.sampleCount) * view.leadCount * sizeof(float));
+                    frames.append(frame);
+                }
+                return !isCancelled();
+            };
+            if (event.waveform.isValid()) {
+                waveformStore->readFrom(event.waveform, event.deviceId, endUs, copyFrame);
+            } else {
+                waveformStore->readRange(event.deviceId, event.timestampUs - preRollUs, endUs, copyFrame);
+            }
+            return frames;
+        });
+}
+
+QFuture<QVector<EventHourCount>> DatabaseManager::eventDensityAsync(const QDateTime& startTime,
+                                                                   const QDateTime& endTime,
+                                                                   const EventFilter& filter,
+                                                                   const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<QVector<EventHourCount>>([=]() {
+            return eventDensityAsync(startTime, endTime, filter, tag);
+        });
+    }
+    if (!m_readPool) return {};
+    
+    return m_readPool->run<QVector<EventHourCount>>(tag.isEmpty() ? QStringLiteral("eventDensity") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>&, QString& error) {
+            return selectEventDensity(db, startTime, endTime, filter, error);
+        });
+}
+
+QFuture<DatabaseManager::Statistics> DatabaseManager::getStatisticsAsync(const QDateTime& startTime,
+                                                                         const QDateTime& endTime,
+                                                                         const QString& tag) {
+    if (m_initializing) {
+        return deferQuery<Statistics>([=]() { return getStatisticsAsync(startTime, endTime, tag); });
+    }
+    if (!m_readPool) return {};
+    
+    return m_readPool->run<Statistics>(tag.isEmpty() ? QStringLiteral("statistics") : tag,
+        [=](QSqlDatabase& db, const std::function<bool()>&, QString& error) {
+            return selectStatistics(db, startTime, endTime, error);
+        });
+}
+
+QFuture<HrvAnalyzer::Report> DatabaseManager::hrvReportAsync(const QString& deviceId,
+                                                            const QDateTime& startTime,
+                                                            const QDateTime& endTime) {
+    if (m_initializing) {
+        return deferQuery<HrvAnalyzer::Report>([=]() { return hrvReportAsync(deviceId, startTime, endTime); });
+    }
+    if (!m_reportPool || !m_hrvAnalyzer) return {};
+    
+    // 单独的单线程池（析构时会等待），长时间的报告不占用历史查询的线程；各小时的计算再分发到全局线程池
+    HrvAnalyzer* analyzer = m_hrvAnalyzer;
+    const qint64 startUs = startTime.toMSecsSinceEpoch() * 1000;
+    const qint64 endUs = endTime.toMSecsSinceEpoch() * 1000;
+    return m_reportPool->run<HrvAnalyzer::Report>(QStringLiteral("hrv"),
+        [=](QSqlDatabase&, const std::function<bool()>&, QString&) {
+            return analyzer->report(deviceId, startUs, endUs);
+        });
+}
+
+QVector<VitalSignData> DatabaseManager::selectVitalSigns(QSqlDatabase& db, WaveformStore* waveformStore,
+                                                         HotWindowCache* hotWindow,
+                                                         const QDateTime& startTime, const QDateTime& endTime,
+                                                         int limit, const QString& deviceId, QString& error,
+                                                         const std::function<bool()>& isCancelled) {
     QVector<VitalSignData> result;
-    if (!checkConnection()) return result;
     
-    QSqlQuery query(m_db);
-    query.prepare(R"(
-        SELECT timestamp, temperature, oxygen_saturation, heart_rate, ecg_signal
+    // 热窗口覆盖的部分直接取自内存
+    const qint64 startUs = startTime.toMSecsSinceEpoch() * 1000;
+    const qint64 endUs = endTime.toMSecsSinceEpoch() * 1000;
+    const qint64 coveredUs = hotWindow ? hotWindow->coveredSinceUs(deviceId) : std::numeric_limits<qint64>::max();
+    if (endUs >= coveredUs) {
+        result = hotWindow->query(qMax(startUs, coveredUs), endUs, limit, deviceId);
+        if (result.size() >= limit || startUs >= coveredUs) {
+            hotWindow->recordLookup(true);
+            return result;
+        }
+    }
+    if (hotWindow) {
+        hotWindow->recordLookup(false);
+    }
+    
+    // 更早的部分查数据库，结果接在内存结果之后（均为降序）
+    const QDateTime dbEnd = endUs >= coveredUs ? QDateTime::fromMSecsSinceEpoch(coveredUs / 1000 - 1) : endTime;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT timestamp, temperature, oxygen_saturation, heart_rate, device_id,
+               wave_segment, wave_offset, ecg_signal, signal_quality, quality_flags
         FROM vital_signs
-        WHERE timestamp BETWEEN :start AND :end
+        WHERE timestamp BETWEEN :start AND :end%1
         ORDER BY timestamp DESC
         LIMIT :limit
-    )");
+    )").arg(deviceId.isEmpty() ? "" : " AND device_id = :device_id"));
+    
+    query.bindValue(":start", startTime);
+    query.bindValue(":end", dbEnd);
+    query.bindValue(":limit", limit - result.size());
+    if (!deviceId.isEmpty()) {
+        query.bindValue(":device_id", deviceId);
+    }
+    
+    if (!query.exec()) {
+        error = "查询数据失败: " + query.lastError().text();
+        return result;
+    }
+    
+    while (query.next()) {
+        if (isCancelled && isCancelled()) break;
+        result.append(readVitalSignRow(query, waveformStore));
+    }
+    
+    return result;
+}
+
+QVector<VitalTrendBucket> DatabaseManager::selectTrendBuckets(QSqlDatabase& db, const QDateTime& startTime,
+                                                             const QDateTime& endTime, qint64 bucketMs,
+                                                             const QString& deviceId, QString& error,
+                                                             const std::function<bool()>& isCancelled) {
+    QVector<VitalTrendBucket> result;
+    bucketMs = qMax<qint64>(1, bucketMs);
+    
+    // 时间列按本地时间保存，julianday按UTC换算，平移到epoch毫秒后按桶长对齐（取查询时的时区偏移）
+    const qint64 utcOffsetMs = qint64(startTime.toLocalTime().offsetFromUtc()) * 1000;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT CAST((CAST(ROUND((julianday(timestamp) - 2440587.5) * 86400000) AS INTEGER) - :offset)
+                    / :bucket AS INTEGER) AS bucket,
+               COUNT(*), AVG(temperature), AVG(heart_rate), AVG(oxygen_saturation), MAX(timestamp)
+        FROM vital_signs
+        WHERE timestamp BETWEEN :start AND :end%1
+        GROUP BY bucket
+        ORDER BY bucket ASC
+    )").arg(deviceId.isEmpty() ? "" : " AND device_id = :device_id"));
     
+    query.bindValue(":offset", utcOffsetMs);
+    query.bindValue(":bucket", bucketMs);
     query.bindValue(":start", startTime);
     query.bindValue(":end", endTime);
-    query.bindValue(":limit", limit);
+    if (!deviceId.isEmpty()) {
+        query.bindValue(":device_id", deviceId);
+    }
     
     if (!query.exec()) {
-        emit databaseError("查询数据失败: " + query.lastError().text());
+        error = "查询趋势失败: " + query.lastError().text();
         return result;
     }
     
     while (query.next()) {
-        VitalSignData data;
-        data.timestamp = query.value(0).toDateTime();
-        data.temperature = query.value(1).toDouble();
-        data.oxygenSaturation = query.value(2).toInt();
-        data.heartRate = query.value(3).toInt();
-        
-        // 解析ECG信号
-        QString ecgJson = query.value(4).toString();
-        QJsonDocument doc = QJsonDocument::fromJson(ecgJson.toUtf8());
-        if (doc.isObject()) {
-            data = VitalSignData::fromJson(doc.object());
-        }
-        
-        result.append(data);
+        if (isCancelled && isCancelled()) break;
+        VitalTrendBucket bucket;
+        bucket.startMs = query.value(0).toLongLong() * bucketMs;
+        bucket.count = query.value(1).toInt();
+        bucket.temperature = query.value(2).toDouble();
+        bucket.heartRate = query.value(3).toDouble();
+        bucket.oxygen = query.value(4).toDouble();
+        bucket.lastUs = query.value(5).toDateTime().toMSecsSinceEpoch() * 1000;
+        result.append(bucket);
     }
     
     return result;
 }
 
-QVector<AlarmInfo> DatabaseManager::queryAlarms(const QDateTime& startTime,
-                                                const QDateTime& endTime,
-                                                int limit) {
+QVector<AlarmInfo> DatabaseManager::selectAlarms(QSqlDatabase& db, HotWindowCache* hotWindow,
+                                                 const QDateTime& startTime, const QDateTime& endTime,
+                                                 int limit, QString& error,
+                                                 const std::function<bool()>& isCancelled) {
     QVector<AlarmInfo> result;
-    if (!checkConnection()) return result;
     
-    QSqlQuery query(m_db);
+    const qint64 startUs = startTime.toMSecsSinceEpoch() * 1000;
+    const qint64 endUs = endTime.toMSecsSinceEpoch() * 1000;
+    const qint64 coveredUs = hotWindow ? hotWindow->alarmsCoveredSinceUs() : std::numeric_limits<qint64>::max();
+    if (endUs >= coveredUs) {
+        result = hotWindow->queryAlarms(qMax(startUs, coveredUs), endUs, limit);
+        if (result.size() >= limit || startUs >= coveredUs) {
+            hotWindow->recordLookup(true);
+            return result;
+        }
+    }
+    if (hotWindow) {
+        hotWindow->recordLookup(false);
+    }
+    
+    const QDateTime dbEnd = endUs >= coveredUs ? QDateTime::fromMSecsSinceEpoch(coveredUs / 1000 - 1) : endTime;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
     query.prepare(R"(
-        SELECT timestamp, type, message, severity
+        SELECT timestamp, type, message, severity, device_id
         FROM alarms
         WHERE timestamp BETWEEN :start AND :end
         ORDER BY timestamp DESC
         LIMIT :limit
     )");
     
+    query.bindValue(":start", startTime);
+    query.bindValue(":end", dbEnd);
+    query.bindValue(":limit", limit - result.size());
+    
+    if (!query.exec()) {
+        error = "查询报警失败: " + query.lastError().text();
+        return result;
+    }
+    
+    while (query.next()) {
+        if (isCancelled && isCancelled()) break;
+        result.append(readAlarmRow(query));
+    }
+    
+    return result;
+}
+
+QVector<DatabaseManager::MorphologyTrendPoint> DatabaseManager::selectMorphologyTrends(
+        QSqlDatabase& db, const QDateTime& startTime, const QDateTime& endTime,
+        const QString& deviceId, QString& error, const std::function<bool()>& isCancelled) {
+    QVector<MorphologyTrendPoint> result;
+    
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT timestamp, device_id, st_mv, qrs_ms, qt_ms, qtc_ms, rr_ms, template_beats
+        FROM morphology_trends
+        WHERE timestamp BETWEEN :start AND :end%1
+        ORDER BY timestamp ASC
+    )").arg(deviceId.isEmpty() ? "" : " AND device_id = :device_id"));
+    
+    query.bindValue(":start", startTime);
+    query.bindValue(":end", endTime);
+    if (!deviceId.isEmpty()) {
+        query.bindValue(":device_id", deviceId);
+    }
+    
+    if (!query.exec()) {
+        error = "查询形态趋势失败: " + query.lastError().text();
+        return result;
+    }
+    
+    while (query.next()) {
+        if (isCancelled && isCancelled()) break;
+        MorphologyTrendPoint point;
+        point.timestampUs = query.value(0).toDateTime().toMSecsSinceEpoch() * 1000;
+        point.deviceId = query.value(1).toString();
+        point.morphology.stMv = query.value(2).toDouble();
+        point.morphology.qrsMs = query.value(3).toDouble();
+        point.morphology.qtMs = query.value(4).toDouble();
+        point.morphology.qtcMs = query.value(5).toDouble();
+        point.morphology.rrMs = query.value(6).toDouble();
+        point.morphology.templateBeats = query.value(7).toInt();
+        result.append(point);
+    }
+    
+    return result;
+}
+
+QVector<DatabaseManager::RhythmEpisodeRecord> DatabaseManager::selectRhythmEpisodes(
+        QSqlDatabase& db, const QDateTime& startTime, const QDateTime& endTime,
+        const QString& deviceId, QString& error, const std::function<bool()>& isCancelled) {
+    QVector<RhythmEpisodeRecord> result;
+    
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT timestamp, end_time, device_id, type, beats
+        FROM rhythm_episodes
+        WHERE end_time >= :start AND timestamp <= :end%1
+        ORDER BY timestamp ASC
+    )").arg(deviceId.isEmpty() ? "" : " AND device_id = :device_id"));
+    
+    query.bindValue(":start", startTime);
+    query.bindValue(":end", endTime);
+    if (!deviceId.isEmpty()) {
+        query.bindValue(":device_id", deviceId);
+    }
+    
+    if (!query.exec()) {
+        error = "查询心律事件失败: " + query.lastError().text();
+        return result;
+    }
+    
+    while (query.next()) {
+        if (isCancelled && isCancelled()) break;
+        RhythmEpisodeRecord record;
+        record.episode.startUs = query.value(0).toDateTime().toMSecsSinceEpoch() * 1000;
+        record.episode.endUs = query.value(1).toDateTime().toMSecsSinceEpoch() * 1000;
+        record.deviceId = query.value(2).toString();
+        record.episode.type = static_cast<RhythmEpisode::Type>(query.value(3).toInt());
+        record.episode.beats = query.value(4).toInt();
+        result.append(record);
+    }
+    
+    return result;
+}
+
+QVector<EventRecord> DatabaseManager::selectEvents(QSqlDatabase& db, const QDateTime& startTime,
+                                                  const QDateTime& endTime, const EventFilter& filter,
+                                                  int limit, QString& error,
+                                                  const std::function<bool()>& isCancelled) {
+    QVector<EventRecord> result;
+    
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT timestamp, end_time, device_id, category, type, severity, message, wave_segment, wave_offset,
+               rowid
+        FROM event_index
+        WHERE timestamp BETWEEN :start AND :end%1
+        ORDER BY timestamp ASC, rowid ASC
+        LIMIT :limit
+    )").arg(eventConditions(filter)));
+    
     query.bindValue(":start", startTime);
     query.bindValue(":end", endTime);
     query.bindValue(":limit", limit);
+    bindEventFilter(query, filter);
     
     if (!query.exec()) {
-        emit databaseError("查询报警失败: " + query.lastError().text());
+        error = "查询事件失败: " + query.lastError().text();
         return result;
     }
     
     while (query.next()) {
-        AlarmInfo alarm;
-        alarm.timestamp = query.value(0).toDateTime();
-        alarm.type = static_cast<AlarmInfo::AlarmType>(query.value(1).toInt());
-        alarm.message = query.value(2).toString();
-        alarm.severity = query.value(3).toInt();
-        result.append(alarm);
+        if (isCancelled && isCancelled()) break;
+        result.append(readEventRow(query));
     }
     
     return result;
 }
 
-VitalSignData DatabaseManager::getLatestVitalSign() {
-    VitalSignData data;
-    if (!checkConnection()) return data;
+EventRecord DatabaseManager::selectAdjacentEvent(QSqlDatabase& db, const QDateTime& fromTime, qint64 fromId,
+                                                 bool forward, const EventFilter& filter, QString& error) {
+    EventRecord best;
     
-    QSqlQuery query(m_db);
-    query.prepare(R"(
-        SELECT timestamp, temperature, oxygen_saturation, heart_rate, ecg_signal
-        FROM vital_signs
-        ORDER BY timestamp DESC
+    // 按(timestamp, rowid)排序，同一毫秒的多个事件逐个跳过；没有起点事件时只比较时间
+    if (fromId < 0) {
+        fromId = forward ? std::numeric_limits<qint64>::max() : -1;
+    }
+    
+    // 每个严重度各做一次(severity, timestamp)索引定位，取最近的一个；
+    // 一个"大于等于"的范围条件会让SQLite按时间扫描，数月数据中远处的严重事件要扫过大量低级别事件
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT timestamp, end_time, device_id, category, type, severity, message, wave_segment, wave_offset,
+               rowid
+        FROM event_index
+        WHERE (timestamp, rowid) %1 (:from, :from_id)%2
+        ORDER BY timestamp %3, rowid %3
         LIMIT 1
-    )");
+    )").arg(forward ? ">" : "<",
+            eventConditions(filter, true),
+            forward ? "ASC" : "DESC"));
     
-    if (query.exec() && query.next()) {
-        data.timestamp = query.value(0).toDateTime();
-        data.temperature = query.value(1).toDouble();
-        data.oxygenSaturation = query.value(2).toInt();
-        data.heartRate = query.value(3).toInt();
+    // 严重度取自数据（每次一个索引定位找下一个存在的级别），不限定取值范围
+    QSqlQuery nextLevel(db);
+    nextLevel.setForwardOnly(true);
+    nextLevel.prepare("SELECT MIN(severity) FROM event_index WHERE severity >= :severity");
+    
+    int severity = filter.minSeverity;
+    while (true) {
+        nextLevel.bindValue(":severity", severity);
+        if (!nextLevel.exec()) {
+            error = "查询事件失败: " + nextLevel.lastError().text();
+            return EventRecord();
+        }
+        if (!nextLevel.next() || nextLevel.value(0).isNull()) break;
+        severity = nextLevel.value(0).toInt();
+        
+        EventFilter level = filter;
+        level.minSeverity = severity;
+        query.bindValue(":from", fromTime);
+        query.bindValue(":from_id", fromId);
+        bindEventFilter(query, level);
         
-        QString ecgJson = query.value(4).toString();
-        QJsonDocument doc = QJsonDocument::fromJson(ecgJson.toUtf8());
-        if (doc.isObject()) {
-            data = VitalSignData::fromJson(doc.object());
+        if (!query.exec()) {
+            error = "查询事件失败: " + query.lastError().text();
+            return EventRecord();
         }
+        if (query.next()) {
+            const EventRecord event = readEventRow(query);
+            const bool closer = forward
+                ? std::make_pair(event.timestampUs, event.id) < std::make_pair(best.timestampUs, best.id)
+                : std::make_pair(event.timestampUs, event.id) > std::make_pair(best.timestampUs, best.id);
+            if (!best.isValid() || closer) {
+                best = event;
+            }
+        }
+        
+        if (severity == std::numeric_limits<int>::max()) break;
+        ++severity;
     }
     
-    return data;
+    return best;
 }
 
-bool DatabaseManager::deleteOldData(int daysToKeep) {
-    if (!checkConnection()) return false;
+QVector<EventHourCount> DatabaseManager::selectEventDensity(QSqlDatabase& db, const QDateTime& startTime,
+                                                           const QDateTime& endTime, const EventFilter& filter,
+                                                           QString& error) {
+    QVector<EventHourCount> result;
     
-    QDateTime cutoffDate = QDateTime::currentDateTime().addDays(-daysToKeep);
+    // 只读小时计数表，一年也不过几千个小时
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT timestamp, SUM(count), MAX(severity)
+        FROM event_hourly
+        WHERE timestamp BETWEEN :start AND :end%1
+        GROUP BY timestamp
+        ORDER BY timestamp ASC
+    )").arg(eventConditions(filter)));
     
-    QSqlQuery query(m_db);
-    query.prepare("DELETE FROM vital_signs WHERE timestamp < :cutoff");
-    query.bindValue(":cutoff", cutoffDate);
+    query.bindValue(":start", hourStart(startTime.toMSecsSinceEpoch() * 1000));
+    query.bindValue(":end", endTime);
+    bindEventFilter(query, filter);
     
     if (!query.exec()) {
-        emit databaseError("删除旧数据失败: " + query.lastError().text());
-        return false;
+        error = "查询事件密度失败: " + query.lastError().text();
+        return result;
+    }
+    
+    while (query.next()) {
+        EventHourCount hour;
+        hour.hourUs = query.value(0).toDateTime().toMSecsSinceEpoch() * 1000;
+        hour.count = query.value(1).toInt();
+        hour.maxSeverity = query.value(2).toInt();
+        result.append(hour);
+    }
+    
+    return result;
+}
+
+VitalSignData DatabaseManager::getLatestVitalSign(const QString& deviceId) {
+    VitalSignData data;
+    if (!checkConnection()) return data;
+    
+    if (m_hotWindow.latest(data, deviceId)) {
+        m_hotWindow.recordLookup(true);
+        return data;
+    }
+    m_hotWindow.recordLookup(false);
+    
+    QSqlQuery query(m_db);
+    query.prepare(QString(R"(
+        SELECT timestamp, temperature, oxygen_saturation, heart_rate, device_id,
+               wave_segment, wave_offset, ecg_signal, signal_quality, quality_flags
+        FROM vital_signs%1
+        ORDER BY timestamp DESC
+        LIMIT 1
+    )").arg(deviceId.isEmpty() ? "" : " WHERE device_id = :device_id"));
+    if (!deviceId.isEmpty()) {
+        query.bindValue(":device_id", deviceId);
+    }
+    
+    if (query.exec() && query.next()) {
+        data = readVitalSignRow(query, m_waveformStore);
     }
     
-    qDebug() << "Deleted" << query.numRowsAffected() << "old records";
+    return data;
+}
+
+bool DatabaseManager::deleteOldData(int daysToKeep) {
+    if (!checkConnection() || !m_retentionJob) return false;
+    
+    // 分块删除在清理线程执行，这里只更新策略并排队
+    m_retentionPolicy = m_retentionJob->policy();
+    m_retentionPolicy.vitalDays = daysToKeep;
+    m_retentionJob->setPolicy(m_retentionPolicy);
+    QMetaObject::invokeMethod(m_retentionJob, &RetentionJob::run, Qt::QueuedConnection);
     return true;
 }
 
 DatabaseManager::Statistics DatabaseManager::getStatistics(const QDateTime& startTime,
                                                            const QDateTime& endTime) {
+    if (!checkConnection()) return Statistics{0, 0, 0, 0};
+    
+    QString error;
+    const Statistics stats = selectStatistics(m_db, startTime, endTime, error);
+    if (!error.isEmpty()) {
+        emit databaseError(error);
+    }
+    return stats;
+}
+
+DatabaseManager::Statistics DatabaseManager::selectStatistics(QSqlDatabase& db,
+                                                              const QDateTime& startTime,
+                                                              const QDateTime& endTime,
+                                                              QString& error) {
     Statistics stats = {0, 0, 0, 0};
-    if (!checkConnection()) return stats;
     
-    QSqlQuery query(m_db);
+    QSqlQuery query(db);
     query.prepare(R"(
         SELECT 
             AVG(temperature) as avg_temp,
@@ -299,7 +1710,9 @@ DatabaseManager::Statistics DatabaseManager::getStatistics(const QDateTime& star
     query.bindValue(":start", startTime);
     query.bindValue(":end", endTime);
     
-    if (query.exec() && query.next()) {
+    if (!query.exec()) {
+        error = "统计查询失败: " + query.lastError().text();
+    } else if (query.next()) {
         stats.avgTemperature = query.value(0).toDouble();
         stats.avgHeartRate = query.value(1).toDouble();
         stats.avgOxygen = query.value(2).toDouble();
@@ -312,30 +1725,19 @@ DatabaseManager::Statistics DatabaseManager::getStatistics(const QDateTime& star
 bool DatabaseManager::exportToCSV(const QString& filePath,
                                   const QDateTime& startTime,
                                   const QDateTime& endTime) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        emit databaseError("无法创建CSV文件");
-        return false;
-    }
-    
-    QTextStream out(&file);
-    // Qt6移除了setCodec，默认使用UTF-8
-    out.setEncoding(QStringConverter::Utf8);
-    
-    // 写入表头
-    out << "时间戳,体温(°C),血氧(%),心率(bpm)\n";
-    
-    // 查询数据
-    auto data = queryVitalSigns(startTime, endTime, 10000);
+    if (!checkConnection()) return false;
     
-    for (const auto& record : data) {
-        out << record.timestamp.toString("yyyy-MM-dd hh:mm:ss") << ","
-            << record.temperature << ","
-            << record.oxygenSaturation << ","
-            << record.heartRate << "\n";
-    }
+    // 同步流式导出；界面中应使用CsvExporter::start()在后台导出
+    CsvExporter exporter(m_dbPath, m_waveformStore);
+    CsvExporter::Options options;
+    options.filePath = filePath;
+    options.startTime = startTime;
+    options.endTime = endTime;
     
-    file.close();
-    qDebug() << "Exported" << data.size() << "records to" << filePath;
-    return true;
+    connect(&exporter, &CsvExporter::finished, this, [this](bool success, qint64, const QString& error) {
+        if (!success) {
+            emit databaseError(error);
+        }
+    });
+    return exporter.exportNow(options);
 }
@@ -1,9 +1,24 @@
 #pragma once
 #include <QObject>
+#include <QFuture>
+#include <QPromise>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <memory>
 #include "VitalSignData.h"
+#include "WaveformStore.h"
+#include "RetentionJob.h"
+#include "HotWindowCache.h"
+#include "HistoryQueryCache.h"
+#include "DbReadPool.h"
+#include "HrvAnalyzer.h"
+#include "MorphologyAnalyzer.h"
+#include "RhythmClassifier.h"
+#include "EventIndex.h"
+
+class QThread;
+class QTimer;
 
 class DatabaseManager : public QObject {
     Q_OBJECT
@@ -15,31 +30,138 @@ public:
     // 初始化数据库
     bool initialize(const QString& dbPath = "");
     
+    // 异步初始化：建表、升级旧版本与读取热窗口数据在工作线程中用独立连接完成，之后在GUI线程打开写入连接，
+    // 发出initialized。完成之前enqueueVitalSign的帧暂存到完成后提交，其他写入失败；异步查询返回的QFuture
+    // 在完成后才开始查询，初始化失败时被取消。完成之前不要再次初始化
+    QFuture<bool> initializeAsync(const QString& dbPath = "");
+    bool isReady() const { return m_db.isOpen(); }
+    
+    // 打开一个命名连接并应用统一设置（增量回收、WAL、忙等待），供工作线程使用
+    static QSqlDatabase openConnection(const QString& connectionName, const QString& dbPath);
+    
+    QString databasePath() const { return m_dbPath; }
+    
     // 保存生理数据
     bool saveVitalSign(const VitalSignData& data);
     
-    // 批量保存
+    // 批量保存（一个事务）。写入失败的帧跳过并报告，其余照常提交；提交失败时整批放回暂存队列稍后重试。
+    // 全部提交成功时返回true
     bool saveVitalSignBatch(const QVector<VitalSignData>& dataList);
     
+    // 写入合并（电池/后台时减少提交次数）：maxFrames > 1时enqueueVitalSign先暂存，
+    // 攒满maxFrames帧或最早一帧等待maxDelayMs后在一个事务中提交；maxFrames <= 1时立即提交已暂存的帧。
+    // 历史查询缓存的稳定窗口随之放宽到maxDelayMs之外
+    void setWriteCoalescing(int maxFrames, int maxDelayMs);
+    
+    // 入队保存（未启用合并时等同saveVitalSign），结果通过vitalSignCommitted/databaseError报告。
+    // 暂存期间的帧尚不在热窗口和数据库中
+    void enqueueVitalSign(const VitalSignData& data);
+    
+    // 立即提交暂存的帧
+    bool flushPendingWrites();
+    
+    // 保存报警、形态趋势和心律事件。异步初始化期间与帧一样先暂存（返回true），初始化完成后按到达顺序写入
     // 保存报警信息
     bool saveAlarm(const AlarmInfo& alarm);
     
-    // 查询历史数据
+    // 保存形态趋势点（每台设备每分钟一行）
+    bool saveMorphologyTrend(const QString& deviceId, qint64 timestampUs, const BeatMorphology& morphology);
+    
+    // 保存已结束的心律事件
+    bool saveRhythmEpisode(const QString& deviceId, const RhythmEpisode& episode);
+    
+    // 查询历史数据（按时间降序）
+    // 热窗口覆盖的时间段直接由内存回答，只有更早的部分访问数据库；deviceId为空表示全部设备
     QVector<VitalSignData> queryVitalSigns(const QDateTime& startTime, 
                                            const QDateTime& endTime,
-                                           int limit = 1000);
+                                           int limit = 1000,
+                                           const QString& deviceId = QString());
     
     // 查询报警历史
     QVector<AlarmInfo> queryAlarms(const QDateTime& startTime,
                                    const QDateTime& endTime,
                                    int limit = 100);
     
-    // 获取最新数据
-    VitalSignData getLatestVitalSign();
+    // 异步查询：在只读连接池中执行，结果通过QFuture返回（可用then(context, ...)回到界面线程）
+    // 同一tag的新查询会取消仍在进行的旧查询，tag为空时按查询类型区分
+    // 生理数据的异步查询经过历史查询缓存：重复查看同一视图时只查询上次之后新增的尾部
+    QFuture<QVector<VitalSignData>> queryVitalSignsAsync(const QDateTime& startTime,
+                                                         const QDateTime& endTime,
+                                                         int limit = 1000,
+                                                         const QString& deviceId = QString(),
+                                                         const QString& tag = QString());
+    QFuture<QVector<AlarmInfo>> queryAlarmsAsync(const QDateTime& startTime,
+                                                 const QDateTime& endTime,
+                                                 int limit = 100,
+                                                 const QString& tag = QString());
     
-    // 删除旧数据（数据清理）
+    // 按bucketMs长的时间桶聚合的生理参数（按时间升序，只包含有数据的桶），每桶一行，
+    // 长时间窗口的趋势不受条数上限限制；deviceId为空表示全部设备
+    QFuture<QVector<VitalTrendBucket>> queryTrendBucketsAsync(const QDateTime& startTime,
+                                                              const QDateTime& endTime,
+                                                              qint64 bucketMs,
+                                                              const QString& deviceId = QString(),
+                                                              const QString& tag = QString());
+    
+    // 形态趋势（按时间升序），deviceId为空表示全部设备
+    struct MorphologyTrendPoint {
+        QString deviceId;
+        qint64 timestampUs;
+        BeatMorphology morphology;
+    };
+    QFuture<QVector<MorphologyTrendPoint>> queryMorphologyTrendsAsync(const QDateTime& startTime,
+                                                                     const QDateTime& endTime,
+                                                                     const QString& deviceId = QString(),
+                                                                     const QString& tag = QString());
+    
+    // 与时间段有交集的心律事件（按开始时间升序），deviceId为空表示全部设备
+    struct RhythmEpisodeRecord {
+        QString deviceId;
+        RhythmEpisode episode;
+    };
+    QFuture<QVector<RhythmEpisodeRecord>> queryRhythmEpisodesAsync(const QDateTime& startTime,
+                                                                  const QDateTime& endTime,
+                                                                  const QString& deviceId = QString(),
+                                                                  const QString& tag = QString());
+    
+    // 事件索引：报警与心律事件按设备、类型、严重度、时间索引，并按小时预先汇总计数
+    // 时间段内符合条件的事件（按时间升序）
+    QFuture<QVector<EventRecord>> queryEventsAsync(const QDateTime& startTime,
+                                                   const QDateTime& endTime,
+                                                   const EventFilter& filter,
+                                                   int limit = 500,
+                                                   const QString& tag = QString());
+    // fromTime之后（forward）或之前最近的一个符合条件的事件，没有时返回无效事件。
+    // fromId为起点事件的id时，同一毫秒内排在它之后（之前）的事件也算；-1表示只按时间
+    QFuture<EventRecord> findEventAsync(const QDateTime& fromTime, qint64 fromId, bool forward,
+                                        const EventFilter& filter, const QString& tag = QString());
+    // 事件前后的波形（PreRollMs之前到之后，按时间升序），在只读连接池中读取：
+    // 重新初始化先等池中的读取结束再替换波形存储；每次调用各自返回，不互相取代
+    QFuture<QVector<EcgFrame>> readEventWaveformAsync(const EventRecord& event);
+    // 每小时的事件数（密度条），只包含有事件的小时
+    QFuture<QVector<EventHourCount>> eventDensityAsync(const QDateTime& startTime,
+                                                       const QDateTime& endTime,
+                                                       const EventFilter& filter,
+                                                       const QString& tag = QString());
+    
+    // 获取最新数据（优先取自热窗口）
+    VitalSignData getLatestVitalSign(const QString& deviceId = QString());
+    
+    // 最近数据的内存热窗口：时间长度与内存预算
+    void setHotWindow(qint64 windowMs, qint64 budgetBytes);
+    HotWindowCache* hotWindowCache() { return &m_hotWindow; }
+    HistoryQueryCache* historyQueryCache() { return &m_historyCache; }
+    
+    // 立即在后台执行一轮数据清理（生理数据按daysToKeep，其余按当前策略），不阻塞调用方
     bool deleteOldData(int daysToKeep = 30);
     
+    // 数据保留策略与周期清理
+    void setRetentionPolicy(const RetentionPolicy& policy);
+    void startRetentionSchedule(int intervalMs);
+    
+    // 波形分段存储（回看与导出可直接按时间段顺序读取映射内存）
+    WaveformStore* waveformStore() const { return m_waveformStore; }
+    
     // 获取统计信息
     struct Statistics {
         double avgTemperature;
@@ -48,21 +170,177 @@ public:
         int totalRecords;
     };
     Statistics getStatistics(const QDateTime& startTime, const QDateTime& endTime);
+    QFuture<Statistics> getStatisticsAsync(const QDateTime& startTime, const QDateTime& endTime,
+                                           const QString& tag = QString());
+    
+    // 心率变异性（由存储的ECG检出R波计算），整体与逐小时指标。报告在单独的单线程池中汇总，
+    // 不占用历史查询的读连接池，各小时的计算再分发到全局线程池
+    HrvAnalyzer* hrvAnalyzer() const { return m_hrvAnalyzer; }
+    QFuture<HrvAnalyzer::Report> hrvReportAsync(const QString& deviceId,
+                                                const QDateTime& startTime,
+                                                const QDateTime& endTime);
     
     // 导出数据到CSV
     bool exportToCSV(const QString& filePath, 
                      const QDateTime& startTime, 
                      const QDateTime& endTime);
+    
+    // 以下查询可在任意线程的连接上执行（同步接口与读连接池共用）；isCancelled在逐行读取之间检查
+    static QVector<VitalSignData> selectVitalSigns(QSqlDatabase& db, WaveformStore* waveformStore,
+                                                   HotWindowCache* hotWindow,
+                                                   const QDateTime& startTime, const QDateTime& endTime,
+                                                   int limit, const QString& deviceId, QString& error,
+                                                   const std::function<bool()>& isCancelled = {});
+    static QVector<AlarmInfo> selectAlarms(QSqlDatabase& db, HotWindowCache* hotWindow,
+                                           const QDateTime& startTime, const QDateTime& endTime,
+                                           int limit, QString& error,
+                                           const std::function<bool()>& isCancelled = {});
+    static QVector<MorphologyTrendPoint> selectMorphologyTrends(QSqlDatabase& db,
+                                                                const QDateTime& startTime,
+                                                                const QDateTime& endTime,
+                                                                const QString& deviceId, QString& error,
+                                                                const std::function<bool()>& isCancelled = {});
+    static QVector<RhythmEpisodeRecord> selectRhythmEpisodes(QSqlDatabase& db,
+                                                             const QDateTime& startTime,
+                                                             const QDateTime& endTime,
+                                                             const QString& deviceId, QString& error,
+                                                             const std::function<bool()>& isCancelled = {});
+    static QVector<VitalTrendBucket> selectTrendBuckets(QSqlDatabase& db, const QDateTime& startTime,
+                                                        const QDateTime& endTime, qint64 bucketMs,
+                                                        const QString& deviceId, QString& error,
+                                                        const std::function<bool()>& isCancelled = {});
+    static QVector<EventRecord> selectEvents(QSqlDatabase& db, const QDateTime& startTime,
+                                             const QDateTime& endTime, const EventFilter& filter,
+                                             int limit, QString& error,
+                                             const std::function<bool()>& isCancelled = {});
+    static EventRecord selectAdjacentEvent(QSqlDatabase& db, const QDateTime& fromTime, qint64 fromId,
+                                           bool forward, const EventFilter& filter, QString& error);
+    static QVector<EventHourCount> selectEventDensity(QSqlDatabase& db, const QDateTime& startTime,
+                                                      const QDateTime& endTime, const EventFilter& filter,
+                                                      QString& error);
+    static Statistics selectStatistics(QSqlDatabase& db, const QDateTime& startTime,
+                                       const QDateTime& endTime, QString& error);
+    
+    // 读取一行生理数据（波形来自分段文件，旧数据回退到ecg_signal列）
+    static VitalSignData readVitalSignRow(const QSqlQuery& query, WaveformStore* waveformStore);
+    static AlarmInfo readAlarmRow(const QSqlQuery& query);
 
 signals:
     void databaseError(const QString& error);
+    void initialized(bool success);
+    // 提交成功的生理数据（批量写入在事务提交后逐条发出），供跟随实时的历史视图增量追加
+    void vitalSignCommitted(const VitalSignData& data);
+    void retentionFinished(qint64 vitalRows, qint64 alarmRows, int waveformSegments, qint64 reclaimedBytes);
 
 private:
+    // 暂存待提交的一帧；波形写入分段文件后记下位置，提交失败重试时不再重复写入
+    struct PendingWrite {
+        VitalSignData data;
+        WaveformLocation location;
+        bool waveformStored = false;
+    };
+    
+    static constexpr int MaxPendingWrites = 20000;  // 提交持续失败时暂存队列的上限，超出丢弃最早的帧
+    static constexpr int RetryDelayMs = 1000;       // 提交失败后的重试间隔下限
+    
     QSqlDatabase m_db;
+    QString m_dbPath;
+    WaveformStore* m_waveformStore;
+    QThread* m_retentionThread;
+    RetentionJob* m_retentionJob;
+    QTimer* m_retentionTimer;
+    HotWindowCache m_hotWindow;
+    HistoryQueryCache m_historyCache;
+    DbReadPool* m_readPool;
+    DbReadPool* m_reportPool;                   // HRV报告，与交互查询分开
+    HrvAnalyzer* m_hrvAnalyzer;
+    bool m_initializing;
+    RetentionPolicy m_retentionPolicy;
+    int m_retentionIntervalMs;                  // 0表示未启动定期清理
+    QVector<PendingWrite> m_pendingWrites;      // 等待合并提交（或提交失败待重试）的帧
+    QVector<std::function<void()>> m_pendingEvents;     // 初始化期间到达的报警、形态趋势、心律事件
+    QVector<std::function<void(bool)>> m_pendingQueries;    // 初始化期间发起的异步查询（参数为初始化是否成功）
+    int m_coalesceFrames;
+    int m_coalesceDelayMs;
+    QTimer* m_flushTimer;
+    
+    // 工作线程中准备数据库的结果
+    struct PreparedDatabase {
+        bool ok = false;
+        QString error;
+        QVector<VitalSignData> recentVitals;    // 热窗口起点之后的数据（按时间升序）
+        QVector<AlarmInfo> recentAlarms;
+    };
+    QFuture<PreparedDatabase> m_prepareFuture;
+    
+    // 初始化的GUI线程部分：准备之前释放旧连接与后台任务、打开波形存储；
+    // 准备之后打开写入连接、装入热窗口、启动后台清理与只读连接池
+    bool beginInitialize(const QString& dbPath);
+    bool finishInitialize(const PreparedDatabase& prepared, qint64 hotWindowSinceUs);
+    
+    // 用独立连接建表、升级并读取sinceUs之后的数据（可在任意线程执行）
+    static PreparedDatabase prepareDatabase(const QString& dbPath, WaveformStore* waveformStore, qint64 sinceUs);
     
     // 创建数据表
-    bool createTables();
+    static bool createTables(QSqlDatabase& db, QString& error);
+    
+    // 启动后台清理线程
+    void startRetentionWorker();
+    void stopRetentionWorker();
+    
+    // 为旧版本数据库补充波形指针列
+    static bool migrateVitalSignsTable(QSqlDatabase& db, QString& error);
+    
+    // 为旧版本数据库的报警表补充设备ID列
+    static bool migrateAlarmsTable(QSqlDatabase& db, QString& error);
+    
+    // 创建事件索引与小时计数表，首次创建时由已有的报警和心律事件补建
+    static bool createEventIndex(QSqlDatabase& db, QString& error);
+    
+    // 写入事件索引并累加小时计数（调用方负责事务）
+    bool indexEvent(const EventRecord& event);
+    
+    // 事件前EventRecord::PreRollMs内该设备最早一帧的波形位置（一次索引定位）
+    WaveformLocation preRollLocation(const QString& deviceId, qint64 timestampUs);
+    
+    // 读取最近一个热窗口的数据，启动时装入热窗口
+    static void readRecent(QSqlDatabase& db, WaveformStore* waveformStore, qint64 sinceUs,
+                           PreparedDatabase& prepared);
+    
+    // 写入一帧的波形与索引行（不提交、不更新缓存），失败时报告databaseError
+    bool writeVitalSign(PendingWrite& write);
+    
+    // 在一个事务中写入并提交；失败的帧跳过，提交失败时放回暂存队列
+    bool commitBatch(QVector<PendingWrite>& writes);
+    
+    // 把未提交的帧放回暂存队列之首并安排重试
+    void requeueWrites(const QVector<PendingWrite>& writes);
+    
+    // 初始化期间的异步查询：返回的QFuture在初始化成功后调用start()开始查询并转发其结果，失败时取消
+    template <typename T>
+    QFuture<T> deferQuery(std::function<QFuture<T>()> start);
     
     // 检查数据库连接
     bool checkConnection();
 };
+
+template <typename T>
+QFuture<T> DatabaseManager::deferQuery(std::function<QFuture<T>()> start) {
+    auto promise = std::make_shared<QPromise<T>>();
+    promise->start();
+    m_pendingQueries.append([this, promise, start = std::move(start)](bool ok) {
+        if (!ok || promise->isCanceled()) {
+            promise->future().cancel();
+            promise->finish();
+            return;
+        }
+        start().then(this, [promise](const T& result) {
+            promise->addResult(result);
+            promise->finish();
+        }).onCanceled(this, [promise]() {
+            promise->future().cancel();
+            promise->finish();
+        });
+    });
+    return promise->future();
+}
@@ -0,0 +1,76 @@
+#include "DbReadPool.h"
+#include "DatabaseManager.h"
+#include <QThread>
+#include <QDebug>
+
+DbReadPool::DbReadPool(const QString& dbPath, int maxThreads)
+    : m_dbPath(dbPath)
+{
+    m_pool.setObjectName("DbReadPool");
+    m_pool.setMaxThreadCount(qMax(1, maxThreads));
+    // 空闲一分钟的线程退出并释放连接
+    m_pool.setExpiryTimeout(60000);
+}
+
+DbReadPool::~DbReadPool() {
+    cancelAll();
+    m_pool.waitForDone();
+}
+
+DbReadPool::ThreadConnection::~ThreadConnection() {
+    {
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+QSqlDatabase DbReadPool::openReadConnection(const QString& connectionName, const QString& dbPath) {
+    QSqlDatabase db = DatabaseManager::openConnection(connectionName, dbPath);
+    if (db.isOpen()) {
+        // 读连接不会意外写入，也就不会与写连接争夺写锁
+        QSqlQuery query(db);
+        query.exec("PRAGMA query_only = ON");
+    }
+    return db;
+}
+
+QSqlDatabase DbReadPool::threadConnection() {
+    if (!m_connections.hasLocalData()) {
+        auto* connection = new ThreadConnection;
+        connection->name = QString("db_read_%1_%2").arg(quintptr(this)).arg(quintptr(QThread::currentThreadId()));
+        m_connections.setLocalData(connection);
+    }
+    const QString name = m_connections.localData()->name;
+    {
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        if (db.isOpen()) return db;
+    }
+
+    // 首次使用或上次打开失败
+    QSqlDatabase::removeDatabase(name);
+    return openReadConnection(name, m_dbPath);
+}
+
+void DbReadPool::supersede(const QString& tag, const QFuture<void>& future) {
+    if (tag.isEmpty()) return;
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_pending.find(tag);
+    if (it != m_pending.end()) {
+        if (!it->isFinished()) {
+            it->cancel();
+        }
+        *it = future;
+    } else {
+        m_pending.insert(tag, future);
+    }
+}
+
+void DbReadPool::cancelAll() {
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        it->cancel();
+    }
+    m_pending.clear();
+}
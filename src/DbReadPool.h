@@ -0,0 +1,82 @@
+#pragma once
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QPromise>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QtConcurrent>
+#include <functional>
+
+// 只读连接池
+// 每个工作线程持有一条只读(query_only)的WAL连接，查询在池中执行并以QFuture返回，
+// 读取不占用GUI线程，也不与唯一的写连接争锁。
+// 同一标签的新请求会取消尚未完成的旧请求（例如连续点击查询），旧请求在逐行读取之间退出
+class DbReadPool {
+public:
+    // 查询函数：在工作线程的连接上执行，isCancelled()为true时应尽快返回，出错时写入error
+    template <typename T>
+    using Task = std::function<T(QSqlDatabase& db, const std::function<bool()>& isCancelled, QString& error)>;
+
+    explicit DbReadPool(const QString& dbPath, int maxThreads = 2);
+    ~DbReadPool();
+
+    // 打开一条只读连接（导出等自带线程的读取方使用）
+    static QSqlDatabase openReadConnection(const QString& connectionName, const QString& dbPath);
+
+    // 查询出错时的回调（在工作线程中调用）
+    void setErrorHandler(std::function<void(const QString&)> handler) { m_errorHandler = std::move(handler); }
+
+    // tag为空表示不参与取代
+    template <typename T>
+    QFuture<T> run(const QString& tag, Task<T> task);
+
+    void cancelAll();
+    void waitForDone() { m_pool.waitForDone(); }
+
+private:
+    // 线程退出（空闲超时或池销毁）时关闭并移除该线程的连接
+    struct ThreadConnection {
+        QString name;
+        ~ThreadConnection();
+    };
+
+    QSqlDatabase threadConnection();
+    void supersede(const QString& tag, const QFuture<void>& future);
+
+    QString m_dbPath;
+    std::function<void(const QString&)> m_errorHandler;
+    QMutex m_mutex;
+    QHash<QString, QFuture<void>> m_pending;
+    // 声明顺序：线程池先于线程存储销毁，线程退出时存储仍然有效
+    QThreadStorage<ThreadConnection*> m_connections;
+    QThreadPool m_pool;
+};
+
+template <typename T>
+QFuture<T> DbReadPool::run(const QString& tag, Task<T> task) {
+    QFuture<T> future = QtConcurrent::run(&m_pool, [this, task = std::move(task)](QPromise<T>& promise) {
+        // 排队期间已被取代
+        if (promise.isCanceled()) return;
+
+        QSqlDatabase db = threadConnection();
+        QString error;
+        T result{};
+        if (!db.isOpen()) {
+            error = "无法打开只读数据库连接: " + db.lastError().text();
+        } else {
+            result = task(db, [&promise]() { return promise.isCanceled(); }, error);
+        }
+
+        if (!error.isEmpty() && !promise.isCanceled() && m_errorHandler) {
+            m_errorHandler(error);
+        }
+        if (!promise.isCanceled()) {
+            promise.addResult(std::move(result));
+        }
+    });
+    supersede(tag, QFuture<void>(future));
+    return future;
+}
@@ -0,0 +1,257 @@
+#include "EcgAnalyzer.h"
+#include "PipelineMetrics.h"
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+const int RecentBeats = 16;
+const int HeartRateBeats = 8;                       // 至少连续8个心搏才判断心率报警
+const qint64 StaleBeatUs = 3LL * 1000000;           // 最后一个心搏过旧则不给出心率
+const qint64 LeadOffAlarmUs = 3LL * 1000000;
+const qint64 PoorSignalAlarmUs = 10LL * 1000000;
+const qint64 AlarmCooldownUs = 60LL * 1000000;
+const qint64 MorphologyTrendUs = 60LL * 1000000;
+
+// 报警冷却的分类键
+enum AlarmKey {
+    KeyLeadOff,
+    KeyPoorSignal,
+    KeyHighHeartRate,
+    KeyLowHeartRate,
+    KeyStDeviation,
+    KeyQtc,
+    KeyQrs,
+    KeyAtrialFibrillation,
+    KeyPause
+};
+
+} // namespace
+
+EcgAnalyzer::EcgAnalyzer(QObject* parent)
+    : QObject(parent)
+    , m_lowHeartRate(40)
+    , m_highHeartRate(150)
+    , m_stats{0, 0, 0, 0, 0}
+{
+}
+
+void EcgAnalyzer::setHeartRateLimits(int low, int high) {
+    m_lowHeartRate = low;
+    m_highHeartRate = high;
+    m_rhythmLimits.lowHeartRate = low;
+    m_rhythmLimits.highHeartRate = high;
+}
+
+void EcgAnalyzer::process(VitalSignData& data) {
+    m_stats.frames++;
+    const EcgFrame& frame = data.ecgSignal;
+    if (frame.isEmpty()) return;
+
+    DeviceState& state = m_devices[data.deviceId];
+    if (state.quality.sampleRate() != frame.sampleRate()) {
+        state.quality = SignalQualityAnalyzer(frame.sampleRate());
+    }
+    data.signalQuality = state.quality.assess(frame.constData(), frame.size());
+
+    // 质量不足的帧不做QRS检测；检测器在恢复后重新学习阈值
+    if (data.signalQuality.isUsable()) {
+        detectBeats(state, data);
+    } else {
+        m_stats.gatedFrames++;
+        state.detectorStarted = false;
+        state.beats.clear();
+        state.rhythm.flush(m_finishedEpisodes);
+        finishEpisodes(data.deviceId);
+    }
+
+    checkAlarms(state, data);
+
+    // 槽函数可能进入事件循环并重入process()（新设备插入会使state失效），信号留到本帧处理完再发出
+    const auto episodes = std::exchange(m_pendingEpisodes, {});
+    for (const auto& episode : episodes) {
+        emit rhythmEpisodeFinished(episode.first, episode.second);
+    }
+    const auto trends = std::exchange(m_pendingTrends, {});
+    for (const PendingTrend& trend : trends) {
+        emit morphologyMeasured(trend.deviceId, trend.timestampUs, trend.morphology);
+    }
+    const QVector<AlarmInfo> alarms = std::exchange(m_pendingAlarms, {});
+    for (const AlarmInfo& alarm : alarms) {
+        emit alarmRaised(alarm);
+    }
+}
+
+qint64 EcgAnalyzer::clockUs(const VitalSignData& data) {
+    // 冷却与趋势间隔按接收时刻（单调时钟）计；直接调用process()的帧退回到数据时间戳，都没有时取当前时刻
+    if (data.receivedAtNs > 0) return data.receivedAtNs / 1000;
+    if (data.timestampUs != 0) return data.timestampUs;
+    return PipelineMetrics::nowNs() / 1000;
+}
+
+void EcgAnalyzer::detectBeats(DeviceState& state, const VitalSignData& data) {
+    const EcgFrame& frame = data.ecgSignal;
+    const int sampleRate = frame.sampleRate();
+    const qint64 startUs = frame.timestampUs() != 0 ? frame.timestampUs() : data.timestampUs;
+
+    // 首帧、采样率变化或帧间有缺口时重新开始
+    const qint64 toleranceUs = 500000 / qMax(1, sampleRate);
+    if (!state.detectorStarted || state.detector.sampleRate() != sampleRate ||
+        qAbs(startUs - state.detector.nextSampleUs()) > toleranceUs) {
+        if (state.detector.sampleRate() != sampleRate) {
+            state.detector = QrsDetector(sampleRate);
+        }
+        state.detector.reset(startUs);
+        state.beats.clear();
+        state.morphology.restart(sampleRate, startUs);
+        state.rhythm.flush(m_finishedEpisodes);
+        finishEpisodes(data.deviceId);
+        state.detectorStarted = true;
+    }
+
+    const int before = state.beats.size();
+    state.detector.process(frame.constData(), frame.size(), state.beats);
+    const int newBeats = state.beats.size() - before;
+    m_stats.beats += newBeats;
+
+    const qint64 rejectedBefore = state.morphology.stats().rejected;
+    m_analyzedBeats.resize(0);
+    state.morphology.process(frame.constData(), frame.size(), state.beats.constData() + before, newBeats,
+                             &m_analyzedBeats);
+    m_stats.rejectedBeats += state.morphology.stats().rejected - rejectedBefore;
+    classifyRhythm(state, data);
+    if (state.beats.size() > RecentBeats) {
+        state.beats.remove(0, state.beats.size() - RecentBeats);
+    }
+}
+
+void EcgAnalyzer::classifyRhythm(DeviceState& state, const VitalSignData& data) {
+    quint8 started = 0;
+    for (const AnalyzedBeat& beat : std::as_const(m_analyzedBeats)) {
+        started |= state.rhythm.addBeat(beat, m_rhythmLimits, m_finishedEpisodes);
+    }
+
+    // 过缓/过速已有心率报警，这里只对房颤与停搏报警
+    if (started & (1u << RhythmEpisode::AtrialFibrillation)) {
+        raise(state, data, AlarmInfo::ECGAbnormal, 3, "疑似房颤（RR间期绝对不齐）", KeyAtrialFibrillation);
+    }
+    if (started & (1u << RhythmEpisode::Pause)) {
+        qint64 longestUs = 0;
+        for (const RhythmEpisode& episode : std::as_const(m_finishedEpisodes)) {
+            if (episode.type == RhythmEpisode::Pause) longestUs = qMax(longestUs, episode.endUs - episode.startUs);
+        }
+        raise(state, data, AlarmInfo::ECGAbnormal, 4,
+              QString("心搏暂停: %1 秒").arg(longestUs / 1e6, 0, 'f', 1), KeyPause);
+    }
+    finishEpisodes(data.deviceId);
+}
+
+void EcgAnalyzer::finishEpisodes(const QString& deviceId) {
+    for (const RhythmEpisode& episode : std::as_const(m_finishedEpisodes)) {
+        m_stats.episodes++;
+        m_pendingEpisodes.append(qMakePair(deviceId, episode));
+    }
+    m_finishedEpisodes.resize(0);
+}
+
+int EcgAnalyzer::heartRateOf(const QVector<qint64>& beats, qint64 nowUs) {
+    if (beats.size() < HeartRateBeats || nowUs - beats.last() > StaleBeatUs) return 0;
+
+    const qint64 first = beats[beats.size() - HeartRateBeats];
+    const qint64 spanUs = beats.last() - first;
+    return spanUs > 0 ? int(qRound64(60.0 * 1e6 * (HeartRateBeats - 1) / spanUs)) : 0;
+}
+
+BeatMorphology EcgAnalyzer::morphology(const QString& deviceId) const {
+    auto it = m_devices.constFind(deviceId);
+    return it == m_devices.cend() ? BeatMorphology() : it->morphology.morphology();
+}
+
+int EcgAnalyzer::localHeartRate(const QString& deviceId) const {
+    auto it = m_devices.constFind(deviceId);
+    if (it == m_devices.cend() || it->beats.isEmpty()) return 0;
+    return heartRateOf(it->beats, it->beats.last());
+}
+
+void EcgAnalyzer::checkAlarms(DeviceState& state, const VitalSignData& data) {
+    const SignalQuality& quality = data.signalQuality;
+    const EcgFrame& frame = data.ecgSignal;
+    const qint64 startUs = frame.timestampUs() != 0 ? frame.timestampUs() : data.timestampUs;
+    const qint64 nowUs = startUs + qint64(frame.durationSeconds() * 1e6);
+
+    // 技术报警：导联脱落与持续的信号质量差
+    if (quality.has(SignalQuality::LeadOff)) {
+        if (state.leadOffSinceUs < 0) state.leadOffSinceUs = nowUs;
+        if (nowUs - state.leadOffSinceUs >= LeadOffAlarmUs) {
+            raise(state, data, AlarmInfo::ECGAbnormal, 3, "ECG导联脱落", KeyLeadOff);
+        }
+    } else {
+        state.leadOffSinceUs = -1;
+    }
+
+    if (!quality.isUsable() && !quality.has(SignalQuality::LeadOff)) {
+        if (state.poorSinceUs < 0) state.poorSinceUs = nowUs;
+        if (nowUs - state.poorSinceUs >= PoorSignalAlarmUs) {
+            raise(state, data, AlarmInfo::ECGAbnormal, 2, "ECG信号质量差，请检查电极", KeyPoorSignal);
+        }
+    } else if (quality.isUsable()) {
+        state.poorSinceUs = -1;
+    }
+
+    // 生理报警只基于质量可用的连续心搏
+    if (!quality.isUsable()) return;
+
+    checkMorphology(state, data);
+
+    const int heartRate = heartRateOf(state.beats, nowUs);
+    if (heartRate <= 0) return;
+    if (heartRate > m_highHeartRate) {
+        raise(state, data, AlarmInfo::HighHeartRate, 4,
+              QString("心率过快: %1 bpm（ECG）").arg(heartRate), KeyHighHeartRate);
+    } else if (heartRate < m_lowHeartRate) {
+        raise(state, data, AlarmInfo::LowHeartRate, 4,
+              QString("心率过慢: %1 bpm（ECG）").arg(heartRate), KeyLowHeartRate);
+    }
+}
+
+void EcgAnalyzer::checkMorphology(DeviceState& state, const VitalSignData& data) {
+    const BeatMorphology& morphology = state.morphology.morphology();
+    if (!morphology.isValid()) return;
+
+    const qint64 nowUs = clockUs(data);
+    if (state.lastTrendUs < 0 || nowUs - state.lastTrendUs >= MorphologyTrendUs) {
+        state.lastTrendUs = nowUs;
+        m_pendingTrends.append(PendingTrend{data.deviceId, data.timestampUs, morphology});
+    }
+
+    if (qAbs(morphology.stMv) > m_morphologyLimits.stMv) {
+        raise(state, data, AlarmInfo::ECGAbnormal, 3,
+              QString("ST段%1: %2 mV").arg(morphology.stMv > 0 ? "抬高" : "压低")
+                  .arg(qAbs(morphology.stMv), 0, 'f', 2), KeyStDeviation);
+    }
+    if (morphology.qtcMs > m_morphologyLimits.qtcMs) {
+        raise(state, data, AlarmInfo::ECGAbnormal, 3,
+              QString("QTc延长: %1 ms").arg(qRound(morphology.qtcMs)), KeyQtc);
+    }
+    if (morphology.qrsMs > m_morphologyLimits.qrsMs) {
+        raise(state, data, AlarmInfo::ECGAbnormal, 2,
+              QString("QRS增宽: %1 ms").arg(qRound(morphology.qrsMs)), KeyQrs);
+    }
+}
+
+void EcgAnalyzer::raise(DeviceState& state, const VitalSignData& data, AlarmInfo::AlarmType type,
+                        int severity, const QString& message, int key) {
+    const qint64 nowUs = clockUs(data);
+    auto it = state.lastAlarmUs.constFind(key);
+    if (it != state.lastAlarmUs.cend() && nowUs - *it < AlarmCooldownUs) return;
+    state.lastAlarmUs.insert(key, nowUs);
+
+    AlarmInfo alarm;
+    alarm.deviceId = data.deviceId;
+    alarm.timestamp = data.dateTime();
+    alarm.type = type;
+    alarm.severity = severity;
+    alarm.message = data.deviceId.isEmpty() ? message : QString("[%1] %2").arg(data.deviceId, message);
+    qDebug() << "Local ECG alarm:" << alarm.message;
+    m_pendingAlarms.append(alarm);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include "VitalSignData.h"
+#include "SignalQuality.h"
+#include "QrsDetector.h"
+#include "MorphologyAnalyzer.h"
+#include "RhythmClassifier.h"
+
+// 本地实时ECG分析
+// 每帧先评估信号质量并写入data.signalQuality；只有质量可用的帧才进入QRS检测与心率报警判断，
+// 噪声段不会产生误报，也不浪费检测计算。导联脱落、信号质量差作为技术报警单独上报。
+// 形态分析后的心搏按RR与QRS宽度做心律分类（房颤、过缓/过速、停搏、室早），结束的事件交给数据库索引。
+// 检出的心搏送入形态分析，在中位数模板上测量ST偏移、QRS宽度与QTc，超限时上报ECG异常，并按分钟输出趋势。
+// 同一设备同类报警在冷却时间内只上报一次
+class EcgAnalyzer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit EcgAnalyzer(QObject* parent = nullptr);
+
+    // 在接收线程（GUI线程）中逐帧调用
+    void process(VitalSignData& data);
+
+    // 最近检出的本地心率（bpm），没有可用数据时为0
+    int localHeartRate(const QString& deviceId) const;
+
+    // 心率报警阈值（同时用于心律分类的过缓/过速）
+    void setHeartRateLimits(int low, int high);
+    // 停搏判定的RR长度
+    void setPauseThreshold(int pauseMs) { m_rhythmLimits.pauseMs = pauseMs; }
+
+    // 形态报警阈值；ST偏移取绝对值
+    struct MorphologyLimits {
+        double stMv = 0.2;
+        double qtcMs = 500.0;
+        double qrsMs = 120.0;
+    };
+    void setMorphologyLimits(const MorphologyLimits& limits) { m_morphologyLimits = limits; }
+
+    // 最近的模板测量结果，尚无模板时isValid()为false
+    BeatMorphology morphology(const QString& deviceId) const;
+
+    struct Stats {
+        qint64 frames;
+        qint64 gatedFrames;     // 质量不足、跳过QRS检测的帧
+        qint64 beats;
+        qint64 rejectedBeats;   // 与模板不匹配、未进入形态模板的心搏
+        qint64 episodes;        // 已结束的心律事件
+    };
+    Stats stats() const { return m_stats; }
+
+signals:
+    // 以下信号都在process()返回前、分析状态更新完毕后发出
+    void alarmRaised(const AlarmInfo& alarm);
+    // 每台设备每分钟一次的形态趋势点
+    void morphologyMeasured(const QString& deviceId, qint64 timestampUs, const BeatMorphology& morphology);
+    // 已结束的心律事件（停搏在发生时即结束）
+    void rhythmEpisodeFinished(const QString& deviceId, const RhythmEpisode& episode);
+
+private:
+    struct DeviceState {
+        SignalQualityAnalyzer quality;
+        QrsDetector detector{EcgFrame::DefaultSampleRate};
+        bool detectorStarted = false;
+        QVector<qint64> beats;          // 最近的R波时间
+        MorphologyAnalyzer morphology;
+        RhythmClassifier rhythm;
+        qint64 lastTrendUs = -1;        // 上次输出形态趋势的时间（clockUs）
+        qint64 poorSinceUs = -1;        // 质量持续不足的起点
+        qint64 leadOffSinceUs = -1;
+        QHash<int, qint64> lastAlarmUs; // 报警类型 -> 上次上报时间（clockUs）
+    };
+
+    void detectBeats(DeviceState& state, const VitalSignData& data);
+    void checkAlarms(DeviceState& state, const VitalSignData& data);
+    void checkMorphology(DeviceState& state, const VitalSignData& data);
+    void classifyRhythm(DeviceState& state, const VitalSignData& data);
+    void finishEpisodes(const QString& deviceId);
+    void raise(DeviceState& state, const VitalSignData& data, AlarmInfo::AlarmType type,
+               int severity, const QString& message, int key);
+    // 冷却与趋势间隔使用的时钟（微秒）
+    static qint64 clockUs(const VitalSignData& data);
+    static int heartRateOf(const QVector<qint64>& beats, qint64 nowUs);
+
+    QHash<QString, DeviceState> m_devices;
+    int m_lowHeartRate;
+    int m_highHeartRate;
+    MorphologyLimits m_morphologyLimits;
+    RhythmLimits m_rhythmLimits;
+    QVector<AnalyzedBeat> m_analyzedBeats;      // 逐帧复用
+    QVector<RhythmEpisode> m_finishedEpisodes;
+    struct PendingTrend {
+        QString deviceId;
+        qint64 timestampUs;
+        BeatMorphology morphology;
+    };
+    // 本帧的报警、趋势点与结束的心律事件，处理结束后发出
+    QVector<AlarmInfo> m_pendingAlarms;
+    QVector<PendingTrend> m_pendingTrends;
+    QVector<QPair<QString, RhythmEpisode>> m_pendingEpisodes;
+    Stats m_stats;
+};
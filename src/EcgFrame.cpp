@@ -0,0 +1,323 @@
+#include "EcgFrame.h"
+#include <QReadWriteLock>
+#include <QtAlgorithms>
+#include <cstring>
+#include <new>
+
+// ==================== EcgLead ====================
+
+namespace {
+
+const char* const LeadLabels[EcgLead::Count] = {
+    "I", "II", "III", "aVR", "aVL", "aVF", "V1", "V2", "V3", "V4", "V5", "V6"
+};
+
+} // namespace
+
+const char* EcgLead::label(int lead) {
+    return lead >= 0 && lead < Count ? LeadLabels[lead] : "";
+}
+
+int EcgLead::fromLabel(const char* text, int length) {
+    for (int lead = 0; lead < Count; ++lead) {
+        if (int(strlen(LeadLabels[lead])) == length && memcmp(LeadLabels[lead], text, length) == 0) {
+            return lead;
+        }
+    }
+    return -1;
+}
+
+int EcgLead::leadAt(quint16 leads, int position) {
+    for (int lead = 0; lead < Count; ++lead) {
+        if ((leads & bit(lead)) && position-- == 0) return lead;
+    }
+    return -1;
+}
+
+QStringList EcgLead::labels(quint16 leads) {
+    QStringList result;
+    if (leads == 0) {
+        result << "ECG";
+        return result;
+    }
+    for (int lead = 0; lead < Count; ++lead) {
+        if (leads & bit(lead)) result << LeadLabels[lead];
+    }
+    return result;
+}
+
+// ==================== EcgFrame ====================
+
+EcgFrame::EcgFrame(const EcgFrame& other) noexcept
+    : d(other.d)
+{
+    if (d) d->ref.ref();
+}
+
+EcgFrame& EcgFrame::operator=(const EcgFrame& other) noexcept {
+    if (other.d != d) {
+        if (other.d) other.d->ref.ref();
+        EcgFrameBlock* old = d;
+        d = other.d;
+        if (old && !old->ref.deref()) {
+            old->pool->release(old);
+        }
+    }
+    return *this;
+}
+
+EcgFrame& EcgFrame::operator=(EcgFrame&& other) noexcept {
+    if (this != &other) {
+        EcgFrameBlock* old = d;
+        d = other.d;
+        other.d = nullptr;
+        if (old && !old->ref.deref()) {
+            old->pool->release(old);
+        }
+    }
+    return *this;
+}
+
+EcgFrame::~EcgFrame() {
+    if (d && !d->ref.deref()) {
+        d->pool->release(d);
+    }
+}
+
+EcgFrame EcgFrame::allocate(EcgFramePool* pool, int sampleCount, qint64 timestampUs, int sampleRate,
+                            quint16 leads) {
+    if (sampleCount <= 0) return EcgFrame();
+
+    const int leadCount = qMax(1, int(qPopulationCount(leads)));
+    EcgFrameBlock* block = pool->acquire(sampleCount * leadCount);
+    block->sampleCount = sampleCount;
+    block->sampleRate = sampleRate;
+    block->timestampUs = timestampUs;
+    block->leadCount = leadCount;
+    block->leads = leads;
+    return EcgFrame(block);
+}
+
+EcgFrame EcgFrame::allocate(const QString& deviceId, int sampleCount, qint64 timestampUs, int sampleRate,
+                            quint16 leads) {
+    return allocate(EcgFramePool::forDevice(deviceId), sampleCount, timestampUs, sampleRate, leads);
+}
+
+EcgFrame EcgFrame::fromSamples(const QString& deviceId, const QVector<double>& samples,
+                               qint64 timestampUs, int sampleRate) {
+    EcgFrame frame = allocate(deviceId, samples.size(), timestampUs, sampleRate);
+    if (!frame.isEmpty()) {
+        float* out = frame.mutableData();
+        for (int i = 0; i < samples.size(); ++i) {
+            out[i] = static_cast<float>(samples[i]);
+        }
+    }
+    return frame;
+}
+
+float* EcgFrame::mutableData() {
+    Q_ASSERT_X(!isShared(), "EcgFrame::mutableData", "frame is already shared");
+    return d ? d->samples() : nullptr;
+}
+
+float* EcgFrame::mutableLead(int index) {
+    Q_ASSERT_X(!isShared(), "EcgFrame::mutableLead", "frame is already shared");
+    return d ? d->samples() + qsizetype(index) * d->sampleCount : nullptr;
+}
+
+void EcgFrame::setTimestampUs(qint64 timestampUs) {
+    Q_ASSERT(!isShared());
+    if (d) d->timestampUs = timestampUs;
+}
+
+void EcgFrame::setSampleRate(int sampleRate) {
+    Q_ASSERT(!isShared());
+    if (d) d->sampleRate = sampleRate;
+}
+
+void EcgFrame::setLeads(quint16 leads) {
+    Q_ASSERT(!isShared());
+    if (d && qMax(1, int(qPopulationCount(leads))) == d->leadCount) d->leads = leads;
+}
+
+void EcgFrame::truncate(int sampleCount) {
+    Q_ASSERT(!isShared());
+    if (d && sampleCount >= 0 && sampleCount < d->sampleCount) {
+        // 平面存放：后面的导联前移，保持各导联连续
+        float* samples = d->samples();
+        for (int lead = 1; lead < d->leadCount; ++lead) {
+            memmove(samples + qsizetype(lead) * sampleCount,
+                    samples + qsizetype(lead) * d->sampleCount, size_t(sampleCount) * sizeof(float));
+        }
+        d->sampleCount = sampleCount;
+    }
+}
+
+QVector<double> EcgFrame::toVector() const {
+    QVector<double> result;
+    result.reserve(size());
+    for (float value : *this) {
+        result.append(value);
+    }
+    return result;
+}
+
+// ==================== EcgFramePool ====================
+
+namespace {
+
+struct PoolRegistry {
+    QReadWriteLock lock;
+    QHash<QString, EcgFramePool*> byId;
+    QHash<QByteArray, EcgFramePool*> byUtf8;
+    EcgFramePool* overflow = nullptr;      // 设备池满后新设备共用
+};
+
+PoolRegistry& registry() {
+    static PoolRegistry instance;
+    return instance;
+}
+
+} // namespace
+
+EcgFramePool::EcgFramePool(const QString& deviceId, bool overflow)
+    : m_deviceId(deviceId)
+    , m_overflow(overflow)
+    , m_slabAllocations(0)
+    , m_acquired(0)
+    , m_oversized(0)
+{
+    m_freeLists.fill(nullptr);
+    m_freeCounts.fill(0);
+}
+
+EcgFramePool* EcgFramePool::forDevice(const QString& deviceId) {
+    PoolRegistry& reg = registry();
+    {
+        QReadLocker locker(&reg.lock);
+        EcgFramePool* pool = reg.byId.value(deviceId, nullptr);
+        if (pool) return pool;
+    }
+
+    QWriteLocker locker(&reg.lock);
+    EcgFramePool* pool = reg.byId.value(deviceId, nullptr);
+    if (!pool && reg.byId.size() >= MaxDevicePools) {
+        if (!reg.overflow) {
+            reg.overflow = new EcgFramePool(QString(), true);
+        }
+        pool = reg.overflow;
+    } else if (!pool) {
+        pool = new EcgFramePool(deviceId);
+        reg.byId.insert(deviceId, pool);
+        reg.byUtf8.insert(deviceId.toUtf8(), pool);
+    }
+    return pool;
+}
+
+EcgFramePool* EcgFramePool::forDeviceUtf8(const char* data, int size) {
+    PoolRegistry& reg = registry();
+    {
+        // fromRawData不复制数据，查找命中时无堆分配
+        QReadLocker locker(&reg.lock);
+        EcgFramePool* pool = reg.byUtf8.value(QByteArray::fromRawData(data, size), nullptr);
+        if (pool) return pool;
+    }
+    return forDevice(QString::fromUtf8(data, size));
+}
+
+int EcgFramePool::sizeClassFor(int sampleCount) {
+    int shift = MinClassShift;
+    while (shift <= MaxClassShift && (1 << shift) < sampleCount) {
+        ++shift;
+    }
+    return shift <= MaxClassShift ? shift - MinClassShift : -1;
+}
+
+size_t EcgFramePool::blockBytes(int sizeClass) {
+    return sizeof(EcgFrameBlock) + (size_t(1) << (sizeClass + MinClassShift)) * sizeof(float);
+}
+
+void EcgFramePool::growSlab(int sizeClass) {
+    const size_t bytes = blockBytes(sizeClass);
+    const int blocks = qMax(1, int(SlabBytes / bytes));
+
+    char* slab = static_cast<char*>(::operator new(bytes * blocks, std::align_val_t(alignof(EcgFrameBlock))));
+    for (int i = 0; i < blocks; ++i) {
+        EcgFrameBlock* block = new (slab + i * bytes) EcgFrameBlock;
+        block->sizeClass = sizeClass;
+        block->pool = this;
+        block->nextFree = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = block;
+    }
+    m_freeCounts[sizeClass] += blocks;
+    m_slabAllocations++;
+}
+
+EcgFrameBlock* EcgFramePool::acquire(int sampleCount) {
+    const int sizeClass = sizeClassFor(sampleCount);
+
+    EcgFrameBlock* block = nullptr;
+    if (sizeClass < 0) {
+        // 超大帧不入池
+        void* memory = ::operator new(sizeof(EcgFrameBlock) + size_t(sampleCount) * sizeof(float),
+                                      std::align_val_t(alignof(EcgFrameBlock)));
+        block = new (memory) EcgFrameBlock;
+        block->sizeClass = -1;
+        block->pool = this;
+
+        QMutexLocker locker(&m_mutex);
+        m_oversized++;
+        m_acquired++;
+    } else {
+        QMutexLocker locker(&m_mutex);
+        if (!m_freeLists[sizeClass]) {
+            growSlab(sizeClass);
+        }
+        block = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = block->nextFree;
+        m_freeCounts[sizeClass]--;
+        m_acquired++;
+    }
+
+    block->ref.storeRelaxed(1);
+    block->nextFree = nullptr;
+    return block;
+}
+
+void EcgFramePool::release(EcgFrameBlock* block) {
+    if (block->sizeClass < 0) {
+        block->~EcgFrameBlock();
+        ::operator delete(static_cast<void*>(block), std::align_val_t(alignof(EcgFrameBlock)));
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    block->nextFree = m_freeLists[block->sizeClass];
+    m_freeLists[block->sizeClass] = block;
+    m_freeCounts[block->sizeClass]++;
+}
+
+EcgFramePool::Stats EcgFramePool::stats() const {
+    QMutexLocker locker(&m_mutex);
+    Stats s = {m_slabAllocations, m_acquired, m_oversized, 0};
+    for (int count : m_freeCounts) {
+        s.freeBlocks += count;
+    }
+    return s;
+}
+
+EcgFramePool::Stats EcgFramePool::totalStats() {
+    Stats total = {0, 0, 0, 0};
+    PoolRegistry& reg = registry();
+    QReadLocker locker(&reg.lock);
+    QList<EcgFramePool*> pools = reg.byId.values();
+    if (reg.overflow) pools.append(reg.overflow);
+    for (EcgFramePool* pool : std::as_const(pools)) {
+        const Stats s = pool->stats();
+        total.slabAllocations += s.slabAllocations;
+        total.acquired += s.acquired;
+        total.oversized += s.oversized;
+        total.freeBlocks += s.freeBlocks;
+    }
+    return total;
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtAlgorithms>
+#include <array>
+
+class EcgFramePool;
+
+// 帧内存块：头部之后紧跟float采样，一次分配
+struct alignas(16) EcgFrameBlock {
+    QAtomicInt ref;
+    int sizeClass;          // 所属尺寸级别，-1表示超大帧（不入池）
+    int sampleCount;        // 每个导联的采样数
+    int sampleRate;
+    qint64 timestampUs;     // 首个采样的时间 (epoch µs)
+    EcgFramePool* pool;
+    EcgFrameBlock* nextFree;
+    int leadCount;
+    quint16 leads;          // 导联集合（EcgLead位掩码），0表示未标注的单导联
+
+    float* samples() { return reinterpret_cast<float*>(this + 1); }
+    const float* samples() const { return reinterpret_cast<const float*>(this + 1); }
+};
+
+// 标准12导联
+// 多导联帧按此顺序平面存放（导联0的全部采样在前），导联集合以位掩码表示
+struct EcgLead {
+    enum Id { I, II, III, aVR, aVL, aVF, V1, V2, V3, V4, V5, V6, Count };
+
+    static quint16 bit(int lead) { return quint16(1u << lead); }
+    static const char* label(int lead);
+    // 按标签查找导联，未知标签返回-1
+    static int fromLabel(const char* text, int length);
+    // 标准顺序的前count个导联
+    static quint16 firstLeads(int count) { return quint16((1u << qBound(0, count, int(Count))) - 1); }
+    // 导联在集合中的位置（平面存放的序号）
+    static int position(quint16 leads, int lead) { return int(qPopulationCount(quint16(leads & (bit(lead) - 1)))); }
+    // 集合中第position个导联
+    static int leadAt(quint16 leads, int position);
+    // 集合内各导联的标签；0（未标注的单导联）返回"ECG"
+    static QStringList labels(quint16 leads);
+};
+
+// 不可变、引用计数的ECG帧
+// 拷贝只增加引用计数，所有消费者（界面、数据库、云端队列）共享同一块内存；
+// 最后一个引用释放时内存块归还所属设备的slab池，稳态下不再触发堆分配。
+// 多导联帧各导联采样数相同；单导联接口（size/constData/begin/end/at）访问第一个导联
+class EcgFrame {
+public:
+    static constexpr int DefaultSampleRate = 100;
+    // 设备采样率的合理范围；重采样、QRS检测与频谱窗口都按采样率分配内存
+    static constexpr int MinSampleRate = 50;
+    static constexpr int MaxSampleRate = 2000;
+
+    // 负载中的采样率超出合理范围时按默认采样率处理
+    static int validSampleRate(int sampleRate) {
+        return sampleRate >= MinSampleRate && sampleRate <= MaxSampleRate ? sampleRate : DefaultSampleRate;
+    }
+
+    EcgFrame() noexcept : d(nullptr) {}
+    EcgFrame(const EcgFrame& other) noexcept;
+    EcgFrame(EcgFrame&& other) noexcept : d(other.d) { other.d = nullptr; }
+    EcgFrame& operator=(const EcgFrame& other) noexcept;
+    EcgFrame& operator=(EcgFrame&& other) noexcept;
+    ~EcgFrame();
+
+    // 从设备池分配一帧，采样内容由调用方通过mutableData()填充
+    // sampleCount为每个导联的采样数，leads为导联集合（0为未标注的单导联）
+    static EcgFrame allocate(EcgFramePool* pool, int sampleCount,
+                             qint64 timestampUs = 0, int sampleRate = DefaultSampleRate, quint16 leads = 0);
+    static EcgFrame allocate(const QString& deviceId, int sampleCount,
+                             qint64 timestampUs = 0, int sampleRate = DefaultSampleRate, quint16 leads = 0);
+
+    // 由double数组构造（兼容旧接口）
+    static EcgFrame fromSamples(const QString& deviceId, const QVector<double>& samples,
+                                qint64 timestampUs = 0, int sampleRate = DefaultSampleRate);
+
+    // 以下修改接口仅在帧被共享前使用
+    float* mutableData();
+    float* mutableLead(int index);
+    void setTimestampUs(qint64 timestampUs);
+    void setSampleRate(int sampleRate);
+    // 只改变导联标注，导联数必须不变
+    void setLeads(quint16 leads);
+    void truncate(int sampleCount);
+
+    bool isEmpty() const { return !d || d->sampleCount == 0; }
+    int size() const { return d ? d->sampleCount : 0; }
+    const float* constData() const { return d ? d->samples() : nullptr; }
+    const float* begin() const { return constData(); }
+    const float* end() const { return d ? d->samples() + d->sampleCount : nullptr; }
+    float at(int i) const { return d->samples()[i]; }
+    float operator[](int i) const { return d->samples()[i]; }
+
+    int leadCount() const { return d ? d->leadCount : 0; }
+    quint16 leads() const { return d ? d->leads : 0; }
+    const float* lead(int index) const { return d ? d->samples() + qsizetype(index) * d->sampleCount : nullptr; }
+    QStringList leadLabels() const { return EcgLead::labels(leads()); }
+
+    qint64 timestampUs() const { return d ? d->timestampUs : 0; }
+    int sampleRate() const { return d ? d->sampleRate : DefaultSampleRate; }
+    double durationSeconds() const { return d && d->sampleRate > 0 ? double(d->sampleCount) / d->sampleRate : 0.0; }
+
+    // 是否被多个持有者共享
+    bool isShared() const { return d && d->ref.loadRelaxed() > 1; }
+
+    QVector<double> toVector() const;
+
+private:
+    explicit EcgFrame(EcgFrameBlock* block) noexcept : d(block) {}
+
+    EcgFrameBlock* d;
+};
+
+// 按设备划分的帧slab池
+// 每个尺寸级别（64..65536采样，按2的幂）维护空闲链表，slab一次分配多块，常驻不归还。
+// 仍有帧引用时池不能释放，因此设备池数量有上限：之后新出现的设备共用一个溢出池，注册表不再增长
+class EcgFramePool {
+public:
+    static constexpr int MaxDevicePools = 256;
+
+    // 获取设备对应的池（首次访问时创建，之后常驻）；设备池已满时返回溢出池
+    static EcgFramePool* forDevice(const QString& deviceId);
+    // 以UTF-8字节查找，供解析器在不构造QString的情况下定位设备池
+    static EcgFramePool* forDeviceUtf8(const char* data, int size);
+
+    // 溢出池的deviceId为空，由多台设备共用
+    const QString& deviceId() const { return m_deviceId; }
+    bool isOverflow() const { return m_overflow; }
+
+    EcgFrameBlock* acquire(int sampleCount);
+    void release(EcgFrameBlock* block);
+
+    struct Stats {
+        qint64 slabAllocations;  // slab分配次数（堆分配）
+        qint64 acquired;         // 累计取出块数
+        qint64 oversized;        // 超大帧直接分配次数
+        int freeBlocks;          // 当前空闲块
+    };
+    Stats stats() const;
+
+    // 所有设备池合计
+    static Stats totalStats();
+
+private:
+    explicit EcgFramePool(const QString& deviceId, bool overflow = false);
+
+    static constexpr int MinClassShift = 6;   // 64采样
+    static constexpr int MaxClassShift = 16;  // 65536采样
+    static constexpr int ClassCount = MaxClassShift - MinClassShift + 1;
+    static constexpr int SlabBytes = 64 * 1024;
+
+    static int sizeClassFor(int sampleCount);
+    static size_t blockBytes(int sizeClass);
+
+    void growSlab(int sizeClass);
+
+    QString m_deviceId;
+    bool m_overflow;
+    mutable QMutex m_mutex;
+    std::array<EcgFrameBlock*, ClassCount> m_freeLists;
+    std::array<int, ClassCount> m_freeCounts;
+    qint64 m_slabAllocations;
+    qint64 m_acquired;
+    qint64 m_oversized;
+};
@@ -0,0 +1,244 @@
+#include "EcgGridRenderer.h"
+#include <QPainter>
+#include <algorithm>
+
+namespace {
+
+const int GridSize = 20;
+const int MaxRowsPerColumn = 6;
+
+} // namespace
+
+EcgGridRenderer::EcgGridRenderer(int capacity)
+    : m_capacity(qMax(1, capacity))
+    , m_gain(10.0)
+    , m_leads(0)
+    , m_leadCount(0)
+    , m_inputRate(0)
+    , m_head(0)
+    , m_filled(0)
+    , m_nextInputUs(-1)
+    , m_currentQuality(EcgGridSnapshot::QualityGood)
+{
+}
+
+void EcgGridRenderer::clear() {
+    m_leads = 0;
+    m_leadCount = 0;
+    m_inputRate = 0;
+    m_resamplers.clear();
+    m_buffers.clear();
+    m_quality.clear();
+    m_head = 0;
+    m_filled = 0;
+    m_nextInputUs = -1;
+    m_currentQuality = EcgGridSnapshot::QualityGood;
+}
+
+void EcgGridRenderer::reset(const EcgFrame& frame) {
+    m_leads = frame.leads();
+    m_leadCount = frame.leadCount();
+    m_inputRate = frame.sampleRate();
+
+    m_resamplers.clear();
+    m_resamplers.reserve(m_leadCount);
+    for (int lead = 0; lead < m_leadCount; ++lead) {
+        m_resamplers.emplace_back(m_inputRate, DisplayRate);
+    }
+    m_buffers.fill(QVector<float>(m_capacity, 0.0f), m_leadCount);
+    m_quality.fill(EcgGridSnapshot::QualityGood, m_capacity);
+    m_head = 0;
+    m_filled = 0;
+    m_nextInputUs = -1;
+}
+
+void EcgGridRenderer::append(const EcgFrame& frame, const SignalQuality& quality) {
+    if (frame.isEmpty()) return;
+
+    if (frame.leads() != m_leads || frame.leadCount() != m_leadCount || frame.sampleRate() != m_inputRate) {
+        reset(frame);
+    } else if (m_nextInputUs >= 0 &&
+               qAbs(frame.timestampUs() - m_nextInputUs) > 500000 / qMax(1, frame.sampleRate())) {
+        for (PolyphaseResampler& resampler : m_resamplers) {
+            resampler.reset();
+        }
+    }
+    m_nextInputUs = frame.timestampUs() + qint64(frame.durationSeconds() * 1e6);
+
+    if (quality.has(SignalQuality::LeadOff)) {
+        m_currentQuality = EcgGridSnapshot::QualityLeadOff;
+    } else {
+        m_currentQuality = quality.isUsable() ? EcgGridSnapshot::QualityGood : EcgGridSnapshot::QualityPoor;
+    }
+
+    // 各导联滤波器状态一致，输出采样数相同
+    int produced = 0;
+    for (int lead = 0; lead < m_leadCount; ++lead) {
+        m_resampled.resize(0);
+        m_resamplers[lead].process(frame.lead(lead), frame.size(), m_resampled);
+        produced = m_resampled.size();
+
+        // 超过容量时只保留最新的部分
+        const int skip = qMax(0, produced - m_capacity);
+        float* ring = m_buffers[lead].data();
+        int position = (m_head + skip) % m_capacity;
+        for (int i = skip; i < produced; ) {
+            const int chunk = qMin(produced - i, m_capacity - position);
+            std::copy(m_resampled.cbegin() + i, m_resampled.cbegin() + i + chunk, ring + position);
+            i += chunk;
+            position = (position + chunk) % m_capacity;
+        }
+    }
+
+    for (int i = qMax(0, produced - m_capacity); i < produced; ++i) {
+        m_quality[(m_head + i) % m_capacity] = m_currentQuality;
+    }
+    m_head = (m_head + produced) % m_capacity;
+    m_filled = qMin(m_capacity, m_filled + produced);
+}
+
+EcgGridSnapshot EcgGridRenderer::snapshot(const QRect& rect) const {
+    EcgGridSnapshot snapshot;
+    snapshot.leads = m_leads;
+    snapshot.leadCount = m_leadCount;
+    snapshot.gain = m_gain;
+    snapshot.currentQuality = m_currentQuality;
+    if (m_leadCount == 0) return snapshot;
+
+    // 每个格子一个像素一个采样，只复制能显示的部分
+    const int visible = qMin(m_filled, EcgGridRaster::cellRect(rect, m_leadCount, 0).width());
+    if (visible < 2) return snapshot;
+    snapshot.sampleCount = visible;
+
+    const int first = (m_head - visible + m_capacity) % m_capacity;
+    const int firstChunk = qMin(visible, m_capacity - first);
+    snapshot.samples.resize(m_leadCount * visible);
+    for (int lead = 0; lead < m_leadCount; ++lead) {
+        const float* ring = m_buffers[lead].constData();
+        float* out = snapshot.samples.data() + lead * visible;
+        std::copy(ring + first, ring + first + firstChunk, out);
+        std::copy(ring, ring + (visible - firstChunk), out + firstChunk);
+    }
+    snapshot.quality.resize(visible);
+    std::copy(m_quality.cbegin() + first, m_quality.cbegin() + first + firstChunk, snapshot.quality.begin());
+    std::copy(m_quality.cbegin(), m_quality.cbegin() + (visible - firstChunk), snapshot.quality.begin() + firstChunk);
+    return snapshot;
+}
+
+void EcgGridRenderer::render(QPainter& painter, const QRect& rect) {
+    m_raster.paint(painter, rect, snapshot(rect));
+}
+
+// ==================== EcgGridRaster ====================
+
+QRect EcgGridRaster::cellRect(const QRect& rect, int leadCount, int lead) {
+    leadCount = qMax(1, leadCount);
+    const int columns = leadCount > MaxRowsPerColumn ? 2 : 1;
+    const int rows = (leadCount + columns - 1) / columns;
+    const int cellWidth = rect.width() / columns;
+    const int cellHeight = rect.height() / rows;
+    return QRect(rect.left() + (lead / rows) * cellWidth, rect.top() + (lead % rows) * cellHeight,
+                 cellWidth, cellHeight);
+}
+
+void EcgGridRaster::ensureBackgrounds(const QSize& cellSize, const EcgGridSnapshot& snapshot,
+                                      qreal devicePixelRatio) {
+    const int count = qMax(1, snapshot.leadCount);
+    if (cellSize == m_backgroundSize && snapshot.leads == m_backgroundLeads &&
+        devicePixelRatio == m_backgroundRatio && m_backgrounds.size() == count) {
+        return;
+    }
+
+    m_backgroundSize = cellSize;
+    m_backgroundLeads = snapshot.leads;
+    m_backgroundRatio = devicePixelRatio;
+    m_backgrounds.resize(count);
+    const QStringList labels = EcgLead::labels(snapshot.leads);
+    for (int lead = 0; lead < count; ++lead) {
+        QImage& background = m_backgrounds[lead];
+        background = QImage(cellSize.expandedTo(QSize(1, 1)) * devicePixelRatio,
+                            QImage::Format_ARGB32_Premultiplied);
+        background.setDevicePixelRatio(devicePixelRatio);
+        background.fill(Qt::transparent);
+
+        QPainter painter(&background);
+        painter.setPen(QPen(Qt::lightGray, 0.5));
+        for (int x = 0; x < cellSize.width(); x += GridSize) {
+            painter.drawLine(x, 0, x, cellSize.height());
+        }
+        for (int y = 0; y < cellSize.height(); y += GridSize) {
+            painter.drawLine(0, y, cellSize.width(), y);
+        }
+
+        // 未标注的单导联（旧设备）不显示导联名
+        if (snapshot.leads != 0 && lead < labels.size()) {
+            painter.setPen(Qt::darkGray);
+            painter.setFont(QFont("Arial", 10, QFont::Bold));
+            painter.drawText(QRect(4, 2, cellSize.width() - 8, cellSize.height() - 4),
+                             Qt::AlignTop | Qt::AlignLeft, labels[lead]);
+        }
+    }
+}
+
+void EcgGridRaster::drawLead(QPainter& painter, const EcgGridSnapshot& snapshot, int lead, const QRect& cell) {
+    // 质量可用为绿色，质量差为黄色，导联脱落为灰色
+    static const QPen pens[] = {
+        QPen(Qt::green, 2),
+        QPen(QColor(230, 180, 0), 2),
+        QPen(Qt::gray, 2)
+    };
+
+    const int visible = qMin(snapshot.sampleCount, cell.width());
+    if (visible < 2) return;
+
+    // 可见部分靠右对齐，最新采样在右端
+    const int skip = snapshot.sampleCount - visible;
+    const float* samples = snapshot.samples.constData() + lead * snapshot.sampleCount + skip;
+    const quint8* quality = snapshot.quality.constData() + skip;
+    const double centerY = cell.top() + cell.height() / 2.0;
+
+    m_polyline.resize(0);
+    quint8 level = quality[0];
+    for (int k = 0; k < visible; ++k) {
+        const QPointF point(cell.left() + k, centerY - samples[k] * snapshot.gain);
+        if (quality[k] != level) {
+            // 换色：当前段画出，新段从上一点接续
+            painter.setPen(pens[level]);
+            painter.drawPolyline(m_polyline.constData(), m_polyline.size());
+            const QPointF last = m_polyline.last();
+            m_polyline.resize(0);
+            m_polyline.append(last);
+            level = quality[k];
+        }
+        m_polyline.append(point);
+    }
+    painter.setPen(pens[level]);
+    painter.drawPolyline(m_polyline.constData(), m_polyline.size());
+}
+
+void EcgGridRaster::paint(QPainter& painter, const QRect& rect, const EcgGridSnapshot& snapshot) {
+    const int count = qMax(1, snapshot.leadCount);
+    ensureBackgrounds(cellRect(rect, snapshot.leadCount, 0).size(), snapshot,
+                      painter.device() ? painter.device()->devicePixelRatioF() : 1.0);
+
+    for (int lead = 0; lead < count; ++lead) {
+        const QRect cell = cellRect(rect, snapshot.leadCount, lead);
+        painter.drawImage(cell.topLeft(), m_backgrounds[lead]);
+    }
+
+    painter.save();
+    for (int lead = 0; lead < snapshot.leadCount; ++lead) {
+        const QRect cell = cellRect(rect, snapshot.leadCount, lead);
+        painter.setClipRect(cell);
+        drawLead(painter, snapshot, lead, cell);
+    }
+    painter.restore();
+
+    if (snapshot.leadCount > 0 && snapshot.currentQuality != EcgGridSnapshot::QualityGood) {
+        const bool leadOff = snapshot.currentQuality == EcgGridSnapshot::QualityLeadOff;
+        painter.setPen(leadOff ? Qt::red : QColor(200, 140, 0));
+        painter.setFont(QFont("Arial", 14, QFont::Bold));
+        painter.drawText(rect.adjusted(10, 10, -10, -10), Qt::AlignTop | Qt::AlignRight,
+                         leadOff ? "导联脱落" : "信号质量差");
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <QImage>
+#include <QPolygonF>
+#include <QRect>
+#include <QVector>
+#include <vector>
+#include "EcgFrame.h"
+#include "PolyphaseResampler.h"
+#include "SignalQuality.h"
+
+class QPainter;
+
+// 一次绘制所需的数据：各导联最近的可见采样（最旧在前）
+// 与接收状态分离，可以交给工作线程栅格化
+struct EcgGridSnapshot {
+    enum QualityLevel : quint8 { QualityGood, QualityPoor, QualityLeadOff };
+
+    quint16 leads = 0;
+    int leadCount = 0;
+    int sampleCount = 0;                        // 每导联的采样数
+    double gain = 10.0;
+    QualityLevel currentQuality = QualityGood;  // 最新一帧的质量，用于提示
+    QVector<float> samples;                     // 导联平面，每导联sampleCount个
+    QVector<quint8> quality;                    // 逐采样的QualityLevel，各导联共用
+};
+
+// 多导联网格栅格化
+// 不超过6个导联时单列排布，更多时两列（肢体导联在左，胸导联在右）。每个导联格子的背景（网格线与导联名）
+// 缓存为QImage，格子尺寸或导联集合变化时才重建；波形按质量颜色分段，每段一次drawPolyline。
+// 只使用QImage，可在工作线程中运行；缓存不加锁，同一时刻只能有一个绘制者
+class EcgGridRaster {
+public:
+    static QRect cellRect(const QRect& rect, int leadCount, int lead);
+
+    void paint(QPainter& painter, const QRect& rect, const EcgGridSnapshot& snapshot);
+
+private:
+    void ensureBackgrounds(const QSize& cellSize, const EcgGridSnapshot& snapshot, qreal devicePixelRatio);
+    void drawLead(QPainter& painter, const EcgGridSnapshot& snapshot, int lead, const QRect& cell);
+
+    QSize m_backgroundSize;
+    quint16 m_backgroundLeads = 0;
+    qreal m_backgroundRatio = 0.0;
+    QVector<QImage> m_backgrounds;      // 每导联一张
+    QPolygonF m_polyline;
+};
+
+// 多导联ECG实时波形
+// 各导联重采样到统一的显示采样率后写入环形缓冲，所有导联共用一条时间轴（同一横坐标为同一时刻），
+// 最新采样在右端。绘制时先截取可见部分（snapshot），再由EcgGridRaster栅格化
+class EcgGridRenderer {
+public:
+    // 显示采样率：每个采样占一个像素
+    static constexpr int DisplayRate = 100;
+
+    explicit EcgGridRenderer(int capacity = 5000);
+
+    // 追加一帧的全部导联；导联集合或采样率变化时清空重新开始，帧间有缺口时清空滤波器历史
+    void append(const EcgFrame& frame, const SignalQuality& quality = SignalQuality());
+    void clear();
+
+    // 增益（像素/mV）
+    void setGain(double gain) { m_gain = gain; }
+    double gain() const { return m_gain; }
+
+    int leadCount() const { return m_leadCount; }
+    quint16 leads() const { return m_leads; }
+
+    // 截取在rect内绘制所需的数据
+    EcgGridSnapshot snapshot(const QRect& rect) const;
+
+    // 在rect内同步绘制全部导联
+    void render(QPainter& painter, const QRect& rect);
+
+private:
+    void reset(const EcgFrame& frame);
+
+    int m_capacity;
+    double m_gain;
+    quint16 m_leads;
+    int m_leadCount;
+    int m_inputRate;
+    std::vector<PolyphaseResampler> m_resamplers;   // 每导联一个
+    QVector<QVector<float>> m_buffers;              // 每导联的环形缓冲
+    QVector<quint8> m_quality;                      // 逐采样的QualityLevel，各导联共用
+    int m_head;                                     // 下一个写入位置
+    int m_filled;
+    qint64 m_nextInputUs;                           // 下一帧预期的起始时间，用于发现缺口
+    EcgGridSnapshot::QualityLevel m_currentQuality;
+    QVector<float> m_resampled;
+    EcgGridRaster m_raster;
+};
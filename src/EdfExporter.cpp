@@ -0,0 +1,431 @@
+#include "EdfExporter.h"
+#include "DatabaseManager.h"
+#include "WaveformStore.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const qint64 RecordDurationUs = 1000000;    // 每条数据记录1秒
+const int AnnotationSamples = 128;          // 每条记录256字节注释
+const int RecordsPerChunk = 60;             // 每个并行编码任务一分钟数据
+const int MaxAlarmTextBytes = 80;
+
+struct SignalSpec {
+    const char* label;
+    const char* transducer;
+    const char* dimension;
+    double physicalMin;
+    double physicalMax;
+    int digitalMin;
+    int digitalMax;
+};
+
+// 顺序与数据记录中的存放顺序一致，最后一路为注释
+const SignalSpec Signals[] = {
+    {"ECG", "ECG electrode", "mV", -10.0, 10.0, -32768, 32767},
+    {"HR", "", "bpm", 0.0, 300.0, 0, 300},
+    {"SpO2", "", "%", 0.0, 100.0, 0, 100},
+    {"Temp", "", "degC", 30.0, 45.0, 3000, 4500},
+    {"EDF Annotations", "", "", -1.0, 1.0, -32768, 32767}
+};
+const int SignalCount = sizeof(Signals) / sizeof(Signals[0]);
+
+void appendField(QByteArray& header, const QByteArray& value, int width) {
+    const QByteArray field = value.left(width);
+    header.append(field);
+    header.append(width - field.size(), ' ');
+}
+
+// EDF+ 头部子字段只允许可打印ASCII，空格以下划线代替，未知值写X
+QByteArray edfToken(const QString& text) {
+    QByteArray token;
+    for (QChar c : text) {
+        const ushort u = c.unicode();
+        token.append(u > 32 && u < 127 ? char(u) : '_');
+    }
+    return token.isEmpty() ? QByteArray("X") : token;
+}
+
+// TAL时间："+秒[.小数]"
+QByteArray formatOnset(qint64 us) {
+    QByteArray out;
+    out.append(us < 0 ? '-' : '+');
+    us = qAbs(us);
+    out.append(QByteArray::number(us / 1000000));
+
+    qint64 fraction = us % 1000000;
+    if (fraction != 0) {
+        char digits[6];
+        for (int i = 5; i >= 0; --i) {
+            digits[i] = char('0' + fraction % 10);
+            fraction /= 10;
+        }
+        int length = 6;
+        while (digits[length - 1] == '0') --length;
+        out.append('.');
+        out.append(digits, length);
+    }
+    return out;
+}
+
+QByteArray alarmAnnotation(qint64 onsetUs, const QString& text) {
+    // TAL中不得出现分隔符0x14/0x15/0x00
+    QString clean = text;
+    clean.remove(QChar(0x14)).remove(QChar(0x15)).remove(QChar(0));
+    while (clean.toUtf8().size() > MaxAlarmTextBytes) {
+        clean.chop(1);
+    }
+
+    QByteArray tal = formatOnset(onsetUs);
+    tal.append('\x14');
+    tal.append(clean.toUtf8());
+    tal.append('\x14');
+    tal.append('\0');
+    return tal;
+}
+
+inline void appendDigital(char*& out, double value, const SignalSpec& spec) {
+    const double scaled = (value - spec.physicalMin) * (spec.digitalMax - spec.digitalMin) /
+                          (spec.physicalMax - spec.physicalMin) + spec.digitalMin;
+    const qint16 digital = qint16(qBound<double>(spec.digitalMin, std::round(scaled), spec.digitalMax));
+    // EDF为小端16位整数
+    out[0] = char(digital & 0xff);
+    out[1] = char((digital >> 8) & 0xff);
+    out += 2;
+}
+
+// 把一组原始记录编码为EDF数据记录（在线程池中并行执行）
+QByteArray encodeRecords(const QVector<EdfExporter::RawRecord>& records, int samplesPerRecord) {
+    const int recordBytes = 2 * (samplesPerRecord + 3 + AnnotationSamples);
+    QByteArray bytes(records.size() * recordBytes, '\0');
+    char* out = bytes.data();
+
+    for (const EdfExporter::RawRecord& record : records) {
+        char* recordStart = out;
+        for (float value : record.ecg) {
+            appendDigital(out, value, Signals[0]);
+        }
+        appendDigital(out, record.heartRate, Signals[1]);
+        appendDigital(out, record.oxygenSaturation, Signals[2]);
+        appendDigital(out, record.temperature, Signals[3]);
+
+        // 第一条TAL为记录时间标注，其后是报警注释，其余补0
+        QByteArray timekeeping = formatOnset(record.onsetUs);
+        timekeeping.append("\x14\x14", 2);
+        timekeeping.append('\0');
+        memcpy(out, timekeeping.constData(), timekeeping.size());
+        memcpy(out + timekeeping.size(), record.annotations.constData(), record.annotations.size());
+
+        out = recordStart + recordBytes;
+    }
+    return bytes;
+}
+
+QByteArray buildHeader(const EdfExporter::Options& options, qint64 startUs, int sampleRate) {
+    static const char* months[] = {"JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                   "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"};
+    const QDateTime start = QDateTime::fromMSecsSinceEpoch(startUs / 1000);
+    const QDate date = start.date();
+
+    QByteArray header;
+    header.reserve(256 * (SignalCount + 1));
+    appendField(header, "0", 8);
+    // 患者: 编号 性别 出生日期 姓名；记录: Startdate 日期 检查号 技师 设备
+    appendField(header, edfToken(options.deviceId) + " X X " + edfToken(options.patientName), 80);
+    appendField(header, "Startdate " + QByteArray::number(date.day()).rightJustified(2, '0') + "-" +
+                        months[date.month() - 1] + "-" + QByteArray::number(date.year()) +
+                        " X X ecg_app", 80);
+    appendField(header, start.toString("dd.MM.yy").toLatin1(), 8);
+    appendField(header, start.toString("hh.mm.ss").toLatin1(), 8);
+    appendField(header, QByteArray::number(256 * (SignalCount + 1)), 8);
+    appendField(header, "EDF+D", 44);       // 结束时若无缺口改为EDF+C
+    appendField(header, "-1", 8);           // 记录数，结束时回填
+    appendField(header, QByteArray::number(RecordDurationUs / 1000000), 8);
+    appendField(header, QByteArray::number(SignalCount), 4);
+
+    for (const SignalSpec& spec : Signals) appendField(header, spec.label, 16);
+    for (const SignalSpec& spec : Signals) appendField(header, spec.transducer, 80);
+    for (const SignalSpec& spec : Signals) appendField(header, spec.dimension, 8);
+    for (const SignalSpec& spec : Signals) appendField(header, QByteArray::number(spec.physicalMin), 8);
+    for (const SignalSpec& spec : Signals) appendField(header, QByteArray::number(spec.physicalMax), 8);
+    for (const SignalSpec& spec : Signals) appendField(header, QByteArray::number(spec.digitalMin), 8);
+    for (const SignalSpec& spec : Signals) appendField(header, QByteArray::number(spec.digitalMax), 8);
+    for (int i = 0; i < SignalCount; ++i) appendField(header, "", 80);
+    appendField(header, QByteArray::number(sampleRate), 8);
+    appendField(header, "1", 8);
+    appendField(header, "1", 8);
+    appendField(header, "1", 8);
+    appendField(header, QByteArray::number(AnnotationSamples), 8);
+    for (int i = 0; i < SignalCount; ++i) appendField(header, "", 32);
+
+    return header;
+}
+
+} // namespace
+
+EdfExporter::EdfExporter(const QString& dbPath, WaveformStore* waveformStore, QObject* parent)
+    : FileExporter(dbPath, waveformStore, parent)
+{
+}
+
+EdfExporter::~EdfExporter() {
+    stopThread();
+}
+
+bool EdfExporter::start(const Options& options) {
+    return startThread([this, options]() { exportRows(options); });
+}
+
+bool EdfExporter::exportNow(const Options& options) {
+    m_cancelled = false;
+    return exportRows(options);
+}
+
+bool EdfExporter::exportRows(const Options& options) {
+    return exportFile(options.filePath, "EDF", [this, &options](QSqlDatabase& db, QFile& file, qint64& records) {
+        return writeRecording(db, file, options, records);
+    });
+}
+
+QString EdfExporter::writeRecording(QSqlDatabase& db, QFile& file, const Options& options, qint64& records) {
+    if (!m_waveformStore) {
+        return "波形存储不可用";
+    }
+
+    const qint64 rangeStartUs = options.startTime.toMSecsSinceEpoch() * 1000;
+    const qint64 rangeEndUs = options.endTime.toMSecsSinceEpoch() * 1000;
+
+    // 报警数量远小于波形，一次读入；只写入本设备的报警（升级前没有设备ID的旧报警不写入）
+    QVector<QPair<qint64, QString>> alarms;
+    {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.prepare(R"(
+            SELECT timestamp, severity, message
+            FROM alarms
+            WHERE device_id = :device_id AND timestamp BETWEEN :start AND :end
+            ORDER BY timestamp ASC
+        )");
+        query.bindValue(":device_id", options.deviceId);
+        query.bindValue(":start", options.startTime);
+        query.bindValue(":end", options.endTime);
+        if (!query.exec()) {
+            return "查询报警失败: " + query.lastError().text();
+        }
+        while (query.next()) {
+            alarms.append({query.value(0).toDateTime().toMSecsSinceEpoch() * 1000,
+                           QString("Alarm S%1: %2").arg(query.value(1).toInt()).arg(query.value(2).toString())});
+        }
+    }
+
+    // 生理参数按时间与波形合并（只进游标）
+    QSqlQuery vitals(db);
+    vitals.setForwardOnly(true);
+    vitals.prepare(R"(
+        SELECT timestamp, temperature, oxygen_saturation, heart_rate
+        FROM vital_signs
+        WHERE device_id = :device_id AND timestamp BETWEEN :start AND :end
+        ORDER BY timestamp ASC
+    )");
+    vitals.bindValue(":device_id", options.deviceId);
+    vitals.bindValue(":start", options.startTime);
+    vitals.bindValue(":end", options.endTime);
+    if (!vitals.exec()) {
+        return "查询数据失败: " + vitals.lastError().text();
+    }
+    bool vitalsPending = vitals.next();
+    int heartRate = 0;
+    int oxygenSaturation = 0;
+    double temperature = 0.0;
+
+    QString error;
+    int sampleRate = 0;
+    qint64 startUs = 0;
+    bool discontinuous = false;
+    int skippedFrames = 0;
+    int alarmIndex = 0;
+
+    RawRecord current;
+    qint64 currentOnsetAbsUs = 0;
+    qint64 lastRecordEndUs = -1;
+    bool haveCurrent = false;
+    QVector<RawRecord> chunk;
+    QVector<QVector<RawRecord>> batch;
+    const int batchChunks = qMax(2, QThread::idealThreadCount() * 2);
+
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+
+    auto flushBatch = [&]() {
+        if (batch.isEmpty() || !error.isEmpty()) return;
+
+        // 各块并行编码，按原顺序拼接
+        const int samplesPerRecord = sampleRate;
+        const QByteArray bytes = QtConcurrent::blockingMappedReduced<QByteArray>(
+            batch,
+            [samplesPerRecord](const QVector<RawRecord>& records) {
+                return encodeRecords(records, samplesPerRecord);
+            },
+            [](QByteArray& result, const QByteArray& part) { result.append(part); },
+            QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce);
+
+        for (const auto& part : std::as_const(batch)) {
+            records += part.size();
+        }
+        batch.clear();
+
+        if (file.write(bytes) != bytes.size()) {
+            error = "写入EDF文件失败: " + file.errorString();
+        }
+    };
+
+    // trailing为true时是最后一条数据记录之后追加的注释记录，剩余报警不论时间都写入
+    auto finishRecord = [&](bool trailing) {
+        current.ecg.resize(sampleRate);     // 缺口前的残缺记录补0
+        const qint64 recordEndUs = currentOnsetAbsUs + RecordDurationUs;
+
+        while (vitalsPending) {
+            const qint64 timestampUs = vitals.value(0).toDateTime().toMSecsSinceEpoch() * 1000;
+            if (timestampUs >= recordEndUs) break;
+            temperature = vitals.value(1).toDouble();
+            oxygenSaturation = vitals.value(2).toInt();
+            heartRate = vitals.value(3).toInt();
+            vitalsPending = vitals.next();
+        }
+        current.heartRate = heartRate;
+        current.oxygenSaturation = oxygenSaturation;
+        current.temperature = temperature;
+
+        // 放不下的报警顺延到下一条记录（TAL带绝对时间）
+        const int capacity = AnnotationSamples * 2 - (formatOnset(current.onsetUs).size() + 3);
+        while (alarmIndex < alarms.size() && (trailing || alarms[alarmIndex].first < recordEndUs)) {
+            const QByteArray tal = alarmAnnotation(alarms[alarmIndex].first - startUs, alarms[alarmIndex].second);
+            if (current.annotations.size() + tal.size() > capacity) break;
+            current.annotations.append(tal);
+            alarmIndex++;
+        }
+
+        chunk.append(current);
+        current = RawRecord();
+        lastRecordEndUs = recordEndUs;
+        haveCurrent = false;
+
+        if (chunk.size() == RecordsPerChunk) {
+            batch.append(chunk);
+            chunk.clear();
+            if (batch.size() >= batchChunks) {
+                flushBatch();
+            }
+        }
+    };
+
+    m_waveformStore->readRange(options.deviceId, rangeStartUs, rangeEndUs,
+                               [&](const WaveformFrameView& frame) {
+        if (m_cancelled || !error.isEmpty()) return false;
+
+        if (sampleRate == 0) {
+            // 头部信息取自第一帧：采样率与起始时间（取整到秒，首条记录的时间标注给出小数部分）
+            sampleRate = frame.sampleRate;
+            startUs = frame.timestampUs - ((frame.timestampUs % 1000000) + 1000000) % 1000000;
+            const QByteArray header = buildHeader(options, startUs, sampleRate);
+            if (file.write(header) != header.size()) {
+                error = "写入EDF文件失败: " + file.errorString();
+                return false;
+            }
+        }
+        if (frame.sampleRate != sampleRate) {
+            skippedFrames++;
+            return true;
+        }
+
+        const double samplePeriodUs = 1e6 / sampleRate;
+        if (haveCurrent) {
+            const qint64 expectedUs = currentOnsetAbsUs + qint64(current.ecg.size() * samplePeriodUs);
+            if (qAbs(frame.timestampUs - expectedUs) > samplePeriodUs / 2) {
+                finishRecord(false);
+                discontinuous = true;
+            }
+        } else if (lastRecordEndUs >= 0 && qAbs(frame.timestampUs - lastRecordEndUs) > samplePeriodUs / 2) {
+            discontinuous = true;
+        }
+
+        int consumed = 0;
+        while (consumed < frame.sampleCount) {
+            if (!haveCurrent) {
+                currentOnsetAbsUs = frame.timestampUs + qint64(consumed * samplePeriodUs);
+                current.onsetUs = currentOnsetAbsUs - startUs;
+                current.ecg.reserve(sampleRate);
+                haveCurrent = true;
+            }
+            const int filled = current.ecg.size();
+            const int take = qMin(sampleRate - filled, frame.sampleCount - consumed);
+            current.ecg.resize(filled + take);
+            std::copy(frame.samples + consumed, frame.samples + consumed + take, current.ecg.begin() + filled);
+            consumed += take;
+            if (current.ecg.size() == sampleRate) {
+                finishRecord(false);
+            }
+        }
+
+        if (progressTimer.elapsed() >= 100) {
+            progressTimer.restart();
+            const qint64 spanUs = qMax<qint64>(1, rangeEndUs - rangeStartUs);
+            emit progress(records, int(qBound<qint64>(0, (frame.timestampUs - rangeStartUs) * 100 / spanUs, 100)));
+        }
+        return error.isEmpty();
+    });
+
+    if (m_cancelled) {
+        return "导出已取消";
+    }
+    if (!error.isEmpty()) {
+        return error;
+    }
+    if (sampleRate == 0) {
+        return "所选时间段内没有该设备的波形数据";
+    }
+
+    if (haveCurrent) {
+        finishRecord(false);
+    }
+    // 最后一条记录之后（或因注释空间不足顺延到最后）的报警写入紧接其后的追加记录，
+    // 追加记录的ECG为0，参数沿用最后的值
+    while (alarmIndex < alarms.size()) {
+        const int before = alarmIndex;
+        currentOnsetAbsUs = lastRecordEndUs;
+        current.onsetUs = currentOnsetAbsUs - startUs;
+        finishRecord(true);
+        if (alarmIndex == before) break;    // 单条注释超出记录容量（不会发生，MaxAlarmTextBytes已限制长度）
+    }
+    if (!chunk.isEmpty()) {
+        batch.append(chunk);
+    }
+    flushBatch();
+    if (!error.isEmpty()) {
+        return error;
+    }
+
+    // 回填记录数与连续性
+    if (!discontinuous) {
+        file.seek(192);
+        file.write(QByteArray("EDF+C").leftJustified(44, ' '));
+    }
+    file.seek(236);
+    file.write(QByteArray::number(records).leftJustified(8, ' '));
+    if (!file.flush()) {
+        return "写入EDF文件失败: " + file.errorString();
+    }
+
+    if (skippedFrames > 0) {
+        qWarning() << "EDF export skipped" << skippedFrames << "frames with a sample rate other than" << sampleRate;
+    }
+    emit progress(records, 100);
+    return QString();
+}
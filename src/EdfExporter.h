@@ -0,0 +1,43 @@
+#pragma once
+#include <QDateTime>
+#include <QVector>
+#include "FileExporter.h"
+
+// EDF+ 导出（单台设备）
+// 信号: ECG(mV) | HR(bpm) | SpO2(%) | Temp(degC) | EDF Annotations
+// 数据记录时长1秒，ECG采样直接取自波形分段的映射内存；记录之间有缺口时使用EDF+D并以
+// 每条记录的时间标注(TAL)给出起点。报警作为注释写入，一条记录放不下时顺延到后续记录，
+// 最后一条记录之后的报警写入追加的注释记录。
+// 采样到16位数字值的转换按批在线程池中并行完成，再按顺序写入文件；progress/finished的count为数据记录数
+class EdfExporter : public FileExporter {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString filePath;
+        QString deviceId;
+        QDateTime startTime;
+        QDateTime endTime;
+        QString patientName;    // 为空则写X（匿名）
+    };
+
+    EdfExporter(const QString& dbPath, WaveformStore* waveformStore, QObject* parent = nullptr);
+    ~EdfExporter();
+
+    bool start(const Options& options);
+    bool exportNow(const Options& options);
+
+    // 一条数据记录的原始内容（时间相对记录起点）
+    struct RawRecord {
+        qint64 onsetUs = 0;
+        QVector<float> ecg;
+        int heartRate = 0;
+        int oxygenSaturation = 0;
+        double temperature = 0.0;
+        QByteArray annotations;     // 已格式化的TAL（不含时间标注TAL）
+    };
+
+private:
+    bool exportRows(const Options& options);
+    QString writeRecording(QSqlDatabase& db, QFile& file, const Options& options, qint64& records);
+};
@@ -0,0 +1,363 @@
+#include "EventBrowser.h"
+#include "DatabaseManager.h"
+#include "ChartWidget.h"
+#include <QComboBox>
+#include <QDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPushButton>
+#include <QSignalBlocker>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <cmath>
+
+namespace {
+
+constexpr qint64 HourUs = 3600LL * 1000000;
+
+// 本地时间的整点（与事件小时计数表的键一致）
+qint64 hourStartUs(qint64 timeUs) {
+    QDateTime hour = QDateTime::fromMSecsSinceEpoch(timeUs / 1000);
+    hour.setTime(QTime(hour.time().hour(), 0));
+    return hour.toMSecsSinceEpoch() * 1000;
+}
+
+QColor severityColor(int severity) {
+    switch (severity) {
+    case 1:  return QColor(110, 150, 190);
+    case 2:  return QColor(220, 200, 70);
+    case 3:  return QColor(240, 140, 40);
+    case 4:  return QColor(220, 50, 50);
+    default: return QColor(200, 40, 170);
+    }
+}
+
+QString eventTypeName(const EventRecord& event) {
+    if (event.category == EventRecord::RhythmEvent) {
+        return RhythmEpisode::typeName(static_cast<RhythmEpisode::Type>(event.type));
+    }
+    return AlarmInfo::typeName(static_cast<AlarmInfo::AlarmType>(event.type));
+}
+
+} // namespace
+
+EventDensityStrip::EventDensityStrip(QWidget* parent)
+    : QWidget(parent)
+    , m_startUs(0)
+    , m_endUs(0)
+    , m_markerUs(-1)
+    , m_maxCount(0)
+{
+    setMinimumHeight(36);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setToolTip("每小时事件数，颜色为该小时最高严重度；点击查看该小时的事件");
+}
+
+void EventDensityStrip::setRange(qint64 startUs, qint64 endUs) {
+    m_startUs = startUs;
+    m_endUs = endUs;
+    update();
+}
+
+void EventDensityStrip::setCounts(const QVector<EventHourCount>& counts) {
+    m_counts = counts;
+    m_maxCount = 0;
+    for (const EventHourCount& hour : counts) {
+        m_maxCount = qMax(m_maxCount, hour.count);
+    }
+    update();
+}
+
+void EventDensityStrip::setMarker(qint64 timeUs) {
+    m_markerUs = timeUs;
+    update();
+}
+
+double EventDensityStrip::xForTime(qint64 timeUs) const {
+    return double(timeUs - m_startUs) / double(m_endUs - m_startUs) * width();
+}
+
+void EventDensityStrip::paintEvent(QPaintEvent* event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(30, 30, 30));
+    if (m_endUs <= m_startUs) return;
+
+    // 对数高度：偶发事件在报警风暴旁边仍然可见；一年范围时一小时不足一个像素，至少画1像素宽
+    const double hourWidth = qMax(1.0, double(HourUs) / double(m_endUs - m_startUs) * width());
+    const double logMax = std::log1p(double(m_maxCount));
+    const int plotHeight = height() - 2;
+    for (const EventHourCount& hour : std::as_const(m_counts)) {
+        const double barHeight = logMax > 0.0 ? qMax(2.0, plotHeight * std::log1p(double(hour.count)) / logMax) : 0.0;
+        painter.fillRect(QRectF(xForTime(hour.hourUs), height() - barHeight, hourWidth, barHeight),
+                         severityColor(hour.maxSeverity));
+    }
+
+    if (m_markerUs >= m_startUs && m_markerUs <= m_endUs) {
+        painter.setPen(Qt::white);
+        const int x = int(xForTime(m_markerUs));
+        painter.drawLine(x, 0, x, height());
+    }
+}
+
+void EventDensityStrip::mousePressEvent(QMouseEvent* event) {
+    if (m_endUs <= m_startUs || width() <= 0) return;
+
+    // 长时间段里单个小时很窄：点击位置附近有事件的小时优先
+    const double x = event->position().x();
+    qint64 hourUs = hourStartUs(m_startUs + qint64(x / width() * double(m_endUs - m_startUs)));
+    double nearest = 4.0;
+    for (const EventHourCount& hour : std::as_const(m_counts)) {
+        const double distance = std::abs(xForTime(hour.hourUs) - x);
+        if (distance <= nearest) {
+            nearest = distance;
+            hourUs = hour.hourUs;
+        }
+    }
+    emit hourClicked(hourUs);
+}
+
+EventBrowser::EventBrowser(DatabaseManager* database, QWidget* parent)
+    : QWidget(parent)
+    , m_database(database)
+    , m_deviceCombo(new QComboBox(this))
+    , m_typeCombo(new QComboBox(this))
+    , m_severitySpin(new QSpinBox(this))
+    , m_rangeCombo(new QComboBox(this))
+    , m_previousButton(new QPushButton("上一个严重事件", this))
+    , m_nextButton(new QPushButton("下一个严重事件", this))
+    , m_strip(new EventDensityStrip(this))
+    , m_summaryLabel(new QLabel(this))
+    , m_table(new QTableWidget(0, 5, this))
+    , m_hourUs(-1)
+    , m_currentUs(-1)
+    , m_currentId(-1)
+{
+    m_deviceCombo->addItem("全部设备", QString());
+
+    // 数据为(类别, 类型)，-1表示不限
+    m_typeCombo->addItem("全部事件", QPoint(-1, -1));
+    m_typeCombo->addItem("全部报警", QPoint(EventRecord::AlarmEvent, -1));
+    for (int type = AlarmInfo::LowOxygen; type <= AlarmInfo::ECGAbnormal; ++type) {
+        m_typeCombo->addItem("  " + AlarmInfo::typeName(static_cast<AlarmInfo::AlarmType>(type)),
+                             QPoint(EventRecord::AlarmEvent, type));
+    }
+    m_typeCombo->addItem("全部心律事件", QPoint(EventRecord::RhythmEvent, -1));
+    for (int type = RhythmEpisode::AtrialFibrillation; type <= RhythmEpisode::Ventricular; ++type) {
+        m_typeCombo->addItem("  " + RhythmEpisode::typeName(static_cast<RhythmEpisode::Type>(type)),
+                             QPoint(EventRecord::RhythmEvent, type));
+    }
+
+    m_severitySpin->setRange(1, 5);
+    m_severitySpin->setPrefix("严重度 ≥ ");
+
+    m_rangeCombo->addItem("最近24小时", 1);
+    m_rangeCombo->addItem("最近7天", 7);
+    m_rangeCombo->addItem("最近30天", 30);
+    m_rangeCombo->addItem("最近90天", 90);
+    m_rangeCombo->addItem("最近1年", 365);
+    m_rangeCombo->setCurrentIndex(1);
+
+    m_previousButton->setToolTip(QString("当前定位之前最近的严重度≥%1的事件").arg(JumpSeverity));
+    m_nextButton->setToolTip(QString("当前定位之后最近的严重度≥%1的事件").arg(JumpSeverity));
+
+    m_table->setHorizontalHeaderLabels({"时间", "设备", "类型", "严重度", "说明"});
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_table->setToolTip("双击打开事件前后的心电波形");
+
+    QHBoxLayout* filterLayout = new QHBoxLayout();
+    filterLayout->addWidget(m_deviceCombo);
+    filterLayout->addWidget(m_typeCombo);
+    filterLayout->addWidget(m_severitySpin);
+    filterLayout->addWidget(m_rangeCombo);
+    filterLayout->addStretch();
+    filterLayout->addWidget(m_previousButton);
+    filterLayout->addWidget(m_nextButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(filterLayout);
+    layout->addWidget(m_strip);
+    layout->addWidget(m_summaryLabel);
+    layout->addWidget(m_table);
+
+    connect(m_deviceCombo, &QComboBox::currentIndexChanged, this, &EventBrowser::refresh);
+    connect(m_typeCombo, &QComboBox::currentIndexChanged, this, &EventBrowser::refresh);
+    connect(m_severitySpin, &QSpinBox::valueChanged, this, &EventBrowser::refresh);
+    connect(m_rangeCombo, &QComboBox::currentIndexChanged, this, &EventBrowser::refresh);
+    connect(m_previousButton, &QPushButton::clicked, this, [this]() { jump(false); });
+    connect(m_nextButton, &QPushButton::clicked, this, [this]() { jump(true); });
+    connect(m_strip, &EventDensityStrip::hourClicked, this, [this](qint64 hourUs) {
+        m_currentUs = hourUs;
+        m_currentId = -1;
+        m_strip->setMarker(hourUs);
+        showHour(hourUs);
+    });
+    connect(m_table, &QTableWidget::currentCellChanged, this, [this](int row) {
+        if (row < 0 || row >= m_events.size()) return;
+        m_currentUs = m_events[row].timestampUs;
+        m_currentId = m_events[row].id;
+        m_strip->setMarker(m_currentUs);
+    });
+    connect(m_table, &QTableWidget::cellDoubleClicked, this, [this](int row) {
+        if (row >= 0 && row < m_events.size()) {
+            openWaveform(m_events[row]);
+        }
+    });
+}
+
+void EventBrowser::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    updateDevices();
+    refresh();
+}
+
+EventFilter EventBrowser::filter() const {
+    EventFilter filter;
+    filter.deviceId = m_deviceCombo->currentData().toString();
+    const QPoint type = m_typeCombo->currentData().toPoint();
+    filter.category = type.x();
+    filter.type = type.y();
+    filter.minSeverity = m_severitySpin->value();
+    return filter;
+}
+
+qint64 EventBrowser::rangeStartUs() const {
+    const int days = m_rangeCombo->currentData().toInt();
+    return hourStartUs(QDateTime::currentDateTime().addDays(-days).toMSecsSinceEpoch() * 1000);
+}
+
+void EventBrowser::updateDevices() {
+    WaveformStore* store = m_database->waveformStore();
+    if (!store) return;
+
+    const QString current = m_deviceCombo->currentData().toString();
+    QSignalBlocker blocker(m_deviceCombo);
+    m_deviceCombo->clear();
+    m_deviceCombo->addItem("全部设备", QString());
+    for (const QString& deviceId : store->deviceIds()) {
+        m_deviceCombo->addItem(deviceId, deviceId);
+    }
+    m_deviceCombo->setCurrentIndex(qMax(0, m_deviceCombo->findData(current)));
+}
+
+void EventBrowser::refresh() {
+    const qint64 startUs = rangeStartUs();
+    const QDateTime endTime = QDateTime::currentDateTime();
+    m_strip->setRange(startUs, endTime.toMSecsSinceEpoch() * 1000);
+
+    // 筛选条件连续变化时，同一标签的新查询取代尚未完成的旧查询
+    m_database->eventDensityAsync(QDateTime::fromMSecsSinceEpoch(startUs / 1000), endTime, filter())
+        .then(this, [this](const QVector<EventHourCount>& counts) {
+            m_strip->setCounts(counts);
+            // 首次打开时显示最近一个有事件的小时
+            if (m_hourUs < 0 && !counts.isEmpty()) {
+                m_hourUs = counts.last().hourUs;
+            }
+            if (m_hourUs >= 0) {
+                showHour(m_hourUs);
+            } else {
+                m_summaryLabel->setText("该时间段内没有事件");
+            }
+        });
+}
+
+void EventBrowser::showHour(qint64 hourUs) {
+    m_hourUs = hourUs;
+    const QDateTime start = QDateTime::fromMSecsSinceEpoch(hourUs / 1000);
+    m_database->queryEventsAsync(start, QDateTime::fromMSecsSinceEpoch((hourUs + HourUs) / 1000 - 1), filter())
+        .then(this, [this, start](const QVector<EventRecord>& events) {
+            m_events = events;
+
+            QSignalBlocker blocker(m_table);
+            m_table->clearContents();
+            m_table->setRowCount(events.size());
+            int currentRow = -1;
+            for (int row = 0; row < events.size(); ++row) {
+                const EventRecord& event = events[row];
+                const QDateTime time = QDateTime::fromMSecsSinceEpoch(event.timestampUs / 1000);
+                auto* severity = new QTableWidgetItem(QString::number(event.severity));
+                severity->setForeground(severityColor(event.severity));
+                m_table->setItem(row, 0, new QTableWidgetItem(time.toString("yyyy-MM-dd hh:mm:ss")));
+                m_table->setItem(row, 1, new QTableWidgetItem(event.deviceId));
+                m_table->setItem(row, 2, new QTableWidgetItem(eventTypeName(event)));
+                m_table->setItem(row, 3, severity);
+                m_table->setItem(row, 4, new QTableWidgetItem(event.message));
+                if (event.timestampUs == m_currentUs && (m_currentId < 0 || event.id == m_currentId)) {
+                    currentRow = row;
+                }
+            }
+            if (currentRow >= 0) {
+                m_table->selectRow(currentRow);
+                m_table->scrollToItem(m_table->item(currentRow, 0));
+            }
+
+            m_summaryLabel->setText(QString("%1 共%2个事件%3")
+                                        .arg(start.toString("yyyy-MM-dd hh:00"))
+                                        .arg(events.size())
+                                        .arg(events.size() >= 500 ? "（只显示前500个）" : ""));
+        });
+}
+
+void EventBrowser::jump(bool forward) {
+    EventFilter jumpFilter = filter();
+    jumpFilter.minSeverity = qMax(jumpFilter.minSeverity, JumpSeverity);
+
+    // 尚未定位时从时间段的一端开始
+    qint64 fromUs = m_currentUs;
+    qint64 fromId = m_currentId;
+    if (fromUs < 0) {
+        fromUs = forward ? rangeStartUs() : QDateTime::currentMSecsSinceEpoch() * 1000;
+        fromId = -1;
+    }
+    m_database->findEventAsync(QDateTime::fromMSecsSinceEpoch(fromUs / 1000), fromId, forward, jumpFilter)
+        .then(this, [this, forward](const EventRecord& event) {
+            if (!event.isValid()) {
+                m_summaryLabel->setText(forward ? "之后没有严重事件" : "之前没有严重事件");
+                return;
+            }
+            m_currentUs = event.timestampUs;
+            m_currentId = event.id;
+            m_strip->setMarker(m_currentUs);
+            showHour(hourStartUs(m_currentUs));
+        });
+}
+
+void EventBrowser::openWaveform(const EventRecord& event) {
+    if (!m_database->waveformStore() || event.deviceId.isEmpty()) {
+        QMessageBox::information(this, "事件波形", "该事件没有关联设备（升级前的报警），无法打开波形");
+        return;
+    }
+
+    // 在数据库的只读连接池中读取，重新初始化时数据库先等读取结束再替换波形存储
+    m_database->readEventWaveformAsync(event).then(this, [this, event](const QVector<EcgFrame>& frames) {
+        const QString time = QDateTime::fromMSecsSinceEpoch(event.timestampUs / 1000).toString("yyyy-MM-dd hh:mm:ss");
+        if (frames.isEmpty()) {
+            QMessageBox::information(this, "事件波形", QString("%1 前后的波形已被清理").arg(time));
+            return;
+        }
+
+        QDialog* dialog = new QDialog(this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->setWindowTitle(QString("%1 %2 %3").arg(event.deviceId, time, eventTypeName(event)));
+        ECGWaveformWidget* waveform = new ECGWaveformWidget(dialog);
+        QVBoxLayout* layout = new QVBoxLayout(dialog);
+        layout->addWidget(new QLabel(event.message, dialog));
+        layout->addWidget(waveform);
+        for (const EcgFrame& frame : frames) {
+            waveform->addECGData(frame);
+        }
+        dialog->resize(1000, 400);
+        dialog->show();
+        waveform->start();
+    });
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <QWidget>
+#include <QVector>
+#include "EventIndex.h"
+
+class DatabaseManager;
+class QComboBox;
+class QSpinBox;
+class QLabel;
+class QPushButton;
+class QTableWidget;
+
+// 事件密度条：时间段内每小时一格，高度按事件数（对数），颜色按该小时的最高严重度
+// 数据来自小时计数表，数月范围也只有几千格；点击选中一个小时
+class EventDensityStrip : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit EventDensityStrip(QWidget* parent = nullptr);
+
+    void setRange(qint64 startUs, qint64 endUs);
+    void setCounts(const QVector<EventHourCount>& counts);
+    // 当前定位的时间（竖线），-1表示不显示
+    void setMarker(qint64 timeUs);
+
+    QSize sizeHint() const override { return QSize(600, 48); }
+
+signals:
+    void hourClicked(qint64 hourUs);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+
+private:
+    double xForTime(qint64 timeUs) const;
+
+    qint64 m_startUs;
+    qint64 m_endUs;
+    qint64 m_markerUs;
+    QVector<EventHourCount> m_counts;
+    int m_maxCount;
+};
+
+// 历史事件浏览（历史查询标签页）
+// 按设备、类型、最低严重度筛选事件索引：筛选条件变化时密度条从小时计数表重新查询，
+// 列表只显示选中的一个小时；"上一个/下一个严重事件"按当前定位时间做索引定位，跨越任意长的时间段。
+// 双击事件从其波形指针顺序读取前后的ECG
+class EventBrowser : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit EventBrowser(DatabaseManager* database, QWidget* parent = nullptr);
+
+    static constexpr int JumpSeverity = 4;      // 跳转按钮查找的最低严重度
+
+public slots:
+    // 重新查询密度条与当前小时的事件
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+
+private:
+    EventFilter filter() const;
+    qint64 rangeStartUs() const;
+    void updateDevices();
+    void showHour(qint64 hourUs);
+    void jump(bool forward);
+    void openWaveform(const EventRecord& event);
+
+    DatabaseManager* m_database;
+    QComboBox* m_deviceCombo;
+    QComboBox* m_typeCombo;
+    QSpinBox* m_severitySpin;
+    QComboBox* m_rangeCombo;
+    QPushButton* m_previousButton;
+    QPushButton* m_nextButton;
+    EventDensityStrip* m_strip;
+    QLabel* m_summaryLabel;
+    QTableWidget* m_table;
+
+    QVector<EventRecord> m_events;      // 列表中的事件（与行对应）
+    qint64 m_hourUs;                    // 列表显示的小时，-1表示未选中
+    qint64 m_currentUs;                 // 当前定位时间（跳转的起点）
+    qint64 m_currentId;                 // 当前定位的事件，-1表示只按时间
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include "WaveformStore.h"
+
+// 事件索引中的一条事件：报警或心律事件
+struct EventRecord {
+    enum Category : quint8 {
+        AlarmEvent,         // type为AlarmInfo::AlarmType
+        RhythmEvent         // type为RhythmEpisode::Type
+    };
+
+    static constexpr int PreRollMs = 10000;     // 波形指针指向事件前这么久的帧
+
+    qint64 id = -1;                 // event_index的rowid，同一毫秒的事件按它排序
+    qint64 timestampUs = -1;        // 开始时间，-1表示无此事件
+    qint64 endUs = -1;
+    QString deviceId;
+    Category category = AlarmEvent;
+    int type = 0;
+    int severity = 1;
+    QString message;
+    WaveformLocation waveform;      // 事件前若干秒的帧，打开周围ECG时从这里顺序读取
+
+    bool isValid() const { return timestampUs >= 0; }
+};
+
+// 事件筛选条件；空设备ID、负数的类别/类型表示不限
+struct EventFilter {
+    QString deviceId;
+    int category = -1;
+    int type = -1;
+    int minSeverity = 1;
+};
+
+// 事件密度条的一个小时
+struct EventHourCount {
+    qint64 hourUs;
+    int count;
+    int maxSeverity;
+};
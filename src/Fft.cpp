@@ -0,0 +1,150 @@
+#include "Fft.h"
+#include "VectorMath.h"
+#include <QtMath>
+#include <utility>
+
+namespace {
+
+// 一组蝶形：a[k] ± w[k]·b[k]，k < count
+inline void butterflies(std::complex<float>* a, std::complex<float>* b, const std::complex<float>* w, int count) {
+    int k = 0;
+#if defined(ECG_VECTOR_SSE)
+    // 每次两个复数：实部 wr·br - wi·bi，虚部 wr·bi + wi·br
+    const __m128 sign = _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f);
+    for (; k + 2 <= count; k += 2) {
+        float* pa = reinterpret_cast<float*>(a + k);
+        float* pb = reinterpret_cast<float*>(b + k);
+        const __m128 vw = _mm_loadu_ps(reinterpret_cast<const float*>(w + k));
+        const __m128 vb = _mm_loadu_ps(pb);
+        const __m128 wr = _mm_shuffle_ps(vw, vw, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 wi = _mm_shuffle_ps(vw, vw, _MM_SHUFFLE(3, 3, 1, 1));
+        const __m128 swapped = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(2, 3, 0, 1));
+        const __m128 t = _mm_add_ps(_mm_mul_ps(wr, vb), _mm_mul_ps(sign, _mm_mul_ps(wi, swapped)));
+        const __m128 va = _mm_loadu_ps(pa);
+        _mm_storeu_ps(pb, _mm_sub_ps(va, t));
+        _mm_storeu_ps(pa, _mm_add_ps(va, t));
+    }
+#elif defined(ECG_VECTOR_NEON)
+    // 每次四个复数，按实部/虚部分开装载
+    for (; k + 4 <= count; k += 4) {
+        float* pa = reinterpret_cast<float*>(a + k);
+        float* pb = reinterpret_cast<float*>(b + k);
+        const float32x4x2_t vw = vld2q_f32(reinterpret_cast<const float*>(w + k));
+        const float32x4x2_t vb = vld2q_f32(pb);
+        const float32x4x2_t va = vld2q_f32(pa);
+        const float32x4_t tr = vmlsq_f32(vmulq_f32(vw.val[0], vb.val[0]), vw.val[1], vb.val[1]);
+        const float32x4_t ti = vmlaq_f32(vmulq_f32(vw.val[0], vb.val[1]), vw.val[1], vb.val[0]);
+        float32x4x2_t sum, difference;
+        sum.val[0] = vaddq_f32(va.val[0], tr);
+        sum.val[1] = vaddq_f32(va.val[1], ti);
+        difference.val[0] = vsubq_f32(va.val[0], tr);
+        difference.val[1] = vsubq_f32(va.val[1], ti);
+        vst2q_f32(pa, sum);
+        vst2q_f32(pb, difference);
+    }
+#endif
+    for (; k < count; ++k) {
+        const std::complex<float> t = w[k] * b[k];
+        b[k] = a[k] - t;
+        a[k] += t;
+    }
+}
+
+} // namespace
+
+Fft::Fft(int size)
+    : m_size(isPowerOfTwo(size) ? size : 1)
+{
+    Q_ASSERT(isPowerOfTwo(size));
+
+    m_twiddles.resize(m_size / 2);
+    for (int k = 0; k < m_size / 2; ++k) {
+        const double angle = -2.0 * M_PI * k / m_size;
+        m_twiddles[k] = std::complex<float>(float(std::cos(angle)), float(std::sin(angle)));
+    }
+
+    // 各级旋转因子依次存放：1 + 2 + 4 + ... + N/2 = N-1个
+    m_stageTwiddles.resize(qMax(1, m_size - 1));
+    for (int len = 2; len <= m_size; len <<= 1) {
+        const int half = len / 2;
+        for (int k = 0; k < half; ++k) {
+            m_stageTwiddles[half - 1 + k] = m_twiddles[k * (m_size / len)];
+        }
+    }
+
+    m_bitReversed = bitReversal(m_size);
+    m_halfBitReversed = bitReversal(qMax(1, m_size / 2));
+}
+
+QVector<int> Fft::bitReversal(int n) {
+    int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    QVector<int> table(n);
+    for (int i = 0; i < n; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+        }
+        table[i] = reversed;
+    }
+    return table;
+}
+
+void Fft::transform(std::complex<float>* data) const {
+    transform(data, m_size, m_bitReversed);
+}
+
+void Fft::transform(std::complex<float>* data, int n, const QVector<int>& bitReversed) const {
+    for (int i = 0; i < n; ++i) {
+        const int j = bitReversed[i];
+        if (j > i) std::swap(data[i], data[j]);
+    }
+
+    // 迭代蝶形运算；长度为len的一级只与len有关，较短的变换共用同一组旋转因子
+    for (int len = 2; len <= n; len <<= 1) {
+        const int half = len / 2;
+        const std::complex<float>* w = m_stageTwiddles.constData() + half - 1;
+        for (int start = 0; start < n; start += len) {
+            butterflies(data + start, data + start + half, w, half);
+        }
+    }
+}
+
+void Fft::realTransform(const float* input, std::complex<float>* out) const {
+    const int half = m_size / 2;
+    if (half == 0) {
+        out[0] = std::complex<float>(input[0], 0.0f);
+        return;
+    }
+
+    // 偶数点作实部、奇数点作虚部，做N/2点复数FFT
+    for (int i = 0; i < half; ++i) {
+        out[i] = std::complex<float>(input[2 * i], input[2 * i + 1]);
+    }
+    transform(out, half, m_halfBitReversed);
+
+    // 拆分：X[k] = (Z[k] + Z*[N/2-k])/2 - i·W^k·(Z[k] - Z*[N/2-k])/2，k与N/2-k成对原地计算
+    const std::complex<float> z0 = out[0];
+    out[0] = std::complex<float>(z0.real() + z0.imag(), 0.0f);
+    out[half] = std::complex<float>(z0.real() - z0.imag(), 0.0f);
+    const std::complex<float> minusI(0.0f, -1.0f);
+    for (int k = 1; k <= half / 2; ++k) {
+        const std::complex<float> a = out[k];
+        const std::complex<float> b = std::conj(out[half - k]);
+        const std::complex<float> even = 0.5f * (a + b);
+        const std::complex<float> odd = 0.5f * (a - b);
+        out[k] = even + minusI * m_twiddles[k] * odd;
+        if (k != half - k) {
+            // 对称的一项：X[N/2-k] = conj(even) - i·W^(N/2-k)·conj(-odd)
+            out[half - k] = std::conj(even) + minusI * m_twiddles[half - k] * std::conj(-odd);
+        }
+    }
+}
+
+void Fft::powerSpectrum(const float* input, float* out) const {
+    QVector<std::complex<float>> buffer(m_size / 2 + 1);
+    realTransform(input, buffer.data());
+    for (int k = 0; k <= m_size / 2; ++k) {
+        out[k] = std::norm(buffer[k]);
+    }
+}
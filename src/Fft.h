@@ -0,0 +1,36 @@
+#pragma once
+#include <QVector>
+#include <complex>
+
+// 基2复数FFT与实数FFT
+// 旋转因子与位反转表在构造时一次算好，同一尺寸的变换可重复使用（transform为const，可多线程共享）。
+// 每一级蝶形的旋转因子连续存放，蝶形运算按SSE/NEON一次处理多个；
+// 实信号用一半长度的复数FFT计算，再按预先算好的旋转因子拆分出单边频谱
+class Fft {
+public:
+    explicit Fft(int size);
+
+    int size() const { return m_size; }
+
+    // 原地正变换，data长度为size()
+    void transform(std::complex<float>* data) const;
+
+    // 实信号正变换：input长度为size()，out长度为size()/2+1（单边频谱X[0..N/2]）
+    void realTransform(const float* input, std::complex<float>* out) const;
+
+    // 实信号单边功率谱：out长度为size()/2+1，值为|X[k]|²（未归一化）
+    void powerSpectrum(const float* input, float* out) const;
+
+    static bool isPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+private:
+    // 长度为n（不超过size()的2的幂）的复数FFT，bitReversed为该长度的位反转表
+    void transform(std::complex<float>* data, int n, const QVector<int>& bitReversed) const;
+    static QVector<int> bitReversal(int n);
+
+    int m_size;
+    QVector<std::complex<float>> m_twiddles;        // e^(-2πik/N), k < N/2
+    QVector<std::complex<float>> m_stageTwiddles;   // 长度为len的一级：从len/2-1起的len/2个e^(-2πik/len)
+    QVector<int> m_bitReversed;
+    QVector<int> m_halfBitReversed;                 // 实数FFT内部N/2点复数FFT的位反转表
+};
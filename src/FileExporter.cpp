@@ -0,0 +1,70 @@
+#include "FileExporter.h"
+#include "DbReadPool.h"
+#include <QFile>
+#include <QSqlError>
+#include <QDebug>
+
+FileExporter::FileExporter(const QString& dbPath, WaveformStore* waveformStore, QObject* parent)
+    : QObject(parent)
+    , m_dbPath(dbPath)
+    , m_waveformStore(waveformStore)
+    , m_cancelled(false)
+{
+}
+
+FileExporter::~FileExporter() {
+    stopThread();
+}
+
+bool FileExporter::startThread(std::function<void()> job) {
+    if (isRunning()) return false;
+
+    m_cancelled = false;
+    m_thread = QThread::create(std::move(job));
+    m_thread->setObjectName(metaObject()->className());
+    connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
+    m_thread->start(QThread::LowPriority);
+    return true;
+}
+
+void FileExporter::stopThread() {
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+    }
+}
+
+bool FileExporter::exportFile(const QString& filePath, const QString& fileType, const WriteFunction& write) {
+    const QString connectionName = QString("%1_%2").arg(metaObject()->className()).arg(quintptr(this));
+    qint64 count = 0;
+    QString error;
+
+    {
+        QFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            error = QString("无法创建%1文件: ").arg(fileType) + file.errorString();
+        } else {
+            QSqlDatabase db = DbReadPool::openReadConnection(connectionName, m_dbPath);
+            if (!db.isOpen()) {
+                error = "无法打开数据库: " + db.lastError().text();
+            } else {
+                error = write(db, file, count);
+                db.close();
+            }
+            file.close();
+
+            // 取消或失败时不留下半个文件
+            if (!error.isEmpty()) {
+                file.remove();
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const bool success = error.isEmpty();
+    if (success) {
+        qDebug() << "Exported" << count << fileType << "records to" << filePath;
+    }
+    emit finished(success, count, error);
+    return success;
+}
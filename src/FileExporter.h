@@ -0,0 +1,48 @@
+#pragma once
+#include <QObject>
+#include <QPointer>
+#include <QThread>
+#include <atomic>
+#include <functional>
+
+class QFile;
+class QSqlDatabase;
+class WaveformStore;
+
+// 后台文件导出的公共部分（CsvExporter、EdfExporter）
+// 导出在低优先级工作线程中运行，使用独立的只读连接；失败或取消时删除写了一半的文件，最后发出finished
+class FileExporter : public QObject {
+    Q_OBJECT
+
+public:
+    ~FileExporter() override;
+
+    void cancel() { m_cancelled = true; }
+    bool isRunning() const { return m_thread && m_thread->isRunning(); }
+
+signals:
+    // count为已导出的行数（CSV）或数据记录数（EDF），percent按已导出数据的时间位置估算
+    void progress(qint64 count, int percent);
+    void finished(bool success, qint64 count, const QString& error);
+
+protected:
+    FileExporter(const QString& dbPath, WaveformStore* waveformStore, QObject* parent);
+
+    // 写入函数：返回错误信息，成功时为空
+    using WriteFunction = std::function<QString(QSqlDatabase& db, QFile& file, qint64& count)>;
+
+    // 在工作线程中运行job，已有导出在运行时返回false
+    bool startThread(std::function<void()> job);
+    // 取消并等待工作线程结束（子类析构时调用，保证线程不再访问子类）
+    void stopThread();
+
+    // 打开文件与只读连接后调用write；fileType用于错误信息（如"CSV"）
+    bool exportFile(const QString& filePath, const QString& fileType, const WriteFunction& write);
+
+    QString m_dbPath;
+    WaveformStore* m_waveformStore;
+    std::atomic<bool> m_cancelled;
+
+private:
+    QPointer<QThread> m_thread;
+};
@@ -0,0 +1,160 @@
+#include "HistoryQueryCache.h"
+#include <QDateTime>
+
+HistoryQueryCache::HistoryQueryCache()
+    : m_settleMs(DefaultSettleMs)
+    , m_epoch(0)
+    , m_useCounter(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_deltaRows(0)
+    , m_invalidations(0)
+{
+}
+
+void HistoryQueryCache::setSettleMs(qint64 settleMs) {
+    QMutexLocker locker(&m_mutex);
+    settleMs = qMax<qint64>(0, settleMs);
+    if (settleMs > m_settleMs) {
+        ++m_epoch;
+        m_invalidations += m_entries.size();
+        m_entries.clear();
+    }
+    m_settleMs = settleMs;
+}
+
+int HistoryQueryCache::findLocked(const QString& deviceId, int limit) const {
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].limit == limit && m_entries[i].deviceId == deviceId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void HistoryQueryCache::storeLocked(Entry entry) {
+    entry.lastUsed = ++m_useCounter;
+    const int index = findLocked(entry.deviceId, entry.limit);
+    if (index >= 0) {
+        m_entries[index] = std::move(entry);
+        return;
+    }
+    if (m_entries.size() >= MaxEntries) {
+        // 淘汰最久未使用的一项
+        int oldest = 0;
+        for (int i = 1; i < m_entries.size(); ++i) {
+            if (m_entries[i].lastUsed < m_entries[oldest].lastUsed) oldest = i;
+        }
+        m_entries.remove(oldest);
+    }
+    m_entries.append(std::move(entry));
+}
+
+bool HistoryQueryCache::query(const QString& deviceId, qint64 startMs, qint64 endMs, int limit,
+                              const Fetch& fetch, QVector<VitalSignData>& result) {
+    Entry cached;
+    bool usable = false;
+    quint64 epoch;
+    qint64 settledMs;
+    {
+        QMutexLocker locker(&m_mutex);
+        epoch = m_epoch;
+        settledMs = qMin(endMs, QDateTime::currentMSecsSinceEpoch() - m_settleMs);
+        const int index = findLocked(deviceId, limit);
+        if (index >= 0) {
+            Entry& entry = m_entries[index];
+            // 起点早于完整覆盖范围时（上次达到条数上限），只要尾部与缓存的行凑满limit条，结果仍然完整
+            usable = endMs >= entry.endMs &&
+                     (startMs >= entry.completeFromMs || entry.rows.size() >= limit);
+            if (usable) {
+                entry.lastUsed = ++m_useCounter;
+                cached = entry;     // 行是共享的，不复制采样
+            }
+        }
+    }
+
+    QVector<VitalSignData> rows;
+    bool hit = false;
+    if (usable) {
+        // 只查询上次覆盖终点之后的尾部，其余取自缓存（都在[completeFromMs, 覆盖终点]内，且按时间降序）
+        if (!fetch(cached.endMs + 1, endMs, rows)) {
+            result = rows;
+            return false;
+        }
+        const int tailRows = rows.size();
+        for (const VitalSignData& data : std::as_const(cached.rows)) {
+            if (rows.size() >= limit || data.timestampUs / 1000 < startMs) break;
+            rows.append(data);
+        }
+        hit = startMs >= cached.completeFromMs || rows.size() >= limit;
+        if (hit) {
+            QMutexLocker locker(&m_mutex);
+            ++m_hits;
+            m_deltaRows += tailRows;
+        } else {
+            rows.clear();
+        }
+    }
+    if (!hit) {
+        if (!fetch(startMs, endMs, rows)) {
+            result = rows;
+            return false;
+        }
+        QMutexLocker locker(&m_mutex);
+        ++m_misses;
+    }
+
+    // 只保存已稳定的部分；达到条数上限时最旧一行之前（含同一毫秒）可能还有未返回的数据
+    Entry entry;
+    entry.deviceId = deviceId;
+    entry.limit = limit;
+    entry.endMs = settledMs;
+    entry.completeFromMs = rows.size() >= limit ? rows.last().timestampUs / 1000 + 1 : startMs;
+    if (settledMs >= entry.completeFromMs) {
+        entry.rows.reserve(rows.size());
+        for (const VitalSignData& data : std::as_const(rows)) {
+            if (data.timestampUs / 1000 <= settledMs) {
+                entry.rows.append(data);
+            }
+        }
+        QMutexLocker locker(&m_mutex);
+        // 查询期间有补传或清理，读到的可能是旧数据，不保存
+        if (epoch == m_epoch) {
+            storeLocked(std::move(entry));
+        }
+    }
+
+    result = std::move(rows);
+    return true;
+}
+
+void HistoryQueryCache::noteWrite(const QString& deviceId, qint64 timestampUs) {
+    const qint64 timestampMs = timestampUs / 1000;
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    // 实时数据落在稳定线之后，不在任何缓存结果的覆盖范围内
+    if (timestampMs > nowMs - m_settleMs) return;
+
+    ++m_epoch;
+    for (int i = m_entries.size() - 1; i >= 0; --i) {
+        const Entry& entry = m_entries[i];
+        if ((entry.deviceId.isEmpty() || entry.deviceId == deviceId) &&
+            timestampMs >= entry.completeFromMs && timestampMs <= entry.endMs) {
+            m_entries.remove(i);
+            ++m_invalidations;
+        }
+    }
+}
+
+void HistoryQueryCache::invalidate() {
+    QMutexLocker locker(&m_mutex);
+    ++m_epoch;
+    m_invalidations += m_entries.size();
+    m_entries.clear();
+}
+
+HistoryQueryCache::Stats HistoryQueryCache::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return Stats{int(m_entries.size()), m_hits, m_misses, m_deltaRows, m_invalidations};
+}
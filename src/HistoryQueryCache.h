@@ -0,0 +1,72 @@
+#pragma once
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "VitalSignData.h"
+
+// 历史查询结果缓存
+// 按(设备, 条数上限)保存最近几次查询的结果及其完整覆盖的时间段。同一视图再次查询（例如"最近24小时"，
+// 起点随时间后移）时只从上次覆盖的终点查询新增的尾部，与缓存的结果合并并裁剪到新的时间段，
+// 代价与新增数据量成正比。结果达到条数上限时只完整覆盖最新的limit条，尾部与缓存的行凑满limit条即可命中。
+// 时间精确到毫秒（与数据库一致）。
+// 最近settleMs内的数据可能仍在陆续到达（设备乱序、网络延迟），不计入覆盖范围，下次随尾部重新查询；
+// 更早时间的写入（补传、云端下载合并）使覆盖该时间的结果失效，数据清理后全部失效
+class HistoryQueryCache {
+public:
+    static constexpr int MaxEntries = 8;
+    static constexpr qint64 DefaultSettleMs = 5000;
+    static constexpr qint64 SettleSlackMs = 1000;      // 合并提交的定时器误差与事务耗时余量
+
+    // 查询[startMs, endMs]内最新的limit条（按时间降序）；结果不完整（出错、被取消）时返回false
+    using Fetch = std::function<bool(qint64 startMs, qint64 endMs, QVector<VitalSignData>& rows)>;
+
+    HistoryQueryCache();
+
+    // 写入合并推迟提交时，settleMs须大于最长的合并延迟，否则尚未提交的时间段会被计入覆盖范围。
+    // 放宽时已缓存的结果全部失效
+    void setSettleMs(qint64 settleMs);
+
+    // 与数据库查询语义相同：[startMs, endMs]内最新的limit条，按时间降序；deviceId为空表示全部设备
+    // 在读线程中调用，fetch只用于缓存未覆盖的部分
+    bool query(const QString& deviceId, qint64 startMs, qint64 endMs, int limit, const Fetch& fetch,
+               QVector<VitalSignData>& result);
+
+    // 写入提交后调用（写入线程）
+    void noteWrite(const QString& deviceId, qint64 timestampUs);
+
+    // 数据被删除（清理）后调用
+    void invalidate();
+
+    struct Stats {
+        int entries;
+        qint64 hits;            // 只查询了新增尾部
+        qint64 misses;          // 完整查询
+        qint64 deltaRows;       // 尾部查询返回的行数
+        qint64 invalidations;
+    };
+    Stats stats() const;
+
+private:
+    struct Entry {
+        QString deviceId;
+        int limit = 0;
+        qint64 completeFromMs = 0;          // [completeFromMs, endMs]内的数据都在rows中
+        qint64 endMs = 0;
+        QVector<VitalSignData> rows;        // 按时间降序
+        quint64 lastUsed = 0;
+    };
+
+    int findLocked(const QString& deviceId, int limit) const;
+    void storeLocked(Entry entry);
+
+    mutable QMutex m_mutex;
+    QVector<Entry> m_entries;
+    qint64 m_settleMs;
+    quint64 m_epoch;            // 每次失效递增；查询期间发生失效时不保存结果
+    quint64 m_useCounter;
+    qint64 m_hits;
+    qint64 m_misses;
+    qint64 m_deltaRows;
+    qint64 m_invalidations;
+};
@@ -0,0 +1,255 @@
+#include "HotWindowCache.h"
+#include <QDateTime>
+#include <algorithm>
+
+HotWindowCache::HotWindowCache(qint64 windowUs, qint64 budgetBytes)
+    : m_windowUs(windowUs)
+    , m_budgetBytes(budgetBytes)
+    , m_bytes(0)
+    , m_entryCount(0)
+    , m_coveredSinceUs(alignUp(QDateTime::currentMSecsSinceEpoch() * 1000))
+    , m_alarmsEvictedUpToUs(-1)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+void HotWindowCache::setWindowUs(qint64 windowUs) {
+    QMutexLocker locker(&m_mutex);
+    m_windowUs = windowUs;
+    evictLocked();
+}
+
+void HotWindowCache::setBudgetBytes(qint64 budgetBytes) {
+    QMutexLocker locker(&m_mutex);
+    m_budgetBytes = budgetBytes;
+    evictLocked();
+}
+
+qint64 HotWindowCache::windowUs() const {
+    QMutexLocker locker(&m_mutex);
+    return m_windowUs;
+}
+
+qint64 HotWindowCache::budgetBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_budgetBytes;
+}
+
+void HotWindowCache::reset(qint64 sinceUs) {
+    QMutexLocker locker(&m_mutex);
+    m_devices.clear();
+    m_alarms.clear();
+    m_bytes = 0;
+    m_entryCount = 0;
+    m_coveredSinceUs = alignUp(sinceUs);
+    m_alarmsEvictedUpToUs = -1;
+}
+
+qint64 HotWindowCache::entryBytes(const VitalSignData& data) {
+    // 帧可能与界面共享，这里按缓存持有的上限计算
+    qint64 bytes = sizeof(VitalSignData);
+    if (!data.ecgSignal.isEmpty()) {
+        bytes += sizeof(EcgFrameBlock) + qint64(data.ecgSignal.size()) * data.ecgSignal.leadCount() * sizeof(float);
+    }
+    return bytes;
+}
+
+qint64 HotWindowCache::alarmTimeUs(const AlarmInfo& alarm) {
+    return alarm.timestamp.toMSecsSinceEpoch() * 1000;
+}
+
+qint64 HotWindowCache::alignUp(qint64 us) {
+    // 数据库中的时间精确到毫秒，覆盖起点对齐到毫秒边界，避免与数据库查询的结果重叠
+    const qint64 ms = us >= 0 ? (us + 999) / 1000 : -((-us) / 1000);
+    return ms * 1000;
+}
+
+void HotWindowCache::insert(const VitalSignData& data) {
+    QMutexLocker locker(&m_mutex);
+    if (m_budgetBytes <= 0 || data.timestampUs < m_coveredSinceUs) return;
+
+    DeviceWindow& window = m_devices[data.deviceId];
+    // 比已淘汰条目更早的数据不再缓存，该时间段由数据库回答
+    if (data.timestampUs <= window.evictedUpToUs) return;
+
+    auto& entries = window.entries;
+    if (entries.empty() || entries.back().timestampUs <= data.timestampUs) {
+        entries.push_back(data);
+    } else {
+        // 乱序到达（补传），按时间插入
+        auto it = std::upper_bound(entries.begin(), entries.end(), data.timestampUs,
+                                   [](qint64 t, const VitalSignData& entry) { return t < entry.timestampUs; });
+        entries.insert(it, data);
+    }
+    m_bytes += entryBytes(data);
+    m_entryCount++;
+    evictLocked();
+}
+
+void HotWindowCache::insertAlarm(const AlarmInfo& alarm) {
+    QMutexLocker locker(&m_mutex);
+    const qint64 timeUs = alarmTimeUs(alarm);
+    if (timeUs < m_coveredSinceUs || timeUs <= m_alarmsEvictedUpToUs) return;
+
+    if (m_alarms.empty() || alarmTimeUs(m_alarms.back()) <= timeUs) {
+        m_alarms.push_back(alarm);
+    } else {
+        auto it = std::upper_bound(m_alarms.begin(), m_alarms.end(), timeUs,
+                                   [](qint64 t, const AlarmInfo& entry) { return t < alarmTimeUs(entry); });
+        m_alarms.insert(it, alarm);
+    }
+
+    const qint64 oldestUs = alarmTimeUs(m_alarms.back()) - m_windowUs;
+    while (!m_alarms.empty() &&
+           (int(m_alarms.size()) > MaxAlarms || alarmTimeUs(m_alarms.front()) < oldestUs)) {
+        m_alarmsEvictedUpToUs = qMax(m_alarmsEvictedUpToUs, alarmTimeUs(m_alarms.front()));
+        m_alarms.pop_front();
+    }
+}
+
+void HotWindowCache::popFrontLocked(DeviceWindow& window) {
+    const VitalSignData& front = window.entries.front();
+    window.evictedUpToUs = qMax(window.evictedUpToUs, front.timestampUs);
+    m_bytes -= entryBytes(front);
+    m_entryCount--;
+    window.entries.pop_front();
+}
+
+void HotWindowCache::evictLocked() {
+    // 超出时间窗口的条目，各设备按自己最新的数据裁剪
+    for (auto it = m_devices.begin(); it != m_devices.end(); ++it) {
+        DeviceWindow& window = it.value();
+        if (window.entries.empty()) continue;
+        const qint64 oldestUs = window.entries.back().timestampUs - m_windowUs;
+        while (!window.entries.empty() && window.entries.front().timestampUs < oldestUs) {
+            popFrontLocked(window);
+        }
+    }
+
+    // 超出预算时淘汰全局最旧的条目（设备数量很少，线性查找即可）
+    while (m_bytes > qMax<qint64>(0, m_budgetBytes) && m_entryCount > 0) {
+        DeviceWindow* oldest = nullptr;
+        for (auto it = m_devices.begin(); it != m_devices.end(); ++it) {
+            DeviceWindow& window = it.value();
+            if (window.entries.empty()) continue;
+            if (!oldest || window.entries.front().timestampUs < oldest->entries.front().timestampUs) {
+                oldest = &window;
+            }
+        }
+        if (!oldest) break;
+        popFrontLocked(*oldest);
+    }
+}
+
+qint64 HotWindowCache::coveredSinceLocked(const QString& deviceId) const {
+    qint64 covered = m_coveredSinceUs;
+    if (!deviceId.isEmpty()) {
+        auto it = m_devices.constFind(deviceId);
+        if (it != m_devices.cend() && it->evictedUpToUs >= 0) {
+            covered = qMax(covered, alignUp(it->evictedUpToUs + 1));
+        }
+        return covered;
+    }
+
+    // 全部设备：取各设备中最晚的覆盖起点
+    for (auto it = m_devices.cbegin(); it != m_devices.cend(); ++it) {
+        if (it->evictedUpToUs >= 0) {
+            covered = qMax(covered, alignUp(it->evictedUpToUs + 1));
+        }
+    }
+    return covered;
+}
+
+qint64 HotWindowCache::coveredSinceUs(const QString& deviceId) const {
+    QMutexLocker locker(&m_mutex);
+    return coveredSinceLocked(deviceId);
+}
+
+qint64 HotWindowCache::alarmsCoveredSinceUs() const {
+    QMutexLocker locker(&m_mutex);
+    return m_alarmsEvictedUpToUs >= 0 ? qMax(m_coveredSinceUs, alignUp(m_alarmsEvictedUpToUs + 1))
+                                      : m_coveredSinceUs;
+}
+
+bool HotWindowCache::latest(VitalSignData& data, const QString& deviceId) const {
+    QMutexLocker locker(&m_mutex);
+    const VitalSignData* newest = nullptr;
+    for (auto it = m_devices.cbegin(); it != m_devices.cend(); ++it) {
+        if (!deviceId.isEmpty() && it.key() != deviceId) continue;
+        if (it->entries.empty()) continue;
+        if (!newest || it->entries.back().timestampUs > newest->timestampUs) {
+            newest = &it->entries.back();
+        }
+    }
+    if (!newest) return false;
+    data = *newest;
+    return true;
+}
+
+QVector<VitalSignData> HotWindowCache::query(qint64 startUs, qint64 endUs, int limit,
+                                             const QString& deviceId) const {
+    QVector<VitalSignData> result;
+    if (limit <= 0 || endUs < startUs) return result;
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_devices.cbegin(); it != m_devices.cend(); ++it) {
+        if (!deviceId.isEmpty() && it.key() != deviceId) continue;
+        const auto& entries = it->entries;
+
+        // 从范围末尾向前取，每台设备最多limit条
+        auto first = std::lower_bound(entries.begin(), entries.end(), startUs,
+                                      [](const VitalSignData& entry, qint64 t) { return entry.timestampUs < t; });
+        auto last = std::upper_bound(first, entries.end(), endUs,
+                                     [](qint64 t, const VitalSignData& entry) { return t < entry.timestampUs; });
+        int taken = 0;
+        while (last != first && taken < limit) {
+            --last;
+            result.append(*last);
+            taken++;
+        }
+    }
+    locker.unlock();
+
+    std::stable_sort(result.begin(), result.end(), [](const VitalSignData& a, const VitalSignData& b) {
+        return a.timestampUs > b.timestampUs;
+    });
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+QVector<AlarmInfo> HotWindowCache::queryAlarms(qint64 startUs, qint64 endUs, int limit) const {
+    QVector<AlarmInfo> result;
+    if (limit <= 0 || endUs < startUs) return result;
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_alarms.crbegin(); it != m_alarms.crend() && result.size() < limit; ++it) {
+        const qint64 timeUs = alarmTimeUs(*it);
+        if (timeUs > endUs) continue;
+        if (timeUs < startUs) break;
+        result.append(*it);
+    }
+    return result;
+}
+
+HotWindowCache::Stats HotWindowCache::stats() const {
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.devices = m_devices.size();
+    stats.entries = m_entryCount;
+    stats.bytes = m_bytes;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    return stats;
+}
+
+void HotWindowCache::recordLookup(bool hit) const {
+    QMutexLocker locker(&m_mutex);
+    if (hit) {
+        m_hits++;
+    } else {
+        m_misses++;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <deque>
+#include "VitalSignData.h"
+
+// 最近数据的内存热窗口
+// 按设备保存最近一段时间（默认15分钟）的生理数据与ECG帧（共享帧，不复制采样），以及全局的最近报警。
+// 写入路径在数据库提交成功后插入；coveredSinceUs()之后的时间段在缓存中是完整的，
+// 查询只需对更早的部分访问数据库。总内存受固定预算约束，超出时淘汰全局最旧的条目
+class HotWindowCache {
+public:
+    static constexpr qint64 DefaultWindowUs = 15LL * 60 * 1000000;
+    static constexpr qint64 DefaultBudgetBytes = 64LL * 1024 * 1024;
+
+    explicit HotWindowCache(qint64 windowUs = DefaultWindowUs, qint64 budgetBytes = DefaultBudgetBytes);
+
+    void setWindowUs(qint64 windowUs);
+    void setBudgetBytes(qint64 budgetBytes);
+    qint64 windowUs() const;
+    qint64 budgetBytes() const;
+
+    // 清空缓存，并声明sinceUs之后的数据从此完整（调用方负责随后补齐这段数据）
+    void reset(qint64 sinceUs);
+
+    void insert(const VitalSignData& data);
+    void insertAlarm(const AlarmInfo& alarm);
+
+    // 缓存完整覆盖的起点（毫秒对齐），deviceId为空表示全部设备
+    qint64 coveredSinceUs(const QString& deviceId = QString()) const;
+    qint64 alarmsCoveredSinceUs() const;
+
+    // 最新一条数据，缓存中没有时返回false
+    bool latest(VitalSignData& data, const QString& deviceId = QString()) const;
+
+    // [startUs, endUs]内最新的limit条，按时间降序（与数据库查询一致）
+    QVector<VitalSignData> query(qint64 startUs, qint64 endUs, int limit,
+                                 const QString& deviceId = QString()) const;
+    QVector<AlarmInfo> queryAlarms(qint64 startUs, qint64 endUs, int limit) const;
+
+    struct Stats {
+        int devices;
+        qint64 entries;
+        qint64 bytes;
+        qint64 hits;        // 完全由缓存回答的查询
+        qint64 misses;      // 需要访问数据库的查询
+    };
+    Stats stats() const;
+    void recordLookup(bool hit) const;
+
+private:
+    struct DeviceWindow {
+        std::deque<VitalSignData> entries;     // 按时间升序
+        qint64 evictedUpToUs = -1;             // 已淘汰条目中最新的时间
+    };
+
+    static qint64 entryBytes(const VitalSignData& data);
+    static qint64 alarmTimeUs(const AlarmInfo& alarm);
+    static qint64 alignUp(qint64 us);
+
+    void evictLocked();
+    void popFrontLocked(DeviceWindow& window);
+    qint64 coveredSinceLocked(const QString& deviceId) const;
+
+    mutable QMutex m_mutex;
+    qint64 m_windowUs;
+    qint64 m_budgetBytes;
+    qint64 m_bytes;
+    qint64 m_entryCount;
+    qint64 m_coveredSinceUs;
+    QHash<QString, DeviceWindow> m_devices;
+
+    static constexpr int MaxAlarms = 1000;
+    std::deque<AlarmInfo> m_alarms;
+    qint64 m_alarmsEvictedUpToUs;
+
+    mutable qint64 m_hits;
+    mutable qint64 m_misses;
+};
@@ -0,0 +1,295 @@
+#include "HrvAnalyzer.h"
+#include "Fft.h"
+#include "QrsDetector.h"
+#include "WaveformStore.h"
+#include <QDateTime>
+#include <QtConcurrent>
+#include <QtMath>
+#include <memory>
+
+namespace {
+
+const qint64 WarmupUs = 5LL * 1000000;         // 检测器学习阈值所需的前导数据
+const qint64 ClosedMarginUs = 10LL * 1000000;  // 小时结束后留出写入延迟
+const double MinRrMs = 300.0;
+const double MaxRrMs = 2000.0;
+const double MaxRrChange = 0.2;                // 与前一区间相差超过20%视为异位/伪差
+
+const double ResampleHz = 4.0;
+const int WelchSize = 256;
+const int WelchStep = WelchSize / 2;
+
+// 区间首尾相接（中间没有缺口或漏检）
+inline bool adjacent(const RrInterval& previous, const RrInterval& next) {
+    return previous.endUs == next.startUs;
+}
+
+inline bool inRange(double ms) {
+    return ms >= MinRrMs && ms <= MaxRrMs;
+}
+
+QString cacheKey(const QString& deviceId, qint64 hourStartUs) {
+    return QString("%1|%2").arg(deviceId).arg(hourStartUs);
+}
+
+const QVector<float>& hannWindow() {
+    static const QVector<float> window = []() {
+        QVector<float> w(WelchSize);
+        for (int i = 0; i < WelchSize; ++i) {
+            w[i] = float(0.5 - 0.5 * std::cos(2.0 * M_PI * i / (WelchSize - 1)));
+        }
+        return w;
+    }();
+    return window;
+}
+
+// Welch功率谱（ms²/Hz），返回参与平均的段数
+int welchSpectrum(const QVector<QVector<RrInterval>>& runs, QVector<double>& psd) {
+    static const Fft fft(WelchSize);
+    const QVector<float>& window = hannWindow();
+    double windowPower = 0.0;
+    for (float w : window) windowPower += double(w) * w;
+
+    psd.fill(0.0, WelchSize / 2 + 1);
+    QVector<float> series;
+    QVector<float> segment(WelchSize);
+    QVector<float> power(WelchSize / 2 + 1);
+    int segments = 0;
+
+    for (const QVector<RrInterval>& run : runs) {
+        // NN值位于区间结束的R波时刻，线性插值到等间隔序列
+        const qint64 firstUs = run.first().endUs;
+        const qint64 lastUs = run.last().endUs;
+        const int count = int((lastUs - firstUs) * ResampleHz / 1e6) + 1;
+        if (count < WelchSize) continue;
+
+        series.resize(count);
+        int j = 0;
+        for (int k = 0; k < count; ++k) {
+            const qint64 t = firstUs + qint64(k * 1e6 / ResampleHz);
+            while (j + 1 < run.size() - 1 && run[j + 1].endUs < t) ++j;
+            const RrInterval& a = run[j];
+            const RrInterval& b = run[qMin(j + 1, run.size() - 1)];
+            const double span = double(b.endUs - a.endUs);
+            const double f = span > 0 ? qBound(0.0, (t - a.endUs) / span, 1.0) : 0.0;
+            series[k] = float(a.ms() + f * (b.ms() - a.ms()));
+        }
+
+        for (int offset = 0; offset + WelchSize <= count; offset += WelchStep) {
+            double mean = 0.0;
+            for (int i = 0; i < WelchSize; ++i) mean += series[offset + i];
+            mean /= WelchSize;
+            for (int i = 0; i < WelchSize; ++i) {
+                segment[i] = float((series[offset + i] - mean) * window[i]);
+            }
+            fft.powerSpectrum(segment.constData(), power.data());
+            for (int k = 0; k < power.size(); ++k) psd[k] += power[k];
+            segments++;
+        }
+    }
+
+    if (segments == 0) return 0;
+
+    // 单边谱密度：除直流与奈奎斯特外乘2
+    const double scale = 1.0 / (ResampleHz * windowPower * segments);
+    for (int k = 0; k < psd.size(); ++k) {
+        psd[k] *= scale * ((k == 0 || k == psd.size() - 1) ? 1.0 : 2.0);
+    }
+    return segments;
+}
+
+} // namespace
+
+HrvAnalyzer::HrvAnalyzer(WaveformStore* waveformStore)
+    : m_waveformStore(waveformStore)
+    , m_hourCache(32 * 1024 * 1024)
+{
+}
+
+void HrvAnalyzer::clearCache() {
+    QMutexLocker locker(&m_mutex);
+    m_hourCache.clear();
+}
+
+bool HrvAnalyzer::isClosed(qint64 endUs) {
+    return endUs + ClosedMarginUs < QDateTime::currentMSecsSinceEpoch() * 1000;
+}
+
+QVector<RrInterval> HrvAnalyzer::detectIntervals(const QString& deviceId, qint64 startUs, qint64 endUs) const {
+    QVector<RrInterval> result;
+    if (!m_waveformStore) return result;
+
+    std::unique_ptr<QrsDetector> detector;
+    QVector<qint64> beats;
+    qint64 lastBeatUs = -1;
+
+    m_waveformStore->readRange(deviceId, startUs - WarmupUs, endUs, [&](const WaveformFrameView& frame) {
+        // 缺口或采样率变化时重新开始检测，不跨缺口形成RR区间
+        const qint64 toleranceUs = frame.sampleRate > 0 ? 500000 / frame.sampleRate : 0;
+        if (!detector || detector->sampleRate() != frame.sampleRate ||
+            qAbs(frame.timestampUs - detector->nextSampleUs()) > toleranceUs) {
+            if (!detector || detector->sampleRate() != frame.sampleRate) {
+                detector = std::make_unique<QrsDetector>(frame.sampleRate);
+            }
+            detector->reset(frame.timestampUs);
+            lastBeatUs = -1;
+        }
+
+        beats.resize(0);
+        detector->process(frame.samples, frame.sampleCount, beats);
+        for (qint64 beatUs : std::as_const(beats)) {
+            if (lastBeatUs >= 0 && beatUs >= startUs && beatUs < endUs) {
+                result.append({lastBeatUs, beatUs});
+            }
+            lastBeatUs = beatUs;
+        }
+        return true;
+    });
+    return result;
+}
+
+QVector<RrInterval> HrvAnalyzer::hourIntervals(const QString& deviceId, qint64 hourStartUs) {
+    const QString key = cacheKey(deviceId, hourStartUs);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const QVector<RrInterval>* cached = m_hourCache.object(key)) {
+            return *cached;
+        }
+    }
+
+    QVector<RrInterval> intervals = detectIntervals(deviceId, hourStartUs, hourStartUs + HourUs);
+
+    // 当前小时还在写入，不缓存
+    if (isClosed(hourStartUs + HourUs)) {
+        QMutexLocker locker(&m_mutex);
+        m_hourCache.insert(key, new QVector<RrInterval>(intervals),
+                           qMax<qsizetype>(1, intervals.size() * qsizetype(sizeof(RrInterval))));
+    }
+    return intervals;
+}
+
+QList<HrvAnalyzer::HourResult> HrvAnalyzer::computeHours(const QString& deviceId, qint64 startUs, qint64 endUs,
+                                                         bool withMetrics) {
+    QList<qint64> hours;
+    const qint64 firstHour = startUs - ((startUs % HourUs) + HourUs) % HourUs;
+    for (qint64 hour = firstHour; hour < endUs; hour += HourUs) {
+        hours.append(hour);
+    }
+
+    // 各小时相互独立，并行检测与计算
+    return QtConcurrent::blockingMapped<QList<HourResult>>(hours,
+        [this, deviceId, startUs, endUs, withMetrics](qint64 hour) {
+            HourResult result;
+            const QVector<RrInterval> all = hourIntervals(deviceId, hour);
+            const qint64 from = qMax(startUs, hour);
+            const qint64 to = qMin(endUs, hour + HourUs);
+            if (from == hour && to == hour + HourUs) {
+                result.intervals = all;
+            } else {
+                for (const RrInterval& interval : all) {
+                    if (interval.endUs >= from && interval.endUs < to) result.intervals.append(interval);
+                }
+            }
+            if (withMetrics) {
+                result.metrics = computeMetrics(result.intervals, from, to);
+            }
+            return result;
+        });
+}
+
+QVector<RrInterval> HrvAnalyzer::intervals(const QString& deviceId, qint64 startUs, qint64 endUs) {
+    QVector<RrInterval> result;
+    const QList<HourResult> hours = computeHours(deviceId, startUs, endUs, false);
+    for (const HourResult& hour : hours) {
+        result += hour.intervals;
+    }
+    return result;
+}
+
+HrvMetrics HrvAnalyzer::analyze(const QString& deviceId, qint64 startUs, qint64 endUs) {
+    return computeMetrics(intervals(deviceId, startUs, endUs), startUs, endUs);
+}
+
+HrvAnalyzer::Report HrvAnalyzer::report(const QString& deviceId, qint64 startUs, qint64 endUs) {
+    // 报告窗口通常截止到当前时刻、每次都不同，不缓存整份报告；已结束的小时由小时缓存复用，
+    // 重复请求只重新计算未结束的小时和合并后的整体指标
+    Report report;
+    const QList<HourResult> hours = computeHours(deviceId, startUs, endUs, true);
+    QVector<RrInterval> all;
+    for (const HourResult& hour : hours) {
+        all += hour.intervals;
+        report.hourly.append(hour.metrics);
+    }
+    report.overall = computeMetrics(all, startUs, endUs);
+    return report;
+}
+
+HrvMetrics HrvAnalyzer::computeMetrics(const QVector<RrInterval>& intervals, qint64 startUs, qint64 endUs) {
+    HrvMetrics metrics;
+    metrics.startUs = startUs;
+    metrics.endUs = endUs;
+
+    // 筛选NN区间，并把首尾相接的NN区间分成连续段（逐差与频域只在段内计算）
+    QVector<QVector<RrInterval>> runs;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    double successiveSquares = 0.0;
+    int successiveCount = 0;
+    int over50 = 0;
+
+    const RrInterval* previous = nullptr;
+    bool previousAccepted = false;
+    for (const RrInterval& interval : intervals) {
+        const double ms = interval.ms();
+        const bool linked = previous && adjacent(*previous, interval);
+        bool accepted = inRange(ms);
+        if (accepted && linked && inRange(previous->ms())) {
+            accepted = qAbs(ms - previous->ms()) <= MaxRrChange * previous->ms();
+        }
+
+        if (accepted) {
+            metrics.nnCount++;
+            sum += ms;
+            sumSquares += ms * ms;
+            if (linked && previousAccepted) {
+                const double diff = ms - previous->ms();
+                successiveSquares += diff * diff;
+                successiveCount++;
+                if (qAbs(diff) > 50.0) over50++;
+                runs.last().append(interval);
+            } else {
+                runs.append(QVector<RrInterval>{interval});
+            }
+        } else {
+            metrics.rejected++;
+        }
+        previous = &interval;
+        previousAccepted = accepted;
+    }
+
+    if (metrics.nnCount < 2) return metrics;
+
+    metrics.meanNnMs = sum / metrics.nnCount;
+    const double variance = (sumSquares - sum * sum / metrics.nnCount) / (metrics.nnCount - 1);
+    metrics.sdnnMs = std::sqrt(qMax(0.0, variance));
+    if (successiveCount > 0) {
+        metrics.rmssdMs = std::sqrt(successiveSquares / successiveCount);
+        metrics.pnn50 = 100.0 * over50 / successiveCount;
+    }
+
+    QVector<double> psd;
+    if (welchSpectrum(runs, psd) > 0) {
+        const double df = ResampleHz / WelchSize;
+        for (int k = 0; k < psd.size(); ++k) {
+            const double frequency = k * df;
+            if (frequency >= 0.04 && frequency < 0.15) {
+                metrics.lfPower += psd[k] * df;
+            } else if (frequency >= 0.15 && frequency < 0.4) {
+                metrics.hfPower += psd[k] * df;
+            }
+        }
+        metrics.hasSpectrum = true;
+        metrics.lfHfRatio = metrics.hfPower > 0 ? metrics.lfPower / metrics.hfPower : 0.0;
+    }
+    return metrics;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+class WaveformStore;
+
+// 一个RR区间（相邻两个R波），时间为epoch µs
+struct RrInterval {
+    qint64 startUs;
+    qint64 endUs;
+
+    double ms() const { return (endUs - startUs) / 1000.0; }
+};
+
+// 心率变异性指标
+struct HrvMetrics {
+    qint64 startUs = 0;
+    qint64 endUs = 0;
+    int nnCount = 0;            // 参与计算的NN区间数
+    int rejected = 0;           // 剔除的区间（伪差、异位搏动）
+    double meanNnMs = 0.0;
+    double sdnnMs = 0.0;
+    double rmssdMs = 0.0;
+    double pnn50 = 0.0;         // %
+    bool hasSpectrum = false;   // 连续NN序列不足64秒时没有频域指标
+    double lfPower = 0.0;       // 0.04-0.15Hz (ms²)
+    double hfPower = 0.0;       // 0.15-0.4Hz (ms²)
+    double lfHfRatio = 0.0;
+
+    bool isValid() const { return nnCount >= 2; }
+};
+
+// 基于已存储ECG的HRV分析
+// R波由QrsDetector从波形分段中检出，RR区间按整小时(UTC)计算并缓存（已结束的小时不会再变化），
+// 跨多个小时的窗口在线程池中并行计算各小时，再合并求指标。
+// 频域：NN序列线性重采样到4Hz，Welch法（256点Hann窗、50%重叠）估计功率谱，各段平均
+class HrvAnalyzer {
+public:
+    static constexpr qint64 HourUs = 3600LL * 1000000;
+
+    struct Report {
+        HrvMetrics overall;
+        QVector<HrvMetrics> hourly;
+    };
+
+    explicit HrvAnalyzer(WaveformStore* waveformStore);
+
+    // 窗口[startUs, endUs)内结束的RR区间（按时间升序）
+    QVector<RrInterval> intervals(const QString& deviceId, qint64 startUs, qint64 endUs);
+
+    // 单个窗口的指标
+    HrvMetrics analyze(const QString& deviceId, qint64 startUs, qint64 endUs);
+
+    // 整体指标与逐小时指标（例如24小时报告）
+    Report report(const QString& deviceId, qint64 startUs, qint64 endUs);
+
+    // 由RR区间计算指标（纯函数）
+    static HrvMetrics computeMetrics(const QVector<RrInterval>& intervals, qint64 startUs, qint64 endUs);
+
+    void clearCache();
+
+private:
+    struct HourResult {
+        QVector<RrInterval> intervals;
+        HrvMetrics metrics;
+    };
+
+    QVector<RrInterval> hourIntervals(const QString& deviceId, qint64 hourStartUs);
+    QVector<RrInterval> detectIntervals(const QString& deviceId, qint64 startUs, qint64 endUs) const;
+    QList<HourResult> computeHours(const QString& deviceId, qint64 startUs, qint64 endUs, bool withMetrics);
+    static bool isClosed(qint64 endUs);
+
+    WaveformStore* m_waveformStore;
+    QMutex m_mutex;
+    QCache<QString, QVector<RrInterval>> m_hourCache;   // 代价为字节数
+};
@@ -0,0 +1,51 @@
+#include "MetricsOverlay.h"
+#include "PipelineMetrics.h"
+#include <QVBoxLayout>
+#include <QFontDatabase>
+
+MetricsOverlay::MetricsOverlay(QWidget* parent)
+    : QFrame(parent)
+    , m_textLabel(new QLabel(this))
+    , m_refreshTimer(new QTimer(this))
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setStyleSheet("MetricsOverlay { background-color: rgba(0, 0, 0, 170); border-radius: 4px; }"
+                  "QLabel { color: #7CFC00; }");
+
+    m_textLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    m_textLabel->setTextFormat(Qt::PlainText);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(8, 6, 8, 6);
+    layout->addWidget(m_textLabel);
+    setLayout(layout);
+
+    connect(m_refreshTimer, &QTimer::timeout, this, &MetricsOverlay::refresh);
+    hide();
+}
+
+void MetricsOverlay::toggle() {
+    setVisible(!isVisible());
+    if (isVisible()) {
+        raise();
+    }
+}
+
+void MetricsOverlay::showEvent(QShowEvent* event) {
+    QFrame::showEvent(event);
+    refresh();
+    m_refreshTimer->start(500);
+}
+
+void MetricsOverlay::hideEvent(QHideEvent* event) {
+    QFrame::hideEvent(event);
+    m_refreshTimer->stop();
+}
+
+void MetricsOverlay::refresh() {
+    m_textLabel->setText(PipelineMetrics::instance()->summaryText());
+    adjustSize();
+    if (parentWidget()) {
+        move(parentWidget()->width() - width() - 10, 10);
+    }
+}
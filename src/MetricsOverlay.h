@@ -0,0 +1,26 @@
+#pragma once
+#include <QFrame>
+#include <QLabel>
+#include <QTimer>
+
+// 调试浮层：周期显示PipelineMetrics的帧率、丢帧、队列深度和各阶段延迟
+class MetricsOverlay : public QFrame {
+    Q_OBJECT
+
+public:
+    explicit MetricsOverlay(QWidget* parent = nullptr);
+
+    // 显示/隐藏（隐藏时停止刷新）
+    void toggle();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private slots:
+    void refresh();
+
+private:
+    QLabel* m_textLabel;
+    QTimer* m_refreshTimer;
+};
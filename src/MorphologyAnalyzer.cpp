@@ -0,0 +1,319 @@
+#include "MorphologyAnalyzer.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr int PostSamples = MorphologyAnalyzer::WindowSamples - MorphologyAnalyzer::PreSamples;
+constexpr double SampleMs = 1000.0 / MorphologyAnalyzer::AnalysisRate;     // 4ms
+
+const int SearchSamples = 25;           // 在检出位置±100ms内找R峰
+const int MaxShift = 8;                 // 模板对齐的搜索范围±32ms
+const int AlignOffset = 12;             // 对齐段从R波前48ms开始
+const int AlignLength = 32;             // 对齐段长128ms（4的倍数），覆盖QRS
+const float MatchCorrelation = 0.9f;
+const int MinTemplateBeats = 5;
+const int HistorySamples = 4 * MorphologyAnalyzer::AnalysisRate;
+const int RecentRr = 8;
+
+// 测量窗口（相对R波，采样数）
+const int BaselineFrom = 30;            // 等电位线在R波前120~32ms内找
+const int BaselineTo = 8;
+const int BaselineLength = 5;           // 最平坦的20ms
+const int OnsetSearch = 25;             // QRS起点在R波前100ms内
+const int OffsetSearch = 40;            // J点在R波后160ms内
+const float SlopeThreshold = 0.15f;     // 相对QRS最大斜率
+const int StAfterJ = 15;                // J点后60ms
+const int TSearchAfterJ = 20;           // T波在J点后80ms起
+const int TEndSearch = 30;              // T波峰后120ms内找最陡处
+
+// QRS起止：R波两侧斜率超过阈值的最外侧采样；t需覆盖r前后OnsetSearch+1/OffsetSearch+1个采样
+bool qrsBounds(const float* t, int r, int& onset, int& jPoint) {
+    const auto slope = [t](int i) { return (t[i + 1] - t[i - 1]) * 0.5f; };
+    float maxSlope = 0.0f;
+    for (int i = r - OnsetSearch; i <= r + OnsetSearch; ++i) {
+        maxSlope = qMax(maxSlope, std::abs(slope(i)));
+    }
+    if (maxSlope <= 0.0f) return false;
+
+    const float threshold = SlopeThreshold * maxSlope;
+    onset = r;
+    for (int i = r - OnsetSearch; i < r; ++i) {
+        if (std::abs(slope(i)) >= threshold) {
+            onset = i - 1;
+            break;
+        }
+    }
+    jPoint = r;
+    for (int i = r + OffsetSearch; i > r; --i) {
+        if (std::abs(slope(i)) >= threshold) {
+            jPoint = i + 1;
+            break;
+        }
+    }
+    return true;
+}
+
+const float* ones() {
+    static const std::vector<float> values(AlignLength, 1.0f);
+    return values.data();
+}
+
+} // namespace
+
+MorphologyAnalyzer::MorphologyAnalyzer()
+    : m_resampler(AnalysisRate, AnalysisRate)
+    , m_streamStartUs(0)
+    , m_historyStart(0)
+    , m_lastBeatUs(-1)
+    , m_beats(TemplateBeats)
+    , m_template(1)
+    , m_beatCount(0)
+    , m_nextBeat(0)
+    , m_unmatched(0)
+    , m_alignEnergy(0.0f)
+    , m_stats{0, 0, 0}
+{
+    m_alignSegment.resize(AlignLength);
+}
+
+void MorphologyAnalyzer::restart(int sampleRate, qint64 firstSampleUs) {
+    if (m_resampler.inputRate() != sampleRate) {
+        m_resampler = PolyphaseResampler(sampleRate, AnalysisRate);
+    } else {
+        m_resampler.reset();
+    }
+    m_streamStartUs = firstSampleUs;
+    m_history.clear();
+    m_historyStart = 0;
+    m_pendingBeats.clear();
+    m_lastBeatUs = -1;
+}
+
+void MorphologyAnalyzer::reset() {
+    restart(m_resampler.inputRate(), 0);
+    m_rrMs.clear();
+    m_beatCount = 0;
+    m_nextBeat = 0;
+    m_unmatched = 0;
+    m_morphology = BeatMorphology();
+}
+
+bool MorphologyAnalyzer::process(const float* samples, int count, const qint64* beatsUs, int beatCount,
+                                 QVector<AnalyzedBeat>* analyzed) {
+    m_resampler.process(samples, count, m_history);
+
+    for (int i = 0; i < beatCount; ++i) {
+        m_stats.beats++;
+        const qint64 beatUs = beatsUs[i];
+        if (m_lastBeatUs >= 0) {
+            const double rrMs = (beatUs - m_lastBeatUs) / 1000.0;
+            // 只保留生理范围内的RR（漏检、误检不参与QTc校正）
+            if (rrMs >= 250.0 && rrMs <= 2500.0) {
+                m_rrMs.append(rrMs);
+                if (m_rrMs.size() > RecentRr) m_rrMs.removeFirst();
+            }
+        }
+        m_lastBeatUs = beatUs;
+        m_pendingBeats.append(qRound64((beatUs - m_streamStartUs) * (AnalysisRate / 1e6)));
+    }
+
+    // 心搏窗口需要R波后的采样，不够时留到下一帧
+    bool updated = false;
+    const qint64 end = m_historyStart + m_history.size();
+    while (!m_pendingBeats.isEmpty()) {
+        const qint64 beat = m_pendingBeats.first();
+        if (beat + SearchSamples + MaxShift + PostSamples > end) break;
+        m_pendingBeats.removeFirst();
+        updated = processBeat(beat, analyzed) || updated;
+    }
+
+    // 只保留最近几秒和尚未处理的心搏所需的采样
+    qint64 keepFrom = end - HistorySamples;
+    if (!m_pendingBeats.isEmpty()) {
+        keepFrom = qMin(keepFrom, m_pendingBeats.first() - SearchSamples - MaxShift - PreSamples);
+    }
+    if (keepFrom > m_historyStart) {
+        m_history.remove(0, int(keepFrom - m_historyStart));
+        m_historyStart = keepFrom;
+    }
+
+    if (updated) {
+        measure();
+    }
+    return updated;
+}
+
+bool MorphologyAnalyzer::processBeat(qint64 beatIndex, QVector<AnalyzedBeat>* analyzed) {
+    if (beatIndex - SearchSamples - MaxShift - PreSamples < m_historyStart) return false;
+    const float* x = m_history.constData() + (beatIndex - m_historyStart);
+
+    // R峰：检出位置附近偏离局部均值最大的采样（兼容负向QRS）
+    float mean = 0.0f;
+    for (int i = -SearchSamples; i <= SearchSamples; ++i) {
+        mean += x[i];
+    }
+    mean /= 2 * SearchSamples + 1;
+    int peak = 0;
+    float largest = -1.0f;
+    for (int i = -SearchSamples; i <= SearchSamples; ++i) {
+        const float deviation = std::abs(x[i] - mean);
+        if (deviation > largest) {
+            largest = deviation;
+            peak = i;
+        }
+    }
+    const float* r = x + peak;
+
+    AnalyzedBeat info;
+    info.timeUs = m_streamStartUs + qRound64((beatIndex + peak) * (1e6 / AnalysisRate));
+    int onset = 0;
+    int jPoint = 0;
+    info.qrsMs = qrsBounds(r, 0, onset, jPoint) ? float((jPoint - onset) * SampleMs) : 0.0f;
+    info.matched = true;
+
+    int shift = 0;
+    if (m_beatCount >= MinTemplateBeats) {
+        float correlation = 0.0f;
+        shift = alignToTemplate(r, correlation);
+        info.matched = correlation >= MatchCorrelation;
+    }
+    if (analyzed) {
+        analyzed->append(info);
+    }
+    if (!info.matched) {
+        m_stats.rejected++;
+        if (++m_unmatched < TemplateBeats) return false;
+        // 连续多个心搏都不匹配：主导形态已改变（例如新发束支阻滞），从这个心搏开始重新学习
+        m_beatCount = 0;
+        m_nextBeat = 0;
+        shift = 0;
+    }
+    m_unmatched = 0;
+    m_stats.matched++;
+
+    BeatWindow& window = m_beats[m_nextBeat];
+    std::copy(r + shift - PreSamples, r + shift + PostSamples, window.samples);
+    m_nextBeat = (m_nextBeat + 1) % TemplateBeats;
+    m_beatCount = qMin(m_beatCount + 1, TemplateBeats);
+    updateTemplate();
+    return true;
+}
+
+int MorphologyAnalyzer::alignToTemplate(const float* r, float& correlation) const {
+    // 模板对齐段已去均值，点积即协方差；心搏段的方差由平方和与和求出
+    int bestShift = 0;
+    correlation = -1.0f;
+    for (int shift = -MaxShift; shift <= MaxShift; ++shift) {
+        const float* segment = r + shift - AlignOffset;
+        const float covariance = dotProduct(segment, m_alignSegment.constData(), AlignLength);
+        const float sum = dotProduct(segment, ones(), AlignLength);
+        const float variance = dotProduct(segment, segment, AlignLength) - sum * sum / AlignLength;
+        if (variance <= 0.0f || m_alignEnergy <= 0.0f) continue;
+        const float value = covariance / std::sqrt(variance * m_alignEnergy);
+        if (value > correlation) {
+            correlation = value;
+            bestShift = shift;
+        }
+    }
+    return bestShift;
+}
+
+void MorphologyAnalyzer::updateTemplate() {
+    // 逐点中位数：个别噪声心搏不影响模板
+    float values[TemplateBeats];
+    const int middle = m_beatCount / 2;
+    float* out = m_template.front().samples;
+    for (int i = 0; i < WindowSamples; ++i) {
+        for (int b = 0; b < m_beatCount; ++b) {
+            values[b] = m_beats[b].samples[i];
+        }
+        std::nth_element(values, values + middle, values + m_beatCount);
+        out[i] = values[middle];
+    }
+
+    const float* segment = out + PreSamples - AlignOffset;
+    float mean = 0.0f;
+    for (int i = 0; i < AlignLength; ++i) {
+        mean += segment[i];
+    }
+    mean /= AlignLength;
+    for (int i = 0; i < AlignLength; ++i) {
+        m_alignSegment[i] = segment[i] - mean;
+    }
+    m_alignEnergy = dotProduct(m_alignSegment.constData(), m_alignSegment.constData(), AlignLength);
+}
+
+void MorphologyAnalyzer::measure() {
+    m_morphology = BeatMorphology();
+    if (m_beatCount < MinTemplateBeats) return;
+
+    const float* t = m_template.front().samples;
+    const int r = PreSamples;
+    const auto slope = [t](int i) { return (t[i + 1] - t[i - 1]) * 0.5f; };
+
+    if (!m_rrMs.isEmpty()) {
+        QVector<double> rr = m_rrMs;
+        std::nth_element(rr.begin(), rr.begin() + rr.size() / 2, rr.end());
+        m_morphology.rrMs = rr[rr.size() / 2];
+    }
+
+    // 等电位线：PR段内最平坦的一小段
+    int baselineStart = r - BaselineFrom;
+    float flattest = std::numeric_limits<float>::max();
+    for (int i = r - BaselineFrom; i + BaselineLength <= r - BaselineTo; ++i) {
+        float activity = 0.0f;
+        for (int k = i; k < i + BaselineLength - 1; ++k) {
+            activity += std::abs(t[k + 1] - t[k]);
+        }
+        if (activity < flattest) {
+            flattest = activity;
+            baselineStart = i;
+        }
+    }
+    float baseline = 0.0f;
+    for (int i = baselineStart; i < baselineStart + BaselineLength; ++i) {
+        baseline += t[i];
+    }
+    baseline /= BaselineLength;
+
+    int onset = r;
+    int jPoint = r;
+    if (!qrsBounds(t, r, onset, jPoint)) return;
+
+    m_morphology.templateBeats = m_beatCount;
+    m_morphology.qrsMs = (jPoint - onset) * SampleMs;
+    m_morphology.stMv = t[qMin(jPoint + StAfterJ, WindowSamples - 1)] - baseline;
+
+    // T波终点：T波峰之后最陡处的切线与等电位线的交点；搜索不超过RR的70%
+    int tLimit = WindowSamples - 2;
+    if (m_morphology.rrMs > 0.0) {
+        tLimit = qMin(tLimit, r + int(0.7 * m_morphology.rrMs / SampleMs));
+    }
+    int tPeak = -1;
+    float tAmplitude = 0.0f;
+    for (int i = jPoint + TSearchAfterJ; i <= tLimit; ++i) {
+        const float amplitude = std::abs(t[i] - baseline);
+        if (amplitude > tAmplitude) {
+            tAmplitude = amplitude;
+            tPeak = i;
+        }
+    }
+    if (tPeak < 0 || tPeak >= tLimit) return;
+
+    int steepest = tPeak + 1;
+    for (int i = tPeak + 1; i <= qMin(tPeak + TEndSearch, tLimit); ++i) {
+        if (std::abs(slope(i)) > std::abs(slope(steepest))) steepest = i;
+    }
+    const float steepestSlope = slope(steepest);
+    if (steepestSlope == 0.0f) return;
+    const double tEnd = steepest + (baseline - t[steepest]) / steepestSlope;
+    if (tEnd <= tPeak || tEnd >= WindowSamples) return;
+
+    m_morphology.qtMs = (tEnd - onset) * SampleMs;
+    if (m_morphology.rrMs > 0.0) {
+        m_morphology.qtcMs = m_morphology.qtMs / std::sqrt(m_morphology.rrMs / 1000.0);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <QVector>
+#include <vector>
+#include "PolyphaseResampler.h"
+
+// 基于模板心搏的形态测量结果（时间单位ms，幅值单位mV）
+struct BeatMorphology {
+    int templateBeats = 0;      // 模板中的心搏数，0表示尚无模板
+    double stMv = 0.0;          // ST偏移：J点后60ms相对PR段等电位线
+    double qrsMs = 0.0;         // QRS宽度
+    double qtMs = 0.0;
+    double qtcMs = 0.0;         // Bazett校正
+    double rrMs = 0.0;          // 最近RR间期的中位数
+
+    bool isValid() const { return templateBeats > 0; }
+};
+
+// 单个心搏的形态（供心律分类）
+struct AnalyzedBeat {
+    qint64 timeUs;              // R峰时间
+    float qrsMs;                // 该心搏自身的QRS宽度，无法测量时为0
+    bool matched;               // 与主导心搏模板相关
+};
+
+// 流式心搏形态分析（QRS检测的下游）
+// 信号重采样到固定的分析采样率，每个心搏截取定长、按缓存行对齐的窗口（R波前320ms、后704ms）；
+// 以当前模板QRS段的归一化互相关对齐（SIMD点积，±32ms），相关系数不足的心搏（异位搏动、噪声）不进入模板。
+// 模板为最近若干个对齐心搏的逐点中位数，在模板上测量QRS宽度、ST偏移与QT/QTc
+class MorphologyAnalyzer {
+public:
+    static constexpr int AnalysisRate = 250;
+    static constexpr int WindowSamples = 256;
+    static constexpr int PreSamples = 80;
+    static constexpr int TemplateBeats = 9;
+
+    struct alignas(64) BeatWindow {
+        float samples[WindowSamples];
+    };
+
+    MorphologyAnalyzer();
+
+    // 开始一段新的连续信号（首帧、缺口、采样率变化）；模板保留
+    void restart(int sampleRate, qint64 firstSampleUs);
+    // 清空模板与全部状态
+    void reset();
+
+    // 输入一段连续采样与其中新检出的R波时间(epoch µs)，返回本次是否更新了模板
+    // 心搏要等R波后的窗口采样到齐才分析，analyzed不为空时追加本次分析完的心搏（约滞后0.8秒）
+    bool process(const float* samples, int count, const qint64* beatsUs, int beatCount,
+                 QVector<AnalyzedBeat>* analyzed = nullptr);
+
+    const BeatMorphology& morphology() const { return m_morphology; }
+    const float* templateSamples() const { return m_template.front().samples; }
+
+    struct Stats {
+        qint64 beats;
+        qint64 matched;
+        qint64 rejected;    // 与模板不相关的心搏
+    };
+    Stats stats() const { return m_stats; }
+
+private:
+    bool processBeat(qint64 beatIndex, QVector<AnalyzedBeat>* analyzed);
+    // 返回最佳偏移（采样），correlation为对应的归一化相关系数
+    int alignToTemplate(const float* r, float& correlation) const;
+    void updateTemplate();
+    void measure();
+
+    PolyphaseResampler m_resampler;
+    qint64 m_streamStartUs;
+    QVector<float> m_history;           // 分析采样率下最近的连续信号
+    qint64 m_historyStart;              // m_history[0]的采样序号（自restart起）
+    QVector<qint64> m_pendingBeats;     // 等待后续采样的心搏（采样序号）
+    qint64 m_lastBeatUs;
+    QVector<double> m_rrMs;             // 最近的RR间期
+
+    std::vector<BeatWindow> m_beats;    // 最近的对齐心搏（环形）
+    std::vector<BeatWindow> m_template; // 1个元素：逐点中位数模板
+    int m_beatCount;
+    int m_nextBeat;
+    int m_unmatched;                    // 连续不匹配的心搏数
+    QVector<float> m_alignSegment;      // 模板QRS段（去均值），用于对齐
+    float m_alignEnergy;
+
+    BeatMorphology m_morphology;
+    Stats m_stats;
+};
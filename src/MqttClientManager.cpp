@@ -1,6 +1,8 @@
 #ifndef NO_MQTT_SUPPORT
 
 #include "MqttClientManager.h"
+#include "PipelineMetrics.h"
+#include "SessionCapture.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -9,6 +11,7 @@
 MqttClientManager::MqttClientManager(QObject* parent)
     : QObject(parent)
     , m_client(new QMqttClient(this))
+    , m_recorder(nullptr)
 {
     connect(m_client, &QMqttClient::connected, this, &MqttClientManager::onConnected);
     connect(m_client, &QMqttClient::disconnected, this, &MqttClientManager::onDisconnected);
@@ -69,9 +72,11 @@ void MqttClientManager::onConnected() {
     qDebug() << "Connected to MQTT broker";
     emit connectionStateChanged(true);
     
-    // 自动订阅数据和报警主题
+    // 自动订阅数据和报警主题（含按设备区分的子主题）
     subscribeTopic("ecg/vitalsign");
+    subscribeTopic("ecg/vitalsign/+");
     subscribeTopic("ecg/alarm");
+    subscribeTopic("ecg/alarm/+");
 }
 
 void MqttClientManager::onDisconnected() {
@@ -80,14 +85,43 @@ void MqttClientManager::onDisconnected() {
 }
 
 void MqttClientManager::onMessageReceived(const QByteArray& message, const QMqttTopicName& topic) {
+    const qint64 receivedAtNs = PipelineMetrics::nowNs();
     QString topicName = topic.name();
     qDebug() << "Message received on topic:" << topicName;
     
-    if (topicName == "ecg/vitalsign") {
-        parseVitalSignData(message);
-    } else if (topicName == "ecg/alarm") {
-        parseAlarmData(message);
+    if (m_recorder) {
+        m_recorder->append(topicName, message);
     }
+    
+    injectMessage(message, topicName, receivedAtNs);
+}
+
+void MqttClientManager::injectMessage(const QByteArray& message, const QString& topicName,
+                                      qint64 receivedAtNs) {
+    if (receivedAtNs <= 0) {
+        receivedAtNs = PipelineMetrics::nowNs();
+    }
+    
+    QString deviceId;
+    if (matchTopic(topicName, "ecg/vitalsign", deviceId)) {
+        parseVitalSignData(message, deviceId, receivedAtNs);
+    } else if (matchTopic(topicName, "ecg/alarm", deviceId)) {
+        parseAlarmData(message, deviceId);
+    }
+}
+
+bool MqttClientManager::matchTopic(const QString& topicName, const QString& base, QString& deviceId) {
+    if (topicName == base) {
+        deviceId.clear();
+        return true;
+    }
+    
+    if (topicName.size() > base.size() + 1 &&
+        topicName.startsWith(base) && topicName.at(base.size()) == '/') {
+        deviceId = topicName.mid(base.size() + 1);
+        return true;
+    }
+    return false;
 }
 
 void MqttClientManager::onStateChanged(QMqttClient::ClientState state) {
@@ -123,23 +157,45 @@ void MqttClientManager::onErrorOccurred(QMqttClient::ClientError error) {
     emit errorOccurred(errorMsg);
 }
 
-void MqttClientManager::parseVitalSignData(const QByteArray& data) {
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        qWarning() << "Invalid JSON format for vital sign data";
-        return;
-    }
+void MqttClientManager::parseVitalSignData(const QByteArray& data, const QString& deviceId,
+                                           qint64 receivedAtNs) {
+    PipelineMetrics* metrics = PipelineMetrics::instance();
+    metrics->recordFrame();
     
-    VitalSignData vitalSign = VitalSignData::fromJson(doc.object());
+    // 快速路径直接扫描负载；含转义等非常规写法时回退到JSON DOM
+    VitalSignData vitalSign;
+    if (!VitalSignData::parse(data, vitalSign, deviceId)) {
+        QJsonDocument doc = QJsonDocument::fromJson(data);
+        if (!doc.isObject()) {
+            qWarning() << "Invalid JSON format for vital sign data";
+            metrics->recordDrop("invalid_json");
+            return;
+        }
+        
+        vitalSign = VitalSignData::fromJson(doc.object());
+        if (vitalSign.deviceId.isEmpty()) {
+            vitalSign.deviceId = deviceId;
+        }
+    }
+    vitalSign.receivedAtNs = receivedAtNs;
     
     if (vitalSign.isValid()) {
+        // 依赖设备与本机时钟同步
+        if (vitalSign.timestampUs > 0) {
+            qint64 deviceLatencyUs = QDateTime::currentMSecsSinceEpoch() * 1000 - vitalSign.timestampUs;
+            if (deviceLatencyUs >= 0) {
+                metrics->recordLatencyUs(PipelineMetrics::DeviceToReceive, deviceLatencyUs);
+            }
+        }
+        metrics->recordStage(PipelineMetrics::Parsed, receivedAtNs);
         emit vitalSignReceived(vitalSign);
     } else {
         qWarning() << "Received invalid vital sign data";
+        metrics->recordDrop("invalid_vitals");
     }
 }
 
-void MqttClientManager::parseAlarmData(const QByteArray& data) {
+void MqttClientManager::parseAlarmData(const QByteArray& data, const QString& deviceId) {
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (!doc.isObject()) {
         qWarning() << "Invalid JSON format for alarm data";
@@ -147,6 +203,9 @@ void MqttClientManager::parseAlarmData(const QByteArray& data) {
     }
     
     AlarmInfo alarm = AlarmInfo::fromJson(doc.object());
+    if (alarm.deviceId.isEmpty()) {
+        alarm.deviceId = deviceId;
+    }
     emit alarmReceived(alarm);
 }
 
@@ -4,6 +4,8 @@
 #include <QMqttSubscription>
 #include "VitalSignData.h"
 
+class SessionRecorder;
+
 class MqttClientManager : public QObject {
     Q_OBJECT
 
@@ -31,6 +33,14 @@ public:
     
     // 获取连接状态
     bool isConnected() const;
+    
+    // 按主题分发一条原始消息（不经过Broker，供基准测试/回放注入）
+    // receivedAtNs为接收时刻（PipelineMetrics::nowNs），0表示取当前时刻
+    void injectMessage(const QByteArray& message, const QString& topicName,
+                       qint64 receivedAtNs = 0);
+    
+    // 设置会话录制器（nullptr停止录制），原始消息在解析前写入
+    void setRecorder(SessionRecorder* recorder) { m_recorder = recorder; }
 
 signals:
     // 接收到生理数据
@@ -55,8 +65,12 @@ private slots:
 private:
     QMqttClient* m_client;
     QMap<QString, QMqttSubscription*> m_subscriptions;
+    SessionRecorder* m_recorder;
     
     // 解析接收到的数据
-    void parseVitalSignData(const QByteArray& data);
-    void parseAlarmData(const QByteArray& data);
+    void parseVitalSignData(const QByteArray& data, const QString& deviceId, qint64 receivedAtNs);
+    void parseAlarmData(const QByteArray& data, const QString& deviceId);
+    
+    // 匹配 base 或 base/<deviceId>，返回是否匹配并取出设备ID
+    static bool matchTopic(const QString& topicName, const QString& base, QString& deviceId);
 };
@@ -0,0 +1,380 @@
+#include "PipelineMetrics.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QtAlgorithms>
+#include <QDebug>
+#include <cmath>
+#include <limits>
+
+// ==================== LatencyHistogram ====================
+
+void LatencyHistogram::record(qint64 valueUs) {
+    if (valueUs < 0) valueUs = 0;
+
+    m_buckets[indexOf(valueUs)]++;
+    m_count++;
+    m_sum += valueUs;
+    if (valueUs < m_min) m_min = valueUs;
+    if (valueUs > m_max) m_max = valueUs;
+}
+
+void LatencyHistogram::reset() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_sum = 0;
+    m_min = std::numeric_limits<qint64>::max();
+    m_max = 0;
+}
+
+int LatencyHistogram::indexOf(qint64 valueUs) {
+    if (valueUs < LinearBuckets) {
+        return static_cast<int>(valueUs);
+    }
+
+    const qint64 maxValue = (qint64(1) << (MaxMsb + 1)) - 1;
+    if (valueUs > maxValue) valueUs = maxValue;
+
+    const int msb = 63 - qCountLeadingZeroBits(static_cast<quint64>(valueUs));
+    const int shift = msb - 4;
+    const int sub = static_cast<int>(valueUs >> shift);  // 16..31
+    return LinearBuckets + (msb - 5) * SubBuckets + (sub - SubBuckets);
+}
+
+qint64 LatencyHistogram::upperBoundOf(int index) {
+    if (index < LinearBuckets) {
+        return index;
+    }
+
+    const int k = index - LinearBuckets;
+    const int msb = k / SubBuckets + 5;
+    const int sub = k % SubBuckets + SubBuckets;
+    const int shift = msb - 4;
+    return ((qint64(sub) + 1) << shift) - 1;
+}
+
+qint64 LatencyHistogram::percentile(double p) const {
+    if (m_count == 0) return 0;
+
+    quint64 target = static_cast<quint64>(std::ceil(p / 100.0 * m_count));
+    if (target == 0) target = 1;
+
+    quint64 cumulative = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        cumulative += m_buckets[i];
+        if (cumulative >= target) {
+            return qMin(upperBoundOf(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+QJsonObject LatencyHistogram::toJson() const {
+    QJsonObject json;
+    json["count"] = static_cast<qint64>(m_count);
+    json["min_us"] = minValue();
+    json["mean_us"] = mean();
+    json["p50_us"] = percentile(50);
+    json["p90_us"] = percentile(90);
+    json["p99_us"] = percentile(99);
+    json["p999_us"] = percentile(99.9);
+    json["max_us"] = m_max;
+    return json;
+}
+
+// ==================== PipelineMetrics ====================
+
+PipelineMetrics* PipelineMetrics::instance() {
+    static PipelineMetrics* metrics = []() {
+        auto* created = new PipelineMetrics();
+        // 首次调用可能来自工作线程（读连接池、栅格化任务），定时导出的QTimer必须属于主线程
+        if (QCoreApplication* app = QCoreApplication::instance()) {
+            created->moveToThread(app->thread());
+        }
+        return created;
+    }();
+    return metrics;
+}
+
+qint64 PipelineMetrics::nowNs() {
+    static QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.nsecsElapsed();
+}
+
+PipelineMetrics::PipelineMetrics(QObject* parent)
+    : QObject(parent)
+    , m_framesTotal(0)
+    , m_currentSecond(0)
+    , m_currentSecondFrames(0)
+    , m_lastSecondFrames(0)
+    , m_dropsTotal(0)
+    , m_cpuPercent(0.0)
+    , m_wakeupsPerMinute(0.0)
+    , m_dumpTimer(new QTimer(this))
+{
+    connect(m_dumpTimer, &QTimer::timeout, this, &PipelineMetrics::dumpNow);
+}
+
+QString PipelineMetrics::stageName(Stage stage) {
+    switch (stage) {
+        case DeviceToReceive: return "device_to_receive";
+        case Parsed:          return "parsed";
+        case GuiDispatch:     return "gui_dispatch";
+        case DbCommit:        return "db_commit";
+        case CloudAck:        return "cloud_ack";
+        case FirstPaint:      return "first_paint";
+        default:              return "unknown";
+    }
+}
+
+void PipelineMetrics::recordStage(Stage stage, qint64 traceStartNs) {
+    if (traceStartNs <= 0) return;
+    recordLatencyUs(stage, (nowNs() - traceStartNs) / 1000);
+}
+
+void PipelineMetrics::recordLatencyUs(Stage stage, qint64 latencyUs) {
+    if (stage < 0 || stage >= StageCount) return;
+
+    QMutexLocker locker(&m_mutex);
+    m_histograms[stage].record(latencyUs);
+}
+
+void PipelineMetrics::recordFrame() {
+    const qint64 second = nowNs() / 1000000000;
+
+    QMutexLocker locker(&m_mutex);
+    m_framesTotal++;
+    if (second != m_currentSecond) {
+        // 跨越多秒无数据时上一秒帧率为0
+        m_lastSecondFrames = (second == m_currentSecond + 1) ? m_currentSecondFrames : 0;
+        m_currentSecond = second;
+        m_currentSecondFrames = 0;
+    }
+    m_currentSecondFrames++;
+}
+
+void PipelineMetrics::recordDrop(const QString& reason) {
+    QMutexLocker locker(&m_mutex);
+    m_dropsTotal++;
+    m_dropReasons[reason]++;
+}
+
+void PipelineMetrics::setQueueDepth(const QString& queue, int depth) {
+    QMutexLocker locker(&m_mutex);
+    m_queueDepths[queue] = depth;
+    if (depth > m_queueDepthPeaks.value(queue, 0)) {
+        m_queueDepthPeaks[queue] = depth;
+    }
+}
+
+void PipelineMetrics::setPowerStats(const QString& mode, double cpuPercent, double wakeupsPerMinute) {
+    QMutexLocker locker(&m_mutex);
+    m_powerMode = mode;
+    m_cpuPercent = cpuPercent;
+    m_wakeupsPerMinute = wakeupsPerMinute;
+}
+
+void PipelineMetrics::setStartupPhases(const QMap<QString, double>& phasesMs) {
+    QMutexLocker locker(&m_mutex);
+    m_startupPhasesMs = phasesMs;
+}
+
+double PipelineMetrics::framesPerSecond() const {
+    const qint64 second = nowNs() / 1000000000;
+
+    QMutexLocker locker(&m_mutex);
+    if (second == m_currentSecond) return m_lastSecondFrames;
+    if (second == m_currentSecond + 1) return m_currentSecondFrames;
+    return 0.0;
+}
+
+QJsonObject PipelineMetrics::snapshot() const {
+    const double fps = framesPerSecond();
+
+    QMutexLocker locker(&m_mutex);
+    QJsonObject json;
+    json["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    json["frames_total"] = static_cast<qint64>(m_framesTotal);
+    json["frames_per_second"] = fps;
+
+    QJsonObject drops;
+    drops["total"] = static_cast<qint64>(m_dropsTotal);
+    for (auto it = m_dropReasons.constBegin(); it != m_dropReasons.constEnd(); ++it) {
+        drops[it.key()] = static_cast<qint64>(it.value());
+    }
+    json["drops"] = drops;
+
+    QJsonObject queues;
+    for (auto it = m_queueDepths.constBegin(); it != m_queueDepths.constEnd(); ++it) {
+        QJsonObject queue;
+        queue["depth"] = it.value();
+        queue["peak"] = m_queueDepthPeaks.value(it.key());
+        queues[it.key()] = queue;
+    }
+    json["queues"] = queues;
+
+    if (!m_powerMode.isEmpty()) {
+        QJsonObject power;
+        power["mode"] = m_powerMode;
+        power["cpu_percent"] = m_cpuPercent;
+        power["wakeups_per_minute"] = m_wakeupsPerMinute;
+        json["power"] = power;
+    }
+
+    if (!m_startupPhasesMs.isEmpty()) {
+        QJsonObject startup;
+        for (auto it = m_startupPhasesMs.constBegin(); it != m_startupPhasesMs.constEnd(); ++it) {
+            startup[it.key()] = it.value();
+        }
+        json["startup_ms"] = startup;
+    }
+
+    QJsonObject stages;
+    for (int i = 0; i < StageCount; ++i) {
+        stages[stageName(static_cast<Stage>(i))] = m_histograms[i].toJson();
+    }
+    json["latency"] = stages;
+
+    return json;
+}
+
+QString PipelineMetrics::toPrometheus() const {
+    const double fps = framesPerSecond();
+
+    QMutexLocker locker(&m_mutex);
+    QString out;
+    out += "# TYPE ecg_frames_total counter\n";
+    out += QString("ecg_frames_total %1\n").arg(m_framesTotal);
+    out += "# TYPE ecg_frames_per_second gauge\n";
+    out += QString("ecg_frames_per_second %1\n").arg(fps);
+
+    out += "# TYPE ecg_frame_drops_total counter\n";
+    for (auto it = m_dropReasons.constBegin(); it != m_dropReasons.constEnd(); ++it) {
+        out += QString("ecg_frame_drops_total{reason=\"%1\"} %2\n").arg(it.key()).arg(it.value());
+    }
+
+    out += "# TYPE ecg_queue_depth gauge\n";
+    for (auto it = m_queueDepths.constBegin(); it != m_queueDepths.constEnd(); ++it) {
+        out += QString("ecg_queue_depth{queue=\"%1\"} %2\n").arg(it.key()).arg(it.value());
+    }
+
+    if (!m_powerMode.isEmpty()) {
+        out += "# TYPE ecg_power_mode gauge\n";
+        out += QString("ecg_power_mode{mode=\"%1\"} 1\n").arg(m_powerMode);
+        out += "# TYPE ecg_process_cpu_percent gauge\n";
+        out += QString("ecg_process_cpu_percent %1\n").arg(m_cpuPercent);
+        out += "# TYPE ecg_process_wakeups_per_minute gauge\n";
+        out += QString("ecg_process_wakeups_per_minute %1\n").arg(m_wakeupsPerMinute);
+    }
+
+    if (!m_startupPhasesMs.isEmpty()) {
+        out += "# TYPE ecg_startup_phase_ms gauge\n";
+        for (auto it = m_startupPhasesMs.constBegin(); it != m_startupPhasesMs.constEnd(); ++it) {
+            out += QString("ecg_startup_phase_ms{phase=\"%1\"} %2\n").arg(it.key()).arg(it.value());
+        }
+    }
+
+    out += "# TYPE ecg_stage_latency_us summary\n";
+    static const double quantiles[] = {50, 90, 99, 99.9};
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram& h = m_histograms[i];
+        const QString stage = stageName(static_cast<Stage>(i));
+        for (double q : quantiles) {
+            out += QString("ecg_stage_latency_us{stage=\"%1\",quantile=\"%2\"} %3\n")
+                       .arg(stage).arg(q / 100.0).arg(h.percentile(q));
+        }
+        out += QString("ecg_stage_latency_us_count{stage=\"%1\"} %2\n").arg(stage).arg(h.count());
+    }
+
+    return out;
+}
+
+QString PipelineMetrics::summaryText() const {
+    const double fps = framesPerSecond();
+
+    QMutexLocker locker(&m_mutex);
+    QString text = QString("帧率: %1 fps  总帧数: %2  丢帧: %3\n")
+                       .arg(fps, 0, 'f', 1)
+                       .arg(m_framesTotal)
+                       .arg(m_dropsTotal);
+
+    for (auto it = m_queueDepths.constBegin(); it != m_queueDepths.constEnd(); ++it) {
+        text += QString("队列 %1: %2 (峰值 %3)\n")
+                    .arg(it.key())
+                    .arg(it.value())
+                    .arg(m_queueDepthPeaks.value(it.key()));
+    }
+
+    if (!m_powerMode.isEmpty()) {
+        text += QString("功耗档位: %1  CPU: %2%  唤醒: %3 次/分\n")
+                    .arg(m_powerMode)
+                    .arg(m_cpuPercent, 0, 'f', 1)
+                    .arg(m_wakeupsPerMinute, 0, 'f', 0);
+    }
+
+    text += QString("%1 %2 %3 %4\n")
+                .arg("阶段", -18)
+                .arg("p50(ms)", 9)
+                .arg("p99(ms)", 9)
+                .arg("max(ms)", 9);
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram& h = m_histograms[i];
+        text += QString("%1 %2 %3 %4\n")
+                    .arg(stageName(static_cast<Stage>(i)), -18)
+                    .arg(h.percentile(50) / 1000.0, 9, 'f', 2)
+                    .arg(h.percentile(99) / 1000.0, 9, 'f', 2)
+                    .arg(h.maxValue() / 1000.0, 9, 'f', 2);
+    }
+
+    return text;
+}
+
+void PipelineMetrics::startPeriodicDump(const QString& filePath, int intervalMs) {
+    m_dumpPath = filePath;
+    m_dumpTimer->start(intervalMs);
+    qDebug() << "Pipeline metrics dump enabled:" << filePath << "every" << intervalMs << "ms";
+}
+
+void PipelineMetrics::stopPeriodicDump() {
+    m_dumpTimer->stop();
+}
+
+bool PipelineMetrics::dumpNow() {
+    if (m_dumpPath.isEmpty()) return false;
+
+    QByteArray content;
+    if (m_dumpPath.endsWith(".prom")) {
+        content = toPrometheus().toUtf8();
+    } else {
+        content = QJsonDocument(snapshot()).toJson(QJsonDocument::Indented);
+    }
+
+    // 原子替换，避免采集端读到写了一半的文件
+    QSaveFile file(m_dumpPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open metrics dump file:" << m_dumpPath;
+        return false;
+    }
+    file.write(content);
+    return file.commit();
+}
+
+void PipelineMetrics::reset() {
+    QMutexLocker locker(&m_mutex);
+    for (auto& histogram : m_histograms) {
+        histogram.reset();
+    }
+    m_framesTotal = 0;
+    m_currentSecondFrames = 0;
+    m_lastSecondFrames = 0;
+    m_dropsTotal = 0;
+    m_dropReasons.clear();
+    m_queueDepthPeaks = m_queueDepths;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <QObject>
+#include <QMutex>
+#include <QMap>
+#include <QJsonObject>
+#include <QTimer>
+#include <array>
+
+// 延迟直方图（HDR风格：按2的幂分段，段内16个线性子桶，相对误差约3%）
+// 单位为微秒，上限2^37微秒（约38小时），更大的值计入最高子桶
+class LatencyHistogram {
+public:
+    LatencyHistogram() { reset(); }
+
+    void record(qint64 valueUs);
+    void reset();
+
+    quint64 count() const { return m_count; }
+    qint64 minValue() const { return m_count ? m_min : 0; }
+    qint64 maxValue() const { return m_max; }
+    double mean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0.0; }
+
+    // 百分位数 (0-100)，返回所在子桶的上界
+    qint64 percentile(double p) const;
+
+    QJsonObject toJson() const;
+
+private:
+    static constexpr int LinearBuckets = 32;
+    static constexpr int SubBuckets = 16;
+    static constexpr int MaxMsb = 36;
+    static constexpr int BucketCount = LinearBuckets + (MaxMsb - 4) * SubBuckets;
+
+    static int indexOf(qint64 valueUs);
+    static qint64 upperBoundOf(int index);
+
+    std::array<quint64, BucketCount> m_buckets;
+    quint64 m_count;
+    qint64 m_sum;
+    qint64 m_min;
+    qint64 m_max;
+};
+
+// 数据链路性能指标：从MQTT接收到上屏的各阶段延迟、帧率、丢帧与队列深度
+class PipelineMetrics : public QObject {
+    Q_OBJECT
+
+public:
+    // 各阶段延迟均相对于MQTT接收时刻（DeviceToReceive除外）
+    enum Stage {
+        DeviceToReceive,    // 设备时间戳 -> MQTT接收（依赖时钟同步，精度1秒）
+        Parsed,             // 接收 -> 解析完成
+        GuiDispatch,        // 接收 -> 主窗口槽函数
+        DbCommit,           // 接收 -> 数据库写入完成
+        CloudAck,           // 接收 -> 云端确认
+        FirstPaint,         // 接收 -> 波形首次绘制
+        StageCount
+    };
+
+    static PipelineMetrics* instance();
+
+    // 单调时钟（纳秒），用于给帧打时间戳
+    static qint64 nowNs();
+
+    static QString stageName(Stage stage);
+
+    // 记录某帧到达指定阶段（traceStartNs为接收时刻，0表示未打戳）
+    void recordStage(Stage stage, qint64 traceStartNs);
+    void recordLatencyUs(Stage stage, qint64 latencyUs);
+
+    // 计数器
+    void recordFrame();
+    void recordDrop(const QString& reason);
+    void setQueueDepth(const QString& queue, int depth);
+    
+    // 功耗：当前档位、进程CPU占用(%)与每分钟唤醒次数（由PowerPolicy周期写入）
+    void setPowerStats(const QString& mode, double cpuPercent, double wakeupsPerMinute);
+    
+    // 启动各阶段耗时(ms)，含合计"total"（由StartupTrace在启动完成时写入）
+    void setStartupPhases(const QMap<QString, double>& phasesMs);
+
+    double framesPerSecond() const;
+
+    // 导出快照
+    QJsonObject snapshot() const;
+    QString toPrometheus() const;
+    QString summaryText() const;
+
+    // 周期性写出指标文件（.prom后缀为Prometheus文本格式，否则为JSON）
+    void startPeriodicDump(const QString& filePath, int intervalMs = 10000);
+    void stopPeriodicDump();
+    bool dumpNow();
+
+    void reset();
+
+private:
+    explicit PipelineMetrics(QObject* parent = nullptr);
+
+    mutable QMutex m_mutex;
+    std::array<LatencyHistogram, StageCount> m_histograms;
+
+    quint64 m_framesTotal;
+    qint64 m_currentSecond;
+    int m_currentSecondFrames;
+    int m_lastSecondFrames;
+
+    quint64 m_dropsTotal;
+    QMap<QString, quint64> m_dropReasons;
+    QMap<QString, int> m_queueDepths;
+    QMap<QString, int> m_queueDepthPeaks;
+
+    QString m_powerMode;        // 为空表示未启用功耗统计
+    double m_cpuPercent;
+    double m_wakeupsPerMinute;
+
+    QMap<QString, double> m_startupPhasesMs;
+
+    QTimer* m_dumpTimer;
+    QString m_dumpPath;
+};
@@ -0,0 +1,149 @@
+#include "PolyphaseResampler.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace {
+
+const int ZeroCrossings = 8;    // 原型滤波器在较低采样率下覆盖的采样数（每侧4个过零点）
+
+// 编译期可用的三角函数（std::sin/cos在C++17中不是constexpr）
+constexpr double Pi = 3.14159265358979323846;
+
+constexpr double constexprSin(double x) {
+    while (x > Pi) x -= 2.0 * Pi;
+    while (x < -Pi) x += 2.0 * Pi;
+    const double x2 = x * x;
+    double term = x;
+    double sum = x;
+    for (int k = 1; k < 12; ++k) {
+        term *= -x2 / ((2.0 * k) * (2.0 * k + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x) {
+    return constexprSin(x + Pi / 2.0);
+}
+
+constexpr int tapsPerPhase(int up, int down) {
+    const int taps = (ZeroCrossings * std::max(up, down) + up - 1) / up;
+    return (taps + 3) / 4 * 4;
+}
+
+// 原型低通的第n个系数（以上采样后的采样率归一化）
+constexpr double prototypeTap(int n, int length, int up, int down) {
+    const double cutoff = 0.45 / std::max(up, down);
+    const double t = n - (length - 1) / 2.0;
+    const double sinc = t == 0.0 ? 2.0 * cutoff : constexprSin(2.0 * Pi * cutoff * t) / (Pi * t);
+    const double phase = 2.0 * Pi * n / (length - 1);
+    const double window = 0.42 - 0.5 * constexprCos(phase) + 0.08 * constexprCos(2.0 * phase);
+    return sinc * window;
+}
+
+// 生成相位优先、逆序的系数：out[p*taps + j]与x[i-(taps-1)+j]相乘。
+// 总增益为up（补零上采样损失的能量），每相直流增益约为1
+constexpr void designKernel(float* out, int up, int down, int taps) {
+    const int length = up * taps;
+    double sum = 0.0;
+    for (int n = 0; n < length; ++n) {
+        sum += prototypeTap(n, length, up, down);
+    }
+    const double gain = up / sum;
+    for (int p = 0; p < up; ++p) {
+        for (int j = 0; j < taps; ++j) {
+            out[p * taps + j] = float(gain * prototypeTap(p + (taps - 1 - j) * up, length, up, down));
+        }
+    }
+}
+
+template <int Size>
+constexpr std::array<float, Size> makeKernel(int up, int down, int taps) {
+    std::array<float, Size> kernel{};
+    designKernel(kernel.data(), up, down, taps);
+    return kernel;
+}
+
+template <int InputRate, int OutputRate>
+struct BuiltinKernel {
+    static constexpr int Gcd = std::gcd(InputRate, OutputRate);
+    static constexpr int Up = OutputRate / Gcd;
+    static constexpr int Down = InputRate / Gcd;
+    static constexpr int Taps = tapsPerPhase(Up, Down);
+    static constexpr std::array<float, Up * Taps> Coefficients = makeKernel<Up * Taps>(Up, Down, Taps);
+};
+
+// 设备常见采样率 → 100Hz显示采样率
+const float* builtinKernel(int inputRate, int outputRate) {
+    if (outputRate != 100) return nullptr;
+    switch (inputRate) {
+    case 125: return BuiltinKernel<125, 100>::Coefficients.data();
+    case 250: return BuiltinKernel<250, 100>::Coefficients.data();
+    case 360: return BuiltinKernel<360, 100>::Coefficients.data();
+    case 500: return BuiltinKernel<500, 100>::Coefficients.data();
+    default: return nullptr;
+    }
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate)
+    : m_inputRate(qMax(1, inputRate))
+    , m_outputRate(qMax(1, outputRate))
+    , m_builtinKernel(nullptr)
+{
+    const int gcd = std::gcd(m_inputRate, m_outputRate);
+    m_up = m_outputRate / gcd;
+    m_down = m_inputRate / gcd;
+
+    if (isPassthrough()) {
+        m_taps = 1;
+    } else {
+        m_taps = tapsPerPhase(m_up, m_down);
+        m_builtinKernel = builtinKernel(m_inputRate, m_outputRate);
+        if (!m_builtinKernel) {
+            m_kernel.resize(m_up * m_taps);
+            designKernel(m_kernel.data(), m_up, m_down, m_taps);
+        }
+    }
+    reset();
+}
+
+void PolyphaseResampler::reset() {
+    m_buffer.fill(0.0f, m_taps - 1);
+    m_index = m_taps - 1;
+    m_phase = 0;
+}
+
+void PolyphaseResampler::process(const float* samples, int count, QVector<float>& out) {
+    if (!samples || count <= 0) return;
+
+    if (isPassthrough()) {
+        const int base = out.size();
+        out.resize(base + count);
+        std::copy(samples, samples + count, out.begin() + base);
+        return;
+    }
+
+    const int history = m_taps - 1;
+    m_buffer.resize(history + count);
+    std::copy(samples, samples + count, m_buffer.begin() + history);
+
+    const float* coefficients = kernel();
+    const float* buffer = m_buffer.constData();
+    const int available = m_buffer.size();
+    out.reserve(out.size() + int(qint64(count) * m_up / m_down) + 1);
+    while (m_index < available) {
+        out.append(dotProduct(coefficients + m_phase * m_taps, buffer + m_index - history, m_taps));
+        m_phase += m_down;
+        m_index += m_phase / m_up;
+        m_phase %= m_up;
+    }
+
+    // 保留最后m_taps-1个采样作为下一段的历史
+    m_index -= available - history;
+    std::copy(m_buffer.cbegin() + (available - history), m_buffer.cend(), m_buffer.begin());
+    m_buffer.resize(history);
+}
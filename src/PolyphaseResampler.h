@@ -0,0 +1,41 @@
+#pragma once
+#include <QVector>
+
+// 流式多相重采样（有理数比 上采样L / 下采样M）
+// 原型低通为Blackman窗sinc，截止在较低采样率奈奎斯特频率的90%；系数按相位拆分并逆序存放，
+// 每个输出采样是一段连续内存上的点积（SSE/NEON，其他平台为标量）。
+// 常见设备采样率到显示采样率的系数在编译期生成，其余比率在构造时计算。
+// 以流方式逐帧输入，跨帧保持滤波器历史；采样不连续（缺口）时应调用reset()
+class PolyphaseResampler {
+public:
+    PolyphaseResampler(int inputRate, int outputRate);
+
+    int inputRate() const { return m_inputRate; }
+    int outputRate() const { return m_outputRate; }
+
+    // 输入输出采样率相同，直接复制
+    bool isPassthrough() const { return m_up == m_down; }
+
+    // 是否使用编译期生成的系数
+    bool hasBuiltinKernel() const { return m_builtinKernel != nullptr; }
+
+    // 清空滤波器历史
+    void reset();
+
+    // 输入一段连续采样，重采样结果追加到out
+    void process(const float* samples, int count, QVector<float>& out);
+
+private:
+    const float* kernel() const { return m_builtinKernel ? m_builtinKernel : m_kernel.constData(); }
+
+    int m_inputRate;
+    int m_outputRate;
+    int m_up;
+    int m_down;
+    int m_taps;                     // 每相抽头数（4的倍数）
+    const float* m_builtinKernel;   // 编译期系数表，没有时为nullptr
+    QVector<float> m_kernel;        // 运行时计算的系数
+    QVector<float> m_buffer;        // 前m_taps-1个为上一段的历史采样
+    int m_index;                    // 下一个输出对应的输入采样在m_buffer中的位置
+    int m_phase;
+};
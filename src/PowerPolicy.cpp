@@ -0,0 +1,172 @@
+#include "PowerPolicy.h"
+#include "PipelineMetrics.h"
+#include <QGuiApplication>
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// sysfs属性文件的第一行
+QByteArray readAttribute(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return QByteArray();
+    return file.readLine().trimmed();
+}
+
+} // namespace
+
+// ==================== ProcessActivity ====================
+
+bool ProcessActivity::sample(ProcessActivity& activity) {
+#if defined(Q_OS_UNIX)
+    // Linux下RUSAGE_SELF包含进程全部线程
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return false;
+    activity.cpuUs = (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000
+                     + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    activity.wakeups = usage.ru_nvcsw;
+    return true;
+#else
+    Q_UNUSED(activity);
+    return false;
+#endif
+}
+
+// ==================== PowerPolicy ====================
+
+PowerPolicy::PowerPolicy(QObject* parent)
+    : QObject(parent)
+    , m_pollTimer(new QTimer(this))
+    , m_source(AutoDetect)
+    , m_onBattery(onBatteryPower())
+    , m_applicationHidden(false)
+    , m_windowMinimized(false)
+    , m_mode(Interactive)
+    , m_activityValid(ProcessActivity::sample(m_lastActivity))
+    , m_cpuPercent(0.0)
+    , m_wakeupsPerMinute(0.0)
+{
+    m_activityClock.start();
+
+    // 策略本身每15秒只唤醒一次，允许系统与其他定时器合并
+    m_pollTimer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_pollTimer, &QTimer::timeout, this, &PowerPolicy::poll);
+    m_pollTimer->start(PollIntervalMs);
+
+    if (qGuiApp) {
+        const auto applyState = [this](Qt::ApplicationState state) {
+            m_applicationHidden = state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended;
+            updateMode();
+        };
+        connect(qGuiApp, &QGuiApplication::applicationStateChanged, this, applyState);
+        m_applicationHidden = qGuiApp->applicationState() == Qt::ApplicationHidden ||
+                              qGuiApp->applicationState() == Qt::ApplicationSuspended;
+    }
+    updateMode();
+    PipelineMetrics::instance()->setPowerStats(modeName(m_mode), m_cpuPercent, m_wakeupsPerMinute);
+}
+
+PowerProfile PowerPolicy::profile(Mode mode) {
+    PowerProfile profile;
+    switch (mode) {
+        case Interactive:
+            break;
+        case Battery:
+            // 10帧/秒，数据库约每2秒、云端约每10秒提交一次
+            profile.refreshIntervalMs = 100;
+            profile.waveformIntervalMs = 100;
+            profile.dbBatchFrames = 64;
+            profile.dbBatchDelayMs = 2000;
+            profile.uploadBatchFrames = 128;
+            profile.uploadBatchDelayMs = 10000;
+            break;
+        case Background:
+            profile.refreshIntervalMs = 1000;
+            profile.waveformIntervalMs = 1000;
+            profile.renderingPaused = true;
+            profile.dbBatchFrames = 256;
+            profile.dbBatchDelayMs = 5000;
+            profile.uploadBatchFrames = 512;
+            profile.uploadBatchDelayMs = 30000;
+            break;
+    }
+    return profile;
+}
+
+QString PowerPolicy::modeName(Mode mode) {
+    switch (mode) {
+        case Interactive: return "interactive";
+        case Battery:     return "battery";
+        case Background:  return "background";
+        default:          return "unknown";
+    }
+}
+
+bool PowerPolicy::onBatteryPower() {
+#if defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+    const QDir dir("/sys/class/power_supply");
+    const QStringList supplies = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    bool hasBattery = false;
+    for (const QString& supply : supplies) {
+        if (readAttribute(dir.filePath(supply + "/type")) == "Battery") {
+            hasBattery = true;
+        } else if (readAttribute(dir.filePath(supply + "/online")) == "1") {
+            return false;
+        }
+    }
+    // 没有电池的网关、台式机视为接电
+    return hasBattery;
+#else
+    return false;
+#endif
+}
+
+void PowerPolicy::setPowerSource(PowerSource source) {
+    m_source = source;
+    m_onBattery = source == AutoDetect ? onBatteryPower() : source == ForceBattery;
+    updateMode();
+}
+
+void PowerPolicy::setWindowMinimized(bool minimized) {
+    m_windowMinimized = minimized;
+    updateMode();
+}
+
+void PowerPolicy::poll() {
+    ProcessActivity activity;
+    if (ProcessActivity::sample(activity)) {
+        const qint64 elapsedMs = m_activityClock.restart();
+        if (m_activityValid && elapsedMs > 0) {
+            m_cpuPercent = (activity.cpuUs - m_lastActivity.cpuUs) / 10.0 / elapsedMs;
+            m_wakeupsPerMinute = (activity.wakeups - m_lastActivity.wakeups) * 60000.0 / elapsedMs;
+        }
+        m_lastActivity = activity;
+        m_activityValid = true;
+    }
+    PipelineMetrics::instance()->setPowerStats(modeName(m_mode), m_cpuPercent, m_wakeupsPerMinute);
+
+    if (m_source == AutoDetect) {
+        m_onBattery = onBatteryPower();
+    }
+    updateMode();
+}
+
+void PowerPolicy::updateMode() {
+    Mode mode = Interactive;
+    if (m_applicationHidden || m_windowMinimized) {
+        mode = Background;
+    } else if (m_onBattery) {
+        mode = Battery;
+    }
+    if (mode == m_mode) return;
+
+    m_mode = mode;
+    qDebug() << "Power mode:" << modeName(mode);
+    PipelineMetrics::instance()->setPowerStats(modeName(mode), m_cpuPercent, m_wakeupsPerMinute);
+    emit modeChanged(mode);
+}
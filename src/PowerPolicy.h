@@ -0,0 +1,88 @@
+#pragma once
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+// 一个功耗档位的刷新与批量参数
+struct PowerProfile {
+    int refreshIntervalMs = 40;     // 中央站、频谱图定时刷新的周期
+    int waveformIntervalMs = 0;     // 波形两次栅格化的最小间隔，0表示每帧
+    bool renderingPaused = false;   // 停止实时绘制（数据照常接收、分析和保存）
+    int dbBatchFrames = 1;          // 数据库每次提交的最多帧数，1表示逐帧提交
+    int dbBatchDelayMs = 0;         // 未攒满时最早一帧的最长等待
+    int uploadBatchFrames = 1;      // 云端每次上传的最多帧数
+    int uploadBatchDelayMs = 0;
+};
+
+// 进程活动累计值
+struct ProcessActivity {
+    qint64 cpuUs = 0;       // 用户态与内核态CPU时间
+    qint64 wakeups = 0;     // 自愿上下文切换：线程等待事件、定时器或锁后被唤醒的次数（全部线程合计）
+
+    // 读取当前进程的累计值；不支持的平台返回false
+    static bool sample(ProcessActivity& activity);
+};
+
+// 自适应执行策略
+// 按供电与前后台状态在三个档位之间切换：交互（接外部电源且在前台）、电池、后台（应用被切到后台或窗口最小化）。
+// 档位变化时发出modeChanged，由主窗口调整刷新周期、数据库提交与云端上传的批量。
+// 每PollIntervalMs检查一次供电，并采样进程CPU时间与唤醒次数，换算为CPU占用和每分钟唤醒数写入PipelineMetrics
+class PowerPolicy : public QObject {
+    Q_OBJECT
+
+public:
+    enum Mode {
+        Interactive,
+        Battery,
+        Background
+    };
+
+    // 供电来源：自动检测，或由配置强制（sysfs不可读的Android设备）
+    enum PowerSource {
+        AutoDetect,
+        ForceMains,
+        ForceBattery
+    };
+
+    static constexpr int PollIntervalMs = 15000;
+
+    explicit PowerPolicy(QObject* parent = nullptr);
+
+    static PowerProfile profile(Mode mode);
+    static QString modeName(Mode mode);
+
+    // Linux/Android从/sys/class/power_supply判断：任一外部电源在线即为接电；有电池且无外部电源时为电池供电
+    static bool onBatteryPower();
+
+    Mode mode() const { return m_mode; }
+
+    void setPowerSource(PowerSource source);
+
+    // 主窗口最小化状态（应用前后台状态自动跟踪）
+    void setWindowMinimized(bool minimized);
+
+    double cpuPercent() const { return m_cpuPercent; }
+    double wakeupsPerMinute() const { return m_wakeupsPerMinute; }
+
+signals:
+    void modeChanged(PowerPolicy::Mode mode);
+
+private slots:
+    void poll();
+
+private:
+    void updateMode();
+
+    QTimer* m_pollTimer;
+    PowerSource m_source;
+    bool m_onBattery;
+    bool m_applicationHidden;
+    bool m_windowMinimized;
+    Mode m_mode;
+
+    ProcessActivity m_lastActivity;
+    bool m_activityValid;
+    QElapsedTimer m_activityClock;
+    double m_cpuPercent;
+    double m_wakeupsPerMinute;
+};
@@ -0,0 +1,119 @@
+#include "QrsDetector.h"
+#include <QtMath>
+
+namespace {
+
+const double HighPassHz = 5.0;
+const double LowPassHz = 15.0;
+const double IntegrationSeconds = 0.15;
+const double LearnSeconds = 2.0;
+const double RefractorySeconds = 0.2;
+const double MissedBeatSeconds = 1.66;     // 超过此时间未检出R波则逐步降低阈值
+
+} // namespace
+
+QrsDetector::QrsDetector(int sampleRate)
+    : m_sampleRate(qMax(1, sampleRate))
+{
+    const double dt = 1.0 / m_sampleRate;
+    const double highPassRc = 1.0 / (2.0 * M_PI * HighPassHz);
+    const double lowPassRc = 1.0 / (2.0 * M_PI * LowPassHz);
+    m_hpAlpha = float(highPassRc / (highPassRc + dt));
+    m_lpAlpha = float(dt / (lowPassRc + dt));
+
+    m_window.resize(qMax(1, int(IntegrationSeconds * m_sampleRate)));
+    m_refractorySamples = int(RefractorySeconds * m_sampleRate);
+    reset(0);
+}
+
+void QrsDetector::reset(qint64 firstSampleUs) {
+    m_startUs = firstSampleUs;
+    m_sampleIndex = 0;
+
+    m_prevInput = 0.0f;
+    m_highPass = 0.0f;
+    m_lowPass = 0.0f;
+    m_history[0] = m_history[1] = 0.0f;
+
+    m_window.fill(0.0f);
+    m_windowPos = 0;
+    m_windowSum = 0.0;
+
+    m_learnSamples = 0;
+    m_learnMax = 0.0f;
+    m_learnSum = 0.0;
+    m_signalLevel = 0.0f;
+    m_noiseLevel = 0.0f;
+    m_lastBeatIndex = -m_refractorySamples;
+    m_inPeak = false;
+    m_peakValue = 0.0f;
+    m_peakIndex = 0;
+}
+
+qint64 QrsDetector::nextSampleUs() const {
+    return m_startUs + m_sampleIndex * 1000000 / m_sampleRate;
+}
+
+void QrsDetector::process(const float* samples, int count, QVector<qint64>& beatsUs) {
+    const int learnTarget = int(LearnSeconds * m_sampleRate);
+    const qint64 missedBeatSamples = qint64(MissedBeatSeconds * m_sampleRate);
+    const float decay = 1.0f - 1.0f / m_sampleRate;
+    // 积分窗口与滤波器带来的延迟，报告的R波位置向前修正
+    const int delay = m_window.size() / 2 + 2;
+    const int windowSize = m_window.size();
+
+    for (int i = 0; i < count; ++i, ++m_sampleIndex) {
+        const float x = samples[i];
+        m_highPass = m_hpAlpha * (m_highPass + x - m_prevInput);
+        m_prevInput = x;
+        m_lowPass += m_lpAlpha * (m_highPass - m_lowPass);
+
+        const float derivative = m_lowPass - m_history[1];
+        m_history[1] = m_history[0];
+        m_history[0] = m_lowPass;
+        const float squared = derivative * derivative;
+
+        m_windowSum += squared - m_window[m_windowPos];
+        m_window[m_windowPos] = squared;
+        m_windowPos = (m_windowPos + 1) % windowSize;
+        const float integrated = float(qMax(0.0, m_windowSum) / windowSize);
+
+        // 前两秒只学习信号与噪声水平
+        if (m_learnSamples < learnTarget) {
+            m_learnMax = qMax(m_learnMax, integrated);
+            m_learnSum += integrated;
+            if (++m_learnSamples == learnTarget) {
+                m_signalLevel = m_learnMax;
+                m_noiseLevel = float(m_learnSum / learnTarget);
+            }
+            continue;
+        }
+
+        if (m_sampleIndex - m_lastBeatIndex > missedBeatSamples) {
+            m_signalLevel = qMax(m_noiseLevel, m_signalLevel * decay);
+        }
+        const float threshold = m_noiseLevel + 0.25f * (m_signalLevel - m_noiseLevel);
+
+        if (!m_inPeak) {
+            if (integrated > threshold && m_sampleIndex - m_lastBeatIndex > m_refractorySamples) {
+                m_inPeak = true;
+                m_peakValue = integrated;
+                m_peakIndex = m_sampleIndex;
+            } else if (integrated < threshold) {
+                m_noiseLevel += 0.001f * (integrated - m_noiseLevel);
+            }
+            continue;
+        }
+
+        if (integrated > m_peakValue) {
+            m_peakValue = integrated;
+            m_peakIndex = m_sampleIndex;
+        } else if (integrated < 0.5f * m_peakValue) {
+            m_inPeak = false;
+            m_lastBeatIndex = m_peakIndex;
+            m_signalLevel = 0.125f * m_peakValue + 0.875f * m_signalLevel;
+            const qint64 beatIndex = qMax<qint64>(0, m_peakIndex - delay);
+            beatsUs.append(m_startUs + beatIndex * 1000000 / m_sampleRate);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <QVector>
+
+// 实时QRS检测（简化的Pan-Tompkins）
+// 带通(约5-15Hz) → 差分 → 平方 → 150ms滑动积分，自适应阈值判定R波，200ms不应期。
+// 以流方式逐帧输入，采样不连续（缺口、采样率变化）时应调用reset()
+class QrsDetector {
+public:
+    explicit QrsDetector(int sampleRate);
+
+    int sampleRate() const { return m_sampleRate; }
+
+    // 重新开始一段连续信号，firstSampleUs为下一个输入采样的时间
+    void reset(qint64 firstSampleUs);
+
+    // 输入一段连续采样，检测到的R波时间(epoch µs)追加到beatsUs
+    void process(const float* samples, int count, QVector<qint64>& beatsUs);
+
+    // 下一个输入采样的时间
+    qint64 nextSampleUs() const;
+
+private:
+    int m_sampleRate;
+    qint64 m_startUs;
+    qint64 m_sampleIndex;       // 自reset以来的采样序号
+
+    // 带通：一阶高通 + 一阶低通
+    float m_hpAlpha;
+    float m_lpAlpha;
+    float m_prevInput;
+    float m_highPass;
+    float m_lowPass;
+    float m_history[2];         // 差分所需的前两个带通输出
+
+    // 滑动积分
+    QVector<float> m_window;
+    int m_windowPos;
+    double m_windowSum;
+
+    // 自适应阈值
+    int m_learnSamples;
+    float m_learnMax;
+    double m_learnSum;
+    float m_signalLevel;
+    float m_noiseLevel;
+    int m_refractorySamples;
+    qint64 m_lastBeatIndex;
+    bool m_inPeak;
+    float m_peakValue;
+    qint64 m_peakIndex;
+};
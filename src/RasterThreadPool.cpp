@@ -0,0 +1,12 @@
+#include "RasterThreadPool.h"
+#include <QThread>
+
+QThreadPool* RasterThreadPool::instance() {
+    static QThreadPool* pool = []() {
+        QThreadPool* threadPool = new QThreadPool();
+        threadPool->setObjectName("RasterThreadPool");
+        threadPool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        return threadPool;
+    }();
+    return pool;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <QThreadPool>
+
+// 波形栅格化共用的线程池
+// 各波形视图在此把绘制结果栅格化为QImage，GUI线程只负责复制图像；
+// 工作线程数为核数减一，给GUI线程留出一个核
+class RasterThreadPool {
+public:
+    static QThreadPool* instance();
+};
@@ -0,0 +1,208 @@
+#include "RetentionJob.h"
+#include "DatabaseManager.h"
+#include "WaveformStore.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QDebug>
+
+RetentionJob::RetentionJob(const QString& dbPath, WaveformStore* waveformStore, QObject* parent)
+    : QObject(parent)
+    , m_dbPath(dbPath)
+    , m_waveformStore(waveformStore)
+    , m_maxLockMs(50)
+    , m_yieldMs(20)
+    , m_cancelled(false)
+    , m_chunkRows(500)
+{
+}
+
+void RetentionJob::setPolicy(const RetentionPolicy& policy) {
+    QMutexLocker locker(&m_policyMutex);
+    m_policy = policy;
+}
+
+RetentionPolicy RetentionJob::policy() const {
+    QMutexLocker locker(&m_policyMutex);
+    return m_policy;
+}
+
+void RetentionJob::run() {
+    m_cancelled = false;
+    const RetentionPolicy policy = this->policy();
+    const QString connectionName = QString("retention_%1").arg(quintptr(this));
+
+    qint64 vitalRows = 0;
+    qint64 alarmRows = 0;
+    int waveformSegments = 0;
+    qint64 reclaimedBytes = 0;
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    {
+        QSqlDatabase db = DatabaseManager::openConnection(connectionName, m_dbPath);
+        if (!db.isOpen()) {
+            emit errorOccurred("数据清理无法打开数据库: " + db.lastError().text());
+        } else {
+            const QDateTime now = QDateTime::currentDateTime();
+
+            // 形态趋势与心律事件是生理数据的派生结果，与生理数据按同一保留期清理
+            const QStringList vitalTables = {"vital_signs", "morphology_trends", "rhythm_episodes"};
+
+            // 单独设置了保留期的设备
+            QVariantMap defaultBindings;
+            QStringList overridden;
+            for (auto it = policy.deviceVitalDays.cbegin(); it != policy.deviceVitalDays.cend() && !m_cancelled; ++it) {
+                const QVariantMap bindings = {
+                    {":device", it.key()},
+                    {":cutoff", now.addDays(-it.value())}
+                };
+                for (const QString& table : vitalTables) {
+                    vitalRows += qMax<qint64>(0, deleteInChunks(db, table,
+                                                                "device_id = :device AND timestamp < :cutoff",
+                                                                bindings));
+                }
+
+                const QString placeholder = QString(":d%1").arg(overridden.size());
+                overridden << placeholder;
+                defaultBindings.insert(placeholder, it.key());
+            }
+
+            // 其余设备按默认保留期
+            if (!m_cancelled) {
+                QString condition = "timestamp < :cutoff";
+                if (!overridden.isEmpty()) {
+                    condition += QString(" AND (device_id IS NULL OR device_id NOT IN (%1))")
+                                     .arg(overridden.join(", "));
+                }
+                defaultBindings.insert(":cutoff", now.addDays(-policy.vitalDays));
+                for (const QString& table : vitalTables) {
+                    vitalRows += qMax<qint64>(0, deleteInChunks(db, table, condition, defaultBindings));
+                }
+            }
+
+            if (!m_cancelled) {
+                const QVariantMap bindings = {{":cutoff", now.addDays(-policy.alarmDays)}};
+                alarmRows = qMax<qint64>(0, deleteInChunks(db, "alarms", "timestamp < :cutoff", bindings));
+                // 事件索引与小时计数是报警历史的导航，按报警保留期清理（波形已清理的事件仍可浏览）
+                for (const QString& table : {QStringLiteral("event_index"), QStringLiteral("event_hourly")}) {
+                    if (m_cancelled) break;
+                    alarmRows += qMax<qint64>(0, deleteInChunks(db, table, "timestamp < :cutoff", bindings));
+                }
+            }
+
+            // 波形按整小时分段文件删除
+            if (m_waveformStore) {
+                const qint64 nowUs = now.toMSecsSinceEpoch() * 1000;
+                const QStringList deviceIds = m_waveformStore->deviceIds();
+                for (const QString& deviceId : deviceIds) {
+                    if (m_cancelled) break;
+                    const qint64 cutoffUs = nowUs - qint64(policy.vitalDaysFor(deviceId)) * 86400 * 1000000;
+                    waveformSegments += m_waveformStore->removeBefore(cutoffUs, deviceId);
+                }
+            }
+
+            if (!m_cancelled) {
+                reclaimedBytes = reclaimSpace(db);
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    qDebug() << "Retention pass finished in" << elapsed.elapsed() << "ms:"
+             << vitalRows << "vital rows," << alarmRows << "alarm rows,"
+             << waveformSegments << "waveform segments," << reclaimedBytes << "bytes reclaimed"
+             << (m_cancelled ? "(cancelled)" : "");
+    emit finished(vitalRows, alarmRows, waveformSegments, reclaimedBytes);
+}
+
+qint64 RetentionJob::deleteInChunks(QSqlDatabase& db, const QString& table, const QString& condition,
+                                    const QVariantMap& bindings) {
+    // 子查询按时间排序取一块，走timestamp索引；每条DELETE独立提交，持锁时间受块大小限制
+    QSqlQuery query(db);
+    const QString sql = QString("DELETE FROM %1 WHERE id IN (SELECT id FROM %1 WHERE %2 ORDER BY timestamp LIMIT :limit)")
+                            .arg(table, condition);
+    if (!query.prepare(sql)) {
+        emit errorOccurred(QString("数据清理失败(%1): %2").arg(table, query.lastError().text()));
+        return -1;
+    }
+
+    qint64 total = 0;
+    while (!m_cancelled) {
+        for (auto it = bindings.cbegin(); it != bindings.cend(); ++it) {
+            query.bindValue(it.key(), it.value());
+        }
+        const int requested = m_chunkRows;
+        query.bindValue(":limit", requested);
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!query.exec()) {
+            emit errorOccurred(QString("数据清理失败(%1): %2").arg(table, query.lastError().text()));
+            return total > 0 ? total : -1;
+        }
+        const qint64 lockMs = timer.elapsed();
+        const int deleted = query.numRowsAffected();
+        total += deleted;
+        if (deleted > 0) {
+            emit progress(table, total);
+        }
+
+        // 根据实际持锁时间调整下一块的大小
+        const int maxLockMs = m_maxLockMs;
+        if (lockMs > maxLockMs) {
+            m_chunkRows = qMax(MinChunkRows, m_chunkRows / 2);
+        } else if (lockMs * 4 < maxLockMs && deleted == requested) {
+            m_chunkRows = qMin(MaxChunkRows, m_chunkRows * 2);
+        }
+
+        if (deleted < requested || !yieldAndCheck()) {
+            break;
+        }
+    }
+    return total;
+}
+
+qint64 RetentionJob::reclaimSpace(QSqlDatabase& db) {
+    QSqlQuery query(db);
+
+    // 未启用增量回收的旧数据库需要一次完整VACUUM才能切换，此处不做（会长时间独占数据库）
+    if (!query.exec("PRAGMA auto_vacuum") || !query.next() || query.value(0).toInt() != 2) {
+        return 0;
+    }
+    if (!query.exec("PRAGMA page_size") || !query.next()) {
+        return 0;
+    }
+    const qint64 pageSize = query.value(0).toLongLong();
+
+    qint64 reclaimed = 0;
+    while (!m_cancelled) {
+        if (!query.exec("PRAGMA freelist_count") || !query.next()) break;
+        const int freePages = query.value(0).toInt();
+        if (freePages <= 0) break;
+
+        // incremental_vacuum每执行一步释放一页，需要把结果集走完
+        const int pages = qMin(freePages, VacuumPagesPerStep);
+        if (!query.exec(QString("PRAGMA incremental_vacuum(%1)").arg(pages))) {
+            emit errorOccurred("回收数据库空间失败: " + query.lastError().text());
+            break;
+        }
+        while (query.next()) {}
+        query.finish();
+        reclaimed += pages * pageSize;
+
+        if (!yieldAndCheck()) break;
+    }
+
+    // WAL模式下检查点后文件才会真正缩小；PASSIVE不等待写入方
+    query.exec("PRAGMA wal_checkpoint(PASSIVE)");
+    return reclaimed;
+}
+
+bool RetentionJob::yieldAndCheck() {
+    QThread::msleep(m_yieldMs);
+    return !m_cancelled;
+}
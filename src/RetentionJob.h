@@ -0,0 +1,71 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <atomic>
+
+class WaveformStore;
+
+// 数据保留策略（天）
+struct RetentionPolicy {
+    int vitalDays = 30;                     // 生理数据与波形默认保留天数
+    int alarmDays = 90;                     // 报警记录保留天数
+    QHash<QString, int> deviceVitalDays;    // 按设备覆盖生理数据与波形保留天数
+
+    int vitalDaysFor(const QString& deviceId) const {
+        return deviceVitalDays.value(deviceId, vitalDays);
+    }
+};
+
+// 后台数据清理任务，运行在独立线程并使用独立的数据库连接
+// 按时间顺序分块删除，每块一个事务，块之间让出写锁；块大小根据实际持锁时间自适应，
+// 删除后通过incremental_vacuum分步归还空闲页，清理期间不阻塞数据写入
+class RetentionJob : public QObject {
+    Q_OBJECT
+
+public:
+    RetentionJob(const QString& dbPath, WaveformStore* waveformStore, QObject* parent = nullptr);
+
+    void setPolicy(const RetentionPolicy& policy);
+    RetentionPolicy policy() const;
+
+    // 单次删除/回收允许持有写锁的最长时间
+    void setMaxLockMs(int ms) { m_maxLockMs = ms; }
+    // 两次删除之间的让步时间
+    void setYieldMs(int ms) { m_yieldMs = ms; }
+
+    // 可在任意线程调用，当前批次结束后停止
+    void cancel() { m_cancelled = true; }
+
+public slots:
+    // 执行一轮完整清理
+    void run();
+
+signals:
+    void progress(const QString& table, qint64 deletedRows);
+    void finished(qint64 vitalRows, qint64 alarmRows, int waveformSegments, qint64 reclaimedBytes);
+    void errorOccurred(const QString& error);
+
+private:
+    // 分块删除满足条件的行，返回删除行数（出错返回-1）
+    qint64 deleteInChunks(QSqlDatabase& db, const QString& table, const QString& condition,
+                          const QVariantMap& bindings);
+    // 分步执行incremental_vacuum，返回回收字节数
+    qint64 reclaimSpace(QSqlDatabase& db);
+
+    bool yieldAndCheck();
+
+    static constexpr int MinChunkRows = 50;
+    static constexpr int MaxChunkRows = 20000;
+    static constexpr int VacuumPagesPerStep = 256;
+
+    QString m_dbPath;
+    WaveformStore* m_waveformStore;
+    mutable QMutex m_policyMutex;
+    RetentionPolicy m_policy;
+    std::atomic<int> m_maxLockMs;
+    std::atomic<int> m_yieldMs;
+    std::atomic<bool> m_cancelled;
+    int m_chunkRows;
+};
@@ -0,0 +1,191 @@
+#include "RhythmClassifier.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float PrematureRatio = 0.8f;      // 早于参考RR的80%视为提前
+const float WideQrsMs = 120.0f;
+const float ReferenceWeight = 0.125f;   // 参考RR的指数平均系数
+const int TrimmedBeats = 2;             // 熵计算前去掉最短、最长各2个RR
+const int EntropyBins = 16;
+const float AfRmssdRatio = 0.1f;        // RMSSD/平均RR
+const float AfEntropy = 0.75f;          // 归一化香农熵
+
+// 事件的开始/结束条件（心搏数）
+const int RateOnBeats = 4;
+const int RateOffBeats = 4;
+const int AfOnBeats = 8;
+const int AfOffBeats = 16;
+const int VentricularOffBeats = 16;     // 16个心搏内的室早合为一个事件
+
+quint8 bit(RhythmEpisode::Type type) {
+    return quint8(1u << type);
+}
+
+} // namespace
+
+QString RhythmEpisode::typeName(Type type) {
+    switch (type) {
+    case AtrialFibrillation: return "房颤";
+    case Bradycardia:        return "心动过缓";
+    case Tachycardia:        return "心动过速";
+    case Pause:              return "停搏";
+    case Ventricular:        return "室性早搏";
+    }
+    return QString();
+}
+
+int RhythmEpisode::severity(Type type) {
+    switch (type) {
+    case Pause:       return 4;
+    case Ventricular: return 2;
+    default:          return 3;
+    }
+}
+
+RhythmClassifier::RhythmClassifier()
+    : m_rrMs{}
+    , m_rrHead(0)
+    , m_rrCount(0)
+    , m_active(0)
+    , m_referenceRrMs(0.0f)
+    , m_lastBeatUs(-1)
+{
+}
+
+quint8 RhythmClassifier::addBeat(const AnalyzedBeat& beat, const RhythmLimits& limits,
+                                 QVector<RhythmEpisode>& finished) {
+    const qint64 previousUs = m_lastBeatUs;
+    m_lastBeatUs = beat.timeUs;
+    if (previousUs < 0 || beat.timeUs <= previousUs) return 0;
+
+    quint8 started = 0;
+    const int rrMs = int(qMin<qint64>((beat.timeUs - previousUs) / 1000, 65535));
+
+    // 停搏直接成为一个事件
+    const bool pause = rrMs >= limits.pauseMs;
+    if (pause) {
+        finished.append({RhythmEpisode::Pause, previousUs, beat.timeUs, 1});
+        started |= bit(RhythmEpisode::Pause);
+    }
+
+    // 室早：相对参考RR提前且QRS增宽；提前的心搏不更新参考RR
+    const bool premature = m_referenceRrMs > 0.0f && rrMs < PrematureRatio * m_referenceRrMs;
+    const bool ventricular = premature && beat.qrsMs >= WideQrsMs;
+    if (!premature && !pause) {
+        m_referenceRrMs = m_referenceRrMs > 0.0f ? m_referenceRrMs + ReferenceWeight * (rrMs - m_referenceRrMs)
+                                                 : float(rrMs);
+    }
+
+    if (!pause) {
+        m_rrMs[m_rrHead] = quint16(rrMs);
+        m_rrHead = quint8((m_rrHead + 1) % RrWindow);
+        m_rrCount = quint8(qMin(m_rrCount + 1, RrWindow));
+    }
+
+    // 心率按单个RR判断；停搏的RR不计入过缓
+    const bool slow = !pause && rrMs * limits.lowHeartRate > 60000;
+    const bool fast = rrMs * limits.highHeartRate < 60000;
+    const bool fibrillating = m_rrCount == RrWindow && irregular();
+
+    if (updateRun(m_brady, RhythmEpisode::Bradycardia, slow, previousUs, beat.timeUs,
+                  RateOnBeats, RateOffBeats, finished)) {
+        started |= bit(RhythmEpisode::Bradycardia);
+    }
+    if (updateRun(m_tachy, RhythmEpisode::Tachycardia, fast, previousUs, beat.timeUs,
+                  RateOnBeats, RateOffBeats, finished)) {
+        started |= bit(RhythmEpisode::Tachycardia);
+    }
+    if (updateRun(m_afib, RhythmEpisode::AtrialFibrillation, fibrillating, previousUs, beat.timeUs,
+                  AfOnBeats, AfOffBeats, finished)) {
+        started |= bit(RhythmEpisode::AtrialFibrillation);
+    }
+    if (updateRun(m_ventricular, RhythmEpisode::Ventricular, ventricular, beat.timeUs, beat.timeUs,
+                  1, VentricularOffBeats, finished)) {
+        started |= bit(RhythmEpisode::Ventricular);
+    }
+    return started;
+}
+
+bool RhythmClassifier::updateRun(Run& run, RhythmEpisode::Type type, bool condition, qint64 candidateUs,
+                                 qint64 beatUs, int onBeats, int offBeats, QVector<RhythmEpisode>& finished) {
+    if (!(m_active & bit(type))) {
+        if (!condition) {
+            run.streak = 0;
+            return false;
+        }
+        if (run.streak == 0) run.candidateUs = candidateUs;
+        if (++run.streak < onBeats) return false;
+
+        run.startUs = run.candidateUs;
+        run.lastUs = beatUs;
+        run.beats = run.streak;
+        run.streak = 0;
+        m_active |= bit(type);
+        return true;
+    }
+
+    if (condition) {
+        run.lastUs = beatUs;
+        run.beats++;
+        run.streak = 0;
+    } else if (++run.streak >= offBeats) {
+        closeRun(run, type, finished);
+    }
+    return false;
+}
+
+void RhythmClassifier::closeRun(Run& run, RhythmEpisode::Type type, QVector<RhythmEpisode>& finished) {
+    if (m_active & bit(type)) {
+        finished.append({type, run.startUs, run.lastUs, run.beats});
+        m_active &= quint8(~bit(type));
+    }
+    run = Run();
+}
+
+void RhythmClassifier::flush(QVector<RhythmEpisode>& finished) {
+    closeRun(m_afib, RhythmEpisode::AtrialFibrillation, finished);
+    closeRun(m_brady, RhythmEpisode::Bradycardia, finished);
+    closeRun(m_tachy, RhythmEpisode::Tachycardia, finished);
+    closeRun(m_ventricular, RhythmEpisode::Ventricular, finished);
+    m_rrHead = 0;
+    m_rrCount = 0;
+    m_lastBeatUs = -1;
+}
+
+bool RhythmClassifier::irregular() const {
+    // 归一化RMSSD：按时间顺序的相邻差
+    double sum = 0.0;
+    double squares = 0.0;
+    int previous = m_rrMs[m_rrHead];
+    for (int i = 0; i < RrWindow; ++i) {
+        const int rr = m_rrMs[(m_rrHead + i) % RrWindow];
+        sum += rr;
+        if (i > 0) {
+            squares += double(rr - previous) * (rr - previous);
+        }
+        previous = rr;
+    }
+    const double mean = sum / RrWindow;
+    if (mean <= 0.0 || std::sqrt(squares / (RrWindow - 1)) < AfRmssdRatio * mean) return false;
+
+    // 香农熵：去掉两端的RR后在其范围内等分直方图，双峰（如二联律）的熵低
+    std::array<quint16, RrWindow> sorted = m_rrMs;
+    std::sort(sorted.begin(), sorted.end());
+    const int low = sorted[TrimmedBeats];
+    const int high = sorted[RrWindow - 1 - TrimmedBeats];
+    if (high <= low) return false;
+    std::array<quint8, EntropyBins> histogram{};
+    for (int i = TrimmedBeats; i < RrWindow - TrimmedBeats; ++i) {
+        histogram[qMin(EntropyBins - 1, (sorted[i] - low) * EntropyBins / (high - low))]++;
+    }
+    const double count = RrWindow - 2 * TrimmedBeats;
+    double entropy = 0.0;
+    for (quint8 n : histogram) {
+        if (n == 0) continue;
+        const double p = n / count;
+        entropy -= p * std::log(p);
+    }
+    return entropy / std::log(double(EntropyBins)) >= AfEntropy;
+}
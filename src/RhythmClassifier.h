@@ -0,0 +1,79 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <array>
+#include "MorphologyAnalyzer.h"
+
+// 心律事件（开始、结束为R波时间，epoch µs）
+struct RhythmEpisode {
+    enum Type : quint8 {
+        AtrialFibrillation = 1,
+        Bradycardia,
+        Tachycardia,
+        Pause,
+        Ventricular             // 室性早搏（成串的早搏合为一个事件，beats为早搏数）
+    };
+
+    Type type;
+    qint64 startUs;
+    qint64 endUs;
+    int beats;
+
+    static QString typeName(Type type);
+    // 在事件索引中的严重度（1-5）
+    static int severity(Type type);
+};
+
+// 分类阈值，所有设备共用
+struct RhythmLimits {
+    int lowHeartRate = 40;
+    int highHeartRate = 150;
+    int pauseMs = 2000;
+};
+
+// 流式心律分类（每台设备一个，逐心搏调用）
+// 房颤：最近32个RR的归一化RMSSD与香农熵同时超过阈值；过缓/过速：连续心搏的瞬时心率越限；
+// 停搏：单个RR超过pauseMs；室早：提前出现（RR短于参考RR的80%）且QRS增宽的心搏。
+// 状态全部放在定长成员中（约200字节，不分配堆内存），数百路设备同时分类时缓存友好
+class RhythmClassifier {
+public:
+    static constexpr int RrWindow = 32;
+
+    RhythmClassifier();
+
+    // 输入一个心搏；结束的事件追加到finished，返回本心搏新开始的事件类型位（1 << Type）
+    quint8 addBeat(const AnalyzedBeat& beat, const RhythmLimits& limits, QVector<RhythmEpisode>& finished);
+
+    // 信号中断：结束进行中的事件（结束时间为最后一个心搏），清空RR历史
+    void flush(QVector<RhythmEpisode>& finished);
+
+    // 进行中的事件类型位
+    quint8 activeEpisodes() const { return m_active; }
+
+private:
+    // 连续满足条件onBeats个心搏后开始、连续不满足offBeats个心搏后结束的事件
+    struct Run {
+        qint64 candidateUs = -1;    // 连续满足条件的第一个心搏
+        qint64 startUs = -1;
+        qint64 lastUs = -1;         // 最后一个满足条件的心搏
+        int beats = 0;              // 事件内满足条件的心搏数
+        quint16 streak = 0;         // 连续满足（未开始时）或不满足（进行中）的心搏数
+    };
+
+    // candidateUs为条件成立时事件的起点（RR类条件取该RR的起始心搏）
+    bool updateRun(Run& run, RhythmEpisode::Type type, bool condition, qint64 candidateUs, qint64 beatUs,
+                   int onBeats, int offBeats, QVector<RhythmEpisode>& finished);
+    void closeRun(Run& run, RhythmEpisode::Type type, QVector<RhythmEpisode>& finished);
+    bool irregular() const;
+
+    std::array<quint16, RrWindow> m_rrMs;   // 环形
+    quint8 m_rrHead;
+    quint8 m_rrCount;
+    quint8 m_active;
+    float m_referenceRrMs;                  // 非早搏RR的指数平均
+    qint64 m_lastBeatUs;
+    Run m_afib;
+    Run m_brady;
+    Run m_tachy;
+    Run m_ventricular;
+};
@@ -0,0 +1,319 @@
+#include "SessionCapture.h"
+#include <QFileInfo>
+#include <QtEndian>
+#include <QDebug>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+const char CaptureMagic[8] = {'E', 'C', 'G', 'C', 'A', 'P', '1', '\0'};
+const quint32 CaptureVersion = 1;
+const int HeaderSize = 8 + 4 + 8;
+
+// 单条记录上限，防止损坏文件导致巨量分配
+const quint32 MaxRecordSize = 64 * 1024 * 1024;
+
+template <typename T>
+void appendLE(QByteArray& buffer, T value) {
+    char bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    buffer.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T readLE(const char* data) {
+    return qFromLittleEndian<T>(data);
+}
+
+} // namespace
+
+// ==================== SessionRecorder ====================
+
+SessionRecorder::SessionRecorder(QObject* parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+    , m_recordCount(0)
+{
+    // 每秒刷新一次，兼顾吞吐与崩溃时的数据完整性
+    connect(m_flushTimer, &QTimer::timeout, this, [this]() {
+        if (m_file.isOpen()) m_file.flush();
+    });
+}
+
+SessionRecorder::~SessionRecorder() {
+    close();
+}
+
+qint64 SessionRecorder::currentEpochUs() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+bool SessionRecorder::open(const QString& filePath) {
+    close();
+
+    // 已有文件须是同一版本的录制文件才继续追加，否则记录会接在无关内容之后；
+    // 崩溃留下的半条记录先截掉，之后追加的记录才能读到
+    qint64 validEnd = -1;
+    if (QFileInfo(filePath).size() > 0) {
+        SessionCaptureReader reader;
+        if (!reader.open(filePath)) {
+            emit errorOccurred("已有文件不是同一版本的录制文件，不能追加: " + reader.errorString());
+            return false;
+        }
+        CaptureRecord record;
+        validEnd = reader.position();
+        while (reader.next(record)) {
+            validEnd = reader.position();
+        }
+        if (!reader.errorString().isEmpty()) {
+            emit errorOccurred("已有录制文件中间有损坏的记录，不能追加: " + filePath);
+            return false;
+        }
+    }
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        emit errorOccurred("无法打开录制文件: " + m_file.errorString());
+        return false;
+    }
+    if (validEnd >= 0 && validEnd < m_file.size()) {
+        qWarning() << "Session capture" << filePath << "has a torn record, truncating"
+                   << m_file.size() - validEnd << "bytes";
+        if (!m_file.resize(validEnd)) {
+            emit errorOccurred("截断录制文件失败: " + m_file.errorString());
+            m_file.close();
+            return false;
+        }
+    }
+
+    // 新文件写入文件头，已有文件继续追加
+    if (m_file.size() == 0) {
+        QByteArray header(CaptureMagic, sizeof(CaptureMagic));
+        appendLE<quint32>(header, CaptureVersion);
+        appendLE<qint64>(header, currentEpochUs());
+        m_file.write(header);
+    }
+
+    m_recordCount = 0;
+    m_flushTimer->start(1000);
+    qDebug() << "Session recording started:" << filePath;
+    return true;
+}
+
+void SessionRecorder::close() {
+    if (!m_file.isOpen()) return;
+
+    m_flushTimer->stop();
+    m_file.close();
+    qDebug() << "Session recording stopped," << m_recordCount << "records written";
+}
+
+void SessionRecorder::append(const QString& topic, const QByteArray& payload, qint64 receivedEpochUs) {
+    if (!m_file.isOpen()) return;
+
+    if (receivedEpochUs <= 0) {
+        receivedEpochUs = currentEpochUs();
+    }
+
+    const QByteArray topicBytes = topic.toUtf8();
+    const quint32 recordSize = 8 + 2 + topicBytes.size() + 4 + payload.size();
+
+    QByteArray record;
+    record.reserve(4 + recordSize);
+    appendLE<quint32>(record, recordSize);
+    appendLE<qint64>(record, receivedEpochUs);
+    appendLE<quint16>(record, static_cast<quint16>(topicBytes.size()));
+    record.append(topicBytes);
+    appendLE<quint32>(record, static_cast<quint32>(payload.size()));
+    record.append(payload);
+
+    if (m_file.write(record) != record.size()) {
+        emit errorOccurred("写入录制文件失败: " + m_file.errorString());
+        return;
+    }
+    m_recordCount++;
+}
+
+// ==================== SessionCaptureReader ====================
+
+bool SessionCaptureReader::open(const QString& filePath) {
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = "无法打开录制文件: " + m_file.errorString();
+        return false;
+    }
+
+    const QByteArray header = m_file.read(HeaderSize);
+    if (header.size() != HeaderSize ||
+        memcmp(header.constData(), CaptureMagic, sizeof(CaptureMagic)) != 0) {
+        m_error = "不是有效的录制文件";
+        m_file.close();
+        return false;
+    }
+
+    const quint32 version = readLE<quint32>(header.constData() + 8);
+    if (version != CaptureVersion) {
+        m_error = QString("不支持的录制文件版本: %1").arg(version);
+        m_file.close();
+        return false;
+    }
+
+    m_createdEpochUs = readLE<qint64>(header.constData() + 12);
+    m_dataOffset = HeaderSize;
+    m_error.clear();
+    return true;
+}
+
+void SessionCaptureReader::close() {
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool SessionCaptureReader::atEnd() const {
+    return !m_file.isOpen() || m_file.atEnd();
+}
+
+bool SessionCaptureReader::rewind() {
+    return m_file.isOpen() && m_file.seek(m_dataOffset);
+}
+
+bool SessionCaptureReader::next(CaptureRecord& record) {
+    if (!m_file.isOpen()) return false;
+
+    char sizeBytes[4];
+    if (m_file.read(sizeBytes, 4) != 4) return false;
+
+    const quint32 recordSize = readLE<quint32>(sizeBytes);
+    if (recordSize < 8 + 2 + 4 || recordSize > MaxRecordSize) {
+        m_error = "录制文件记录损坏";
+        return false;
+    }
+
+    const QByteArray body = m_file.read(recordSize);
+    if (body.size() != static_cast<int>(recordSize)) {
+        return false; // 末尾残缺记录
+    }
+
+    const char* p = body.constData();
+    record.receivedEpochUs = readLE<qint64>(p);
+    p += 8;
+
+    const quint16 topicSize = readLE<quint16>(p);
+    p += 2;
+    if (8u + 2u + topicSize + 4u > recordSize) {
+        m_error = "录制文件记录损坏";
+        return false;
+    }
+    record.topic = QString::fromUtf8(p, topicSize);
+    p += topicSize;
+
+    const quint32 payloadSize = readLE<quint32>(p);
+    p += 4;
+    if (8u + 2u + topicSize + 4u + payloadSize != recordSize) {
+        m_error = "录制文件记录损坏";
+        return false;
+    }
+    record.payload = QByteArray(p, payloadSize);
+
+    return true;
+}
+
+// ==================== SessionReplayer ====================
+
+SessionReplayer::SessionReplayer(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_speed(1.0)
+    , m_running(false)
+    , m_hasPending(false)
+    , m_firstEpochUs(0)
+    , m_replayedCount(0)
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &SessionReplayer::onTick);
+}
+
+bool SessionReplayer::open(const QString& filePath) {
+    stop();
+
+    if (!m_reader.open(filePath)) {
+        emit errorOccurred(m_reader.errorString());
+        return false;
+    }
+    return true;
+}
+
+void SessionReplayer::start() {
+    if (m_running) return;
+
+    if (!m_reader.rewind()) {
+        emit errorOccurred("回放文件未打开");
+        return;
+    }
+
+    m_hasPending = m_reader.next(m_pending);
+    if (!m_hasPending) {
+        emit errorOccurred("录制文件为空");
+        return;
+    }
+
+    m_firstEpochUs = m_pending.receivedEpochUs;
+    m_replayedCount = 0;
+    m_running = true;
+    m_clock.start();
+    m_timer->start(0);
+
+    qDebug() << "Session replay started, speed:" << (m_speed > 0 ? QString::number(m_speed) : "max");
+}
+
+void SessionReplayer::stop() {
+    if (!m_running) return;
+
+    m_timer->stop();
+    finish();
+}
+
+void SessionReplayer::onTick() {
+    if (!m_running) return;
+
+    // 最快模式下每轮只发送一批，避免长时间占用事件循环
+    int emitted = 0;
+    while (m_hasPending && emitted < MaxBatchPerTick) {
+        if (m_speed > 0) {
+            const qint64 dueUs = static_cast<qint64>((m_pending.receivedEpochUs - m_firstEpochUs) / m_speed);
+            const qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+            if (dueUs > nowUs) {
+                m_timer->start(static_cast<int>(qMax<qint64>(1, (dueUs - nowUs) / 1000)));
+                return;
+            }
+        }
+
+        emit messageReplayed(m_pending.payload, m_pending.topic);
+        m_replayedCount++;
+        emitted++;
+
+        m_hasPending = m_reader.next(m_pending);
+    }
+
+    if (m_hasPending) {
+        m_timer->start(0);
+    } else {
+        finish();
+    }
+}
+
+void SessionReplayer::finish() {
+    m_running = false;
+    m_hasPending = false;
+
+    const qint64 elapsedMs = m_clock.elapsed();
+    const double rate = elapsedMs > 0 ? m_replayedCount * 1000.0 / elapsedMs : 0.0;
+    qDebug() << "Session replay finished:" << m_replayedCount << "frames in" << elapsedMs << "ms";
+    emit finished(m_replayedCount, elapsedMs, rate);
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// 会话录制文件格式（小端序，仅追加）:
+//   文件头: "ECGCAP1\0"(8字节) | version(u32) | 创建时间(i64, epoch µs)
+//   记录:   长度(u32, 不含自身) | 接收时间(i64, epoch µs) | 主题长度(u16) | 主题(UTF-8)
+//           | 负载长度(u32) | 负载
+// 进程崩溃留下的半条记录在读取时被忽略
+
+// 录制的一条原始MQTT消息
+struct CaptureRecord {
+    qint64 receivedEpochUs = 0;
+    QString topic;
+    QByteArray payload;
+};
+
+// 会话录制器：将原始消息按到达顺序追加写入录制文件
+class SessionRecorder : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SessionRecorder(QObject* parent = nullptr);
+    ~SessionRecorder();
+
+    // 已有的同版本录制文件继续追加（末尾的半条记录先截掉）；不是录制文件或中间有损坏的记录时拒绝打开
+    bool open(const QString& filePath);
+    void close();
+    bool isRecording() const { return m_file.isOpen(); }
+    QString filePath() const { return m_file.fileName(); }
+
+    // 追加一条记录（receivedEpochUs为0时取当前时间）
+    void append(const QString& topic, const QByteArray& payload, qint64 receivedEpochUs = 0);
+
+    qint64 recordCount() const { return m_recordCount; }
+
+    // 当前墙上时间（epoch µs）
+    static qint64 currentEpochUs();
+
+signals:
+    void errorOccurred(const QString& error);
+
+private:
+    QFile m_file;
+    QTimer* m_flushTimer;
+    qint64 m_recordCount;
+};
+
+// 录制文件顺序读取器
+class SessionCaptureReader {
+public:
+    bool open(const QString& filePath);
+    void close();
+    bool atEnd() const;
+
+    // 读取下一条记录，文件结束或遇到残缺记录时返回false
+    bool next(CaptureRecord& record);
+
+    // 回到第一条记录
+    bool rewind();
+    // 下一条记录的文件偏移
+    qint64 position() const { return m_file.pos(); }
+
+    qint64 createdEpochUs() const { return m_createdEpochUs; }
+    QString errorString() const { return m_error; }
+
+private:
+    QFile m_file;
+    qint64 m_createdEpochUs = 0;
+    qint64 m_dataOffset = 0;
+    QString m_error;
+};
+
+// 会话回放引擎：按原始节奏（1x/Nx）或最快速度将录制消息重新注入处理链路
+class SessionReplayer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SessionReplayer(QObject* parent = nullptr);
+
+    bool open(const QString& filePath);
+
+    // 回放倍速，0表示不等待、尽可能快
+    void setSpeed(double speed) { m_speed = speed; }
+    double speed() const { return m_speed; }
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    qint64 replayedCount() const { return m_replayedCount; }
+
+signals:
+    // 一条消息到达回放时刻（与MqttClientManager::injectMessage对接）
+    void messageReplayed(const QByteArray& payload, const QString& topic);
+
+    // 回放结束：帧数、耗时、实际速率（帧/秒）
+    void finished(qint64 frames, qint64 elapsedMs, double framesPerSecond);
+
+    void errorOccurred(const QString& error);
+
+private slots:
+    void onTick();
+
+private:
+    SessionCaptureReader m_reader;
+    QTimer* m_timer;
+    QElapsedTimer m_clock;
+
+    double m_speed;
+    bool m_running;
+    bool m_hasPending;
+    CaptureRecord m_pending;
+    qint64 m_firstEpochUs;
+    qint64 m_replayedCount;
+
+    static constexpr int MaxBatchPerTick = 256;
+
+    void finish();
+};
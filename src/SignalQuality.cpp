@@ -0,0 +1,176 @@
+#include "SignalQuality.h"
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// 阈值针对mV单位的体表ECG
+const float FlatRangeMv = 0.05f;            // 极差小于此值视为平直
+const float FlatStdMv = 0.01f;
+const double LeadOffSeconds = 2.0;          // 平直持续此时间判为导联脱落
+const float ClipMarginRatio = 0.005f;       // 距极值不到极差的0.5%视为贴边
+const float ClipFractionLimit = 0.05f;      // 正常波形只有R峰附近少数采样接近极值
+const float NoiseCrossingRate = 0.35f;      // 一阶差分过零率：平滑ECG远低于此，白噪声约0.67
+const float CleanKurtosis = 5.0f;           // 含QRS的ECG峰度高，高斯噪声约3，正弦约1.5
+const float DriftMv = 0.6f;                 // 帧内前后1/4段均值差或帧间均值差
+
+struct BlockFeatures {
+    float mean;
+    float minimum;
+    float maximum;
+    float variance;
+    float kurtosis;
+    float crossingRate;
+    float clipFraction;
+    float headMean;
+    float tailMean;
+};
+
+float sumRange(const float* x, int n) {
+    float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc[0] += x[i];
+        acc[1] += x[i + 1];
+        acc[2] += x[i + 2];
+        acc[3] += x[i + 3];
+    }
+    for (; i < n; ++i) acc[0] += x[i];
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+BlockFeatures computeFeatures(const float* x, int n) {
+    BlockFeatures f;
+
+    // 第一遍：均值与极值
+    float mn[4] = {x[0], x[0], x[0], x[0]};
+    float mx[4] = {x[0], x[0], x[0], x[0]};
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int lane = 0; lane < 4; ++lane) {
+            mn[lane] = std::min(mn[lane], x[i + lane]);
+            mx[lane] = std::max(mx[lane], x[i + lane]);
+        }
+    }
+    for (; i < n; ++i) {
+        mn[0] = std::min(mn[0], x[i]);
+        mx[0] = std::max(mx[0], x[i]);
+    }
+    f.minimum = std::min(std::min(mn[0], mn[1]), std::min(mn[2], mn[3]));
+    f.maximum = std::max(std::max(mx[0], mx[1]), std::max(mx[2], mx[3]));
+    f.mean = sumRange(x, n) / n;
+
+    const int quarter = qMax(1, n / 4);
+    f.headMean = sumRange(x, quarter) / quarter;
+    f.tailMean = sumRange(x + n - quarter, quarter) / quarter;
+
+    // 第二遍：中心矩、贴边采样、差分过零
+    const float range = f.maximum - f.minimum;
+    const float margin = range * ClipMarginRatio;
+    const float low = f.minimum + margin;
+    const float high = f.maximum - margin;
+    float m2[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float m4[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int clipped[4] = {0, 0, 0, 0};
+    i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int lane = 0; lane < 4; ++lane) {
+            const float d = x[i + lane] - f.mean;
+            const float d2 = d * d;
+            m2[lane] += d2;
+            m4[lane] += d2 * d2;
+            clipped[lane] += (x[i + lane] <= low) | (x[i + lane] >= high);
+        }
+    }
+    for (; i < n; ++i) {
+        const float d = x[i] - f.mean;
+        const float d2 = d * d;
+        m2[0] += d2;
+        m4[0] += d2 * d2;
+        clipped[0] += (x[i] <= low) | (x[i] >= high);
+    }
+    const float sumM2 = (m2[0] + m2[1]) + (m2[2] + m2[3]);
+    const float sumM4 = (m4[0] + m4[1]) + (m4[2] + m4[3]);
+    f.variance = sumM2 / n;
+    f.kurtosis = f.variance > 0.0f ? (sumM4 / n) / (f.variance * f.variance) : 0.0f;
+    f.clipFraction = float(clipped[0] + clipped[1] + clipped[2] + clipped[3]) / n;
+
+    int crossings = 0;
+    for (int k = 2; k < n; ++k) {
+        const float d1 = x[k - 1] - x[k - 2];
+        const float d2 = x[k] - x[k - 1];
+        crossings += (d1 * d2) < 0.0f;
+    }
+    f.crossingRate = n > 2 ? float(crossings) / (n - 2) : 0.0f;
+    return f;
+}
+
+inline float clamp01(float value) {
+    return qBound(0.0f, value, 1.0f);
+}
+
+} // namespace
+
+SignalQualityAnalyzer::SignalQualityAnalyzer(int sampleRate)
+    : m_sampleRate(qMax(1, sampleRate))
+{
+    reset();
+}
+
+void SignalQualityAnalyzer::reset() {
+    m_previousMean = 0.0f;
+    m_havePrevious = false;
+    m_flatSamples = 0;
+}
+
+SignalQuality SignalQualityAnalyzer::assess(const float* samples, int count) {
+    SignalQuality quality;
+    if (!samples || count < 4) {
+        return quality;
+    }
+
+    const BlockFeatures f = computeFeatures(samples, count);
+    float score = 1.0f;
+
+    // 平直与导联脱落
+    const float range = f.maximum - f.minimum;
+    if (range < FlatRangeMv || std::sqrt(f.variance) < FlatStdMv) {
+        quality.flags |= SignalQuality::FlatLine;
+        m_flatSamples += count;
+        if (m_flatSamples >= LeadOffSeconds * m_sampleRate) {
+            quality.flags |= SignalQuality::LeadOff;
+        }
+        quality.score = 0.0f;
+        m_previousMean = f.mean;
+        m_havePrevious = true;
+        return quality;
+    }
+    m_flatSamples = 0;
+
+    if (f.clipFraction > ClipFractionLimit) {
+        quality.flags |= SignalQuality::Clipping;
+        score *= clamp01(1.0f - (f.clipFraction - ClipFractionLimit) * 10.0f);
+    }
+
+    if (f.crossingRate > NoiseCrossingRate) {
+        quality.flags |= SignalQuality::HighFrequencyNoise;
+        score *= clamp01(1.0f - (f.crossingRate - NoiseCrossingRate) / 0.25f);
+    }
+
+    // 峰度只在帧内至少含一个心搏周期时有意义
+    if (count >= m_sampleRate && f.kurtosis < CleanKurtosis) {
+        score *= clamp01(0.4f + 0.6f * (f.kurtosis - 2.0f) / (CleanKurtosis - 2.0f));
+    }
+
+    const bool intraDrift = qAbs(f.tailMean - f.headMean) > DriftMv;
+    const bool interDrift = m_havePrevious && qAbs(f.mean - m_previousMean) > DriftMv;
+    if (intraDrift || interDrift) {
+        quality.flags |= SignalQuality::BaselineDrift;
+        score *= 0.7f;
+    }
+
+    m_previousMean = f.mean;
+    m_havePrevious = true;
+    quality.score = clamp01(score);
+    return quality;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QtGlobal>
+
+// ECG信号质量（每帧评估一次）
+struct SignalQuality {
+    enum Flag : quint8 {
+        FlatLine = 0x01,            // 平直：电极未接触或放大器无输出
+        Clipping = 0x02,            // 削顶：大量采样贴在量程上下限
+        HighFrequencyNoise = 0x04,  // 高频噪声：肌电、工频干扰
+        BaselineDrift = 0x08,       // 基线漂移：接触不良、体动
+        LeadOff = 0x10              // 导联脱落：持续平直
+    };
+
+    static constexpr float UsableScore = 0.5f;
+
+    float score = -1.0f;    // 0~1，小于0表示未评估（旧数据）
+    quint8 flags = 0;
+
+    bool isAssessed() const { return score >= 0.0f; }
+    // 未评估的数据视为可用，保持旧数据的行为
+    bool isUsable() const { return !isAssessed() || score >= UsableScore; }
+    bool has(Flag flag) const { return (flags & flag) != 0; }
+};
+
+// 流式信号质量评估
+// 每帧只做两遍线性扫描，特征为方差、极差、峰度、一阶差分过零率与能量比、贴边采样比例、
+// 帧内/帧间均值变化；累加按4路展开，便于编译器生成SIMD指令。帧间状态用于判断持续平直（导联脱落）
+class SignalQualityAnalyzer {
+public:
+    explicit SignalQualityAnalyzer(int sampleRate = 100);
+
+    int sampleRate() const { return m_sampleRate; }
+
+    SignalQuality assess(const float* samples, int count);
+
+    void reset();
+
+private:
+    int m_sampleRate;
+    float m_previousMean;
+    bool m_havePrevious;
+    int m_flatSamples;      // 连续平直的采样数
+};
@@ -0,0 +1,142 @@
+#include "StartupTrace.h"
+#include "PipelineMetrics.h"
+#include <QJsonArray>
+#include <QMap>
+#include <QThread>
+#include <QDebug>
+
+// ==================== StartupTrace::Scope ====================
+
+StartupTrace::Scope::Scope(const QString& phase)
+    : m_phase(phase)
+{
+    StartupTrace::instance()->begin(m_phase);
+}
+
+StartupTrace::Scope::~Scope() {
+    StartupTrace::instance()->end(m_phase);
+}
+
+// ==================== StartupTrace ====================
+
+StartupTrace* StartupTrace::instance() {
+    static StartupTrace* trace = new StartupTrace();
+    return trace;
+}
+
+StartupTrace::StartupTrace()
+    : m_mainThread(QThread::currentThreadId())
+    , m_finishedNs(-1)
+{
+    m_clock.start();
+}
+
+void StartupTrace::start() {
+    QMutexLocker locker(&m_mutex);
+    m_clock.restart();
+    m_mainThread = QThread::currentThreadId();
+    m_phases.clear();
+    m_finishedNs = -1;
+}
+
+int StartupTrace::findLocked(const QString& phase) const {
+    for (int i = 0; i < m_phases.size(); ++i) {
+        if (m_phases[i].name == phase) return i;
+    }
+    return -1;
+}
+
+void StartupTrace::begin(const QString& phase) {
+    QMutexLocker locker(&m_mutex);
+    if (m_finishedNs >= 0 || findLocked(phase) >= 0) return;
+
+    Phase entry;
+    entry.name = phase;
+    entry.startNs = m_clock.nsecsElapsed();
+    entry.mainThread = QThread::currentThreadId() == m_mainThread;
+    m_phases.append(entry);
+}
+
+void StartupTrace::end(const QString& phase) {
+    QMutexLocker locker(&m_mutex);
+    const int index = findLocked(phase);
+    if (index < 0 || m_phases[index].endNs >= 0) return;
+    m_phases[index].endNs = m_clock.nsecsElapsed();
+}
+
+void StartupTrace::finish() {
+    QMap<QString, double> phasesMs;
+    double firstPaintMs = -1.0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_finishedNs >= 0) return;
+        m_finishedNs = m_clock.nsecsElapsed();
+        for (const Phase& phase : std::as_const(m_phases)) {
+            if (phase.endNs < 0) continue;
+            phasesMs[phase.name] = phase.durationMs();
+            if (phase.name == "first_paint") firstPaintMs = phase.endNs / 1e6;
+        }
+        phasesMs["total"] = m_finishedNs / 1e6;
+    }
+
+    PipelineMetrics::instance()->setStartupPhases(phasesMs);
+    qInfo().noquote() << report();
+    if (firstPaintMs > TargetMs) {
+        qWarning() << "Startup: first paint after" << firstPaintMs << "ms, target" << TargetMs << "ms";
+    }
+}
+
+bool StartupTrace::isFinished() const {
+    QMutexLocker locker(&m_mutex);
+    return m_finishedNs >= 0;
+}
+
+double StartupTrace::elapsedMs() const {
+    QMutexLocker locker(&m_mutex);
+    return m_clock.nsecsElapsed() / 1e6;
+}
+
+QVector<StartupTrace::Phase> StartupTrace::phases() const {
+    QMutexLocker locker(&m_mutex);
+    return m_phases;
+}
+
+QString StartupTrace::report() const {
+    QMutexLocker locker(&m_mutex);
+    QString text = QString("启动耗时 (目标首次绘制 %1 ms)\n").arg(TargetMs);
+    text += QString("%1 %2 %3 %4\n")
+                .arg("阶段", -18)
+                .arg("开始(ms)", 9)
+                .arg("耗时(ms)", 9)
+                .arg("线程", 6);
+    for (const Phase& phase : std::as_const(m_phases)) {
+        text += QString("%1 %2 %3 %4\n")
+                    .arg(phase.name, -18)
+                    .arg(phase.startNs / 1e6, 9, 'f', 1)
+                    .arg(phase.endNs < 0 ? QString("-") : QString::number(phase.durationMs(), 'f', 1), 9)
+                    .arg(phase.mainThread ? "main" : "worker", 6);
+    }
+    if (m_finishedNs >= 0) {
+        text += QString("合计: %1 ms\n").arg(m_finishedNs / 1e6, 0, 'f', 1);
+    }
+    return text;
+}
+
+QJsonObject StartupTrace::toJson() const {
+    QMutexLocker locker(&m_mutex);
+    QJsonArray phases;
+    for (const Phase& phase : std::as_const(m_phases)) {
+        QJsonObject entry;
+        entry["name"] = phase.name;
+        entry["start_ms"] = phase.startNs / 1e6;
+        entry["duration_ms"] = phase.endNs < 0 ? QJsonValue() : QJsonValue(phase.durationMs());
+        entry["thread"] = phase.mainThread ? "main" : "worker";
+        phases.append(entry);
+    }
+
+    QJsonObject json;
+    json["target_ms"] = TargetMs;
+    json["total_ms"] = m_finishedNs < 0 ? QJsonValue() : QJsonValue(m_finishedNs / 1e6);
+    json["phases"] = phases;
+    return json;
+}
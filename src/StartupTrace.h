@@ -0,0 +1,65 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// 启动耗时剖析
+// 记录从main()开始到窗口首次绘制、数据库就绪之间各阶段的起止时间（相对进程启动，线程安全，
+// 工作线程中的阶段与主线程并行）。finish()时输出报告并写入PipelineMetrics；首次绘制超过TargetMs时告警
+class StartupTrace {
+public:
+    static constexpr qint64 TargetMs = 300;     // 网关上的冷启动目标：首次绘制
+
+    struct Phase {
+        QString name;
+        qint64 startNs = 0;
+        qint64 endNs = -1;          // -1表示未结束
+        bool mainThread = true;
+
+        double durationMs() const { return endNs < 0 ? 0.0 : (endNs - startNs) / 1e6; }
+    };
+
+    // 同一阶段的begin/end
+    class Scope {
+    public:
+        explicit Scope(const QString& phase);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        QString m_phase;
+    };
+
+    static StartupTrace* instance();
+
+    // main()开头调用，之前的时间不计入
+    void start();
+
+    // 同名阶段只记录第一次（例如历史页首次打开），finish()之后不再记录
+    void begin(const QString& phase);
+    void end(const QString& phase);
+
+    // 启动完成：输出各阶段耗时
+    void finish();
+    bool isFinished() const;
+
+    double elapsedMs() const;
+    QVector<Phase> phases() const;
+
+    QString report() const;
+    QJsonObject toJson() const;
+
+private:
+    StartupTrace();
+
+    int findLocked(const QString& phase) const;
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    Qt::HANDLE m_mainThread;    // 调用start()的线程
+    QVector<Phase> m_phases;
+    qint64 m_finishedNs;        // -1表示未完成
+};
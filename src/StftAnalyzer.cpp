@@ -0,0 +1,93 @@
+#include "StftAnalyzer.h"
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+const float FloorPower = 1e-12f;    // -120dB，避免log(0)
+
+int windowSizeFor(int sampleRate) {
+    int size = 64;
+    while (size < sampleRate && size < 4096) size <<= 1;
+    return size;
+}
+
+} // namespace
+
+StftAnalyzer::StftAnalyzer(int sampleRate)
+    : m_sampleRate(qMax(1, sampleRate))
+    , m_fft(windowSizeFor(sampleRate))
+    , m_hop(m_fft.size() / 4)
+    , m_head(0)
+    , m_filled(0)
+    , m_sinceColumn(0)
+{
+    const int size = m_fft.size();
+    m_window.resize(size);
+    double sum = 0.0;
+    for (int i = 0; i < size; ++i) {
+        const double w = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / size);
+        m_window[i] = float(w);
+        sum += w;
+    }
+    // 按窗的和归一化：幅值为A的正弦在峰值处的功率为A²/4，与窗长、采样率无关
+    const float scale = float(1.0 / sum);
+    for (float& w : m_window) {
+        w *= scale;
+    }
+
+    m_ring.resize(size);
+    m_frame.resize(size);
+    m_spectrum.resize(size / 2 + 1);
+}
+
+void StftAnalyzer::reset() {
+    m_head = 0;
+    m_filled = 0;
+    m_sinceColumn = 0;
+}
+
+int StftAnalyzer::process(const float* samples, int count, QVector<float>& columns) {
+    const int size = m_fft.size();
+    int emitted = 0;
+    for (int i = 0; i < count; ++i) {
+        m_ring[m_head] = samples[i];
+        m_head = (m_head + 1) % size;
+        if (m_filled < size) ++m_filled;
+        // 窗未填满前不输出，之后每跳步一列
+        if (++m_sinceColumn >= m_hop && m_filled == size) {
+            m_sinceColumn = 0;
+            emitColumn(columns);
+            ++emitted;
+        }
+    }
+    return emitted;
+}
+
+void StftAnalyzer::emitColumn(QVector<float>& columns) {
+    const int size = m_fft.size();
+
+    // 环形缓冲按时间顺序展开并加窗，同时去掉直流（基线）
+    const int tail = size - m_head;
+    double mean = 0.0;
+    for (float v : m_ring) {
+        mean += v;
+    }
+    const float offset = float(mean / size);
+    for (int i = 0; i < tail; ++i) {
+        m_frame[i] = (m_ring[m_head + i] - offset) * m_window[i];
+    }
+    for (int i = 0; i < m_head; ++i) {
+        m_frame[tail + i] = (m_ring[i] - offset) * m_window[tail + i];
+    }
+
+    m_fft.realTransform(m_frame.constData(), m_spectrum.data());
+
+    const int bins = binCount();
+    const int base = columns.size();
+    columns.resize(base + bins);
+    float* out = columns.data() + base;
+    for (int k = 0; k < bins; ++k) {
+        out[k] = 10.0f * std::log10(std::norm(m_spectrum[k]) + FloorPower);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <QVector>
+#include <complex>
+#include "Fft.h"
+
+// 流式短时傅里叶变换（频谱图）
+// 窗长取不小于采样率的2的幂（频率分辨率约1Hz），跳步为窗长的1/4。最近一个窗长的采样保存在环形缓冲中，
+// 每凑满一个跳步就对整窗做一次加Hann窗的实数FFT，输出一列功率谱(dB)；之前的窗内采样原样保留、不重复处理，
+// 每个采样的计算量固定（约 N·log2(N)/跳步），与已处理的信号长度无关
+class StftAnalyzer {
+public:
+    explicit StftAnalyzer(int sampleRate);
+
+    int sampleRate() const { return m_sampleRate; }
+    int windowSize() const { return m_fft.size(); }
+    int hopSize() const { return m_hop; }
+    int binCount() const { return m_fft.size() / 2 + 1; }
+    double binHz() const { return double(m_sampleRate) / m_fft.size(); }
+
+    // 清空窗内历史（信号不连续时调用）
+    void reset();
+
+    // 输入一段连续采样，每输出一列就把binCount()个dB值追加到columns，返回新输出的列数
+    int process(const float* samples, int count, QVector<float>& columns);
+
+private:
+    void emitColumn(QVector<float>& columns);
+
+    int m_sampleRate;
+    Fft m_fft;
+    int m_hop;
+    QVector<float> m_window;                    // Hann窗，已按窗的和归一化
+    QVector<float> m_ring;                      // 最近windowSize()个采样
+    int m_head;                                 // 下一个写入位置（也是窗内最旧的采样）
+    int m_filled;
+    int m_sinceColumn;                          // 上一列之后的新采样数
+    QVector<float> m_frame;                     // 加窗后的整窗
+    QVector<std::complex<float>> m_spectrum;
+};
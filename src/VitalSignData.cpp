@@ -1,39 +1,544 @@
 #include "VitalSignData.h"
 #include <QJsonArray>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 采样以float存储，输出JSON时保留到µV，避免float转double后出现冗长小数
+double roundMicrovolt(float value) {
+    return std::round(static_cast<double>(value) * 1e6) / 1e6;
+}
+
+// 10的整数次幂（0..22可被double精确表示）
+double pow10(int exponent) {
+    static const double table[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if (exponent >= 0 && exponent <= 22) return table[exponent];
+    return std::pow(10.0, exponent);
+}
+
+// 负载扫描器：只处理生理数据负载用到的JSON子集
+class PayloadScanner {
+public:
+    PayloadScanner(const char* begin, const char* end) : m_p(begin), m_end(end) {}
+
+    void skipWhitespace() {
+        while (m_p < m_end && (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t')) {
+            ++m_p;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (m_p < m_end && *m_p == c) {
+            ++m_p;
+            return true;
+        }
+        return false;
+    }
+
+    bool peek(char c) {
+        skipWhitespace();
+        return m_p < m_end && *m_p == c;
+    }
+    
+    // 读取不含转义的字符串（返回指向负载内部的指针）
+    bool readString(const char*& text, int& length) {
+        if (!consume('"')) return false;
+        text = m_p;
+        while (m_p < m_end && *m_p != '"') {
+            if (*m_p == '\\') return false;
+            ++m_p;
+        }
+        if (m_p >= m_end) return false;
+        length = static_cast<int>(m_p - text);
+        ++m_p;
+        return true;
+    }
+
+    // 十进制数：尾数累加后按10的幂缩放，误差在1-2 ulp内（采样最终存为float）
+    bool readNumber(double& value) {
+        skipWhitespace();
+        bool negative = false;
+        if (m_p < m_end && *m_p == '-') {
+            negative = true;
+            ++m_p;
+        }
+
+        quint64 mantissa = 0;
+        int exponent = 0;
+        bool anyDigit = false;
+        while (m_p < m_end && isDigit(*m_p)) {
+            if (mantissa < 100000000000000000ULL) {
+                mantissa = mantissa * 10 + (*m_p - '0');
+            } else {
+                exponent++;
+            }
+            anyDigit = true;
+            ++m_p;
+        }
+        if (m_p < m_end && *m_p == '.') {
+            ++m_p;
+            while (m_p < m_end && isDigit(*m_p)) {
+                if (mantissa < 100000000000000000ULL) {
+                    mantissa = mantissa * 10 + (*m_p - '0');
+                    exponent--;
+                }
+                anyDigit = true;
+                ++m_p;
+            }
+        }
+        if (!anyDigit) return false;
+
+        if (m_p < m_end && (*m_p == 'e' || *m_p == 'E')) {
+            ++m_p;
+            bool negativeExp = false;
+            if (m_p < m_end && (*m_p == '+' || *m_p == '-')) {
+                negativeExp = (*m_p == '-');
+                ++m_p;
+            }
+            int exp = 0;
+            bool anyExpDigit = false;
+            while (m_p < m_end && isDigit(*m_p)) {
+                if (exp < 10000) exp = exp * 10 + (*m_p - '0');
+                anyExpDigit = true;
+                ++m_p;
+            }
+            if (!anyExpDigit) return false;
+            exponent += negativeExp ? -exp : exp;
+        }
+
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / pow10(-exponent) : result * pow10(exponent);
+        value = negative ? -result : result;
+        return true;
+    }
+
+    // 统计数值数组元素个数（从'['之后到']'），含嵌套或字符串时返回-1
+    int countArrayElements() const {
+        int commas = 0;
+        bool empty = true;
+        for (const char* q = m_p; q < m_end; ++q) {
+            switch (*q) {
+                case ']': return empty ? 0 : commas + 1;
+                case ',': commas++; break;
+                case '[': case '{': case '"': return -1;
+                case ' ': case '\n': case '\r': case '\t': break;
+                default: empty = false; break;
+            }
+        }
+        return -1;
+    }
+
+    // 统计二维数值数组的行数（从外层'['之后到对应的']'），格式不符时返回-1
+    int countArrayRows() const {
+        int rows = 0;
+        int depth = 0;
+        for (const char* q = m_p; q < m_end; ++q) {
+            switch (*q) {
+                case '[':
+                    if (depth > 0) return -1;
+                    depth++;
+                    rows++;
+                    break;
+                case ']':
+                    if (depth == 0) return rows;
+                    depth--;
+                    break;
+                case '{': case '"': return -1;
+                default: break;
+            }
+        }
+        return -1;
+    }
+    
+    // 跳过任意JSON值
+    bool skipValue() {
+        skipWhitespace();
+        if (m_p >= m_end) return false;
+
+        int depth = 0;
+        do {
+            if (m_p >= m_end) return false;
+            const char c = *m_p;
+            if (c == '"') {
+                ++m_p;
+                while (m_p < m_end && *m_p != '"') {
+                    if (*m_p == '\\') ++m_p;
+                    ++m_p;
+                }
+                if (m_p >= m_end) return false;
+                ++m_p;
+            } else if (c == '[' || c == '{') {
+                depth++;
+                ++m_p;
+            } else if (c == ']' || c == '}') {
+                if (depth == 0) return false;
+                depth--;
+                ++m_p;
+            } else if (depth == 0 && c == ',') {
+                return false;
+            } else {
+                ++m_p;
+                if (depth == 0) {
+                    // 数字或字面量，读到分隔符为止
+                    while (m_p < m_end && *m_p != ',' && *m_p != '}' && *m_p != ']') ++m_p;
+                }
+            }
+        } while (depth > 0);
+        return true;
+    }
+
+private:
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    const char* m_p;
+    const char* m_end;
+};
+
+bool keyIs(const char* key, int length, const char* expected) {
+    return int(qstrlen(expected)) == length && memcmp(key, expected, length) == 0;
+}
+
+int readDigits(const char* text, int count) {
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (text[i] < '0' || text[i] > '9') return -1;
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+// 解析 yyyy-MM-ddTHH:mm:ss[.ffffff][Z|±HH:MM]，无时区标记按本地时间处理
+bool parseIsoTimestamp(const char* text, int length, qint64& epochUs) {
+    if (length < 19 || text[4] != '-' || text[7] != '-' || (text[10] != 'T' && text[10] != ' ') ||
+        text[13] != ':' || text[16] != ':') {
+        return false;
+    }
+
+    const int year = readDigits(text, 4);
+    const int month = readDigits(text + 5, 2);
+    const int day = readDigits(text + 8, 2);
+    const int hour = readDigits(text + 11, 2);
+    const int minute = readDigits(text + 14, 2);
+    const int second = readDigits(text + 17, 2);
+    const QDate date(year, month, day);
+    const QTime time(hour, minute, second);
+    if (!date.isValid() || !time.isValid()) return false;
+
+    int pos = 19;
+    qint64 fractionUs = 0;
+    if (pos < length && text[pos] == '.') {
+        ++pos;
+        qint64 scale = 100000;
+        while (pos < length && text[pos] >= '0' && text[pos] <= '9') {
+            fractionUs += (text[pos] - '0') * scale;
+            scale /= 10;
+            ++pos;
+        }
+    }
+
+    qint64 secondsSinceEpoch = 0;
+    if (pos == length) {
+        secondsSinceEpoch = QDateTime(date, time).toSecsSinceEpoch();
+    } else {
+        const qint64 utcSeconds = (date.toJulianDay() - 2440588) * 86400 +
+                                  hour * 3600 + minute * 60 + second;
+        if (text[pos] == 'Z' && pos + 1 == length) {
+            secondsSinceEpoch = utcSeconds;
+        } else if ((text[pos] == '+' || text[pos] == '-') && pos + 6 == length && text[pos + 3] == ':') {
+            const int offsetHours = readDigits(text + pos + 1, 2);
+            const int offsetMinutes = readDigits(text + pos + 4, 2);
+            if (offsetHours < 0 || offsetMinutes < 0) return false;
+            const int offset = (offsetHours * 3600 + offsetMinutes * 60) * (text[pos] == '-' ? -1 : 1);
+            secondsSinceEpoch = utcSeconds - offset;
+        } else {
+            return false;
+        }
+    }
+
+    epochUs = secondsSinceEpoch * 1000000 + fractionUs;
+    return true;
+}
+
+// 与QJsonValue::toInt一致：非整数返回0
+int toInt(double value) {
+    return (value == std::floor(value) && std::abs(value) <= INT_MAX) ? static_cast<int>(value) : 0;
+}
+
+// 按导联标签整理帧：rows为平面数组的行数（0表示一维数组），wireLeads为负载中各导联的标签顺序。
+// 一维数组带多个标签时按交织处理；与标准顺序不一致时重新排布（从设备池分配，不触发堆分配）
+bool arrangeLeads(EcgFrame& frame, EcgFramePool* pool, const int* wireLeads, int labelCount, int rows) {
+    if (frame.isEmpty() || labelCount == 0) return true;
+    
+    quint16 leads = 0;
+    bool canonical = true;
+    for (int i = 0; i < labelCount; ++i) {
+        if (leads & EcgLead::bit(wireLeads[i])) return false;    // 重复的导联
+        canonical = canonical && (i == 0 || wireLeads[i] > wireLeads[i - 1]);
+        leads |= EcgLead::bit(wireLeads[i]);
+    }
+    
+    if (rows == 0 && labelCount == 1) {
+        frame.setLeads(leads);
+        return true;
+    }
+    if (rows > 0 && rows != labelCount) return false;
+    if (rows == 0 && frame.size() % labelCount != 0) return false;
+    if (rows > 0 && canonical) {
+        frame.setLeads(leads);
+        return true;
+    }
+    
+    const int perLead = rows > 0 ? frame.size() : frame.size() / labelCount;
+    EcgFrame arranged = EcgFrame::allocate(pool, perLead, frame.timestampUs(), frame.sampleRate(), leads);
+    for (int i = 0; i < labelCount; ++i) {
+        float* out = arranged.mutableLead(EcgLead::position(leads, wireLeads[i]));
+        if (rows > 0) {
+            memcpy(out, frame.lead(i), size_t(perLead) * sizeof(float));
+        } else {
+            const float* in = frame.constData() + i;
+            for (int k = 0; k < perLead; ++k) {
+                out[k] = in[qsizetype(k) * labelCount];
+            }
+        }
+    }
+    frame = arranged;
+    return true;
+}
+
+} // namespace
 
 QJsonObject VitalSignData::toJson() const {
     QJsonObject json;
-    json["timestamp"] = timestamp.toString(Qt::ISODate);
+    if (!deviceId.isEmpty()) {
+        json["deviceId"] = deviceId;
+    }
+    json["timestamp"] = dateTime().toString(Qt::ISODateWithMs);
     json["temperature"] = temperature;
     json["oxygenSaturation"] = oxygenSaturation;
     json["heartRate"] = heartRate;
     
+    // 多导联按导联平面输出二维数组，单导联保持一维数组
     QJsonArray ecgArray;
-    for (double value : ecgSignal) {
-        ecgArray.append(value);
+    if (ecgSignal.leadCount() > 1) {
+        for (int lead = 0; lead < ecgSignal.leadCount(); ++lead) {
+            const float* samples = ecgSignal.lead(lead);
+            QJsonArray row;
+            for (int i = 0; i < ecgSignal.size(); ++i) {
+                row.append(roundMicrovolt(samples[i]));
+            }
+            ecgArray.append(row);
+        }
+    } else {
+        for (float value : ecgSignal) {
+            ecgArray.append(roundMicrovolt(value));
+        }
     }
     json["ecgSignal"] = ecgArray;
+    if (ecgSignal.leads() != 0) {
+        json["leads"] = QJsonArray::fromStringList(ecgSignal.leadLabels());
+    }
+    json["sampleRate"] = ecgSignal.sampleRate();
+    
+    if (signalQuality.isAssessed()) {
+        json["signalQuality"] = signalQuality.score;
+        json["qualityFlags"] = int(signalQuality.flags);
+    }
     
     return json;
 }
 
 VitalSignData VitalSignData::fromJson(const QJsonObject& json) {
     VitalSignData data;
-    data.timestamp = QDateTime::fromString(json["timestamp"].toString(), Qt::ISODate);
+    data.deviceId = json["deviceId"].toString();
+    // 没有时间戳时保留构造时的当前时刻（接收时刻）
+    const QDateTime timestamp = QDateTime::fromString(json["timestamp"].toString(), Qt::ISODate);
+    if (timestamp.isValid()) {
+        data.setDateTime(timestamp);
+    }
     data.temperature = json["temperature"].toDouble();
     data.oxygenSaturation = json["oxygenSaturation"].toInt();
     data.heartRate = json["heartRate"].toInt();
+    if (json.contains("signalQuality")) {
+        data.signalQuality.score = static_cast<float>(json["signalQuality"].toDouble());
+        data.signalQuality.flags = static_cast<quint8>(json["qualityFlags"].toInt());
+    }
+    
+    const QJsonArray ecgArray = json["ecgSignal"].toArray();
+    // 旧格式没有sampleRate，按默认100Hz处理；超出范围的值同样回退
+    const int sampleRate = EcgFrame::validSampleRate(json["sampleRate"].toInt(EcgFrame::DefaultSampleRate));
+    // 二维数组为导联平面，每行一个导联
+    const bool planar = !ecgArray.isEmpty() && ecgArray.first().isArray();
+    const int rows = planar ? ecgArray.size() : 0;
+    if (rows > EcgLead::Count) return data;
+    const int perLead = planar ? ecgArray.first().toArray().size() : ecgArray.size();
+    EcgFramePool* pool = EcgFramePool::forDevice(data.deviceId);
+    data.ecgSignal = EcgFrame::allocate(pool, perLead, data.timestampUs,
+                                        sampleRate,
+                                        rows > 1 ? EcgLead::firstLeads(rows) : 0);
+    if (data.ecgSignal.isEmpty()) return data;
+    
+    for (int lead = 0; lead < qMax(1, rows); ++lead) {
+        const QJsonArray values = planar ? ecgArray.at(lead).toArray() : ecgArray;
+        float* samples = data.ecgSignal.mutableLead(lead);
+        for (int i = 0; i < perLead; ++i) {
+            samples[i] = static_cast<float>(values.at(i).toDouble());
+        }
+    }
     
-    QJsonArray ecgArray = json["ecgSignal"].toArray();
-    for (const QJsonValue& value : ecgArray) {
-        data.ecgSignal.append(value.toDouble());
+    const QJsonArray labels = json["leads"].toArray();
+    int wireLeads[EcgLead::Count];
+    int labelCount = 0;
+    for (const QJsonValue& label : labels) {
+        const QByteArray text = label.toString().toUtf8();
+        const int lead = EcgLead::fromLabel(text.constData(), text.size());
+        if (lead < 0 || labelCount == EcgLead::Count) {
+            labelCount = 0;
+            break;
+        }
+        wireLeads[labelCount++] = lead;
+    }
+    // 标签与数据不符时保留按顺序标注的导联
+    EcgFrame arranged = data.ecgSignal;
+    if (arrangeLeads(arranged, pool, wireLeads, labelCount, rows)) {
+        data.ecgSignal = arranged;
     }
     
     return data;
 }
 
+bool VitalSignData::parse(const QByteArray& payload, VitalSignData& data, const QString& defaultDeviceId) {
+    PayloadScanner scanner(payload.constData(), payload.constData() + payload.size());
+    if (!scanner.consume('{')) return false;
+    
+    data.deviceId = defaultDeviceId;
+    data.timestampUs = 0;
+    data.temperature = 0.0;
+    data.oxygenSaturation = 0;
+    data.heartRate = 0;
+    data.ecgSignal = EcgFrame();
+    data.signalQuality = SignalQuality();
+    
+    EcgFramePool* pool = nullptr;
+    int sampleRate = EcgFrame::DefaultSampleRate;
+    int wireLeads[EcgLead::Count];
+    int labelCount = 0;
+    int rows = 0;
+    
+    if (!scanner.consume('}')) {
+        do {
+            const char* key;
+            int keyLength;
+            if (!scanner.readString(key, keyLength) || !scanner.consume(':')) return false;
+            
+            if (keyIs(key, keyLength, "deviceId")) {
+                const char* value;
+                int length;
+                if (!scanner.readString(value, length)) return false;
+                pool = EcgFramePool::forDeviceUtf8(value, length);
+                data.deviceId = pool->isOverflow() ? QString::fromUtf8(value, length) : pool->deviceId();
+            } else if (keyIs(key, keyLength, "timestamp")) {
+                const char* value;
+                int length;
+                if (!scanner.readString(value, length)) return false;
+                if (!parseIsoTimestamp(value, length, data.timestampUs)) return false;
+            } else if (keyIs(key, keyLength, "temperature")) {
+                if (!scanner.readNumber(data.temperature)) return false;
+            } else if (keyIs(key, keyLength, "oxygenSaturation")) {
+                double value;
+                if (!scanner.readNumber(value)) return false;
+                data.oxygenSaturation = toInt(value);
+            } else if (keyIs(key, keyLength, "heartRate")) {
+                double value;
+                if (!scanner.readNumber(value)) return false;
+                data.heartRate = toInt(value);
+            } else if (keyIs(key, keyLength, "sampleRate")) {
+                double value;
+                if (!scanner.readNumber(value)) return false;
+                sampleRate = EcgFrame::validSampleRate(toInt(value));
+            } else if (keyIs(key, keyLength, "signalQuality")) {
+                double value;
+                if (!scanner.readNumber(value)) return false;
+                data.signalQuality.score = static_cast<float>(value);
+            } else if (keyIs(key, keyLength, "qualityFlags")) {
+                double value;
+                if (!scanner.readNumber(value)) return false;
+                data.signalQuality.flags = static_cast<quint8>(toInt(value));
+            } else if (keyIs(key, keyLength, "leads")) {
+                if (!scanner.consume('[')) return false;
+                labelCount = 0;
+                if (!scanner.consume(']')) {
+                    do {
+                        const char* label;
+                        int length;
+                        if (!scanner.readString(label, length)) return false;
+                        const int lead = EcgLead::fromLabel(label, length);
+                        if (lead < 0 || labelCount == EcgLead::Count) return false;
+                        wireLeads[labelCount++] = lead;
+                    } while (scanner.consume(','));
+                    if (!scanner.consume(']')) return false;
+                }
+            } else if (keyIs(key, keyLength, "ecgSignal")) {
+                if (!scanner.consume('[')) return false;
+                
+                // 二维数组为导联平面，每行一个导联，各行长度必须相同
+                rows = 0;
+                if (scanner.peek('[')) {
+                    rows = scanner.countArrayRows();
+                    if (rows <= 0 || rows > EcgLead::Count) return false;
+                }
+                
+                if (!pool) {
+                    pool = EcgFramePool::forDevice(data.deviceId);
+                }
+                for (int row = 0; row < qMax(1, rows); ++row) {
+                    if (rows > 0 && ((row > 0 && !scanner.consume(',')) || !scanner.consume('['))) return false;
+                    const int count = scanner.countArrayElements();
+                    if (count < 0) return false;
+                    if (row == 0) {
+                        data.ecgSignal = EcgFrame::allocate(pool, count, 0, EcgFrame::DefaultSampleRate,
+                                                            rows > 1 ? EcgLead::firstLeads(rows) : 0);
+                    } else if (count != data.ecgSignal.size()) {
+                        return false;
+                    }
+                    float* samples = data.ecgSignal.mutableLead(row);
+                    for (int i = 0; i < count; ++i) {
+                        double value;
+                        if ((i > 0 && !scanner.consume(',')) || !scanner.readNumber(value)) return false;
+                        samples[i] = static_cast<float>(value);
+                    }
+                    if (!scanner.consume(']')) return false;
+                }
+                if (rows > 0 && !scanner.consume(']')) return false;
+            } else if (!scanner.skipValue()) {
+                return false;
+            }
+        } while (scanner.consume(','));
+        
+        if (!scanner.consume('}')) return false;
+    }
+    
+    // leads与sampleRate可能出现在ecgSignal之后，帧分配完再统一整理
+    if (!arrangeLeads(data.ecgSignal, pool, wireLeads, labelCount, rows)) return false;
+    // 与fromJson一致：没有时间戳时取接收时刻
+    if (data.timestampUs == 0) {
+        data.timestampUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+    }
+    data.ecgSignal.setTimestampUs(data.timestampUs);
+    data.ecgSignal.setSampleRate(sampleRate);
+    return true;
+}
+
 QJsonObject AlarmInfo::toJson() const {
     QJsonObject json;
+    if (!deviceId.isEmpty()) {
+        json["deviceId"] = deviceId;
+    }
     json["timestamp"] = timestamp.toString(Qt::ISODate);
     json["type"] = static_cast<int>(type);
     json["message"] = message;
@@ -41,8 +546,20 @@ QJsonObject AlarmInfo::toJson() const {
     return json;
 }
 
+QString AlarmInfo::typeName(AlarmType type) {
+    switch (type) {
+    case LowOxygen:           return "低血氧";
+    case HighHeartRate:       return "心率过高";
+    case LowHeartRate:        return "心率过低";
+    case AbnormalTemperature: return "体温异常";
+    case ECGAbnormal:         return "心电异常";
+    }
+    return QString();
+}
+
 AlarmInfo AlarmInfo::fromJson(const QJsonObject& json) {
     AlarmInfo alarm;
+    alarm.deviceId = json["deviceId"].toString();
     alarm.timestamp = QDateTime::fromString(json["timestamp"].toString(), Qt::ISODate);
     alarm.type = static_cast<AlarmType>(json["type"].toInt());
     alarm.message = json["message"].toString();
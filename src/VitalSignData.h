@@ -3,28 +3,50 @@
 #include <QDateTime>
 #include <QVector>
 #include <QJsonObject>
+#include "EcgFrame.h"
+#include "SignalQuality.h"
 
 // 生理信号数据结构
+// 按值传递只复制标量和引用计数：时间为整数，ECG采样为共享的不可变帧
 struct VitalSignData {
-    QDateTime timestamp;        // 时间戳
+    QString deviceId;           // 设备ID（来自负载或主题 ecg/vitalsign/<deviceId>）
+    qint64 timestampUs;         // 时间戳 (epoch µs)
     double temperature;         // 体温 (°C)
     int oxygenSaturation;      // 血氧饱和度 (%)
     int heartRate;             // 心率 (bpm)
-    QVector<double> ecgSignal; // 心电图信号数组
+    EcgFrame ecgSignal;        // 心电图信号（共享帧，含采样率）
+    SignalQuality signalQuality;  // ECG信号质量（由本地EcgAnalyzer评估）
+    qint64 receivedAtNs;       // 接收时刻（单调时钟，用于链路延迟统计，不序列化）
     
     VitalSignData() 
-        : timestamp(QDateTime::currentDateTime())
+        : timestampUs(QDateTime::currentMSecsSinceEpoch() * 1000)
         , temperature(0.0)
         , oxygenSaturation(0)
         , heartRate(0)
+        , receivedAtNs(0)
     {}
     
+    // ECG采样率 (Hz)，随帧携带
+    int sampleRate() const { return ecgSignal.sampleRate(); }
+    
+    QDateTime dateTime() const {
+        return QDateTime::fromMSecsSinceEpoch(timestampUs / 1000);
+    }
+    void setDateTime(const QDateTime& dateTime) {
+        timestampUs = dateTime.isValid() ? dateTime.toMSecsSinceEpoch() * 1000 : 0;
+    }
+    
     // 转换为JSON格式
     QJsonObject toJson() const;
     
     // 从JSON解析
     static VitalSignData fromJson(const QJsonObject& json);
     
+    // 直接从原始负载解析，不构建JSON DOM，采样写入设备池中的帧（稳态无堆分配）
+    // 遇到转义字符等不支持的写法时返回false，调用方应回退到fromJson
+    static bool parse(const QByteArray& payload, VitalSignData& data,
+                      const QString& defaultDeviceId = QString());
+    
     // 验证数据有效性
     bool isValid() const {
         return temperature >= 35.0 && temperature <= 42.0 &&
@@ -33,6 +55,16 @@ struct VitalSignData {
     }
 };
 
+// 趋势时间桶：桶内各参数的平均值（数据库按桶聚合的结果）
+struct VitalTrendBucket {
+    qint64 startMs = 0;         // 桶起点（按绝对时间对齐到桶长）
+    qint64 lastUs = 0;          // 桶内最新一帧的时间
+    int count = 0;
+    double temperature = 0.0;
+    double heartRate = 0.0;
+    double oxygen = 0.0;
+};
+
 // 报警信息结构
 struct AlarmInfo {
     enum AlarmType {
@@ -43,6 +75,7 @@ struct AlarmInfo {
         ECGAbnormal         // 心电异常
     };
     
+    QString deviceId;
     QDateTime timestamp;
     AlarmType type;
     QString message;
@@ -52,4 +85,6 @@ struct AlarmInfo {
     
     QJsonObject toJson() const;
     static AlarmInfo fromJson(const QJsonObject& json);
+    
+    static QString typeName(AlarmType type);
 };
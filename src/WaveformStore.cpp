@@ -0,0 +1,679 @@
+#include "WaveformStore.h"
+#include <QDate>
+#include <QDir>
+#include <QFileInfo>
+#include <QUrl>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+namespace {
+
+const char SegmentMagic[8] = {'E', 'C', 'G', 'S', 'E', 'G', '1', '\0'};
+const char TrailerMagic[4] = {'E', 'I', 'D', 'X'};
+const quint32 SegmentVersion = 2;          // 版本2的记录头带导联集合，仍可读取版本1
+const quint32 ByteOrderMark = 0x01020304;
+const char SegmentSuffix[] = ".ecgseg";
+
+struct SegmentHeader {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 hourStartUs;
+    qint64 reserved;
+};
+
+struct RecordHeaderV1 {
+    qint64 timestampUs;
+    qint32 sampleRate;
+    qint32 sampleCount;
+};
+
+struct RecordHeader {
+    qint64 timestampUs;
+    qint32 sampleRate;
+    qint32 sampleCount;     // 每个导联的采样数
+    quint16 leads;          // EcgLead位掩码，0为未标注的单导联
+    quint16 leadCount;
+    quint32 reserved;
+};
+
+struct SegmentTrailer {
+    qint64 indexOffset;
+    quint32 entryCount;
+    char magic[4];
+};
+
+static_assert(sizeof(SegmentHeader) == 32, "segment header layout");
+static_assert(sizeof(RecordHeaderV1) == 16, "v1 record header layout");
+static_assert(sizeof(RecordHeader) == 24, "record header layout");
+static_assert(sizeof(SegmentTrailer) == 16, "segment trailer layout");
+static_assert(sizeof(WaveformStore::IndexEntry) == 24, "index entry layout");
+
+// 单帧采样数上限（与帧池超大帧一致的合理范围），用于识别损坏记录
+const qint32 MaxRecordSamples = 1 << 20;
+
+// 返回分段版本，无效时返回0
+quint32 segmentVersion(const uchar* data, qint64 size) {
+    if (size < qint64(sizeof(SegmentHeader))) return 0;
+    SegmentHeader header;
+    memcpy(&header, data, sizeof(header));
+    const bool valid = memcmp(header.magic, SegmentMagic, sizeof(SegmentMagic)) == 0 &&
+                       (header.version == 1 || header.version == SegmentVersion) &&
+                       header.byteOrder == ByteOrderMark;
+    return valid ? header.version : 0;
+}
+
+qint64 recordHeaderSize(quint32 version) {
+    return version >= 2 ? qint64(sizeof(RecordHeader)) : qint64(sizeof(RecordHeaderV1));
+}
+
+// 读取offset处的记录头，版本1补为单导联；格式不符返回false
+bool readRecordHeader(const uchar* data, qint64 size, qint64 offset, quint32 version, RecordHeader& header) {
+    if (offset + recordHeaderSize(version) > size) return false;
+    if (version >= 2) {
+        memcpy(&header, data + offset, sizeof(header));
+    } else {
+        RecordHeaderV1 v1;
+        memcpy(&v1, data + offset, sizeof(v1));
+        header = {v1.timestampUs, v1.sampleRate, v1.sampleCount, 0, 1, 0};
+    }
+    return header.sampleCount > 0 && header.leadCount > 0 && header.leadCount <= EcgLead::Count &&
+           qint64(header.sampleCount) * header.leadCount <= MaxRecordSamples;
+}
+
+qint64 recordSize(const RecordHeader& header, quint32 version) {
+    return recordHeaderSize(version) + qint64(header.sampleCount) * header.leadCount * qint64(sizeof(float));
+}
+
+bool earlierThan(const WaveformStore::IndexEntry& a, const WaveformStore::IndexEntry& b) {
+    return a.timestampUs < b.timestampUs;
+}
+
+// 扫描得到的索引按文件顺序排列，迟到的帧需要按时间戳重排（时间相同的保持写入顺序）
+void sortIndex(QVector<WaveformStore::IndexEntry>& index) {
+    if (!std::is_sorted(index.cbegin(), index.cend(), earlierThan)) {
+        std::stable_sort(index.begin(), index.end(), earlierThan);
+    }
+}
+
+} // namespace
+
+WaveformStore::MappedSegment::~MappedSegment() {
+    if (data) {
+        file.unmap(const_cast<uchar*>(data));
+    }
+}
+
+WaveformStore::WaveformStore(const QString& rootPath)
+    : m_rootPath(rootPath)
+{
+}
+
+WaveformStore::~WaveformStore() {
+    close();
+}
+
+bool WaveformStore::open() {
+    if (!QDir().mkpath(m_rootPath)) {
+        QMutexLocker locker(&m_mutex);
+        m_error = "无法创建波形目录: " + m_rootPath;
+        return false;
+    }
+    return true;
+}
+
+void WaveformStore::close() {
+    QMutexLocker locker(&m_mutex);
+    for (Writer* writer : std::as_const(m_writers)) {
+        sealWriter(writer);
+        delete writer;
+    }
+    m_writers.clear();
+    for (Writer* writer : std::as_const(m_lateWriters)) {
+        sealWriter(writer);
+        delete writer;
+    }
+    m_lateWriters.clear();
+    m_mapped.clear();
+    m_mappedOrder.clear();
+}
+
+QString WaveformStore::errorString() const {
+    QMutexLocker locker(&m_mutex);
+    return m_error;
+}
+
+QString WaveformStore::deviceDirectory(const QString& deviceId) {
+    if (deviceId.isEmpty()) {
+        return "_unassigned";
+    }
+    // 百分号编码保证目录名可逆且不含路径分隔符
+    QString name = QString::fromLatin1(QUrl::toPercentEncoding(deviceId));
+    if (name == "." || name == "..") {
+        name.replace('.', "%2E");
+    }
+    return name;
+}
+
+qint64 WaveformStore::hourStart(qint64 timestampUs) {
+    qint64 hour = timestampUs / SegmentDurationUs;
+    if (timestampUs < 0 && timestampUs % SegmentDurationUs != 0) {
+        hour--;
+    }
+    return hour * SegmentDurationUs;
+}
+
+QString WaveformStore::segmentName(const QString& deviceId, qint64 hourStartUs, int sequence) {
+    const qint64 hours = hourStartUs / SegmentDurationUs;
+    const QDate date = QDate::fromJulianDay(hours / 24 + 2440588);
+    QString name = QString::asprintf("%04d%02d%02d%02d", date.year(), date.month(), date.day(), int(hours % 24));
+    if (sequence > 0) {
+        name += QString("-%1").arg(sequence);
+    }
+    // 设备目录含百分号编码，不能参与QString::arg替换
+    return deviceDirectory(deviceId) + "/" + name + SegmentSuffix;
+}
+
+qint64 WaveformStore::parseSegmentHour(const QString& fileName, int* sequence) {
+    if (!fileName.endsWith(SegmentSuffix)) {
+        return -1;
+    }
+    const QString stem = fileName.left(fileName.size() - int(strlen(SegmentSuffix)));
+    int number = 0;
+    if (stem.size() > 11 && stem.at(10) == '-') {
+        bool ok = false;
+        number = stem.mid(11).toInt(&ok);
+        if (!ok || number <= 0) return -1;
+    } else if (stem.size() != 10) {
+        return -1;
+    }
+
+    bool ok[4];
+    const QDate date(stem.mid(0, 4).toInt(&ok[0]), stem.mid(4, 2).toInt(&ok[1]), stem.mid(6, 2).toInt(&ok[2]));
+    const int hour = stem.mid(8, 2).toInt(&ok[3]);
+    if (!ok[0] || !ok[1] || !ok[2] || !ok[3] || !date.isValid() || hour < 0 || hour > 23) {
+        return -1;
+    }
+    if (sequence) *sequence = number;
+    return ((date.toJulianDay() - 2440588) * 24 + hour) * SegmentDurationUs;
+}
+
+WaveformLocation WaveformStore::append(const QString& deviceId, qint64 timestampUs, const EcgFrame& frame) {
+    WaveformLocation location;
+    if (frame.isEmpty()) return location;
+
+    QMutexLocker locker(&m_mutex);
+    Writer* writer = writerFor(deviceId, hourStart(timestampUs));
+    if (!writer) return location;
+
+    const qint64 offset = writer->file.pos();
+    const RecordHeader header = {timestampUs, frame.sampleRate(), frame.size(),
+                                 frame.leads(), quint16(frame.leadCount()), 0};
+    const qint64 headerBytes = sizeof(RecordHeader);
+    const qint64 sampleBytes = qint64(frame.size()) * header.leadCount * sizeof(float);
+
+    // 每帧写完即flush，读取方通过映射可立即看到
+    if (writer->file.write(reinterpret_cast<const char*>(&header), headerBytes) != headerBytes ||
+        writer->file.write(reinterpret_cast<const char*>(frame.constData()), sampleBytes) != sampleBytes ||
+        !writer->file.flush()) {
+        m_error = "写入波形失败: " + writer->file.errorString();
+        writer->file.resize(offset);
+        writer->file.seek(offset);
+        return location;
+    }
+
+    // 记录按到达顺序追加，索引按时间戳有序；迟到的帧插入到对应位置
+    const IndexEntry entry = {timestampUs, offset, frame.size(), frame.sampleRate()};
+    if (writer->index.isEmpty() || writer->index.last().timestampUs <= timestampUs) {
+        writer->index.append(entry);
+    } else {
+        writer->index.insert(std::upper_bound(writer->index.begin(), writer->index.end(), entry, earlierThan),
+                             entry);
+    }
+    location.segment = writer->segment;
+    location.offset = offset;
+    return location;
+}
+
+WaveformStore::Writer* WaveformStore::writerFor(const QString& deviceId, qint64 hourStartUs) {
+    Writer* writer = m_writers.value(deviceId, nullptr);
+    if (writer && writer->hourStartUs == hourStartUs) {
+        return writer;
+    }
+
+    if (writer && hourStartUs < writer->hourStartUs) {
+        // 更早小时的迟到帧写入该小时的续写分段，当前小时的分段照常写入；
+        // 跨整点交替到达的帧分别写入两个分段，不会反复封存、重开
+        Writer* late = m_lateWriters.value(deviceId, nullptr);
+        if (late && late->hourStartUs == hourStartUs) {
+            return late;
+        }
+        if (late) {
+            sealWriter(late);
+            delete late;
+            m_lateWriters.remove(deviceId);
+        }
+        late = createWriter(deviceId, hourStartUs);
+        if (late) {
+            m_lateWriters.insert(deviceId, late);
+        }
+        return late;
+    }
+
+    // 进入新的小时，封存上一分段与迟到帧的续写分段
+    if (writer) {
+        sealWriter(writer);
+        delete writer;
+        m_writers.remove(deviceId);
+    }
+    if (Writer* late = m_lateWriters.take(deviceId)) {
+        sealWriter(late);
+        delete late;
+    }
+
+    writer = createWriter(deviceId, hourStartUs);
+    if (writer) {
+        m_writers.insert(deviceId, writer);
+    }
+    return writer;
+}
+
+WaveformStore::Writer* WaveformStore::createWriter(const QString& deviceId, qint64 hourStartUs) {
+    // 已有的分段（重启前写入、已封存）保持不变，写入该小时下一个未使用的序号
+    QString segment = segmentName(deviceId, hourStartUs);
+    for (int sequence = 1; QFileInfo::exists(m_rootPath + "/" + segment); ++sequence) {
+        segment = segmentName(deviceId, hourStartUs, sequence);
+    }
+
+    const QString path = m_rootPath + "/" + segment;
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        m_error = "无法创建波形目录: " + QFileInfo(path).absolutePath();
+        return nullptr;
+    }
+
+    Writer* writer = new Writer;
+    writer->segment = segment;
+    writer->hourStartUs = hourStartUs;
+    writer->file.setFileName(path);
+    if (!writer->file.open(QIODevice::WriteOnly | QIODevice::NewOnly)) {
+        m_error = "无法打开波形分段: " + writer->file.errorString();
+        delete writer;
+        return nullptr;
+    }
+
+    SegmentHeader header;
+    memcpy(header.magic, SegmentMagic, sizeof(SegmentMagic));
+    header.version = SegmentVersion;
+    header.byteOrder = ByteOrderMark;
+    header.hourStartUs = hourStartUs;
+    header.reserved = 0;
+    if (writer->file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        !writer->file.flush()) {
+        m_error = "写入波形分段头失败: " + writer->file.errorString();
+        delete writer;
+        return nullptr;
+    }
+    return writer;
+}
+
+qint64 WaveformStore::writtenSize(const QString& deviceId, const QString& segment) const {
+    for (const Writer* writer : {m_writers.value(deviceId, nullptr), m_lateWriters.value(deviceId, nullptr)}) {
+        if (writer && writer->segment == segment) {
+            return writer->file.pos();
+        }
+    }
+    return 0;
+}
+
+void WaveformStore::sealWriter(Writer* writer) {
+    if (!writer->file.isOpen()) return;
+
+    // 索引按8字节对齐，映射后可直接按结构体访问
+    qint64 indexOffset = writer->file.pos();
+    const qint64 padding = (8 - indexOffset % 8) % 8;
+    if (padding > 0) {
+        const char zeros[8] = {0};
+        writer->file.write(zeros, padding);
+        indexOffset += padding;
+    }
+
+    SegmentTrailer trailer;
+    trailer.indexOffset = indexOffset;
+    trailer.entryCount = quint32(writer->index.size());
+    memcpy(trailer.magic, TrailerMagic, sizeof(TrailerMagic));
+
+    writer->file.write(reinterpret_cast<const char*>(writer->index.constData()),
+                       qint64(writer->index.size()) * sizeof(IndexEntry));
+    writer->file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    writer->file.close();
+
+    dropMapping(writer->segment);
+}
+
+bool WaveformStore::readTrailer(const uchar* data, qint64 size, qint64& indexOffset, quint32& entryCount) {
+    if (size < qint64(sizeof(SegmentHeader) + sizeof(SegmentTrailer))) return false;
+
+    SegmentTrailer trailer;
+    memcpy(&trailer, data + size - sizeof(SegmentTrailer), sizeof(trailer));
+    if (memcmp(trailer.magic, TrailerMagic, sizeof(TrailerMagic)) != 0) return false;
+
+    const qint64 indexBytes = qint64(trailer.entryCount) * sizeof(IndexEntry);
+    if (trailer.indexOffset < qint64(sizeof(SegmentHeader)) || trailer.indexOffset % 8 != 0 ||
+        trailer.indexOffset + indexBytes + qint64(sizeof(SegmentTrailer)) != size) {
+        return false;
+    }
+
+    indexOffset = trailer.indexOffset;
+    entryCount = trailer.entryCount;
+    return true;
+}
+
+bool WaveformStore::scanRecords(const uchar* data, qint64 size, quint32 version,
+                                QVector<IndexEntry>& index, qint64& validEnd) {
+    index.clear();
+    qint64 offset = sizeof(SegmentHeader);
+    RecordHeader header;
+    while (readRecordHeader(data, size, offset, version, header)) {
+        const qint64 recordEnd = offset + recordSize(header, version);
+        if (recordEnd > size) break;
+
+        index.append({header.timestampUs, offset, header.sampleCount, header.sampleRate});
+        offset = recordEnd;
+    }
+    validEnd = offset;
+    return offset == size;
+}
+
+WaveformStore::MappedSegmentPtr WaveformStore::mapSegment(const QString& segment, qint64 minSize) {
+    MappedSegmentPtr mapped = m_mapped.value(segment);
+    if (mapped && mapped->size >= minSize) {
+        m_mappedOrder.removeOne(segment);
+        m_mappedOrder.append(segment);
+        return mapped;
+    }
+    // 写入中的分段已增长，重新映射
+    dropMapping(segment);
+
+    mapped = MappedSegmentPtr::create();
+    mapped->file.setFileName(m_rootPath + "/" + segment);
+    if (!mapped->file.open(QIODevice::ReadOnly)) {
+        return MappedSegmentPtr();
+    }
+    mapped->size = mapped->file.size();
+    mapped->data = mapped->size > 0 ? mapped->file.map(0, mapped->size) : nullptr;
+    mapped->version = mapped->data ? segmentVersion(mapped->data, mapped->size) : 0;
+    if (!mapped->version) {
+        m_error = "波形分段格式无效: " + segment;
+        return MappedSegmentPtr();
+    }
+
+    qint64 indexOffset = 0;
+    quint32 entryCount = 0;
+    if (readTrailer(mapped->data, mapped->size, indexOffset, entryCount)) {
+        // 已封存：索引直接指向映射内存（修复前封存、时间无序的索引复制后重排）
+        mapped->index = reinterpret_cast<const IndexEntry*>(mapped->data + indexOffset);
+        mapped->indexCount = int(entryCount);
+        if (!std::is_sorted(mapped->index, mapped->index + mapped->indexCount, earlierThan)) {
+            mapped->scannedIndex = QVector<IndexEntry>(mapped->index, mapped->index + mapped->indexCount);
+            sortIndex(mapped->scannedIndex);
+            mapped->index = mapped->scannedIndex.constData();
+        }
+    } else {
+        qint64 validEnd = 0;
+        scanRecords(mapped->data, mapped->size, mapped->version, mapped->scannedIndex, validEnd);
+        sortIndex(mapped->scannedIndex);
+        mapped->index = mapped->scannedIndex.constData();
+        mapped->indexCount = mapped->scannedIndex.size();
+    }
+
+    m_mapped.insert(segment, mapped);
+    m_mappedOrder.append(segment);
+    while (m_mappedOrder.size() > MaxMappedSegments) {
+        m_mapped.remove(m_mappedOrder.takeFirst());
+    }
+    return mapped;
+}
+
+void WaveformStore::dropMapping(const QString& segment) {
+    // 正在使用的读取方仍持有映射，释放后自动解除
+    if (m_mapped.remove(segment) > 0) {
+        m_mappedOrder.removeOne(segment);
+    }
+}
+
+EcgFrame WaveformStore::read(const WaveformLocation& location, const QString& deviceId) {
+    if (!location.isValid()) return EcgFrame();
+
+    // 先按较长的版本2记录头映射，版本1分段的记录头更短
+    MappedSegmentPtr mapped;
+    {
+        QMutexLocker locker(&m_mutex);
+        mapped = mapSegment(location.segment, location.offset + qint64(sizeof(RecordHeaderV1)));
+    }
+    RecordHeader header;
+    if (!mapped || !readRecordHeader(mapped->data, mapped->size, location.offset, mapped->version, header)) {
+        return EcgFrame();
+    }
+
+    const qint64 recordEnd = location.offset + recordSize(header, mapped->version);
+    if (recordEnd > mapped->size) {
+        QMutexLocker locker(&m_mutex);
+        mapped = mapSegment(location.segment, recordEnd);
+        if (!mapped || mapped->size < recordEnd) return EcgFrame();
+    }
+
+    EcgFrame frame = EcgFrame::allocate(deviceId, header.sampleCount, header.timestampUs, header.sampleRate,
+                                        header.leads);
+    if (frame.leadCount() != header.leadCount) return EcgFrame();
+    memcpy(frame.mutableData(), mapped->data + location.offset + recordHeaderSize(mapped->version),
+           qint64(header.sampleCount) * header.leadCount * sizeof(float));
+    return frame;
+}
+
+int WaveformStore::readRange(const QString& deviceId, qint64 startUs, qint64 endUs,
+                             const std::function<bool(const WaveformFrameView&)>& visitor) {
+    const QString directory = deviceDirectory(deviceId);
+    const QStringList files = QDir(m_rootPath + "/" + directory)
+                                  .entryList(QStringList() << QString("*") + SegmentSuffix, QDir::Files);
+
+    // 按(小时, 续写序号)排序，同一小时的分段一起合并读取
+    struct SegmentFile {
+        qint64 hourStartUs;
+        int sequence;
+        QString segment;
+    };
+    QVector<SegmentFile> segments;
+    const qint64 firstHour = hourStart(startUs);
+    for (const QString& fileName : files) {
+        int sequence = 0;
+        const qint64 hourStartUs = parseSegmentHour(fileName, &sequence);
+        if (hourStartUs < firstHour || hourStartUs > endUs) continue;
+        segments.append({hourStartUs, sequence, directory + "/" + fileName});
+    }
+    std::sort(segments.begin(), segments.end(), [](const SegmentFile& a, const SegmentFile& b) {
+        return std::tie(a.hourStartUs, a.sequence) < std::tie(b.hourStartUs, b.sequence);
+    });
+
+    int visited = 0;
+    qint64 lastUs = -1;
+    for (int first = 0; first < segments.size();) {
+        QVector<MappedSegmentPtr> hour;
+        int next = first;
+        {
+            QMutexLocker locker(&m_mutex);
+            for (; next < segments.size() && segments[next].hourStartUs == segments[first].hourStartUs; ++next) {
+                const QString& segment = segments[next].segment;
+                if (MappedSegmentPtr mapped = mapSegment(segment, writtenSize(deviceId, segment))) {
+                    hour.append(mapped);
+                }
+            }
+        }
+        first = next;
+        if (!visitMerged(hour, startUs, endUs, visitor, visited, lastUs)) return visited;
+    }
+    return visited;
+}
+
+int WaveformStore::readFrom(const WaveformLocation& location, const QString& deviceId, qint64 endUs,
+                            const std::function<bool(const WaveformFrameView&)>& visitor) {
+    if (!location.isValid()) return 0;
+
+    MappedSegmentPtr mapped;
+    {
+        QMutexLocker locker(&m_mutex);
+        mapped = mapSegment(location.segment, writtenSize(deviceId, location.segment));
+    }
+    if (!mapped) return 0;
+
+    RecordHeader header;
+    if (!readRecordHeader(mapped->data, mapped->size, location.offset, mapped->version, header)) return 0;
+
+    // 该小时有续写分段时各分段的记录交错，按时间合并读取
+    int sequence = 0;
+    const qint64 hourStartUs = parseSegmentHour(QFileInfo(location.segment).fileName(), &sequence);
+    if (hourStartUs >= 0 &&
+        (sequence > 0 || QFileInfo::exists(m_rootPath + "/" + segmentName(deviceId, hourStartUs, 1)))) {
+        return readRange(deviceId, header.timestampUs, endUs, visitor);
+    }
+
+    // 索引按时间有序：按该记录的时间戳定位（同一时间戳的记录中找到该偏移），之后顺序读取
+    const IndexEntry* begin = mapped->index;
+    const IndexEntry* end = begin + mapped->indexCount;
+    const IndexEntry* it = std::lower_bound(begin, end, header.timestampUs,
+        [](const IndexEntry& entry, qint64 timestampUs) { return entry.timestampUs < timestampUs; });
+    while (it != end && it->timestampUs == header.timestampUs && it->offset != location.offset) ++it;
+    if (it == end || it->offset != location.offset) return 0;
+
+    int visited = 0;
+    qint64 lastUs = -1;
+    if (!visitRecords(*mapped, it, end, endUs, visitor, visited, lastUs)) return visited;
+
+    // 跨过整点时从下一个分段继续
+    if (lastUs >= 0 && lastUs < endUs) {
+        visited += readRange(deviceId, lastUs + 1, endUs, visitor);
+    }
+    return visited;
+}
+
+bool WaveformStore::frameView(const MappedSegment& mapped, const IndexEntry& entry, WaveformFrameView& view) {
+    RecordHeader header;
+    if (!readRecordHeader(mapped.data, mapped.size, entry.offset, mapped.version, header) ||
+        entry.offset + recordSize(header, mapped.version) > mapped.size) {
+        return false;
+    }
+
+    view = {
+        entry.timestampUs,
+        entry.sampleRate,
+        entry.sampleCount,
+        reinterpret_cast<const float*>(mapped.data + entry.offset + recordHeaderSize(mapped.version)),
+        header.leadCount,
+        header.leads
+    };
+    return true;
+}
+
+bool WaveformStore::visitRecords(const MappedSegment& mapped, const IndexEntry* it, const IndexEntry* end,
+                                 qint64 endUs, const std::function<bool(const WaveformFrameView&)>& visitor,
+                                 int& visited, qint64& lastUs) {
+    WaveformFrameView view;
+    for (; it != end && it->timestampUs <= endUs; ++it) {
+        if (!frameView(mapped, *it, view)) break;
+        ++visited;
+        lastUs = it->timestampUs;
+        if (!visitor(view)) return false;
+    }
+    return true;
+}
+
+bool WaveformStore::visitMerged(const QVector<MappedSegmentPtr>& segments, qint64 startUs, qint64 endUs,
+                                const std::function<bool(const WaveformFrameView&)>& visitor,
+                                int& visited, qint64& lastUs) {
+    const auto lowerBound = [startUs](const MappedSegment& mapped) {
+        return std::lower_bound(mapped.index, mapped.index + mapped.indexCount, startUs,
+            [](const IndexEntry& entry, qint64 timestampUs) { return entry.timestampUs < timestampUs; });
+    };
+    if (segments.size() == 1) {
+        const MappedSegment& mapped = *segments.first();
+        return visitRecords(mapped, lowerBound(mapped), mapped.index + mapped.indexCount, endUs,
+                            visitor, visited, lastUs);
+    }
+
+    struct Cursor {
+        const MappedSegment* mapped;
+        const IndexEntry* it;
+        const IndexEntry* end;
+    };
+    QVector<Cursor> cursors;
+    for (const MappedSegmentPtr& mapped : segments) {
+        cursors.append({mapped.data(), lowerBound(*mapped), mapped->index + mapped->indexCount});
+    }
+
+    WaveformFrameView view;
+    while (true) {
+        Cursor* next = nullptr;
+        for (Cursor& cursor : cursors) {
+            if (cursor.it != cursor.end && cursor.it->timestampUs <= endUs &&
+                (!next || cursor.it->timestampUs < next->it->timestampUs)) {
+                next = &cursor;
+            }
+        }
+        if (!next) return true;
+
+        if (!frameView(*next->mapped, *next->it, view)) {
+            // 残缺的尾记录：该分段到此为止
+            next->it = next->end;
+            continue;
+        }
+        ++next->it;
+        ++visited;
+        lastUs = view.timestampUs;
+        if (!visitor(view)) return false;
+    }
+}
+
+QStringList WaveformStore::deviceIds() const {
+    QStringList result;
+    const QStringList directories = QDir(m_rootPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& directory : directories) {
+        result << (directory == "_unassigned" ? QString("") : QUrl::fromPercentEncoding(directory.toLatin1()));
+    }
+    return result;
+}
+
+int WaveformStore::removeBefore(qint64 cutoffUs, const QString& deviceId) {
+    QDir root(m_rootPath);
+    const QStringList directories = deviceId.isNull()
+        ? root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)
+        : QStringList() << deviceDirectory(deviceId);
+
+    int removed = 0;
+    for (const QString& directory : directories) {
+        const QStringList files = QDir(root.filePath(directory))
+                                      .entryList(QStringList() << QString("*") + SegmentSuffix, QDir::Files);
+        for (const QString& fileName : files) {
+            const qint64 hourStartUs = parseSegmentHour(fileName);
+            if (hourStartUs < 0 || hourStartUs + SegmentDurationUs > cutoffUs) continue;
+
+            const QString segment = directory + "/" + fileName;
+            QMutexLocker locker(&m_mutex);
+            bool active = false;
+            for (const QHash<QString, Writer*>* writers : {&m_writers, &m_lateWriters}) {
+                for (const Writer* writer : *writers) {
+                    active = active || writer->segment == segment;
+                }
+            }
+            if (active) continue;
+
+            dropMapping(segment);
+            if (QFile::remove(root.filePath(segment))) {
+                removed++;
+            } else {
+                qWarning() << "Failed to remove waveform segment" << segment;
+            }
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include "EcgFrame.h"
+
+// 波形分段文件格式（本机字节序，仅追加，读取时直接mmap）:
+//   目录:   <根目录>/<设备ID>/<yyyyMMddHH>.ecgseg，每台设备每小时(UTC)一个文件；
+//           同一小时的续写分段为<yyyyMMddHH>-<n>.ecgseg（n从1起）
+//   文件头: "ECGSEG1\0"(8字节) | version(u32) | 字节序标记(u32) | 小时起点(i64, epoch µs) | 保留(i64)
+//   记录:   时间戳(i64, epoch µs) | 采样率(i32) | 每导联采样数(i32) | 导联集合(u16) | 导联数(u16) | 保留(u32)
+//           | float采样 × 采样数 × 导联数（按导联平面存放）
+//           版本1的记录没有导联字段（16字节记录头，单导联），仍可读取
+//   封存:   索引项数组 {时间戳(i64) | 记录偏移(i64) | 采样数(i32) | 采样率(i32)}
+//           | 索引偏移(i64) | 索引项数(u32) | "EIDX"
+// 未封存的文件（当前小时或进程崩溃）读取时按记录扫描重建索引，残缺的尾记录被忽略。
+// 记录按到达顺序追加，索引始终按时间戳排序：同一小时内迟到的帧插入索引中的对应位置。
+// 关闭后的文件不再写入也不截断（读取方可能仍映射着它，Windows上也无法缩小已映射的文件）：
+// 重启后续写当前小时、或更早小时的迟到帧都写入该小时新的续写分段，迟到帧不封存当前小时的分段。
+// 读取时同一小时的各分段按时间戳合并
+
+// 波形在分段文件中的位置（保存在数据库中）
+struct WaveformLocation {
+    QString segment;        // 相对根目录的路径
+    qint64 offset = -1;     // 记录起始偏移
+
+    bool isValid() const { return !segment.isEmpty() && offset >= 0; }
+};
+
+// 指向映射内存的只读帧视图，仅在访问回调内有效
+struct WaveformFrameView {
+    qint64 timestampUs;
+    int sampleRate;
+    int sampleCount;        // 每个导联的采样数
+    const float* samples;   // 导联0的采样，其余导联依次紧随其后
+    int leadCount;
+    quint16 leads;
+
+    const float* lead(int index) const { return samples + qsizetype(index) * sampleCount; }
+};
+
+class WaveformStore {
+public:
+    explicit WaveformStore(const QString& rootPath);
+    ~WaveformStore();
+
+    bool open();
+    // 封存所有写入中的分段
+    void close();
+
+    QString rootPath() const { return m_rootPath; }
+    QString errorString() const;
+
+    // 追加一帧，返回其位置；失败时返回无效位置
+    WaveformLocation append(const QString& deviceId, qint64 timestampUs, const EcgFrame& frame);
+
+    // 读取单帧（从映射内存复制到设备池中的帧）
+    EcgFrame read(const WaveformLocation& location, const QString& deviceId);
+
+    // 按时间顺序遍历 [startUs, endUs] 内的帧，采样直接指向映射内存
+    // visitor返回false时停止；返回访问的帧数
+    int readRange(const QString& deviceId, qint64 startUs, qint64 endUs,
+                  const std::function<bool(const WaveformFrameView&)>& visitor);
+
+    // 从location处的帧起按时间顺序遍历到endUs（一次定位，之后顺序读取；跨整点时继续下一个分段）
+    int readFrom(const WaveformLocation& location, const QString& deviceId, qint64 endUs,
+                 const std::function<bool(const WaveformFrameView&)>& visitor);
+
+    // 存有波形的设备ID
+    QStringList deviceIds() const;
+
+    // 删除整小时都早于cutoffUs的分段文件，返回删除的文件数
+    int removeBefore(qint64 cutoffUs, const QString& deviceId = QString());
+
+    static constexpr qint64 SegmentDurationUs = 3600LL * 1000000;
+
+    struct IndexEntry {
+        qint64 timestampUs;
+        qint64 offset;
+        qint32 sampleCount;
+        qint32 sampleRate;
+    };
+
+private:
+    struct Writer {
+        QString segment;
+        qint64 hourStartUs = 0;
+        QFile file;
+        QVector<IndexEntry> index;
+    };
+
+    struct MappedSegment {
+        QFile file;
+        const uchar* data = nullptr;
+        qint64 size = 0;
+        quint32 version = 0;
+        QVector<IndexEntry> scannedIndex;   // 未封存时扫描得到，或按时间重排的索引
+        const IndexEntry* index = nullptr;
+        int indexCount = 0;
+
+        ~MappedSegment();
+    };
+    using MappedSegmentPtr = QSharedPointer<MappedSegment>;
+
+    static QString deviceDirectory(const QString& deviceId);
+    static qint64 hourStart(qint64 timestampUs);
+    static QString segmentName(const QString& deviceId, qint64 hourStartUs, int sequence = 0);
+    // 文件名对应的小时起点，无效时返回-1；sequence为续写序号（首个分段为0）
+    static qint64 parseSegmentHour(const QString& fileName, int* sequence = nullptr);
+
+    // 调用方需持有m_mutex
+    Writer* writerFor(const QString& deviceId, qint64 hourStartUs);
+    // 在该小时第一个未使用的文件名上创建分段
+    Writer* createWriter(const QString& deviceId, qint64 hourStartUs);
+    void sealWriter(Writer* writer);
+    // 写入中分段已写入的长度，不在写入时返回0
+    qint64 writtenSize(const QString& deviceId, const QString& segment) const;
+
+    // 调用方需持有m_mutex
+    MappedSegmentPtr mapSegment(const QString& segment, qint64 minSize);
+    void dropMapping(const QString& segment);
+
+    // 依次访问索引项[it, end)中不晚于endUs的记录；visitor要求停止时返回false
+    static bool visitRecords(const MappedSegment& mapped, const IndexEntry* it, const IndexEntry* end,
+                             qint64 endUs, const std::function<bool(const WaveformFrameView&)>& visitor,
+                             int& visited, qint64& lastUs);
+    // 同一小时的多个分段按时间戳合并访问[startUs, endUs]（时间相同时先访问序号小的分段）
+    static bool visitMerged(const QVector<MappedSegmentPtr>& segments, qint64 startUs, qint64 endUs,
+                            const std::function<bool(const WaveformFrameView&)>& visitor,
+                            int& visited, qint64& lastUs);
+    static bool frameView(const MappedSegment& mapped, const IndexEntry& entry, WaveformFrameView& view);
+    static bool scanRecords(const uchar* data, qint64 size, quint32 version,
+                            QVector<IndexEntry>& index, qint64& validEnd);
+    static bool readTrailer(const uchar* data, qint64 size, qint64& indexOffset, quint32& entryCount);
+
+    static constexpr int MaxMappedSegments = 32;
+
+    QString m_rootPath;
+    mutable QMutex m_mutex;
+    QHash<QString, Writer*> m_writers;              // 设备ID -> 当前写入分段
+    QHash<QString, Writer*> m_lateWriters;          // 设备ID -> 更早小时迟到帧的续写分段
+    QHash<QString, MappedSegmentPtr> m_mapped;      // 分段路径 -> 映射
+    QList<QString> m_mappedOrder;                   // 映射的最近使用顺序
+    QString m_error;
+};
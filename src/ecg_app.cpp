@@ -1,8 +1,13 @@
 #include "ecg_app.h"
+#include "PipelineMetrics.h"
+#include "CsvExporter.h"
+#include "EdfExporter.h"
+#include "StartupTrace.h"
 #include <QSettings>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QInputDialog>
+#include <QProgressDialog>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QSplitter>
@@ -10,37 +15,88 @@
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QLineEdit>
 #include <QtWidgets/QSpinBox>
+#include <QtWidgets/QCheckBox>
 #include <QTabWidget>
+#include <QTimer>
+
+namespace {
+
+// 后台导出的进度框与结果提示（CsvExporter/EdfExporter）
+void runExport(QWidget* parent, FileExporter* exporter, const QString& unit) {
+    auto* dialog = new QProgressDialog("正在导出数据...", "取消", 0, 100, parent);
+    dialog->setWindowModality(Qt::WindowModal);
+    dialog->setMinimumDuration(500);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    // Esc关闭进度框时即被删除，之后的信号不能再访问它
+    const QPointer<QProgressDialog> progressDialog(dialog);
+    
+    QObject::connect(dialog, &QProgressDialog::canceled, exporter, &FileExporter::cancel);
+    QObject::connect(exporter, &FileExporter::progress, dialog, [dialog, unit](qint64 count, int percent) {
+        dialog->setLabelText(QString("正在导出数据... 已导出 %1 %2").arg(count).arg(unit));
+        dialog->setValue(percent);
+    });
+    QObject::connect(exporter, &FileExporter::finished, parent,
+                     [parent, exporter, progressDialog, unit](bool success, qint64 count, const QString& error) {
+        const bool cancelled = !progressDialog || progressDialog->wasCanceled();
+        if (progressDialog) {
+            progressDialog->close();
+        }
+        if (success) {
+            QMessageBox::information(parent, "导出", QString("数据导出成功，共 %1 %2").arg(count).arg(unit));
+        } else if (!cancelled) {
+            QMessageBox::warning(parent, "导出", "数据导出失败: " + error);
+        }
+        exporter->deleteLater();
+    });
+}
+
+} // namespace
 
 ecg_app::ecg_app(QWidget* parent)
     : QMainWindow(parent)
     , ui(new Ui_ecg_app)
+    , m_powerPolicy(nullptr)
+    , m_historyChart(nullptr)
+    , m_eventBrowser(nullptr)
     , m_mqttHost("47.115.148.200")
     , m_mqttPort(1883)
     , m_cloudServerUrl("https://ecg-cloud.com")
+    , m_metricsDumpIntervalMs(10000)
+    , m_firstPainted(false)
+    , m_databaseReady(false)
 {
-    qDebug() << "ecg_app: Constructor starting...";
-    qDebug() << "ecg_app: Setting up UI...";
+    StartupTrace* trace = StartupTrace::instance();
+    
+    trace->begin("setup_ui");
     ui->setupUi(this);
-    qDebug() << "ecg_app: UI setup complete";
+    trace->end("setup_ui");
     
-    qDebug() << "initializeModules: Starting...";
+    trace->begin("modules");
     initializeModules();
-    qDebug() << "initializeModules: Complete";
+    trace->end("modules");
     
-    qDebug() << "setupUI: Starting...";
+    // 热窗口长度、保留策略须在数据库初始化之前设置
+    trace->begin("settings");
+    loadSettings();
+    trace->end("settings");
+    
+    // 建表、升级与热窗口读取在工作线程中进行，与界面构建并行
+    connect(m_database, &DatabaseManager::initialized, this, [this](bool success) {
+        m_databaseReady = true;
+        if (!success) {
+            statusBar()->showMessage("数据库初始化失败", 5000);
+        }
+        finishStartupIfReady();
+    });
+    m_database->initializeAsync();
+    
+    trace->begin("build_views");
     setupUI();
-    qDebug() << "setupUI: Complete";
+    trace->end("build_views");
     
-    qDebug() << "connectSignals: Starting...";
+    trace->begin("connect_signals");
     connectSignals();
-    qDebug() << "connectSignals: Complete";
-    
-    qDebug() << "loadSettings: Starting...";
-    loadSettings();
-    qDebug() << "loadSettings: Complete";
-    
-    qDebug() << "ecg_app: Constructor completed successfully";
+    trace->end("connect_signals");
 }
 
 ecg_app::~ecg_app()
@@ -58,19 +114,24 @@ void ecg_app::initializeModules() {
 #endif
     
     qDebug() << "initializeModules: Creating DatabaseManager...";
-    // 初始化数据库
+    // 数据库在读取设置后异步初始化
     m_database = new DatabaseManager(this);
-    qDebug() << "initializeModules: Initializing database...";
-    m_database->initialize();
-    qDebug() << "initializeModules: Database initialized";
+    
+    // 本地ECG分析（信号质量、QRS检测、技术报警）
+    m_ecgAnalyzer = new EcgAnalyzer(this);
     
     qDebug() << "initializeModules: Creating CloudSyncManager...";
-    // 初始化云同步
+    // 初始化云同步（首次绘制后启动自动同步）
     m_cloudSync = new CloudSyncManager(this);
-    m_cloudSync->setServerUrl(m_cloudServerUrl);
-    m_cloudSync->enableAutoSync(true, 5); // 每5分钟自动同步
     qDebug() << "initializeModules: CloudSyncManager created";
     
+    // 会话录制与回放
+    m_sessionRecorder = new SessionRecorder(this);
+    m_sessionReplayer = new SessionReplayer(this);
+    
+    // 供电与前后台状态决定刷新率和批量
+    m_powerPolicy = new PowerPolicy(this);
+    
     qDebug() << "initializeModules: Creating ChartWidget (realtime)...";
     // 初始化UI组件
     m_realtimeChart = new ChartWidget(this);
@@ -80,13 +141,15 @@ void ecg_app::initializeModules() {
     m_ecgWaveform = new ECGWaveformWidget(this);
     qDebug() << "initializeModules: ECGWaveformWidget created";
     
+    // 实时频谱图（噪声来源分析）
+    m_spectrogram = new SpectrogramWidget(this);
+    
+    // 中央站多床位总览
+    m_centralStation = new CentralStationWidget(this);
+    
     qDebug() << "initializeModules: Creating VitalSignPanel...";
     m_vitalSignPanel = new VitalSignPanel(this);
     qDebug() << "initializeModules: VitalSignPanel created";
-    
-    qDebug() << "initializeModules: Creating ChartWidget (history)...";
-    m_historyChart = new ChartWidget(this);
-    qDebug() << "initializeModules: ChartWidget (history) created";
 }
 
 void ecg_app::setupUI() {
@@ -103,6 +166,7 @@ void ecg_app::setupUI() {
     QWidget* chartContainer = new QWidget();
     QVBoxLayout* chartLayout = new QVBoxLayout(chartContainer);
     chartLayout->addWidget(m_ecgWaveform, 2);
+    chartLayout->addWidget(m_spectrogram, 1);
     chartLayout->addWidget(m_realtimeChart, 1);
     splitter->addWidget(chartContainer);
     
@@ -110,6 +174,10 @@ void ecg_app::setupUI() {
     splitter->setStretchFactor(1, 3);
     
     realtimeLayout->addWidget(splitter);
+    m_ecgWaveform->start();
+    
+    // 中央站标签页
+    ui->tabWidget->insertTab(ui->tabWidget->indexOf(ui->tab_history), m_centralStation, "中央站");
     
     // 历史查询标签页
     QWidget* historyTab = ui->tab_history;
@@ -119,22 +187,39 @@ void ecg_app::setupUI() {
     QHBoxLayout* queryLayout = new QHBoxLayout();
     QPushButton* btnQuery = new QPushButton("查询", historyTab);
     QPushButton* btnExport = new QPushButton("导出CSV", historyTab);
+    QPushButton* btnHrv = new QPushButton("HRV报告", historyTab);
+    QCheckBox* chkFollowLive = new QCheckBox("跟随实时", historyTab);
     queryLayout->addStretch();
+    queryLayout->addWidget(chkFollowLive);
     queryLayout->addWidget(btnQuery);
     queryLayout->addWidget(btnExport);
+    queryLayout->addWidget(btnHrv);
     
     historyLayout->addLayout(queryLayout);
-    historyLayout->addWidget(m_historyChart);
-    
-    connect(btnQuery, &QPushButton::clicked, this, [this]() {
-        // 查询最近24小时的数据
-        QDateTime endTime = QDateTime::currentDateTime();
-        QDateTime startTime = endTime.addDays(-1);
-        auto historyData = m_database->queryVitalSigns(startTime, endTime);
-        m_historyChart->loadHistoryData(historyData);
+    
+    // 趋势图与事件浏览在首次切换到本页时创建
+    connect(ui->tabWidget, &QTabWidget::currentChanged, this, [this](int index) {
+        if (ui->tabWidget->widget(index) == ui->tab_history) {
+            ensureHistoryView();
+        }
+    });
+    if (ui->tabWidget->currentWidget() == ui->tab_history) {
+        ensureHistoryView();
+    }
+    connect(btnQuery, &QPushButton::clicked, this, &ecg_app::queryHistory);
+    
+    // 跟随实时：载入一次最近24小时，此后由提交的帧增量追加，不再整体重建
+    connect(chkFollowLive, &QCheckBox::toggled, this, [this, btnQuery](bool enabled) {
+        ensureHistoryView();
+        m_historyChart->setFollowLive(enabled, 24LL * 3600 * 1000);
+        btnQuery->setEnabled(!enabled);
+        if (enabled) {
+            queryHistory();
+        }
     });
     
     connect(btnExport, &QPushButton::clicked, this, &ecg_app::onExportData);
+    connect(btnHrv, &QPushButton::clicked, this, &ecg_app::onHrvReport);
     
     // 设置标签页
     QWidget* settingsTab = ui->tab_settings;
@@ -163,11 +248,84 @@ void ecg_app::setupUI() {
         QMessageBox::information(this, "设置", "设置已保存");
     });
     
+    // 会话录制/回放
+    QAction* actionRecord = new QAction("录制会话", this);
+    actionRecord->setCheckable(true);
+    QAction* actionReplay = new QAction("回放会话...", this);
+    ui->menuFile->insertAction(ui->actionExit, actionRecord);
+    ui->menuFile->insertAction(ui->actionExit, actionReplay);
+    ui->menuFile->insertSeparator(ui->actionExit);
+    connect(actionRecord, &QAction::toggled, this, &ecg_app::onToggleRecording);
+    connect(actionReplay, &QAction::triggered, this, &ecg_app::onReplaySession);
+    
+    // 性能监视浮层 (Ctrl+Shift+M)
+    m_metricsOverlay = new MetricsOverlay(ui->centralwidget);
+    QAction* actionMetrics = new QAction("性能监视", this);
+    actionMetrics->setShortcut(QKeySequence("Ctrl+Shift+M"));
+    ui->menuHelp->addAction(actionMetrics);
+    connect(actionMetrics, &QAction::triggered, m_metricsOverlay, &MetricsOverlay::toggle);
+    
     // 设置状态栏
     statusBar()->showMessage("就绪");
 }
 
+void ecg_app::ensureHistoryView() {
+    if (m_historyChart) return;
+    StartupTrace::Scope trace("history_view");
+    
+    m_historyChart = new ChartWidget(this);
+    m_historyChart->setDisplayMode(ChartWidget::HeartRateTrend);
+    m_historyChart->setLivePaused(m_powerProfile.renderingPaused);
+    
+    // 报警与心律事件浏览
+    m_eventBrowser = new EventBrowser(m_database, this);
+    
+    QSplitter* historySplitter = new QSplitter(Qt::Vertical, ui->tab_history);
+    historySplitter->addWidget(m_historyChart);
+    historySplitter->addWidget(m_eventBrowser);
+    historySplitter->setStretchFactor(0, 3);
+    historySplitter->setStretchFactor(1, 2);
+    ui->tab_history->layout()->addWidget(historySplitter);
+    
+    connect(m_database, &DatabaseManager::vitalSignCommitted, m_historyChart, &ChartWidget::appendCommitted);
+    // 数据库尚未就绪时打开的页面在就绪后补查
+    connect(m_database, &DatabaseManager::initialized, m_eventBrowser, [this](bool success) {
+        if (success && m_eventBrowser->isVisible()) {
+            m_eventBrowser->refresh();
+        }
+    });
+}
+
+void ecg_app::queryHistory() {
+    ensureHistoryView();
+    // 查询最近24小时的数据
+    QDateTime endTime = QDateTime::currentDateTime();
+    QDateTime startTime = endTime.addDays(-1);
+    
+    // 跟随实时：由数据库按图表的桶长聚合，整个窗口每桶一行，不受明细条数上限截断
+    if (m_historyChart->isFollowingLive()) {
+        m_database->queryTrendBucketsAsync(startTime, endTime, m_historyChart->followBucketMs())
+            .then(this, [this](const QVector<VitalTrendBucket>& buckets) {
+                m_historyChart->loadTrendBuckets(buckets);
+            });
+        return;
+    }
+    
+    // 在只读连接池中查询，重复点击时取消上一次查询
+    m_database->queryVitalSignsAsync(startTime, endTime)
+        .then(this, [this](const QVector<VitalSignData>& historyData) {
+            m_historyChart->loadHistoryData(historyData);
+        });
+}
+
 void ecg_app::connectSignals() {
+    connect(m_ecgAnalyzer, &EcgAnalyzer::alarmRaised,
+            this, &ecg_app::onAlarmReceived);
+    connect(m_ecgAnalyzer, &EcgAnalyzer::morphologyMeasured,
+            m_database, &DatabaseManager::saveMorphologyTrend);
+    connect(m_ecgAnalyzer, &EcgAnalyzer::rhythmEpisodeFinished,
+            m_database, &DatabaseManager::saveRhythmEpisode);
+    
 #ifndef NO_MQTT_SUPPORT
     // MQTT信号
     connect(m_mqttClient, &MqttClientManager::vitalSignReceived,
@@ -176,8 +334,34 @@ void ecg_app::connectSignals() {
             this, &ecg_app::onAlarmReceived);
     connect(m_mqttClient, &MqttClientManager::connectionStateChanged,
             this, &ecg_app::onMqttConnected);
+    
+    // 回放消息走与实时接收完全相同的解析/分发路径
+    connect(m_sessionReplayer, &SessionReplayer::messageReplayed, this,
+            [this](const QByteArray& payload, const QString& topic) {
+        m_mqttClient->injectMessage(payload, topic);
+    });
 #endif
     
+    connect(m_sessionReplayer, &SessionReplayer::finished, this,
+            [this](qint64 frames, qint64 elapsedMs, double framesPerSecond) {
+        statusBar()->showMessage(QString("回放完成: %1帧 耗时%2ms (%3帧/秒)")
+                                 .arg(frames).arg(elapsedMs).arg(framesPerSecond, 0, 'f', 1));
+    });
+    connect(m_sessionReplayer, &SessionReplayer::errorOccurred, this, [this](const QString& error) {
+        QMessageBox::warning(this, "回放", error);
+    });
+    connect(m_sessionRecorder, &SessionRecorder::errorOccurred, this, [this](const QString& error) {
+        statusBar()->showMessage(error, 5000);
+    });
+    
+    // 合并写入时按实际提交时刻统计
+    connect(m_database, &DatabaseManager::vitalSignCommitted, this, [](const VitalSignData& data) {
+        PipelineMetrics::instance()->recordStage(PipelineMetrics::DbCommit, data.receivedAtNs);
+    });
+    
+    connect(m_powerPolicy, &PowerPolicy::modeChanged, this, &ecg_app::applyPowerMode);
+    applyPowerMode(m_powerPolicy->mode());
+    
     // 云同步信号
     connect(m_cloudSync, &CloudSyncManager::uploadCompleted,
             this, &ecg_app::onUploadCompleted);
@@ -201,6 +385,41 @@ void ecg_app::loadSettings() {
     m_mqttHost = settings.value("mqtt/host", "localhost").toString();
     m_mqttPort = settings.value("mqtt/port", 1883).toInt();
     m_cloudServerUrl = settings.value("cloud/server", "https://ecg-cloud.com").toString();
+    m_metricsDumpPath = settings.value("debug/metricsDumpPath", "").toString();
+    m_metricsDumpIntervalMs = settings.value("debug/metricsDumpIntervalMs", 10000).toInt();
+    
+    if (!m_metricsDumpPath.isEmpty()) {
+        PipelineMetrics::instance()->startPeriodicDump(m_metricsDumpPath, m_metricsDumpIntervalMs);
+    }
+    
+    // 数据保留策略，[retention/devices] 下按设备ID覆盖生理数据保留天数
+    RetentionPolicy policy;
+    policy.vitalDays = settings.value("retention/vitalDays", policy.vitalDays).toInt();
+    policy.alarmDays = settings.value("retention/alarmDays", policy.alarmDays).toInt();
+    settings.beginGroup("retention/devices");
+    const QStringList devices = settings.childKeys();
+    for (const QString& deviceId : devices) {
+        policy.deviceVitalDays.insert(deviceId, settings.value(deviceId).toInt());
+    }
+    settings.endGroup();
+    m_database->setRetentionPolicy(policy);
+    m_database->setHotWindow(settings.value("cache/hotWindowMinutes", 15).toLongLong() * 60 * 1000,
+                             settings.value("cache/hotWindowMB", 64).toLongLong() * 1024 * 1024);
+    m_ecgAnalyzer->setHeartRateLimits(settings.value("alarm/lowHeartRate", 40).toInt(),
+                                      settings.value("alarm/highHeartRate", 150).toInt());
+    EcgAnalyzer::MorphologyLimits morphologyLimits;
+    morphologyLimits.stMv = settings.value("alarm/stDeviationMv", morphologyLimits.stMv).toDouble();
+    morphologyLimits.qtcMs = settings.value("alarm/qtcMs", morphologyLimits.qtcMs).toDouble();
+    morphologyLimits.qrsMs = settings.value("alarm/qrsMs", morphologyLimits.qrsMs).toDouble();
+    m_ecgAnalyzer->setMorphologyLimits(morphologyLimits);
+    m_ecgAnalyzer->setPauseThreshold(settings.value("alarm/pauseMs", 2000).toInt());
+    m_database->startRetentionSchedule(settings.value("retention/intervalHours", 6).toInt() * 3600 * 1000);
+    
+    // 供电来源：auto按系统检测，mains/battery强制（无法读取电源状态的设备）
+    const QString powerSource = settings.value("power/source", "auto").toString();
+    m_powerPolicy->setPowerSource(powerSource == "battery" ? PowerPolicy::ForceBattery
+                                  : powerSource == "mains" ? PowerPolicy::ForceMains
+                                                           : PowerPolicy::AutoDetect);
 }
 
 void ecg_app::saveSettings() {
@@ -210,7 +429,65 @@ void ecg_app::saveSettings() {
     settings.setValue("cloud/server", m_cloudServerUrl);
 }
 
-void ecg_app::onVitalSignReceived(const VitalSignData& data) {
+void ecg_app::changeEvent(QEvent* event) {
+    QMainWindow::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange && m_powerPolicy) {
+        m_powerPolicy->setWindowMinimized(isMinimized());
+    }
+}
+
+void ecg_app::paintEvent(QPaintEvent* event) {
+    QMainWindow::paintEvent(event);
+    if (!m_firstPainted) {
+        m_firstPainted = true;
+        // 本轮绘制（含子部件）完成后
+        QTimer::singleShot(0, this, &ecg_app::onFirstPaint);
+    }
+}
+
+void ecg_app::onFirstPaint() {
+    StartupTrace::instance()->end("first_paint");
+    
+    m_cloudSync->setServerUrl(m_cloudServerUrl);
+    m_cloudSync->enableAutoSync(true, 5); // 每5分钟自动同步
+    finishStartupIfReady();
+}
+
+void ecg_app::finishStartupIfReady() {
+    if (m_firstPainted && m_databaseReady) {
+        StartupTrace::instance()->finish();
+    }
+}
+
+void ecg_app::applyPowerMode(PowerPolicy::Mode mode) {
+    m_powerProfile = PowerPolicy::profile(mode);
+    const PowerProfile& profile = m_powerProfile;
+    
+    // 后台停止全部实时绘制；数据照常进入各视图的缓冲，恢复后按最新数据补画
+    m_ecgWaveform->setMinRasterInterval(profile.waveformIntervalMs);
+    if (profile.renderingPaused) {
+        m_ecgWaveform->stop();
+    } else {
+        m_ecgWaveform->start();
+    }
+    m_spectrogram->setRepaintInterval(profile.refreshIntervalMs);
+    m_centralStation->setRefreshInterval(profile.renderingPaused ? 0 : profile.refreshIntervalMs);
+    if (m_historyChart) {
+        m_historyChart->setLivePaused(profile.renderingPaused);
+    }
+    
+    m_database->setWriteCoalescing(profile.dbBatchFrames, profile.dbBatchDelayMs);
+    m_cloudSync->setUploadBatching(profile.uploadBatchFrames, profile.uploadBatchDelayMs);
+}
+
+void ecg_app::onVitalSignReceived(const VitalSignData& received) {
+    PipelineMetrics* metrics = PipelineMetrics::instance();
+    metrics->recordStage(PipelineMetrics::GuiDispatch, received.receivedAtNs);
+    
+    // 先评估信号质量，结果随数据一起显示和保存（帧本身共享，不复制采样）
+    VitalSignData data = received;
+    m_ecgAnalyzer->process(data);
+    
     // 更新显示
     m_vitalSignPanel->updateVitalSigns(data);
     
@@ -219,24 +496,32 @@ void ecg_app::onVitalSignReceived(const VitalSignData& data) {
     
     // 显示ECG波形
     if (!data.ecgSignal.isEmpty()) {
-        m_ecgWaveform->addECGData(data.ecgSignal);
+        m_ecgWaveform->addECGData(data.ecgSignal, data.receivedAtNs, data.signalQuality);
+        m_spectrogram->addECGData(data.deviceId, data.ecgSignal);
     }
+    m_centralStation->updateVitals(data);
     
-    // 保存到数据库
-    m_database->saveVitalSign(data);
+    // 保存到数据库（电池/后台时合并提交）
+    m_database->enqueueVitalSign(data);
     
     // 上传到云端（队列）
     m_cloudSync->uploadVitalSign(data);
     
-    statusBar()->showMessage(QString("收到数据: 体温=%1°C 心率=%2bpm 血氧=%3%")
-                             .arg(data.temperature, 0, 'f', 1)
-                             .arg(data.heartRate)
-                             .arg(data.oxygenSaturation));
+    // 状态栏每个刷新周期最多更新一次，后台不更新
+    if (!m_powerProfile.renderingPaused &&
+        (!m_statusClock.isValid() || m_statusClock.elapsed() >= m_powerProfile.refreshIntervalMs)) {
+        m_statusClock.start();
+        statusBar()->showMessage(QString("收到数据: 体温=%1°C 心率=%2bpm 血氧=%3%")
+                                 .arg(data.temperature, 0, 'f', 1)
+                                 .arg(data.heartRate)
+                                 .arg(data.oxygenSaturation));
+    }
 }
 
 void ecg_app::onAlarmReceived(const AlarmInfo& alarm) {
     // 显示报警
     m_vitalSignPanel->showAlarm(alarm);
+    m_centralStation->showAlarm(alarm);
     
     // 保存到数据库
     m_database->saveAlarm(alarm);
@@ -244,8 +529,16 @@ void ecg_app::onAlarmReceived(const AlarmInfo& alarm) {
     // 上传到云端
     m_cloudSync->uploadAlarm(alarm);
     
-    // 显示提示框
-    QMessageBox::warning(this, "报警", alarm.message);
+    // 非模态提示框：模态框的事件循环会在接收路径中重入数据处理；连续的报警更新同一个提示框
+    if (!m_alarmBox) {
+        m_alarmBox = new QMessageBox(QMessageBox::Warning, "报警", alarm.message, QMessageBox::Ok, this);
+        m_alarmBox->setWindowModality(Qt::NonModal);
+        m_alarmBox->setAttribute(Qt::WA_DeleteOnClose);
+    } else {
+        m_alarmBox->setText(alarm.message);
+    }
+    m_alarmBox->show();
+    m_alarmBox->raise();
     
     statusBar()->showMessage("报警: " + alarm.message, 5000);
 }
@@ -279,17 +572,98 @@ void ecg_app::onDisconnectDevice() {
 }
 
 void ecg_app::onExportData() {
-    QString fileName = QFileDialog::getSaveFileName(this, "导出数据", "", "CSV文件 (*.csv)");
+    const QString csvFilter = "CSV文件 (*.csv)";
+    const QString edfFilter = "EDF+文件 (*.edf)";
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, "导出数据", "", csvFilter + ";;" + edfFilter,
+                                                    &selectedFilter);
     if (fileName.isEmpty()) return;
     
-    QDateTime endTime = QDateTime::currentDateTime();
-    QDateTime startTime = endTime.addDays(-7); // 导出最近7天
+    const QDateTime endTime = QDateTime::currentDateTime();
+    const QDateTime startTime = endTime.addDays(-7); // 导出最近7天
+    bool ok;
     
-    if (m_database->exportToCSV(fileName, startTime, endTime)) {
-        QMessageBox::information(this, "导出", "数据导出成功");
-    } else {
-        QMessageBox::warning(this, "导出", "数据导出失败");
+    if (selectedFilter == edfFilter || fileName.endsWith(".edf", Qt::CaseInsensitive)) {
+        // EDF+ 每个文件对应一台设备
+        const QStringList devices = m_database->waveformStore()->deviceIds();
+        if (devices.isEmpty()) {
+            QMessageBox::information(this, "导出", "没有可导出的波形数据");
+            return;
+        }
+        const QString deviceId = QInputDialog::getItem(this, "导出EDF+", "设备:", devices, 0, false, &ok);
+        if (!ok) return;
+        
+        EdfExporter::Options options;
+        options.filePath = fileName;
+        options.deviceId = deviceId;
+        options.startTime = startTime;
+        options.endTime = endTime;
+        
+        auto* exporter = new EdfExporter(m_database->databasePath(), m_database->waveformStore(), this);
+        runExport(this, exporter, "秒");
+        exporter->start(options);
+        return;
+    }
+    
+    const QStringList layouts = {"不含波形", "含波形（每个采样一行）", "含波形（每帧一行）"};
+    const QString layout = QInputDialog::getItem(this, "导出", "ECG波形:", layouts, 0, false, &ok);
+    if (!ok) return;
+    
+    CsvExporter::Options options;
+    options.filePath = fileName;
+    options.startTime = startTime;
+    options.endTime = endTime;
+    options.waveform = static_cast<CsvExporter::WaveformLayout>(layouts.indexOf(layout));
+    
+    auto* exporter = new CsvExporter(m_database->databasePath(), m_database->waveformStore(), this);
+    runExport(this, exporter, "条");
+    exporter->start(options);
+}
+
+void ecg_app::onHrvReport() {
+    const QStringList devices = m_database->waveformStore()->deviceIds();
+    if (devices.isEmpty()) {
+        QMessageBox::information(this, "HRV报告", "没有可分析的波形数据");
+        return;
     }
+    bool ok;
+    const QString deviceId = QInputDialog::getItem(this, "HRV报告", "设备:", devices, 0, false, &ok);
+    if (!ok) return;
+    
+    // 最近24小时，各小时并行计算
+    const QDateTime endTime = QDateTime::currentDateTime();
+    const QDateTime startTime = endTime.addDays(-1);
+    statusBar()->showMessage("正在计算HRV...");
+    m_database->hrvReportAsync(deviceId, startTime, endTime)
+        .then(this, [this, deviceId](const HrvAnalyzer::Report& report) {
+            statusBar()->clearMessage();
+            const HrvMetrics& m = report.overall;
+            if (!m.isValid()) {
+                QMessageBox::information(this, "HRV报告", "有效心搏不足，无法计算HRV");
+                return;
+            }
+            // 设备ID最后替换，避免其中的%被当作占位符
+            QString text = QString("设备: %7（最近24小时）\n"
+                                   "NN区间: %1（剔除 %2）\n"
+                                   "平均NN: %3 ms\n"
+                                   "SDNN: %4 ms\n"
+                                   "RMSSD: %5 ms\n"
+                                   "pNN50: %6 %")
+                               .arg(m.nnCount)
+                               .arg(m.rejected)
+                               .arg(m.meanNnMs, 0, 'f', 1)
+                               .arg(m.sdnnMs, 0, 'f', 1)
+                               .arg(m.rmssdMs, 0, 'f', 1)
+                               .arg(m.pnn50, 0, 'f', 1)
+                               .arg(deviceId);
+            if (m.hasSpectrum) {
+                text += QString("\nLF: %1 ms²\nHF: %2 ms²\nLF/HF: %3")
+                            .arg(m.lfPower, 0, 'f', 1)
+                            .arg(m.hfPower, 0, 'f', 1)
+                            .arg(m.lfHfRatio, 0, 'f', 2);
+            }
+            QMessageBox::information(this, "HRV报告", text);
+        });
 }
 
 void ecg_app::onSyncToCloud() {
@@ -319,6 +693,55 @@ void ecg_app::onShareData() {
     QMessageBox::information(this, "分享", "分享链接已发送到邮箱");
 }
 
+void ecg_app::onToggleRecording(bool enabled) {
+#ifdef NO_MQTT_SUPPORT
+    Q_UNUSED(enabled);
+    QMessageBox::information(this, "提示", "MQTT功能未启用，无法录制会话");
+#else
+    if (!enabled) {
+        m_mqttClient->setRecorder(nullptr);
+        m_sessionRecorder->close();
+        statusBar()->showMessage(QString("录制结束: %1条消息").arg(m_sessionRecorder->recordCount()), 5000);
+        return;
+    }
+    
+    QString fileName = QFileDialog::getSaveFileName(this, "录制会话", "", "ECG录制文件 (*.ecgcap)");
+    if (fileName.isEmpty() || !m_sessionRecorder->open(fileName)) {
+        QSignalBlocker blocker(sender());
+        qobject_cast<QAction*>(sender())->setChecked(false);
+        return;
+    }
+    
+    m_mqttClient->setRecorder(m_sessionRecorder);
+    statusBar()->showMessage("正在录制: " + fileName);
+#endif
+}
+
+void ecg_app::onReplaySession() {
+#ifdef NO_MQTT_SUPPORT
+    QMessageBox::information(this, "提示", "MQTT功能未启用，无法回放会话");
+#else
+    if (m_sessionReplayer->isRunning()) {
+        m_sessionReplayer->stop();
+        return;
+    }
+    
+    QString fileName = QFileDialog::getOpenFileName(this, "回放会话", "", "ECG录制文件 (*.ecgcap)");
+    if (fileName.isEmpty()) return;
+    
+    bool ok;
+    double speed = QInputDialog::getDouble(this, "回放会话", "回放倍速 (0 = 最快):",
+                                           1.0, 0.0, 1000.0, 1, &ok);
+    if (!ok) return;
+    
+    if (m_sessionReplayer->open(fileName)) {
+        m_sessionReplayer->setSpeed(speed);
+        m_sessionReplayer->start();
+        statusBar()->showMessage("正在回放: " + fileName);
+    }
+#endif
+}
+
 void ecg_app::onUploadCompleted(bool success) {
     if (success) {
         statusBar()->showMessage("数据同步成功", 3000);
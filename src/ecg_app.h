@@ -1,6 +1,9 @@
 #pragma once
 #include "ui_ecg_app.h"
 #include <QMainWindow>
+#include <QElapsedTimer>
+#include <QMessageBox>
+#include <QPointer>
 
 #ifndef NO_MQTT_SUPPORT
 #include "MqttClientManager.h"
@@ -9,6 +12,11 @@
 #include "DatabaseManager.h"
 #include "ChartWidget.h"
 #include "CloudSyncManager.h"
+#include "EcgAnalyzer.h"
+#include "EventBrowser.h"
+#include "MetricsOverlay.h"
+#include "PowerPolicy.h"
+#include "SessionCapture.h"
 
 class ecg_app : public QMainWindow {
     Q_OBJECT
@@ -17,6 +25,10 @@ public:
     ecg_app(QWidget* parent = nullptr);
     ~ecg_app();
 
+protected:
+    void changeEvent(QEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+
 private slots:
     // MQTT相关
     void onVitalSignReceived(const VitalSignData& data);
@@ -27,8 +39,11 @@ private slots:
     void onConnectDevice();
     void onDisconnectDevice();
     void onExportData();
+    void onHrvReport();
     void onSyncToCloud();
     void onShareData();
+    void onToggleRecording(bool enabled);
+    void onReplaySession();
     
     // 云同步
     void onUploadCompleted(bool success);
@@ -43,12 +58,21 @@ private:
 #endif
     DatabaseManager* m_database;
     CloudSyncManager* m_cloudSync;
+    EcgAnalyzer* m_ecgAnalyzer;
+    SessionRecorder* m_sessionRecorder;
+    SessionReplayer* m_sessionReplayer;
+    PowerPolicy* m_powerPolicy;
     
     // UI组件
     ChartWidget* m_realtimeChart;
     ECGWaveformWidget* m_ecgWaveform;
+    SpectrogramWidget* m_spectrogram;
+    CentralStationWidget* m_centralStation;
     VitalSignPanel* m_vitalSignPanel;
     ChartWidget* m_historyChart;
+    EventBrowser* m_eventBrowser;
+    MetricsOverlay* m_metricsOverlay;
+    QPointer<QMessageBox> m_alarmBox;   // 当前显示的报警提示
     
     // 初始化函数
     void initializeModules();
@@ -57,8 +81,27 @@ private:
     void loadSettings();
     void saveSettings();
     
+    // 按功耗档位调整刷新周期、写入与上传批量
+    void applyPowerMode(PowerPolicy::Mode mode);
+    
+    // 历史趋势图与事件浏览在首次打开历史页时创建
+    void ensureHistoryView();
+    void queryHistory();
+    
+    // 启动：窗口首次绘制后再启动云同步；首次绘制与数据库就绪都完成时结束启动剖析
+    void onFirstPaint();
+    void finishStartupIfReady();
+    
     // 设置项
     QString m_mqttHost;
     quint16 m_mqttPort;
     QString m_cloudServerUrl;
+    QString m_metricsDumpPath;      // 为空则不输出指标文件
+    int m_metricsDumpIntervalMs;
+    
+    PowerProfile m_powerProfile;
+    QElapsedTimer m_statusClock;    // 上一次更新状态栏数据
+    
+    bool m_firstPainted;
+    bool m_databaseReady;
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "ecg_app.h"
+#include "StartupTrace.h"
 
 #include <QApplication>
 #include <QDebug>
@@ -34,17 +35,25 @@ void messageHandler(QtMsgType type, const QMessageLogContext &context, const QSt
 
 int main(int argc, char *argv[])
 {
+    StartupTrace* trace = StartupTrace::instance();
+    trace->start();
     qInstallMessageHandler(messageHandler);
     qDebug() << "=== ECG App Starting ===";
     
+    trace->begin("qapplication");
     QApplication a(argc, argv);
     a.setApplicationName("ECG监护系统");
     a.setApplicationVersion("1.0");
+    trace->end("qapplication");
     
     qDebug() << "Creating main window...";
+    trace->begin("main_window");
     ecg_app w;
+    trace->end("main_window");
     
+    // 到窗口首次绘制完成为止，由主窗口结束
     qDebug() << "Showing window...";
+    trace->begin("first_paint");
     w.show();
     
     qDebug() << "Entering event loop...";
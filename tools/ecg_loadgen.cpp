@@ -0,0 +1,502 @@
+// ecg_loadgen: 多设备高速率负载生成器
+//
+// 模拟N台设备按各自主题 (ecg/vitalsign/<deviceId>) 发布生理数据，
+// 支持最高1kHz采样率、突发/抖动发送模式和报警风暴，每秒报告实际发布速率，
+// 用于寻找应用的饱和点。
+//
+// 输出方式:
+//   1. 通过QtMqtt发布到Broker（默认）
+//   2. --capture <文件> 直接生成录制文件，由应用"回放会话"注入处理链路（无需Broker）
+//
+// 示例:
+//   ecg_loadgen --devices 200 --rate 500 --frame-ms 200 --jitter-ms 20 --duration 60
+//   ecg_loadgen --devices 50 --rate 1000 --alarm-storm 10,5,20 --capture storm.ecgcap
+//   ecg_loadgen --devices 50 --alarm-rate 0.01 --alarm-storm 10,5,20 --self-check
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QMqttClient>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QTimer>
+#include <QtMath>
+#include <cmath>
+#include <limits>
+
+#include "VitalSignData.h"
+#include "SessionCapture.h"
+
+namespace {
+
+QTextStream& out() {
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+struct LoadConfig {
+    QString host = "localhost";
+    quint16 port = 1883;
+    QString topicPrefix = "ecg";
+    int qos = 0;
+    int devices = 10;
+    int sampleRate = 100;       // Hz
+    int frameMs = 1000;         // 每帧时长
+    int durationSec = 60;
+    int jitterMs = 0;           // 每帧发送时间随机偏移 ±jitter
+    int burst = 1;              // 每次突发合并发送的帧数
+    double alarmRate = 0.0;     // 常规报警速率（每设备每秒）
+    double stormStartSec = -1;  // 报警风暴开始时间
+    double stormLengthSec = 0;
+    double stormRate = 0.0;     // 风暴期间报警速率（每设备每秒）
+    QString capturePath;        // 非空则写录制文件而不发布
+
+    bool hasStorm() const { return stormStartSec >= 0 && stormRate > 0; }
+};
+
+struct DeviceState {
+    QString deviceId;
+    QString vitalTopic;
+    QString alarmTopic;
+    double heartRate = 72.0;
+    qint64 startOffsetNs = 0;
+    qint64 frameIndex = 0;
+    qint64 nextDueNs = 0;
+    qint64 nextAlarmNs = 0;
+};
+
+// 每秒统计
+struct RateWindow {
+    qint64 frames = 0;
+    qint64 alarms = 0;
+    qint64 samples = 0;
+    qint64 bytes = 0;
+    qint64 failures = 0;
+    qint64 maxLagNs = 0;
+
+    void reset() { *this = RateWindow(); }
+};
+
+class LoadGenerator : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LoadGenerator(const LoadConfig& config, QObject* parent = nullptr)
+        : QObject(parent)
+        , m_config(config)
+        , m_client(nullptr)
+        , m_recorder(nullptr)
+        , m_tickTimer(new QTimer(this))
+        , m_reportTimer(new QTimer(this))
+        , m_startEpochUs(0)
+        , m_lastReportNs(0)
+    {
+        const qint64 periodNs = frameNs();
+        for (int i = 0; i < m_config.devices; ++i) {
+            DeviceState device;
+            device.deviceId = QString("dev%1").arg(i + 1, 4, 10, QChar('0'));
+            device.vitalTopic = QString("%1/vitalsign/%2").arg(m_config.topicPrefix, device.deviceId);
+            device.alarmTopic = QString("%1/alarm/%2").arg(m_config.topicPrefix, device.deviceId);
+            device.heartRate = 60 + QRandomGenerator::global()->bounded(40);
+            // 起始相位均匀错开，避免所有设备同时发送
+            device.startOffsetNs = periodNs * i / qMax(1, m_config.devices);
+            device.nextDueNs = dueTimeNs(device);
+            device.nextAlarmNs = nextAlarmAfter(device.startOffsetNs);
+            m_devices.append(device);
+        }
+
+        m_tickTimer->setTimerType(Qt::PreciseTimer);
+        connect(m_tickTimer, &QTimer::timeout, this, &LoadGenerator::onTick);
+        connect(m_reportTimer, &QTimer::timeout, this, &LoadGenerator::onReport);
+    }
+
+    void start() {
+        if (!m_config.capturePath.isEmpty()) {
+            runCapture();
+            return;
+        }
+
+        m_client = new QMqttClient(this);
+        m_client->setHostname(m_config.host);
+        m_client->setPort(m_config.port);
+        m_client->setClientId(QString("ecg_loadgen_%1").arg(QCoreApplication::applicationPid()));
+
+        connect(m_client, &QMqttClient::connected, this, [this]() {
+            out() << "Connected to " << m_config.host << ":" << m_config.port << Qt::endl;
+            m_startEpochUs = SessionRecorder::currentEpochUs();
+            m_clock.start();
+            m_tickTimer->start(1);
+            m_reportTimer->start(1000);
+        });
+        connect(m_client, &QMqttClient::errorChanged, this, [this](QMqttClient::ClientError error) {
+            if (error != QMqttClient::NoError) {
+                out() << "MQTT error: " << static_cast<int>(error) << Qt::endl;
+                emit finished(1);
+            }
+        });
+
+        m_client->connectToHost();
+    }
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void onTick() {
+        const qint64 nowNs = m_clock.nsecsElapsed();
+        generateUntil(nowNs, nowNs);
+
+        if (nowNs >= qint64(m_config.durationSec) * 1000000000) {
+            m_tickTimer->stop();
+            onReport();
+            printSummary();
+            m_client->disconnectFromHost();
+            emit finished(0);
+        }
+    }
+
+    void onReport() {
+        const qint64 nowNs = m_clock.nsecsElapsed();
+        const double seconds = qMax<qint64>(1, nowNs - m_lastReportNs) / 1e9;
+        m_lastReportNs = nowNs;
+
+        out() << QString("[%1s] frames/s=%2 samples/s=%3 alarms/s=%4 MB/s=%5 fail=%6 maxLag=%7ms")
+                     .arg(nowNs / 1000000000, 4)
+                     .arg(m_window.frames / seconds, 0, 'f', 1)
+                     .arg(m_window.samples / seconds, 0, 'f', 0)
+                     .arg(m_window.alarms / seconds, 0, 'f', 1)
+                     .arg(m_window.bytes / seconds / (1024.0 * 1024.0), 0, 'f', 2)
+                     .arg(m_window.failures)
+                     .arg(m_window.maxLagNs / 1e6, 0, 'f', 1)
+              << Qt::endl;
+        m_window.reset();
+    }
+
+private:
+    LoadConfig m_config;
+    QVector<DeviceState> m_devices;
+    QMqttClient* m_client;
+    SessionRecorder* m_recorder;
+    QTimer* m_tickTimer;
+    QTimer* m_reportTimer;
+    QElapsedTimer m_clock;
+    qint64 m_startEpochUs;
+    qint64 m_lastReportNs;
+
+    RateWindow m_window;
+    RateWindow m_total;
+
+    qint64 frameNs() const { return qint64(m_config.frameMs) * 1000000; }
+    int samplesPerFrame() const { return qMax(1, m_config.sampleRate * m_config.frameMs / 1000); }
+
+    // 帧k的发送时刻：突发模式下一组帧在组内最后一帧的时刻一起发出，再叠加随机抖动
+    qint64 dueTimeNs(const DeviceState& device) const {
+        const qint64 burst = qMax(1, m_config.burst);
+        const qint64 groupLast = (device.frameIndex / burst) * burst + burst - 1;
+        qint64 due = device.startOffsetNs + (groupLast + 1) * frameNs();
+        if (m_config.jitterMs > 0) {
+            const qint64 jitterNs = qint64(m_config.jitterMs) * 1000000;
+            due += QRandomGenerator::global()->bounded(2 * jitterNs + 1) - jitterNs;
+        }
+        return due;
+    }
+
+    qint64 stormStartNs() const { return qint64(m_config.stormStartSec * 1e9); }
+    qint64 stormEndNs() const { return qint64((m_config.stormStartSec + m_config.stormLengthSec) * 1e9); }
+
+    bool inStorm(qint64 timeNs) const {
+        return m_config.hasStorm() && timeNs >= stormStartNs() && timeNs < stormEndNs();
+    }
+
+    // timeNs之后报警速率下一次变化的时刻（风暴开始或结束）
+    qint64 nextRateChange(qint64 timeNs) const {
+        if (m_config.hasStorm()) {
+            if (timeNs < stormStartNs()) return stormStartNs();
+            if (timeNs < stormEndNs()) return stormEndNs();
+        }
+        return std::numeric_limits<qint64>::max();
+    }
+
+    // 分段恒定速率的泊松过程生成下一次报警时刻：间隔越过速率变化点时，
+    // 按无记忆性从变化点以新速率重新抽取，常规速率下的长间隔不会跳过整个风暴
+    qint64 nextAlarmAfter(qint64 timeNs) const {
+        qint64 t = timeNs;
+        for (;;) {
+            const double rate = inStorm(t) ? m_config.stormRate : m_config.alarmRate;
+            const qint64 changeNs = nextRateChange(t);
+            if (rate > 0) {
+                const double u = qMax(1e-9, QRandomGenerator::global()->generateDouble());
+                const double stepNs = -std::log(u) / rate * 1e9;
+                if (stepNs < double(changeNs - t)) return t + qint64(stepNs);
+            }
+            if (changeNs == std::numeric_limits<qint64>::max()) return changeNs;
+            t = changeNs;
+        }
+    }
+
+public:
+    // 自检：按虚拟时钟只推进报警时刻（不发布），检查风暴窗口内的报警数符合泊松期望
+    bool selfCheck() {
+        const qint64 endNs = qint64(m_config.durationSec) * 1000000000;
+        qint64 stormAlarms = 0;
+        qint64 otherAlarms = 0;
+        for (DeviceState& device : m_devices) {
+            while (device.nextAlarmNs <= endNs) {
+                if (inStorm(device.nextAlarmNs)) {
+                    stormAlarms++;
+                } else {
+                    otherAlarms++;
+                }
+                device.nextAlarmNs = nextAlarmAfter(device.nextAlarmNs);
+            }
+        }
+
+        const double stormEndSec = qMin(m_config.stormStartSec + m_config.stormLengthSec,
+                                        double(m_config.durationSec));
+        const double stormSec = qMax(0.0, stormEndSec - m_config.stormStartSec);
+        const double expected = m_config.devices * m_config.stormRate * stormSec;
+        // 允许5个标准差的随机偏差
+        const double tolerance = 5.0 * std::sqrt(expected) + 1.0;
+        const bool ok = expected > 0 && qAbs(stormAlarms - expected) <= tolerance;
+        out() << QString("Self-check: %1 storm alarms (expected %2 ± %3), %4 other alarms: %5")
+                     .arg(stormAlarms)
+                     .arg(expected, 0, 'f', 0)
+                     .arg(tolerance, 0, 'f', 0)
+                     .arg(otherAlarms)
+                     .arg(ok ? "OK" : "FAILED")
+              << Qt::endl;
+        return ok;
+    }
+
+private:
+
+    // 生成截至nowNs的所有到期消息；sendNs为实际发送时刻（用于统计滞后）
+    void generateUntil(qint64 nowNs, qint64 sendNs) {
+        for (DeviceState& device : m_devices) {
+            while (device.nextDueNs <= nowNs) {
+                const qint64 lag = sendNs - device.nextDueNs;
+                if (lag > m_window.maxLagNs) m_window.maxLagNs = lag;
+
+                // 突发：一次发出整组帧
+                const int burst = qMax(1, m_config.burst);
+                do {
+                    publishFrame(device, sendNs);
+                    device.frameIndex++;
+                } while (device.frameIndex % burst != 0);
+
+                device.nextDueNs = dueTimeNs(device);
+            }
+
+            while (device.nextAlarmNs <= nowNs) {
+                publishAlarm(device, sendNs);
+                device.nextAlarmNs = nextAlarmAfter(device.nextAlarmNs);
+            }
+        }
+    }
+
+    void publishFrame(DeviceState& device, qint64 sendNs) {
+        const int samples = samplesPerFrame();
+        const qint64 frameStartNs = device.startOffsetNs + device.frameIndex * frameNs();
+
+        VitalSignData data;
+        data.deviceId = device.deviceId;
+        data.timestampUs = m_startEpochUs + frameStartNs / 1000;
+        data.temperature = 36.5 + QRandomGenerator::global()->bounded(10) * 0.05;
+        data.oxygenSaturation = 95 + QRandomGenerator::global()->bounded(5);
+        data.heartRate = qRound(device.heartRate);
+
+        // 简化ECG：基线正弦 + R波尖峰 + 噪声，相位跨帧连续
+        const double beatHz = device.heartRate / 60.0;
+        const qint64 firstSample = device.frameIndex * samples;
+        data.ecgSignal = EcgFrame::allocate(device.deviceId, samples, data.timestampUs, m_config.sampleRate);
+        float* out = data.ecgSignal.mutableData();
+        for (int i = 0; i < samples; ++i) {
+            const double t = double(firstSample + i) / m_config.sampleRate;
+            double value = 0.3 * qSin(2 * M_PI * beatHz * t);
+            const double phase = std::fmod(t * beatHz, 1.0);
+            if (phase < 0.04) value += 1.5;
+            value += (QRandomGenerator::global()->generateDouble() - 0.5) * 0.05;
+            out[i] = static_cast<float>(value);
+        }
+
+        const QByteArray payload = QJsonDocument(data.toJson()).toJson(QJsonDocument::Compact);
+        if (send(device.vitalTopic, payload, sendNs)) {
+            m_window.frames++;
+            m_window.samples += samples;
+            m_total.frames++;
+            m_total.samples += samples;
+        }
+    }
+
+    void publishAlarm(DeviceState& device, qint64 sendNs) {
+        static const char* messages[] = {"血氧过低", "心率过高", "心率过低", "体温异常", "心电异常"};
+
+        AlarmInfo alarm;
+        alarm.deviceId = device.deviceId;
+        alarm.type = static_cast<AlarmInfo::AlarmType>(QRandomGenerator::global()->bounded(5));
+        alarm.message = QString::fromUtf8(messages[alarm.type]);
+        alarm.severity = 1 + QRandomGenerator::global()->bounded(5);
+        alarm.timestamp = QDateTime::fromMSecsSinceEpoch(m_startEpochUs / 1000 + sendNs / 1000000);
+
+        const QByteArray payload = QJsonDocument(alarm.toJson()).toJson(QJsonDocument::Compact);
+        if (send(device.alarmTopic, payload, sendNs)) {
+            m_window.alarms++;
+            m_total.alarms++;
+        }
+    }
+
+    bool send(const QString& topic, const QByteArray& payload, qint64 sendNs) {
+        if (m_recorder) {
+            m_recorder->append(topic, payload, m_startEpochUs + sendNs / 1000);
+        } else if (m_client->publish(topic, payload, quint8(m_config.qos)) < 0) {
+            m_window.failures++;
+            m_total.failures++;
+            return false;
+        }
+        m_window.bytes += payload.size();
+        m_total.bytes += payload.size();
+        return true;
+    }
+
+    // 录制文件模式：按虚拟时钟1ms步进生成，不做实时等待
+    void runCapture() {
+        m_recorder = new SessionRecorder(this);
+        if (!m_recorder->open(m_config.capturePath)) {
+            out() << "Cannot open capture file: " << m_config.capturePath << Qt::endl;
+            emit finished(1);
+            return;
+        }
+
+        m_startEpochUs = SessionRecorder::currentEpochUs();
+        QElapsedTimer wall;
+        wall.start();
+
+        const qint64 endNs = qint64(m_config.durationSec) * 1000000000;
+        for (qint64 virtualNs = 0; virtualNs <= endNs; virtualNs += 1000000) {
+            generateUntil(virtualNs, virtualNs);
+        }
+        m_recorder->close();
+
+        const double seconds = qMax<qint64>(1, wall.elapsed()) / 1000.0;
+        out() << QString("Wrote %1 frames, %2 alarms (%3 MB) to %4 in %5s (%6 frames/s)")
+                     .arg(m_total.frames)
+                     .arg(m_total.alarms)
+                     .arg(m_total.bytes / (1024.0 * 1024.0), 0, 'f', 1)
+                     .arg(m_config.capturePath)
+                     .arg(seconds, 0, 'f', 2)
+                     .arg(m_total.frames / seconds, 0, 'f', 0)
+              << Qt::endl;
+        emit finished(0);
+    }
+
+    void printSummary() {
+        const double seconds = qMax<qint64>(1, m_clock.elapsed()) / 1000.0;
+        const double targetFps = m_config.devices * 1000.0 / m_config.frameMs;
+        const double achievedFps = m_total.frames / seconds;
+        out() << QString("Total: %1 frames, %2 alarms, %3 failures in %4s\n"
+                         "Target %5 frames/s, achieved %6 frames/s (%7%), %8 samples/s")
+                     .arg(m_total.frames)
+                     .arg(m_total.alarms)
+                     .arg(m_total.failures)
+                     .arg(seconds, 0, 'f', 1)
+                     .arg(targetFps, 0, 'f', 1)
+                     .arg(achievedFps, 0, 'f', 1)
+                     .arg(targetFps > 0 ? achievedFps * 100.0 / targetFps : 0.0, 0, 'f', 1)
+                     .arg(m_total.samples / seconds, 0, 'f', 0)
+              << Qt::endl;
+    }
+};
+
+// 解析 "start,length,rate" 形式的报警风暴参数
+bool parseStorm(const QString& text, LoadConfig& config) {
+    const QStringList parts = text.split(',');
+    if (parts.size() != 3) return false;
+
+    bool ok1, ok2, ok3;
+    config.stormStartSec = parts[0].toDouble(&ok1);
+    config.stormLengthSec = parts[1].toDouble(&ok2);
+    config.stormRate = parts[2].toDouble(&ok3);
+    return ok1 && ok2 && ok3;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ecg_loadgen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ECG多设备负载生成器");
+    parser.addHelpOption();
+
+    QCommandLineOption hostOption("host", "MQTT Broker地址", "host", "localhost");
+    QCommandLineOption portOption("port", "MQTT端口", "port", "1883");
+    QCommandLineOption prefixOption("topic-prefix", "主题前缀", "prefix", "ecg");
+    QCommandLineOption qosOption("qos", "发布QoS (0/1)", "qos", "0");
+    QCommandLineOption devicesOption("devices", "模拟设备数", "n", "10");
+    QCommandLineOption rateOption("rate", "每设备采样率Hz (最高1000)", "hz", "100");
+    QCommandLineOption frameOption("frame-ms", "每帧时长ms", "ms", "1000");
+    QCommandLineOption durationOption("duration", "运行时长s", "sec", "60");
+    QCommandLineOption jitterOption("jitter-ms", "发送时间抖动±ms", "ms", "0");
+    QCommandLineOption burstOption("burst", "突发合并帧数", "n", "1");
+    QCommandLineOption alarmOption("alarm-rate", "常规报警速率(每设备每秒)", "rate", "0");
+    QCommandLineOption stormOption("alarm-storm", "报警风暴: 开始s,持续s,速率(每设备每秒)", "spec");
+    QCommandLineOption captureOption("capture", "写入录制文件而不发布", "file");
+    QCommandLineOption selfCheckOption("self-check", "自检报警风暴的报警生成（未指定风暴时使用10,5,20）后退出");
+
+    parser.addOptions({hostOption, portOption, prefixOption, qosOption, devicesOption,
+                       rateOption, frameOption, durationOption, jitterOption, burstOption,
+                       alarmOption, stormOption, captureOption, selfCheckOption});
+    parser.process(app);
+
+    LoadConfig config;
+    config.host = parser.value(hostOption);
+    config.port = static_cast<quint16>(parser.value(portOption).toUInt());
+    config.topicPrefix = parser.value(prefixOption);
+    config.qos = qBound(0, parser.value(qosOption).toInt(), 1);
+    config.devices = qMax(1, parser.value(devicesOption).toInt());
+    config.sampleRate = qBound(1, parser.value(rateOption).toInt(), 1000);
+    config.frameMs = qBound(10, parser.value(frameOption).toInt(), 10000);
+    config.durationSec = qMax(1, parser.value(durationOption).toInt());
+    config.jitterMs = qMax(0, parser.value(jitterOption).toInt());
+    config.burst = qMax(1, parser.value(burstOption).toInt());
+    config.alarmRate = qMax(0.0, parser.value(alarmOption).toDouble());
+    config.capturePath = parser.value(captureOption);
+
+    if (parser.isSet(stormOption) && !parseStorm(parser.value(stormOption), config)) {
+        out() << "Invalid --alarm-storm, expected start,length,rate" << Qt::endl;
+        return 1;
+    }
+
+    if (parser.isSet(selfCheckOption)) {
+        if (!config.hasStorm()) {
+            parseStorm("10,5,20", config);
+        }
+        // 运行时长至少覆盖整个风暴
+        config.durationSec = qMax(config.durationSec, int(std::ceil(config.stormStartSec + config.stormLengthSec)));
+        return LoadGenerator(config).selfCheck() ? 0 : 1;
+    }
+
+    out() << QString("Simulating %1 devices @ %2 Hz, %3 ms frames (%4 samples), burst %5, jitter ±%6 ms")
+                 .arg(config.devices)
+                 .arg(config.sampleRate)
+                 .arg(config.frameMs)
+                 .arg(qMax(1, config.sampleRate * config.frameMs / 1000))
+                 .arg(config.burst)
+                 .arg(config.jitterMs)
+          << Qt::endl;
+
+    LoadGenerator generator(config);
+    int exitCode = 0;
+    QObject::connect(&generator, &LoadGenerator::finished, &app, [&exitCode](int code) {
+        exitCode = code;
+        QTimer::singleShot(0, QCoreApplication::instance(), &QCoreApplication::quit);
+    });
+
+    QTimer::singleShot(0, &generator, &LoadGenerator::start);
+    app.exec();
+    return exitCode;
+}
+
+#include "ecg_loadgen.moc"